@@ -10,7 +10,49 @@ constexpr uint8_t I2C_SDA_PIN = D2; // NodeMCU GPIO4
 constexpr uint8_t I2C_SCL_PIN = D1; // NodeMCU GPIO5
 
 constexpr bool ENABLE_DATA_FETCH = true;       // Enable MLX90614 measurements
-constexpr unsigned long MEASUREMENT_INTERVAL_MS = 1500; // Sample every second
+constexpr unsigned long MEASUREMENT_INTERVAL_MS = 1500; // Nominal sample interval
+constexpr bool ENABLE_ADAPTIVE_SAMPLING = true;         // Sample faster near min/max or on steep slopes
+constexpr unsigned long MEASUREMENT_INTERVAL_MIN_MS = 300;
+constexpr unsigned long MEASUREMENT_INTERVAL_MAX_MS = 3000;
+constexpr float ADAPTIVE_SAMPLING_MARGIN_C = 2.0f;       // Distance to min/max where sampling speeds up
+constexpr float ADAPTIVE_SAMPLING_SLOPE_C_PER_S = 0.1f;  // Slope that forces the fastest interval
+
+constexpr uint8_t LOG_LEVEL = 2;                        // 0 error, 1 warn, 2 info, 3 debug (sample lines); higher levels compile out
+constexpr size_t LOG_BUFFER_BYTES = 1024;               // Ring drained into the UART FIFO from loop()
+constexpr size_t LOG_LINE_MAX = 160;                    // Longer lines are cut
+constexpr unsigned long LOG_REPEAT_WINDOW_MS = 10000;   // Identical lines folded into one per window; 0 disables
+
+constexpr bool ENABLE_SAMPLE_STREAM = true;             // COBS/CRC binary sample frames on the serial port ("stream on")
+constexpr bool STREAM_START_ACTIVE = false;             // true: stream from boot, text log muted
+constexpr unsigned long STREAM_SAMPLE_INTERVAL_MS = 10; // Raw read period while streaming; loop() sleeps 10 ms per pass
+
+constexpr bool ENABLE_TRACE_RECORDER = true;             // Decision trace on LittleFS for host replay (trace command, src/replay)
+constexpr size_t TRACE_FILE_MAX_BYTES = 262144;          // Rotated to /trace.1.bin; ~5 h of 1.5 s readings per file
+constexpr size_t TRACE_BUFFER_BYTES = 512;               // Readings collected in RAM between flash writes
+constexpr unsigned long TRACE_FLUSH_INTERVAL_MS = 60000; // Max reading loss on power cut; decisions are written at once
+
+constexpr bool ENABLE_STAGE_PROFILER = true;   // Per-stage loop latency histograms (stats command)
+constexpr bool ENABLE_HEAP_MONITOR = true;     // Free heap / fragmentation telemetry (heap command)
+constexpr unsigned long HEAP_SAMPLE_INTERVAL_MS = 1000;
+constexpr unsigned long HEAP_HISTORY_INTERVAL_MS = 60000; // One history entry per minute
+
+constexpr bool ENABLE_HISTORY = true;                        // In-RAM temperature history (history command)
+constexpr unsigned long HISTORY_FINE_BUCKET_MS = 60000;      // 1 min buckets ...
+constexpr size_t HISTORY_FINE_BUCKETS = 120;                 // ... for 2 h
+constexpr unsigned long HISTORY_COARSE_BUCKET_MS = 900000;   // 15 min buckets ...
+constexpr size_t HISTORY_COARSE_BUCKETS = 192;               // ... for 48 h
+constexpr size_t HISTORY_MAX_ROWS = 24;                      // history table rows before buckets are merged
+constexpr unsigned long HISTORY_DEFAULT_RANGE_MS = 3600000;
+
+constexpr bool ENABLE_TIMESERIES_LOG = true;                 // Per-sample compressed log on LittleFS (export command)
+constexpr size_t TIMESERIES_BLOCK_BYTES = 512;
+constexpr size_t TIMESERIES_BLOCKS = 1280;                   // 640 KB ring, ~3 days at 1.5 s sampling
+constexpr size_t TIMESERIES_SEGMENT_BLOCKS = 16;             // Blocks per segment file: 8 KB, one LittleFS block (4m2m)
+constexpr unsigned long TIMESERIES_FLUSH_INTERVAL_MS = 600000; // Partial block write period (max loss on power cut)
+constexpr char TIME_NTP_SERVER[] = "pool.ntp.org";           // Timestamps in the log are UTC
+
+constexpr bool ENABLE_METRICS_SERVER = true;                 // Prometheus text format on http://<ip>/metrics
+constexpr uint16_t METRICS_HTTP_PORT = 80;
 
 constexpr bool ENABLE_TELEGRAM = true;
 constexpr char TELEGRAM_BOT_TOKEN[] = "8323126146:AAGcQUHIvtDSvo4Y3o9ASztQAMT18pQLHWQ";
@@ -18,17 +60,65 @@ constexpr char TELEGRAM_ALERT_CHAT_ID[] = "-5023156896";   // Koruma ve hata bil
 constexpr char TELEGRAM_INFO_CHAT_ID[] = "-5014546274";           // Rapor kanali
 constexpr char TELEGRAM_SECONDARY_CHAT_ID[] = "6069420562";              // Ek komut/bildirim kanali (opsiyonel)
 constexpr unsigned long TELEGRAM_REPORT_INTERVAL_MS = 20000;
+constexpr float TELEGRAM_REPORT_DEADBAND_C = 0.0f;              // >0: skip reports that moved less than this
+constexpr unsigned long TELEGRAM_REPORT_MAX_SILENCE_MS = 600000; // Send at least this often in deadband mode
 constexpr bool TELEGRAM_ALLOW_INSECURE_TLS = true;
-constexpr char TELEGRAM_START_MESSAGE[] = "Cihaz baslatildi.";
-constexpr char TELEGRAM_USAGE_MESSAGE[] =
-    "Komutlar:\n"
-    "config\n"
-    "set min <deger_C>\n"
-    "set max <deger_C>\n"
-    "set hysteresis <deger_C>\n"
-    "set minsamples <tam_sayi>\n"
-    "set renotify <saniye>";
-constexpr char TELEGRAM_NO_DATA_MESSAGE[] = "Son periyotta olcum verisi bulunamadi.";
+// Optional api.telegram.org public key (PEM). When set it is pinned and setInsecure() is not used.
+constexpr char TELEGRAM_TLS_PUBLIC_KEY[] = "";
+constexpr int TELEGRAM_TLS_RX_BUFFER_BYTES = 1024;  // Used when the server accepts Max Fragment Length
+constexpr int TELEGRAM_TLS_TX_BUFFER_BYTES = 512;
+constexpr uint8_t TELEGRAM_CHAT_BURST = 3;                 // Per-chat token bucket size
+constexpr unsigned long TELEGRAM_CHAT_REFILL_MS = 3000;     // ~20 messages/minute per chat
+constexpr uint8_t TELEGRAM_GLOBAL_BURST = 10;
+constexpr unsigned long TELEGRAM_GLOBAL_REFILL_MS = 1000;
+constexpr unsigned long TELEGRAM_BACKOFF_BASE_MS = 1000;    // Transport error backoff, doubled per failure
+constexpr unsigned long TELEGRAM_BACKOFF_MAX_MS = 60000;
+constexpr size_t TELEGRAM_MAX_MESSAGE_UNITS = 4096;        // Telegram text limit (UTF-16 code units)
+constexpr bool TELEGRAM_DASHBOARD_MODE = true;  // Edit one report message per chat instead of posting new ones
+// Start, usage and report texts: src/text/MessagesTr.h
+
+constexpr size_t NOTIFY_QUEUE_LENGTH = 16;                 // Events waiting for their sinks
+constexpr size_t NOTIFY_BATCH_MAX = 8;                      // Events handed to one sink per loop() pass
+constexpr unsigned long NOTIFY_RETRY_MS = 2000;             // Pause for a sink after a failed delivery
+constexpr char NOTIFY_UDP_HOST[] = "";                      // Empty: UDP sink off
+constexpr uint16_t NOTIFY_UDP_PORT = 5140;
+constexpr bool NOTIFY_FILE_LOG = true;                      // /events.log on LittleFS
+constexpr size_t NOTIFY_FILE_MAX_BYTES = 32768;             // Rotated to /events.1.log
+
+constexpr bool ENABLE_MQTT = true;                          // Active once MQTT_BROKER_HOST is set
+constexpr char MQTT_BROKER_HOST[] = "";
+constexpr uint16_t MQTT_BROKER_PORT = 1883;
+constexpr char MQTT_CLIENT_ID[] = "tastan09";
+constexpr char MQTT_USERNAME[] = "";
+constexpr char MQTT_PASSWORD[] = "";
+constexpr char MQTT_TOPIC_PREFIX[] = "tastan09";          // <prefix>/telemetry, /event, /status, /cmd, /cmd/reply
+constexpr bool MQTT_ACCEPT_COMMANDS = false;                // true: any client able to publish <prefix>/cmd runs "set"
+constexpr bool MQTT_TELEMETRY_PER_SAMPLE = true;            // false: one message per report window
+constexpr uint16_t MQTT_KEEPALIVE_S = 30;
+constexpr unsigned long MQTT_CONNECT_TIMEOUT_MS = 2000;     // TCP connect + CONNACK, stays below the stall budget
+constexpr unsigned long MQTT_RECONNECT_BASE_MS = 2000;      // Doubled per failed attempt
+constexpr unsigned long MQTT_RECONNECT_MAX_MS = 60000;
+constexpr unsigned long MQTT_ACK_TIMEOUT_MS = 5000;         // QoS 1 retransmit period
+constexpr size_t MQTT_MAX_PACKET_BYTES = 1024;
+constexpr size_t MQTT_QOS1_QUEUE = 4;                       // Unacknowledged alerts kept for retransmission
+
+constexpr bool ENABLE_FLEET = true;                         // Active once FLEET_NODE_NAME is set
+constexpr char FLEET_NODE_NAME[] = "";                      // Unique per board, max 15 chars; "@<name>" routes commands
+constexpr uint8_t FLEET_GATEWAY_PRIORITY = 1;               // Highest live priority does Telegram I/O; 0: never gateway
+constexpr char FLEET_KEY[] = "";                            // Signs every datagram; empty: "@<node>" commands refused
+constexpr char FLEET_MULTICAST_GROUP[] = "239.255.42.9";
+constexpr uint16_t FLEET_PORT = 4209;
+constexpr uint8_t FLEET_MULTICAST_TTL = 1;                  // Stay on the local segment
+constexpr unsigned long FLEET_HEARTBEAT_MS = 2000;
+constexpr unsigned long FLEET_PEER_TIMEOUT_MS = 7000;       // Also the listen time before the first election
+constexpr unsigned long FLEET_SAMPLE_INTERVAL_MS = 5000;    // Latest sample to the group, best effort
+constexpr size_t FLEET_MAX_PEERS = 8;
+constexpr size_t FLEET_RETRANSMIT_SLOTS = 8;                // Own warnings/alerts kept for NACKs
+constexpr unsigned long FLEET_NACK_INTERVAL_MS = 500;
+constexpr uint8_t FLEET_NACK_RETRIES = 4;                   // Then the gateway counts the event lost
+constexpr unsigned long FLEET_COMMAND_RETRY_MS = 1500;
+constexpr uint8_t FLEET_COMMAND_RETRIES = 3;
+constexpr size_t FLEET_PENDING_COMMANDS = 4;                // Routed commands awaiting a reply
 
 constexpr bool ENABLE_PROTECTION = true;
 constexpr float OBJECT_TEMP_MIN_C = 20.0f;
@@ -41,4 +131,8 @@ constexpr uint8_t COOLING_RELAY_PIN = D6;
 constexpr uint8_t HEATING_RELAY_ACTIVE_LEVEL = LOW;
 constexpr uint8_t COOLING_RELAY_ACTIVE_LEVEL = LOW;
 constexpr unsigned long RELAY_MIN_SWITCH_INTERVAL_MS = 5000;
+
+constexpr bool ENABLE_LOOP_WATCHDOG = true;             // Force relays off when loop() stalls
+constexpr unsigned long LOOP_STALL_BUDGET_MS = 4000;    // Max time a relay may run without loop() progress
+constexpr unsigned long LOOP_WATCHDOG_TICK_MS = 100;    // timer1 check period (adds to the upper bound)
 }
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Fake sensor: readings come from native::setSensorReading() or a
+// native::SensorSource, so traces can be scripted against the clock.
+class Adafruit_MLX90614 {
+public:
+  bool begin(uint8_t address = 0x5A);
+  double readAmbientTempC();
+  double readObjectTempC();
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+// Host stand-in for the ESP8266 Arduino core, used by [env:native]. Only the
+// surface the firmware uses is provided; NativeHost.h controls the simulated
+// board (clock, pins, sensor, Wi-Fi, serial input).
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <algorithm>
+
+using std::isnan;
+
+typedef uint8_t byte;
+
+#define HEX 16
+#define DEC 10
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define OUTPUT 0x01
+
+// NodeMCU pin names map to GPIO numbers as on the board.
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define LED_BUILTIN 2
+
+// Flash and RAM are the same address space on the host.
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define FPSTR(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+inline size_t strlen_P(PGM_P s) { return strlen(s); }
+inline int strcmp_P(const char *a, PGM_P b) { return strcmp(a, b); }
+inline int strncmp_P(const char *a, PGM_P b, size_t n) { return strncmp(a, b, n); }
+inline char *strcpy_P(char *dst, PGM_P src) { return strcpy(dst, src); }
+inline char *strncpy_P(char *dst, PGM_P src, size_t n) { return strncpy(dst, src, n); }
+inline void *memcpy_P(void *dst, const void *src, size_t n) { return memcpy(dst, src, n); }
+inline uint8_t pgm_read_byte(const void *p) { return *static_cast<const uint8_t *>(p); }
+inline uint16_t pgm_read_word(const void *p) {
+  uint16_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+inline uint32_t pgm_read_dword(const void *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+inline const void *pgm_read_ptr(const void *p) { return *static_cast<const void *const *>(p); }
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+unsigned long millis();
+unsigned long micros();
+// Sleeps on the real clock; advances the virtual clock (native::useVirtualClock).
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+#include "Esp.h"
+
+#define TIM_DIV1 0
+#define TIM_DIV16 1
+#define TIM_DIV256 3
+#define TIM_EDGE 0
+#define TIM_LEVEL 1
+#define TIM_SINGLE 0
+#define TIM_LOOP 1
+
+// timer1 callbacks run from delay()/yield() once their period has passed on the
+// active clock, so a loop() that never yields is not interrupted as on the chip.
+typedef void (*timercallback)(void);
+void timer1_isr_init(void);
+void timer1_enable(uint8_t divider, uint8_t int_type, uint8_t reload);
+void timer1_disable(void);
+void timer1_attachInterrupt(timercallback userFunc);
+void timer1_detachInterrupt(void);
+void timer1_write(uint32_t ticks);
+
+// The host clock is already synchronised; SNTP setup is a no-op.
+void configTime(int timezone, int daylightOffset_sec, const char *server1, const char *server2 = nullptr,
+                const char *server3 = nullptr);
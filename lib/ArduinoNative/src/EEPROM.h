@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string.h>
+
+#include <vector>
+
+#include "Arduino.h"
+
+// Emulated EEPROM kept in RAM between begin() and commit(), persisted to
+// <native::stateDirectory()>/eeprom.bin. Erased bytes read as 0xFF.
+class EEPROMClass {
+public:
+  bool begin(size_t size);
+  bool commit();
+  bool end();
+  size_t length() const { return data_.size(); }
+
+  uint8_t read(int address) const;
+  void write(int address, uint8_t value);
+
+  template <typename T>
+  T &get(int address, T &value) const {
+    if (address >= 0 && static_cast<size_t>(address) + sizeof(T) <= data_.size()) {
+      memcpy(&value, data_.data() + address, sizeof(T));
+    }
+    return value;
+  }
+
+  template <typename T>
+  const T &put(int address, const T &value) {
+    if (address >= 0 && static_cast<size_t>(address) + sizeof(T) <= data_.size()) {
+      memcpy(data_.data() + address, &value, sizeof(T));
+      dirty_ = true;
+    }
+    return value;
+  }
+
+private:
+  std::vector<uint8_t> data_;
+  bool dirty_{false};
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ESP8266WiFi.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_BAD_REQUEST 400
+#define HTTP_CODE_NOT_FOUND 404
+#define HTTP_CODE_TOO_MANY_REQUESTS 429
+#define HTTP_CODE_INTERNAL_SERVER_ERROR 500
+
+#define HTTPC_ERROR_CONNECTION_FAILED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Minimal HTTP/1.1 client over the caller's WiFiClient: one request per
+// begin(), "Connection: close", body by Content-Length or until the peer closes.
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url);
+  void end();
+
+  void setTimeout(uint16_t timeoutMs) { timeoutMs_ = timeoutMs; }
+  void setReuse(bool) {}
+  void addHeader(const String &name, const String &value);
+
+  int GET();
+  int POST(const String &payload);
+  int POST(const uint8_t *payload, size_t size);
+  int sendRequest(const char *method, const uint8_t *payload, size_t size);
+
+  int getSize() const { return contentLength_; }
+  String getString();
+  WiFiClient &getStream() { return *client_; }
+  WiFiClient *getStreamPtr() { return client_; }
+  bool connected() { return client_ && client_->connected(); }
+  static String errorToString(int error);
+
+private:
+  bool readLine(String &line, unsigned long deadline);
+
+  WiFiClient *client_{nullptr};
+  String host_;
+  uint16_t port_{80};
+  String path_;
+  String headers_;
+  uint16_t timeoutMs_{5000};
+  int contentLength_{-1};
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "ESP8266WiFi.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+constexpr size_t CONTENT_LENGTH_UNKNOWN = static_cast<size_t>(-1);
+constexpr size_t CONTENT_LENGTH_NOT_SET = static_cast<size_t>(-2);
+
+// One request per handleClient() call and "Connection: close", like the core
+// server without keep-alive. Unknown content length is sent chunked.
+class ESP8266WebServer {
+public:
+  using THandlerFunction = std::function<void(void)>;
+
+  explicit ESP8266WebServer(int port = 80) : server_(static_cast<uint16_t>(port)) {}
+
+  void begin() { server_.begin(); }
+  void close() { server_.stop(); }
+  void on(const String &uri, HTTPMethod method, THandlerFunction handler);
+  void onNotFound(THandlerFunction handler) { notFound_ = handler; }
+  void handleClient();
+
+  const String &uri() const { return uri_; }
+  HTTPMethod method() const { return method_; }
+  WiFiClient &client() { return client_; }
+
+  void setContentLength(size_t length) { contentLength_ = length; }
+  void send(int code, const String &contentType, const String &content);
+  void sendContent(const char *content, size_t length);
+  void sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+
+private:
+  struct Route {
+    String uri;
+    HTTPMethod method;
+    THandlerFunction handler;
+  };
+
+  WiFiServer server_;
+  std::vector<Route> routes_;
+  THandlerFunction notFound_;
+  WiFiClient client_;
+  String uri_;
+  HTTPMethod method_{HTTP_GET};
+  size_t contentLength_{CONTENT_LENGTH_NOT_SET};
+  bool chunked_{false};
+};
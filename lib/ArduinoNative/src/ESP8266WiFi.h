@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#define WL_IDLE_STATUS 0
+#define WL_DISCONNECTED 6
+#define WL_CONNECTED 3
+#define WIFI_OFF 0
+#define WIFI_STA 1
+
+// Station state comes from native::setWifiConnected(); the address is loopback
+// so multicast and local servers work without a real interface.
+class WiFiClass {
+public:
+  void mode(int) {}
+  void begin(const char *ssid, const char *password);
+  void disconnect() {}
+  int status() const;
+  IPAddress localIP() const;
+  int32_t RSSI() const { return -55; }
+};
+
+extern WiFiClass WiFi;
+
+class Client : public Stream {
+public:
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  virtual int read(uint8_t *buffer, size_t size) = 0;
+  using Stream::read;
+};
+
+// Blocking connect, non-blocking reads over a host TCP socket, or over the
+// native::setLoopbackHandler() peer when one is set. Copies share the socket,
+// as copies of the core's WiFiClient share their connection context.
+class WiFiClient : public Client {
+public:
+  WiFiClient() = default;
+
+  int connect(const char *host, uint16_t port) override;
+  int connect(const String &host, uint16_t port) { return connect(host.c_str(), port); }
+  uint8_t connected() override;
+  void stop() override;
+  explicit operator bool() { return connected() != 0; }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int availableForWrite() override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override {}
+
+  void setNoDelay(bool enabled);
+  IPAddress remoteIP() const;
+
+protected:
+  friend class WiFiServer;
+  struct Socket;
+  explicit WiFiClient(int fd);
+  int fd() const;
+  int connectLoopback(const char *host, uint16_t port);
+
+  std::shared_ptr<Socket> socket_;
+};
+
+class WiFiServer {
+public:
+  explicit WiFiServer(uint16_t port) : port_(port) {}
+  ~WiFiServer();
+
+  void begin();
+  void stop();
+  // Non-blocking; an unconnected client when nobody is waiting.
+  WiFiClient accept();
+  WiFiClient available() { return accept(); }
+  uint16_t port() const { return port_; }
+
+private:
+  uint16_t port_;
+  int fd_{-1};
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// Cycle counter and heap figures modelled on an 80 MHz ESP8266: cycles follow the
+// active clock, free heap is native::HEAP_BYTES minus what the process has
+// allocated since startup.
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 80; }
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize() { return getFreeHeap(); }
+  uint8_t getHeapFragmentation() { return 0; }
+  void getHeapStats(uint32_t *freeBytes, uint16_t *maxBlock, uint8_t *fragmentation);
+  uint32_t getFreeContStack() { return 4096; }
+  uint32_t getChipId() { return 0x00A11CE5; }
+  void restart();
+  void wdtFeed() {}
+  void wdtEnable(uint32_t) {}
+  void wdtDisable() {}
+};
+
+extern EspClass ESP;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+struct FSInfo {
+  size_t totalBytes = 0;
+  size_t usedBytes = 0;
+  size_t blockSize = 4096;
+  size_t pageSize = 256;
+  size_t maxOpenFiles = 5;
+  size_t maxPathLength = 32;
+};
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+// A host file opened in binary mode. Copies share the handle, as in the core.
+class File : public Stream {
+public:
+  File() = default;
+  File(FILE *file, const char *name);
+
+  explicit operator bool() const { return static_cast<bool>(file_); }
+  const char *name() const { return name_.c_str(); }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size);
+  int peek() override;
+  void flush() override;
+
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+
+private:
+  std::shared_ptr<FILE> file_;
+  std::string name_;
+};
+
+// Files live under <native::stateDirectory()>/littlefs; the capacity reported
+// by info() is the 2 MB partition of eagle.flash.4m2m.ld.
+class FS {
+public:
+  bool begin();
+  void end() {}
+  bool format();
+  bool info(FSInfo &info);
+
+  bool exists(const char *path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  File open(const char *path, const char *mode);
+  File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+  bool remove(const char *path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char *from, const char *to);
+  bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+private:
+  std::string hostPath(const char *path) const;
+
+  bool mounted_{false};
+};
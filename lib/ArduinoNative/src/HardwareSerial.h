@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "Print.h"
+
+// Output goes to stdout. Input is read from stdin when it is readable and from
+// text queued with native::feedSerial().
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { baud_ = baud; }
+  void end() {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  // Never blocks on the host; reports a full 128-byte UART FIFO.
+  int availableForWrite() override { return 128; }
+  void flush() override;
+
+  int available() override;
+  int read() override;
+  int peek() override;
+
+  unsigned long baudRate() const { return baud_; }
+  void inject(const char *text, size_t length) { input_.append(text, length); }
+
+private:
+  void pollStdin();
+
+  unsigned long baud_{0};
+  std::string input_;
+  size_t inputPos_{0};
+};
+
+extern HardwareSerial Serial;
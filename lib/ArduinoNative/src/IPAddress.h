@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "WString.h"
+
+// IPv4 only. The uint32_t value is in network byte order, as on the ESP8266.
+class IPAddress {
+public:
+  IPAddress() = default;
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : address_(static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 |
+                 static_cast<uint32_t>(d) << 24) {}
+  explicit IPAddress(uint32_t address) : address_(address) {}
+
+  bool fromString(const char *text);
+  bool fromString(const String &text) { return fromString(text.c_str()); }
+  String toString() const;
+  bool isSet() const { return address_ != 0; }
+
+  operator uint32_t() const { return address_; }
+  bool operator==(const IPAddress &other) const { return address_ == other.address_; }
+  bool operator!=(const IPAddress &other) const { return address_ != other.address_; }
+  uint8_t operator[](int index) const { return static_cast<uint8_t>(address_ >> (8 * index)); }
+
+private:
+  uint32_t address_{0};
+};
@@ -0,0 +1,566 @@
+#include <errno.h>
+#include <malloc.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "Arduino.h"
+#include "NativeHost.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace native {
+namespace detail {
+// NativeNetwork.cpp: real wait for a socket with a request outstanding.
+void waitForNetwork(unsigned long ms);
+}  // namespace detail
+
+namespace {
+using SteadyClock = std::chrono::steady_clock;
+
+const SteadyClock::time_point startTime = SteadyClock::now();
+bool virtualMode = false;
+uint64_t virtualMicros = 0;
+int64_t realOffsetMicros = 0;  // setMillis() on the real clock
+
+PinRecord pins[PIN_COUNT];
+PinListener pinListener = nullptr;
+void *pinListenerContext = nullptr;
+
+SensorReading fixedReading;
+SensorSource sensorSource = nullptr;
+void *sensorSourceContext = nullptr;
+bool sensorIsPresent = true;
+
+std::string stateDir;
+volatile sig_atomic_t stopFlag = 0;
+
+std::mt19937 &generator() {
+  static std::mt19937 engine([] {
+    const char *seed = getenv("NATIVE_SEED");
+    return seed ? static_cast<uint32_t>(strtoul(seed, nullptr, 10))
+                : static_cast<uint32_t>(getpid()) ^ static_cast<uint32_t>(time(nullptr));
+  }());
+  return engine;
+}
+
+uint64_t realMicros() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - startTime).count());
+}
+
+struct Timer1 {
+  timercallback callback = nullptr;
+  bool enabled = false;
+  bool repeat = false;
+  uint32_t divider = 1;
+  uint64_t periodMicros = 0;
+  uint64_t dueMicros = 0;
+};
+Timer1 timer1;
+bool inTimer = false;
+constexpr uint32_t MAX_TIMER_CATCH_UP = 1000;
+}  // namespace
+
+void useVirtualClock(bool enabled) {
+  if (enabled == virtualMode) {
+    return;
+  }
+  const uint64_t now = elapsedMicros();
+  virtualMode = enabled;
+  if (enabled) {
+    virtualMicros = now;
+  } else {
+    realOffsetMicros = static_cast<int64_t>(now) - static_cast<int64_t>(realMicros());
+  }
+}
+
+bool virtualClock() { return virtualMode; }
+
+void advanceMicros(uint64_t micros) {
+  if (virtualMode) {
+    virtualMicros += micros;
+  } else {
+    realOffsetMicros += static_cast<int64_t>(micros);
+  }
+}
+
+void setMillis(unsigned long ms) {
+  const uint64_t target = static_cast<uint64_t>(ms) * 1000ULL;
+  if (virtualMode) {
+    virtualMicros = target;
+  } else {
+    realOffsetMicros = static_cast<int64_t>(target) - static_cast<int64_t>(realMicros());
+  }
+}
+
+uint64_t elapsedMicros() {
+  if (virtualMode) {
+    return virtualMicros;
+  }
+  return static_cast<uint64_t>(static_cast<int64_t>(realMicros()) + realOffsetMicros);
+}
+
+const PinRecord &pin(uint8_t number) {
+  static const PinRecord none;
+  return number < PIN_COUNT ? pins[number] : none;
+}
+
+void setPinListener(PinListener listener, void *context) {
+  pinListener = listener;
+  pinListenerContext = context;
+}
+
+void setSensorReading(const SensorReading &reading) { fixedReading = reading; }
+
+void setSensorSource(SensorSource source, void *context) {
+  sensorSource = source;
+  sensorSourceContext = context;
+}
+
+void setSensorPresent(bool present) { sensorIsPresent = present; }
+bool sensorPresent() { return sensorIsPresent; }
+
+bool readSensor(SensorReading &reading) {
+  reading = fixedReading;
+  if (sensorSource) {
+    SensorReading scripted = fixedReading;
+    if (sensorSource(millis(), scripted, sensorSourceContext)) {
+      reading = scripted;
+    }
+  }
+  return reading.ok;
+}
+
+void feedSerial(const char *text) { Serial.inject(text, strlen(text)); }
+
+void setStateDirectory(const char *path) { stateDir = path ? path : ""; }
+
+const char *stateDirectory() {
+  if (stateDir.empty()) {
+    const char *env = getenv("NATIVE_STATE_DIR");
+    stateDir = env && env[0] ? env : "native_state";
+  }
+  mkdir(stateDir.c_str(), 0755);
+  return stateDir.c_str();
+}
+
+void requestStop() { stopFlag = 1; }
+bool stopRequested() { return stopFlag != 0; }
+
+void serviceTimers() {
+  if (inTimer || !timer1.enabled || !timer1.callback || timer1.periodMicros == 0) {
+    return;
+  }
+  inTimer = true;
+  const uint64_t now = elapsedMicros();
+  uint32_t fired = 0;
+  while (timer1.enabled && now >= timer1.dueMicros && fired < MAX_TIMER_CATCH_UP) {
+    ++fired;
+    timer1.callback();
+    if (!timer1.repeat) {
+      timer1.enabled = false;
+    }
+    timer1.dueMicros += timer1.periodMicros;
+  }
+  if (timer1.enabled && now >= timer1.dueMicros) {
+    timer1.dueMicros = now + timer1.periodMicros;  // Too far behind; skip the rest
+  }
+  inTimer = false;
+}
+
+}  // namespace native
+
+// --- Core functions ------------------------------------------------------------
+
+unsigned long millis() { return static_cast<unsigned long>(native::elapsedMicros() / 1000ULL); }
+
+unsigned long micros() { return static_cast<unsigned long>(native::elapsedMicros()); }
+
+void delay(unsigned long ms) {
+  native::serviceTimers();
+  if (native::virtualMode) {
+    native::detail::waitForNetwork(ms);
+    native::virtualMicros += static_cast<uint64_t>(ms) * 1000ULL;
+  } else if (ms > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+  native::serviceTimers();
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (native::virtualMode) {
+    native::virtualMicros += us;
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+}
+
+void yield() { native::serviceTimers(); }
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < native::PIN_COUNT) {
+    native::pins[pin].mode = mode;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= native::PIN_COUNT) {
+    return;
+  }
+  native::PinRecord &record = native::pins[pin];
+  const uint8_t level = value ? HIGH : LOW;
+  const unsigned long now = millis();
+  ++record.writes;
+  if (record.level != level || record.writes == 1) {
+    ++record.transitions;
+    record.lastChangeMs = now;
+  }
+  record.level = level;
+  if (native::pinListener) {
+    native::pinListener(pin, level, now, native::pinListenerContext);
+  }
+}
+
+int digitalRead(uint8_t pin) { return pin < native::PIN_COUNT ? native::pins[pin].level : LOW; }
+
+long random(long max) { return max <= 0 ? 0 : random(0, max); }
+
+long random(long min, long max) {
+  if (max <= min) {
+    return min;
+  }
+  std::uniform_int_distribution<long> distribution(min, max - 1);
+  return distribution(native::generator());
+}
+
+void randomSeed(unsigned long seed) { native::generator().seed(static_cast<uint32_t>(seed)); }
+
+void timer1_isr_init(void) {}
+
+void timer1_enable(uint8_t divider, uint8_t, uint8_t reload) {
+  native::timer1.divider = divider == TIM_DIV256 ? 256 : divider == TIM_DIV16 ? 16 : 1;
+  native::timer1.repeat = reload == TIM_LOOP;
+  native::timer1.enabled = true;
+}
+
+void timer1_disable(void) { native::timer1.enabled = false; }
+
+void timer1_attachInterrupt(timercallback userFunc) { native::timer1.callback = userFunc; }
+
+void timer1_detachInterrupt(void) { native::timer1.callback = nullptr; }
+
+void timer1_write(uint32_t ticks) {
+  // 80 MHz APB clock through the prescaler.
+  native::timer1.periodMicros = static_cast<uint64_t>(ticks) * native::timer1.divider / 80ULL;
+  native::timer1.dueMicros = native::elapsedMicros() + native::timer1.periodMicros;
+}
+
+void configTime(int, int, const char *, const char *, const char *) {}
+
+// --- String --------------------------------------------------------------------
+
+String::String(long value, unsigned char base) {
+  if (base == 10) {
+    s_ = std::to_string(value);
+  } else {
+    *this = String(static_cast<unsigned long>(value), base);
+  }
+}
+
+String::String(unsigned long value, unsigned char base) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char buffer[8 * sizeof(unsigned long) + 1];
+  char *p = buffer + sizeof(buffer) - 1;
+  *p = '\0';
+  do {
+    const unsigned digit = static_cast<unsigned>(value % base);
+    *--p = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value > 0);
+  s_ = p;
+}
+
+String::String(double value, unsigned char decimals) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  s_ = buffer;
+}
+
+bool String::equalsIgnoreCase(const String &other) const {
+  if (s_.size() != other.s_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < s_.size(); ++i) {
+    if (tolower(static_cast<unsigned char>(s_[i])) != tolower(static_cast<unsigned char>(other.s_[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    std::swap(from, to);
+  }
+  if (from >= s_.size()) {
+    return String();
+  }
+  return String(s_.substr(from, std::min<size_t>(to, s_.size()) - from));
+}
+
+void String::replace(const String &find, const String &replacement) {
+  if (find.s_.empty()) {
+    return;
+  }
+  size_t index = 0;
+  while ((index = s_.find(find.s_, index)) != std::string::npos) {
+    s_.replace(index, find.s_.size(), replacement.s_);
+    index += replacement.s_.size();
+  }
+}
+
+void String::replace(char find, char replacement) {
+  for (char &c : s_) {
+    if (c == find) {
+      c = replacement;
+    }
+  }
+}
+
+void String::trim() {
+  size_t begin = 0;
+  while (begin < s_.size() && isspace(static_cast<unsigned char>(s_[begin]))) {
+    ++begin;
+  }
+  size_t end = s_.size();
+  while (end > begin && isspace(static_cast<unsigned char>(s_[end - 1]))) {
+    --end;
+  }
+  s_ = s_.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+  for (char &c : s_) {
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  }
+}
+
+void String::toUpperCase() {
+  for (char &c : s_) {
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+  }
+}
+
+// --- Print / Stream --------------------------------------------------------------
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (size-- > 0) {
+    if (write(*buffer++) == 0) {
+      break;
+    }
+    ++written;
+  }
+  return written;
+}
+
+size_t Print::print(long value, int base) {
+  if (base == 10) {
+    return print(String(value));
+  }
+  return print(String(static_cast<unsigned long>(value), static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return print(String(value, static_cast<unsigned char>(base)));
+}
+
+size_t Print::print(long long value, int base) {
+  return base == 10 ? print(String(value)) : print(static_cast<unsigned long long>(value), base);
+}
+
+size_t Print::print(unsigned long long value, int base) {
+  if (base == 10) {
+    return print(String(value));
+  }
+  char buffer[8 * sizeof(value) + 1];
+  char *p = buffer + sizeof(buffer) - 1;
+  *p = '\0';
+  do {
+    const unsigned digit = static_cast<unsigned>(value % static_cast<unsigned>(base));
+    *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    value /= static_cast<unsigned>(base);
+  } while (value > 0);
+  return write(p);
+}
+
+size_t Print::print(double value, int decimals) { return print(String(value, static_cast<unsigned char>(decimals))); }
+
+namespace {
+size_t vprint(Print &out, const char *format, va_list args) {
+  char buffer[256];
+  va_list copy;
+  va_copy(copy, args);
+  const int length = vsnprintf(buffer, sizeof(buffer), format, copy);
+  va_end(copy);
+  if (length < 0) {
+    return 0;
+  }
+  if (static_cast<size_t>(length) < sizeof(buffer)) {
+    return out.write(buffer, static_cast<size_t>(length));
+  }
+  std::string large(static_cast<size_t>(length) + 1, '\0');
+  vsnprintf(&large[0], large.size(), format, args);
+  return out.write(large.data(), static_cast<size_t>(length));
+}
+}  // namespace
+
+size_t Print::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  const size_t n = vprint(*this, format, args);
+  va_end(args);
+  return n;
+}
+
+size_t Print::printf_P(PGM_P format, ...) {
+  va_list args;
+  va_start(args, format);
+  const size_t n = vprint(*this, format, args);
+  va_end(args);
+  return n;
+}
+
+int Stream::timedRead() {
+  const unsigned long start = millis();
+  do {
+    const int c = read();
+    if (c >= 0) {
+      return c;
+    }
+    // The virtual clock only moves when something waits on it.
+    if (native::virtualClock()) {
+      delay(1);
+    } else {
+      yield();
+    }
+  } while (millis() - start < timeoutMs_);
+  return -1;
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t size) {
+  size_t count = 0;
+  while (count < size) {
+    const int c = timedRead();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = static_cast<uint8_t>(c);
+  }
+  return count;
+}
+
+String Stream::readString() {
+  String text;
+  for (int c = timedRead(); c >= 0; c = timedRead()) {
+    text += static_cast<char>(c);
+  }
+  return text;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String text;
+  for (int c = timedRead(); c >= 0 && c != terminator; c = timedRead()) {
+    text += static_cast<char>(c);
+  }
+  return text;
+}
+
+// --- HardwareSerial ------------------------------------------------------------
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  const size_t written = fwrite(buffer, 1, size, stdout);
+  fflush(stdout);
+  return written;
+}
+
+void HardwareSerial::flush() { fflush(stdout); }
+
+void HardwareSerial::pollStdin() {
+  static bool eof = false;
+  if (eof || inputPos_ < input_.size()) {
+    return;
+  }
+  input_.clear();
+  inputPos_ = 0;
+  pollfd fd{STDIN_FILENO, POLLIN, 0};
+  if (poll(&fd, 1, 0) <= 0 || !(fd.revents & (POLLIN | POLLHUP))) {
+    return;
+  }
+  char buffer[256];
+  const ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+  if (n <= 0) {
+    eof = n == 0 || errno != EAGAIN;
+    return;
+  }
+  input_.append(buffer, static_cast<size_t>(n));
+}
+
+int HardwareSerial::available() {
+  pollStdin();
+  return static_cast<int>(input_.size() - inputPos_);
+}
+
+int HardwareSerial::read() {
+  pollStdin();
+  return inputPos_ < input_.size() ? static_cast<uint8_t>(input_[inputPos_++]) : -1;
+}
+
+int HardwareSerial::peek() {
+  pollStdin();
+  return inputPos_ < input_.size() ? static_cast<uint8_t>(input_[inputPos_]) : -1;
+}
+
+// --- EspClass --------------------------------------------------------------------
+
+uint32_t EspClass::getCycleCount() { return static_cast<uint32_t>(native::elapsedMicros() * 80ULL); }
+
+uint32_t EspClass::getFreeHeap() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const size_t inUse = mallinfo2().uordblks;
+#else
+  const size_t inUse = static_cast<size_t>(mallinfo().uordblks);
+#endif
+  static const size_t baseline = inUse;
+  const size_t grown = inUse > baseline ? inUse - baseline : 0;
+  return grown >= native::HEAP_BYTES ? 0 : static_cast<uint32_t>(native::HEAP_BYTES - grown);
+}
+
+void EspClass::getHeapStats(uint32_t *freeBytes, uint16_t *maxBlock, uint8_t *fragmentation) {
+  const uint32_t free = getFreeHeap();
+  if (freeBytes) {
+    *freeBytes = free;
+  }
+  if (maxBlock) {
+    *maxBlock = static_cast<uint16_t>(free > 0xFFFF ? 0xFFFF : free);
+  }
+  if (fragmentation) {
+    *fragmentation = 0;
+  }
+}
+
+void EspClass::restart() {
+  fputs("\n[native] ESP.restart()\n", stderr);
+  native::requestStop();
+}
@@ -0,0 +1,17 @@
+#include "Adafruit_MLX90614.h"
+#include "NativeHost.h"
+#include "Wire.h"
+
+TwoWire Wire;
+
+bool Adafruit_MLX90614::begin(uint8_t) { return native::sensorPresent(); }
+
+double Adafruit_MLX90614::readAmbientTempC() {
+  native::SensorReading reading;
+  return native::readSensor(reading) ? reading.ambientC : NAN;
+}
+
+double Adafruit_MLX90614::readObjectTempC() {
+  native::SensorReading reading;
+  return native::readSensor(reading) ? reading.objectC : NAN;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Controls for the simulated board in [env:native]. The firmware never includes
+// this; the native runner and host-side tools use it to drive the clock, the
+// sensor and the network state and to observe the relay pins.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace native {
+
+constexpr uint32_t HEAP_BYTES = 52 * 1024;  // Roughly what an ESP8266 sketch starts with
+constexpr uint8_t PIN_COUNT = 17;
+
+// --- Clock -----------------------------------------------------------------
+// The real clock follows steady_clock. The virtual clock only moves in delay(),
+// delayMicroseconds(), advanceMicros() and setMillis(), so a run is
+// deterministic and as fast as the CPU allows.
+void useVirtualClock(bool enabled);
+bool virtualClock();
+void advanceMicros(uint64_t micros);
+void setMillis(unsigned long ms);
+uint64_t elapsedMicros();
+
+// --- Pins ------------------------------------------------------------------
+using PinListener = void (*)(uint8_t pin, uint8_t level, unsigned long ms, void *context);
+
+struct PinRecord {
+  uint8_t mode = 0;
+  uint8_t level = 0;
+  uint32_t writes = 0;       // digitalWrite() calls
+  uint32_t transitions = 0;  // Writes that changed the level
+  unsigned long lastChangeMs = 0;
+};
+
+const PinRecord &pin(uint8_t number);
+// One listener; called for every digitalWrite(), including repeats.
+void setPinListener(PinListener listener, void *context);
+
+// --- Sensor (fake MLX90614) --------------------------------------------------
+struct SensorReading {
+  float ambientC = 22.0f;
+  float objectC = 25.0f;
+  bool ok = true;  // false: both reads return NAN
+};
+
+// Overrides the fixed reading; return false to fall back to it.
+using SensorSource = bool (*)(unsigned long nowMs, SensorReading &reading, void *context);
+
+void setSensorReading(const SensorReading &reading);
+void setSensorSource(SensorSource source, void *context);
+void setSensorPresent(bool present);  // false: begin() fails
+bool readSensor(SensorReading &reading);
+bool sensorPresent();
+
+// --- Network ---------------------------------------------------------------
+void setWifiConnected(bool connected);
+bool wifiConnected();
+// WiFiClientSecure connects in plain TCP to this endpoint (TLS terminated
+// locally), whatever host it is asked for. Empty: secure connects fail.
+// Initialised from NATIVE_TLS_ENDPOINT ("host:port").
+void setTlsEndpoint(const char *host, uint16_t port);
+bool tlsEndpoint(const char *&host, uint16_t &port);
+// Added to every listening TCP port, so port 80 does not need root.
+// Initialised from NATIVE_PORT_OFFSET.
+uint16_t listenPort(uint16_t port);
+
+// In-process stand-in for remote servers. While a handler is set, every
+// outgoing TCP connection (plain or "TLS") goes to it instead of a socket, so a
+// fake service can answer with injected latency on the virtual clock without
+// real waits or ports.
+struct LoopbackExchange {
+  std::string request;              // Everything the client wrote on this connection
+  std::string response;             // Readable once millis() reaches readyAtMs
+  unsigned long readyAtMs = 0;
+  unsigned long connectDelayMs = 0;  // Set on Connect; at or past the stream timeout the connect fails
+  bool closeAfterResponse = true;    // Peer closes once the response has been read
+};
+
+enum class LoopbackEvent : uint8_t {
+  Connect,  // Return false to refuse the connection
+  Data,     // The client wrote; set response/readyAtMs once the request is complete
+};
+
+using LoopbackHandler = bool (*)(const char *host, uint16_t port, LoopbackEvent event, LoopbackExchange &exchange,
+                                 void *context);
+
+// nullptr restores real sockets.
+void setLoopbackHandler(LoopbackHandler handler, void *context);
+
+// --- Serial ----------------------------------------------------------------
+void feedSerial(const char *text);
+
+// --- Files -------------------------------------------------------------------
+// EEPROM image and LittleFS root live under this directory (created on demand).
+// Initialised from NATIVE_STATE_DIR, default "native_state".
+void setStateDirectory(const char *path);
+const char *stateDirectory();
+
+// --- Runner ------------------------------------------------------------------
+// Set by SIGINT/SIGTERM, ESP.restart() or requestStop(); the runner then returns from main().
+void requestStop();
+bool stopRequested();
+// Runs timer1 if its period has elapsed; called from delay() and yield().
+void serviceTimers();
+
+}  // namespace native
@@ -0,0 +1,298 @@
+#include "ESP8266HTTPClient.h"
+#include "ESP8266WebServer.h"
+
+namespace {
+// Reads one CRLF-terminated line; false on timeout or when the peer closed
+// without finishing it.
+bool readHttpLine(WiFiClient &client, String &line, unsigned long deadline) {
+  line = "";
+  while (static_cast<long>(millis() - deadline) < 0) {
+    const int c = client.read();
+    if (c < 0) {
+      if (!client.connected()) {
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    if (c == '\n') {
+      if (line.endsWith("\r")) {
+        line.remove(line.length() - 1);
+      }
+      return true;
+    }
+    line += static_cast<char>(c);
+  }
+  return false;
+}
+
+bool startsWithIgnoreCase(const String &text, const char *prefix) {
+  return strncasecmp(text.c_str(), prefix, strlen(prefix)) == 0;
+}
+
+const char *reasonPhrase(int code) {
+  switch (code) {
+    case 200:
+      return "OK";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 429:
+      return "Too Many Requests";
+    case 500:
+      return "Internal Server Error";
+    default:
+      return "";
+  }
+}
+}  // namespace
+
+// --- HTTPClient ----------------------------------------------------------------------
+
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  client_ = &client;
+  headers_ = "";
+  contentLength_ = -1;
+  String rest = url;
+  port_ = 80;
+  if (rest.startsWith("https://")) {
+    port_ = 443;
+    rest = rest.substring(8);
+  } else if (rest.startsWith("http://")) {
+    rest = rest.substring(7);
+  } else {
+    return false;
+  }
+  const int slash = rest.indexOf('/');
+  String authority = slash < 0 ? rest : rest.substring(0, slash);
+  path_ = slash < 0 ? String("/") : rest.substring(slash);
+  const int colon = authority.indexOf(':');
+  if (colon >= 0) {
+    port_ = static_cast<uint16_t>(authority.substring(colon + 1).toInt());
+    authority = authority.substring(0, colon);
+  }
+  host_ = authority;
+  return host_.length() > 0;
+}
+
+void HTTPClient::end() {
+  if (client_) {
+    client_->stop();
+  }
+}
+
+void HTTPClient::addHeader(const String &name, const String &value) {
+  headers_ += name;
+  headers_ += ": ";
+  headers_ += value;
+  headers_ += "\r\n";
+}
+
+int HTTPClient::GET() { return sendRequest("GET", nullptr, 0); }
+
+int HTTPClient::POST(const String &payload) {
+  return sendRequest("POST", reinterpret_cast<const uint8_t *>(payload.c_str()), payload.length());
+}
+
+int HTTPClient::POST(const uint8_t *payload, size_t size) { return sendRequest("POST", payload, size); }
+
+int HTTPClient::sendRequest(const char *method, const uint8_t *payload, size_t size) {
+  if (!client_) {
+    return HTTPC_ERROR_NOT_CONNECTED;
+  }
+  client_->setTimeout(timeoutMs_);
+  if (!client_->connected() && !client_->connect(host_.c_str(), port_)) {
+    return HTTPC_ERROR_CONNECTION_FAILED;
+  }
+  String request;
+  request.reserve(160 + headers_.length());
+  request += method;
+  request += ' ';
+  request += path_;
+  request += " HTTP/1.1\r\nHost: ";
+  request += host_;
+  request += "\r\nUser-Agent: ESP8266HTTPClient\r\nConnection: close\r\n";
+  request += headers_;
+  if (payload || strcmp(method, "POST") == 0) {
+    request += "Content-Length: ";
+    request += String(static_cast<unsigned long>(size));
+    request += "\r\n";
+  }
+  request += "\r\n";
+  if (client_->write(request.c_str(), request.length()) != request.length()) {
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (size > 0 && client_->write(payload, size) != size) {
+    return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+  }
+
+  const unsigned long deadline = millis() + timeoutMs_;
+  String line;
+  if (!readHttpLine(*client_, line, deadline)) {
+    return client_->connected() ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+  }
+  const int space = line.indexOf(' ');
+  const int code = space > 0 ? line.substring(space + 1).toInt() : 0;
+  if (!line.startsWith("HTTP/1.") || code <= 0) {
+    return HTTPC_ERROR_CONNECTION_LOST;
+  }
+  contentLength_ = -1;
+  while (true) {
+    if (!readHttpLine(*client_, line, deadline)) {
+      return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    if (line.length() == 0) {
+      break;
+    }
+    if (startsWithIgnoreCase(line, "Content-Length:")) {
+      contentLength_ = line.substring(15).toInt();
+    }
+  }
+  return code;
+}
+
+String HTTPClient::getString() {
+  String body;
+  if (!client_) {
+    return body;
+  }
+  if (contentLength_ > 0) {
+    body.reserve(static_cast<size_t>(contentLength_));
+  }
+  const unsigned long deadline = millis() + timeoutMs_;
+  char buffer[512];
+  while (contentLength_ < 0 || static_cast<int>(body.length()) < contentLength_) {
+    const int n = client_->read(reinterpret_cast<uint8_t *>(buffer), sizeof(buffer));
+    if (n > 0) {
+      body.concat(buffer, static_cast<size_t>(n));
+      continue;
+    }
+    if (!client_->connected() || static_cast<long>(millis() - deadline) >= 0) {
+      break;
+    }
+    delay(1);
+  }
+  return body;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_FAILED:
+      return F("connection failed");
+    case HTTPC_ERROR_SEND_HEADER_FAILED:
+      return F("send header failed");
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED:
+      return F("send payload failed");
+    case HTTPC_ERROR_NOT_CONNECTED:
+      return F("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST:
+      return F("connection lost");
+    case HTTPC_ERROR_READ_TIMEOUT:
+      return F("read Timeout");
+    default:
+      return String();
+  }
+}
+
+// --- ESP8266WebServer ------------------------------------------------------------------
+
+void ESP8266WebServer::on(const String &uri, HTTPMethod method, THandlerFunction handler) {
+  routes_.push_back(Route{uri, method, handler});
+}
+
+void ESP8266WebServer::handleClient() {
+  client_ = server_.accept();
+  if (!client_.connected()) {
+    return;
+  }
+  const unsigned long deadline = millis() + 1000;
+  String line;
+  if (!readHttpLine(client_, line, deadline)) {
+    client_.stop();
+    return;
+  }
+  const int firstSpace = line.indexOf(' ');
+  const int secondSpace = line.indexOf(' ', firstSpace + 1);
+  if (firstSpace <= 0 || secondSpace <= firstSpace) {
+    client_.stop();
+    return;
+  }
+  const String method = line.substring(0, firstSpace);
+  uri_ = line.substring(firstSpace + 1, secondSpace);
+  const int query = uri_.indexOf('?');
+  if (query >= 0) {
+    uri_.remove(query);
+  }
+  method_ = method == "POST"     ? HTTP_POST
+            : method == "HEAD"   ? HTTP_HEAD
+            : method == "PUT"    ? HTTP_PUT
+            : method == "DELETE" ? HTTP_DELETE
+                                 : HTTP_GET;
+  while (readHttpLine(client_, line, deadline) && line.length() > 0) {
+  }
+
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  chunked_ = false;
+  bool handled = false;
+  for (const Route &route : routes_) {
+    if (route.uri == uri_ && (route.method == HTTP_ANY || route.method == method_)) {
+      route.handler();
+      handled = true;
+      break;
+    }
+  }
+  if (!handled) {
+    if (notFound_) {
+      notFound_();
+    } else {
+      send(404, "text/plain", "Not found");
+    }
+  }
+  if (chunked_) {
+    sendContent("", 0);
+  }
+  client_.stop();
+}
+
+void ESP8266WebServer::send(int code, const String &contentType, const String &content) {
+  String header;
+  header.reserve(128);
+  header += "HTTP/1.1 ";
+  header += String(code);
+  header += ' ';
+  header += reasonPhrase(code);
+  header += "\r\nContent-Type: ";
+  header += contentType;
+  header += "\r\nConnection: close\r\n";
+  if (contentLength_ == CONTENT_LENGTH_UNKNOWN) {
+    header += "Transfer-Encoding: chunked\r\n\r\n";
+    client_.write(header.c_str(), header.length());
+    chunked_ = true;
+    if (content.length() > 0) {
+      sendContent(content);
+    }
+    return;
+  }
+  header += "Content-Length: ";
+  header += String(static_cast<unsigned long>(contentLength_ == CONTENT_LENGTH_NOT_SET ? content.length()
+                                                                                       : contentLength_));
+  header += "\r\n\r\n";
+  client_.write(header.c_str(), header.length());
+  client_.write(content.c_str(), content.length());
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t length) {
+  if (!chunked_) {
+    client_.write(content, length);
+    return;
+  }
+  char size[16];
+  const int sizeLength = snprintf(size, sizeof(size), "%zx\r\n", length);
+  client_.write(size, static_cast<size_t>(sizeLength));
+  client_.write(content, length);
+  client_.write("\r\n", 2);
+  if (length == 0) {
+    chunked_ = false;  // Terminating chunk sent
+  }
+}
@@ -0,0 +1,92 @@
+// Runner for the firmware in [env:native]: setup() once, then loop() until
+// Ctrl-C, ESP.restart() or --duration. It is only linked when the program has
+// no main() of its own (the library is an archive), so host tools and
+// benchmarks can bring theirs.
+
+#include <signal.h>
+
+#include "Arduino.h"
+#include "NativeHost.h"
+
+void setup();
+void loop();
+
+namespace {
+
+void onSignal(int) { native::requestStop(); }
+
+void printUsage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --virtual          virtual clock: time only moves in delay(), runs as fast as possible\n"
+          "  --duration <s>     stop after <s> seconds on the active clock\n"
+          "  --object <C>       object temperature reported by the fake MLX90614 (default 25)\n"
+          "  --ambient <C>      ambient temperature (default 22)\n"
+          "  --no-sensor        MLX90614 begin() fails\n"
+          "  --offline          Wi-Fi never connects\n"
+          "  --tls <host:port>  plain TCP endpoint that stands in for every TLS host\n"
+          "  --state <dir>      EEPROM image and LittleFS root (default native_state)\n"
+          "  --seed <n>         random() seed\n"
+          "  --trace-pins       log every digitalWrite() to stderr\n",
+          program);
+}
+
+void tracePin(uint8_t pin, uint8_t level, unsigned long ms, void *) {
+  fprintf(stderr, "[pin] %lu ms GPIO%u=%u\n", ms, pin, level);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  double durationSeconds = 0;
+  native::SensorReading reading;
+  for (int i = 1; i < argc; ++i) {
+    const String option(argv[i]);
+    const bool hasValue = i + 1 < argc;
+    if (option == "--virtual") {
+      native::useVirtualClock(true);
+    } else if (option == "--duration" && hasValue) {
+      durationSeconds = atof(argv[++i]);
+    } else if (option == "--object" && hasValue) {
+      reading.objectC = static_cast<float>(atof(argv[++i]));
+    } else if (option == "--ambient" && hasValue) {
+      reading.ambientC = static_cast<float>(atof(argv[++i]));
+    } else if (option == "--no-sensor") {
+      native::setSensorPresent(false);
+    } else if (option == "--offline") {
+      native::setWifiConnected(false);
+    } else if (option == "--tls" && hasValue) {
+      const String endpoint(argv[++i]);
+      const int colon = endpoint.lastIndexOf(':');
+      if (colon <= 0) {
+        printUsage(argv[0]);
+        return 2;
+      }
+      native::setTlsEndpoint(endpoint.substring(0, colon).c_str(),
+                             static_cast<uint16_t>(endpoint.substring(colon + 1).toInt()));
+    } else if (option == "--state" && hasValue) {
+      native::setStateDirectory(argv[++i]);
+    } else if (option == "--seed" && hasValue) {
+      randomSeed(strtoul(argv[++i], nullptr, 10));
+    } else if (option == "--trace-pins") {
+      native::setPinListener(tracePin, nullptr);
+    } else {
+      printUsage(argv[0]);
+      return option == "--help" ? 0 : 2;
+    }
+  }
+  native::setSensorReading(reading);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  const uint64_t endMicros =
+      durationSeconds > 0 ? native::elapsedMicros() + static_cast<uint64_t>(durationSeconds * 1e6) : 0;
+  setup();
+  while (!native::stopRequested() && (endMicros == 0 || native::elapsedMicros() < endMicros)) {
+    loop();
+    yield();
+  }
+  Serial.flush();
+  return 0;
+}
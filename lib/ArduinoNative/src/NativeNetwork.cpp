@@ -0,0 +1,567 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "ESP8266WiFi.h"
+#include "NativeHost.h"
+#include "WiFiClientSecure.h"
+#include "WiFiUdp.h"
+
+WiFiClass WiFi;
+
+namespace native {
+namespace {
+bool wifiUp = getenv("NATIVE_WIFI_DOWN") == nullptr;
+std::string tlsHost;
+uint16_t tlsPort = 0;
+bool tlsLoaded = false;
+// Socket that had nothing to read while a reply was expected; the next
+// virtual delay() waits on it for real so the reply can arrive.
+int waitingFd = -1;
+LoopbackHandler loopbackHandler = nullptr;
+void *loopbackContext = nullptr;
+
+void loadTlsEndpoint() {
+  if (tlsLoaded) {
+    return;
+  }
+  tlsLoaded = true;
+  const char *env = getenv("NATIVE_TLS_ENDPOINT");
+  if (!env || !env[0]) {
+    return;
+  }
+  const std::string value(env);
+  const size_t colon = value.rfind(':');
+  if (colon == std::string::npos) {
+    return;
+  }
+  tlsHost = value.substr(0, colon);
+  tlsPort = static_cast<uint16_t>(atoi(value.c_str() + colon + 1));
+}
+
+bool resolve(const char *host, uint16_t port, int type, sockaddr_in &address) {
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = type;
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+    return false;
+  }
+  address = *reinterpret_cast<sockaddr_in *>(result->ai_addr);
+  address.sin_port = htons(port);
+  freeaddrinfo(result);
+  return true;
+}
+}  // namespace
+
+void setWifiConnected(bool connected) { wifiUp = connected; }
+bool wifiConnected() { return wifiUp; }
+
+void setTlsEndpoint(const char *host, uint16_t port) {
+  tlsLoaded = true;
+  tlsHost = host ? host : "";
+  tlsPort = port;
+}
+
+bool tlsEndpoint(const char *&host, uint16_t &port) {
+  loadTlsEndpoint();
+  host = tlsHost.c_str();
+  port = tlsPort;
+  return !tlsHost.empty() && tlsPort != 0;
+}
+
+void setLoopbackHandler(LoopbackHandler handler, void *context) {
+  loopbackHandler = handler;
+  loopbackContext = context;
+}
+
+uint16_t listenPort(uint16_t port) {
+  static const long offset = [] {
+    const char *env = getenv("NATIVE_PORT_OFFSET");
+    return env ? strtol(env, nullptr, 10) : 0L;
+  }();
+  return static_cast<uint16_t>(port + offset);
+}
+
+namespace detail {
+void waitForNetwork(unsigned long ms) {
+  if (waitingFd < 0 || ms == 0) {
+    return;
+  }
+  pollfd fd{waitingFd, POLLIN, 0};
+  waitingFd = -1;
+  poll(&fd, 1, static_cast<int>(ms));
+}
+}  // namespace detail
+
+}  // namespace native
+
+// --- IPAddress -----------------------------------------------------------------
+
+bool IPAddress::fromString(const char *text) {
+  in_addr parsed{};
+  if (!text || inet_pton(AF_INET, text, &parsed) != 1) {
+    return false;
+  }
+  address_ = parsed.s_addr;
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buffer[INET_ADDRSTRLEN];
+  in_addr value{};
+  value.s_addr = address_;
+  return String(inet_ntop(AF_INET, &value, buffer, sizeof(buffer)));
+}
+
+// --- WiFi ------------------------------------------------------------------------
+
+void WiFiClass::begin(const char *, const char *) {}
+
+int WiFiClass::status() const { return native::wifiConnected() ? WL_CONNECTED : WL_DISCONNECTED; }
+
+IPAddress WiFiClass::localIP() const {
+  return native::wifiConnected() ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+// --- WiFiClient --------------------------------------------------------------------
+
+struct WiFiClient::Socket {
+  explicit Socket(int descriptor) : fd(descriptor) {}
+  Socket(const char *peerHost, uint16_t peerPort) : fd(-1), loopback(true), host(peerHost), port(peerPort) {}
+  ~Socket() { close(); }
+  Socket(const Socket &) = delete;
+  Socket &operator=(const Socket &) = delete;
+
+  void close() {
+    if (fd >= 0) {
+      if (native::waitingFd == fd) {
+        native::waitingFd = -1;
+      }
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  // Called when a read found nothing; see native::waitingFd.
+  void nothingToRead() {
+    if (native::virtualClock() && native::elapsedMicros() < replyDueMicros) {
+      native::waitingFd = fd;
+    }
+  }
+
+  // Bytes of the loopback response the client may read now.
+  size_t readable() const {
+    if (!loopbackOpen || exchange.response.size() <= readPos ||
+        static_cast<long>(millis() - exchange.readyAtMs) < 0) {
+      return 0;
+    }
+    return exchange.response.size() - readPos;
+  }
+
+  int fd;
+  // A reply is expected until the stream timeout after the last write.
+  uint64_t replyDueMicros = 0;
+
+  bool loopback = false;
+  bool loopbackOpen = false;
+  std::string host;
+  uint16_t port = 0;
+  native::LoopbackExchange exchange;
+  size_t readPos = 0;
+};
+
+WiFiClient::WiFiClient(int fd) : socket_(std::make_shared<Socket>(fd)) {}
+
+int WiFiClient::fd() const { return socket_ ? socket_->fd : -1; }
+
+int WiFiClient::connectLoopback(const char *host, uint16_t port) {
+  auto socket = std::make_shared<Socket>(host, port);
+  if (!native::loopbackHandler(host, port, native::LoopbackEvent::Connect, socket->exchange,
+                               native::loopbackContext)) {
+    return 0;
+  }
+  if (socket->exchange.connectDelayMs >= timeoutMs_) {
+    delay(timeoutMs_);
+    return 0;
+  }
+  delay(socket->exchange.connectDelayMs);
+  socket->loopbackOpen = true;
+  socket_ = socket;
+  return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  stop();
+  if (!native::wifiConnected()) {
+    return 0;
+  }
+  if (native::loopbackHandler) {
+    return connectLoopback(host, port);
+  }
+  sockaddr_in address{};
+  if (!native::resolve(host, port, SOCK_STREAM, address)) {
+    return 0;
+  }
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  // Connect with the stream timeout, then go back to blocking writes.
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int result = ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  if (result < 0 && errno == EINPROGRESS) {
+    pollfd pending{fd, POLLOUT, 0};
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (poll(&pending, 1, static_cast<int>(timeoutMs_)) == 1 &&
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+      result = 0;
+    }
+  }
+  if (result < 0) {
+    ::close(fd);
+    return 0;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+  socket_ = std::make_shared<Socket>(fd);
+  return 1;
+}
+
+uint8_t WiFiClient::connected() {
+  if (socket_ && socket_->loopback) {
+    const native::LoopbackExchange &exchange = socket_->exchange;
+    const bool drained = !exchange.response.empty() && socket_->readPos >= exchange.response.size();
+    return socket_->loopbackOpen && !(drained && exchange.closeAfterResponse) ? 1 : 0;
+  }
+  const int descriptor = fd();
+  if (descriptor < 0) {
+    return 0;
+  }
+  char probe;
+  const ssize_t n = recv(descriptor, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0) {
+    return 1;
+  }
+  return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : 0;
+}
+
+void WiFiClient::stop() {
+  if (socket_) {
+    socket_->loopbackOpen = false;
+    socket_->close();
+    socket_.reset();
+  }
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+  if (socket_ && socket_->loopback) {
+    if (!socket_->loopbackOpen || size == 0) {
+      return 0;
+    }
+    socket_->exchange.request.append(reinterpret_cast<const char *>(buffer), size);
+    native::loopbackHandler(socket_->host.c_str(), socket_->port, native::LoopbackEvent::Data, socket_->exchange,
+                            native::loopbackContext);
+    return size;
+  }
+  const int descriptor = fd();
+  if (descriptor < 0 || size == 0) {
+    return 0;
+  }
+  size_t written = 0;
+  while (written < size) {
+    const ssize_t n = send(descriptor, buffer + written, size - written, MSG_NOSIGNAL);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    written += static_cast<size_t>(n);
+  }
+  if (written > 0) {
+    socket_->replyDueMicros = native::elapsedMicros() + static_cast<uint64_t>(timeoutMs_) * 1000ULL;
+  }
+  return written;
+}
+
+int WiFiClient::availableForWrite() {
+  if (socket_ && socket_->loopback) {
+    return socket_->loopbackOpen ? 1460 : 0;
+  }
+  return fd() >= 0 ? 1460 : 0;
+}
+
+int WiFiClient::available() {
+  if (socket_ && socket_->loopback) {
+    return static_cast<int>(socket_->readable());
+  }
+  const int descriptor = fd();
+  int pending = 0;
+  if (descriptor < 0 || ioctl(descriptor, FIONREAD, &pending) != 0) {
+    return 0;
+  }
+  if (pending == 0) {
+    socket_->nothingToRead();
+  }
+  return pending;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+  if (socket_ && socket_->loopback) {
+    const size_t count = std::min(size, socket_->readable());
+    if (count == 0) {
+      return -1;
+    }
+    memcpy(buffer, socket_->exchange.response.data() + socket_->readPos, count);
+    socket_->readPos += count;
+    return static_cast<int>(count);
+  }
+  const int descriptor = fd();
+  if (descriptor < 0 || size == 0) {
+    return -1;
+  }
+  const ssize_t n = recv(descriptor, buffer, size, MSG_DONTWAIT);
+  if (n <= 0) {
+    socket_->nothingToRead();
+    return -1;
+  }
+  return static_cast<int>(n);
+}
+
+int WiFiClient::peek() {
+  if (socket_ && socket_->loopback) {
+    return socket_->readable() > 0 ? static_cast<uint8_t>(socket_->exchange.response[socket_->readPos]) : -1;
+  }
+  const int descriptor = fd();
+  uint8_t c;
+  if (descriptor < 0 || recv(descriptor, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+    return -1;
+  }
+  return c;
+}
+
+void WiFiClient::setNoDelay(bool enabled) {
+  const int descriptor = fd();
+  if (descriptor >= 0) {
+    const int value = enabled ? 1 : 0;
+    setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  sockaddr_in address{};
+  socklen_t length = sizeof(address);
+  if (fd() < 0 || getpeername(fd(), reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+    return IPAddress();
+  }
+  return IPAddress(address.sin_addr.s_addr);
+}
+
+int BearSSL::WiFiClientSecure::connect(const char *requestedHost, uint16_t requestedPort) {
+  if (native::loopbackHandler) {
+    return WiFiClient::connect(requestedHost, requestedPort);
+  }
+  const char *host = nullptr;
+  uint16_t port = 0;
+  if (!native::tlsEndpoint(host, port)) {
+    return 0;
+  }
+  return WiFiClient::connect(host, port);
+}
+
+// --- WiFiServer --------------------------------------------------------------------
+
+WiFiServer::~WiFiServer() { stop(); }
+
+void WiFiServer::begin() {
+  stop();
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return;
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(native::listenPort(port_));
+  if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, 4) != 0) {
+    fprintf(stderr, "[native] TCP port %u could not be opened: %s\n", native::listenPort(port_), strerror(errno));
+    ::close(fd);
+    return;
+  }
+  fd_ = fd;
+}
+
+void WiFiServer::stop() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+WiFiClient WiFiServer::accept() {
+  if (fd_ < 0) {
+    return WiFiClient();
+  }
+  const int fd = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+  return fd >= 0 ? WiFiClient(fd) : WiFiClient();
+}
+
+// --- WiFiUDP -------------------------------------------------------------------------
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  stop();
+  const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+    ::close(fd);
+    return 0;
+  }
+  receiveFd_ = fd;
+  return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress interfaceAddress, IPAddress group, uint16_t port) {
+  if (!begin(port)) {
+    return 0;
+  }
+  ip_mreq membership{};
+  membership.imr_multiaddr.s_addr = static_cast<uint32_t>(group);
+  membership.imr_interface.s_addr = static_cast<uint32_t>(interfaceAddress);
+  if (setsockopt(receiveFd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void WiFiUDP::stop() {
+  if (receiveFd_ >= 0) {
+    ::close(receiveFd_);
+    receiveFd_ = -1;
+  }
+  if (sendFd_ >= 0) {
+    ::close(sendFd_);
+    sendFd_ = -1;
+  }
+  received_.clear();
+  readPos_ = 0;
+}
+
+bool WiFiUDP::ensureSendSocket() {
+  if (sendFd_ < 0) {
+    sendFd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  }
+  return sendFd_ >= 0;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+  sockaddr_in address{};
+  if (!native::resolve(host, port, SOCK_DGRAM, address)) {
+    return 0;
+  }
+  return beginPacket(IPAddress(address.sin_addr.s_addr), port);
+}
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port) {
+  if (!native::wifiConnected() || !ensureSendSocket()) {
+    return 0;
+  }
+  destinationAddress_ = static_cast<uint32_t>(address);
+  destinationPort_ = port;
+  outgoing_.clear();
+  return 1;
+}
+
+int WiFiUDP::beginPacketMulticast(IPAddress group, uint16_t port, IPAddress interfaceAddress, int ttl) {
+  if (!beginPacket(group, port)) {
+    return 0;
+  }
+  in_addr interface{};
+  interface.s_addr = static_cast<uint32_t>(interfaceAddress);
+  const unsigned char hops = static_cast<unsigned char>(ttl);
+  const unsigned char loop = 1;  // Other processes on this host are the fleet
+  setsockopt(sendFd_, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+  setsockopt(sendFd_, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops));
+  setsockopt(sendFd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+  return 1;
+}
+
+int WiFiUDP::endPacket() {
+  if (sendFd_ < 0 || destinationPort_ == 0) {
+    return 0;
+  }
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = destinationAddress_;
+  address.sin_port = htons(destinationPort_);
+  const ssize_t n = sendto(sendFd_, outgoing_.data(), outgoing_.size(), 0, reinterpret_cast<sockaddr *>(&address),
+                           sizeof(address));
+  outgoing_.clear();
+  destinationPort_ = 0;
+  return n >= 0 ? 1 : 0;
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  if (destinationPort_ == 0) {
+    return 0;
+  }
+  outgoing_.append(reinterpret_cast<const char *>(buffer), size);
+  return size;
+}
+
+int WiFiUDP::parsePacket() {
+  received_.clear();
+  readPos_ = 0;
+  if (receiveFd_ < 0) {
+    return 0;
+  }
+  char buffer[2048];
+  sockaddr_in from{};
+  socklen_t length = sizeof(from);
+  const ssize_t n =
+      recvfrom(receiveFd_, buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&from), &length);
+  if (n <= 0) {
+    return 0;
+  }
+  received_.assign(buffer, static_cast<size_t>(n));
+  remoteIP_ = IPAddress(from.sin_addr.s_addr);
+  remotePort_ = ntohs(from.sin_port);
+  return static_cast<int>(n);
+}
+
+int WiFiUDP::read() { return readPos_ < received_.size() ? static_cast<uint8_t>(received_[readPos_++]) : -1; }
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+  const size_t count = std::min(size, received_.size() - readPos_);
+  memcpy(buffer, received_.data() + readPos_, count);
+  readPos_ += count;
+  return static_cast<int>(count);
+}
+
+int WiFiUDP::peek() { return readPos_ < received_.size() ? static_cast<uint8_t>(received_[readPos_]) : -1; }
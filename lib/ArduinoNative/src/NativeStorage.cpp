@@ -0,0 +1,203 @@
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <string>
+
+#include "EEPROM.h"
+#include "LittleFS.h"
+#include "NativeHost.h"
+
+EEPROMClass EEPROM;
+FS LittleFS;
+
+namespace {
+std::string eepromPath() { return std::string(native::stateDirectory()) + "/eeprom.bin"; }
+
+std::string littleFsRoot() { return std::string(native::stateDirectory()) + "/littlefs"; }
+
+std::string entryPath(const char *name) {
+  std::string path = littleFsRoot();
+  path += '/';
+  path += name;
+  return path;
+}
+}  // namespace
+
+// --- EEPROM ----------------------------------------------------------------------------
+
+bool EEPROMClass::begin(size_t size) {
+  data_.assign(size, 0xFF);
+  dirty_ = false;
+  FILE *file = fopen(eepromPath().c_str(), "rb");
+  if (file) {
+    const size_t n = fread(data_.data(), 1, size, file);
+    (void)n;  // A shorter image leaves the rest erased
+    fclose(file);
+  }
+  return true;
+}
+
+bool EEPROMClass::commit() {
+  if (!dirty_) {
+    return true;
+  }
+  FILE *file = fopen(eepromPath().c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  const bool ok = fwrite(data_.data(), 1, data_.size(), file) == data_.size();
+  fclose(file);
+  dirty_ = !ok;
+  return ok;
+}
+
+bool EEPROMClass::end() {
+  const bool ok = commit();
+  data_.clear();
+  return ok;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+  return address >= 0 && static_cast<size_t>(address) < data_.size() ? data_[static_cast<size_t>(address)] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && static_cast<size_t>(address) < data_.size() && data_[static_cast<size_t>(address)] != value) {
+    data_[static_cast<size_t>(address)] = value;
+    dirty_ = true;
+  }
+}
+
+// --- File ------------------------------------------------------------------------------
+
+File::File(FILE *file, const char *name) : file_(file, fclose), name_(name) {}
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  return file_ ? fwrite(buffer, 1, size, file_.get()) : 0;
+}
+
+int File::available() {
+  if (!file_) {
+    return 0;
+  }
+  const size_t total = size();
+  const size_t here = position();
+  return here < total ? static_cast<int>(total - here) : 0;
+}
+
+int File::read() { return file_ ? fgetc(file_.get()) : -1; }
+
+int File::read(uint8_t *buffer, size_t size) {
+  return file_ ? static_cast<int>(fread(buffer, 1, size, file_.get())) : -1;
+}
+
+int File::peek() {
+  if (!file_) {
+    return -1;
+  }
+  const int c = fgetc(file_.get());
+  if (c >= 0) {
+    ungetc(c, file_.get());
+  }
+  return c;
+}
+
+void File::flush() {
+  if (file_) {
+    fflush(file_.get());
+  }
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  const int whence = mode == SeekCur ? SEEK_CUR : mode == SeekEnd ? SEEK_END : SEEK_SET;
+  return file_ && fseek(file_.get(), static_cast<long>(position), whence) == 0;
+}
+
+size_t File::position() const {
+  const long here = file_ ? ftell(file_.get()) : -1;
+  return here < 0 ? 0 : static_cast<size_t>(here);
+}
+
+size_t File::size() const {
+  if (!file_) {
+    return 0;
+  }
+  fflush(file_.get());
+  struct stat status {};
+  return fstat(fileno(file_.get()), &status) == 0 ? static_cast<size_t>(status.st_size) : 0;
+}
+
+void File::close() { file_.reset(); }
+
+// --- FS --------------------------------------------------------------------------------
+
+std::string FS::hostPath(const char *path) const {
+  std::string result = littleFsRoot();
+  if (path && path[0] != '/') {
+    result += '/';
+  }
+  result += path ? path : "";
+  return result;
+}
+
+bool FS::begin() {
+  native::stateDirectory();
+  mkdir(littleFsRoot().c_str(), 0755);
+  struct stat status {};
+  mounted_ = stat(littleFsRoot().c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+  return mounted_;
+}
+
+bool FS::format() {
+  DIR *dir = opendir(littleFsRoot().c_str());
+  if (dir) {
+    while (dirent *entry = readdir(dir)) {
+      if (entry->d_type == DT_REG) {
+        ::remove(entryPath(entry->d_name).c_str());
+      }
+    }
+    closedir(dir);
+  }
+  return begin();
+}
+
+bool FS::info(FSInfo &info) {
+  if (!mounted_) {
+    return false;
+  }
+  info = FSInfo();
+  info.totalBytes = 2 * 1024 * 1024;
+  DIR *dir = opendir(littleFsRoot().c_str());
+  if (dir) {
+    while (dirent *entry = readdir(dir)) {
+      struct stat status {};
+      if (entry->d_type == DT_REG && stat(entryPath(entry->d_name).c_str(), &status) == 0) {
+        // LittleFS rounds every file up to whole blocks.
+        info.usedBytes += (static_cast<size_t>(status.st_size) + info.blockSize - 1) / info.blockSize * info.blockSize;
+      }
+    }
+    closedir(dir);
+  }
+  return true;
+}
+
+bool FS::exists(const char *path) {
+  struct stat status {};
+  return mounted_ && stat(hostPath(path).c_str(), &status) == 0;
+}
+
+File FS::open(const char *path, const char *mode) {
+  if (!mounted_ || !mode) {
+    return File();
+  }
+  std::string hostMode(mode);
+  hostMode += 'b';
+  FILE *file = fopen(hostPath(path).c_str(), hostMode.c_str());
+  return file ? File(file, path) : File();
+}
+
+bool FS::remove(const char *path) { return mounted_ && ::remove(hostPath(path).c_str()) == 0; }
+
+bool FS::rename(const char *from, const char *to) {
+  return mounted_ && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
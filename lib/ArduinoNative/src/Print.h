@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+class Print {
+public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) { return text ? write(reinterpret_cast<const uint8_t *>(text), strlen(text)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write(reinterpret_cast<const uint8_t *>(buffer), size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *text) { return write(reinterpret_cast<const char *>(text)); }
+  size_t print(const String &text) { return write(text.c_str(), text.length()); }
+  size_t print(const char *text) { return write(text); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(unsigned char value, int base = DEC_BASE) { return print(static_cast<unsigned long>(value), base); }
+  size_t print(int value, int base = DEC_BASE) { return print(static_cast<long>(value), base); }
+  size_t print(unsigned int value, int base = DEC_BASE) { return print(static_cast<unsigned long>(value), base); }
+  size_t print(long value, int base = DEC_BASE);
+  size_t print(unsigned long value, int base = DEC_BASE);
+  size_t print(long long value, int base = DEC_BASE);
+  size_t print(unsigned long long value, int base = DEC_BASE);
+  size_t print(double value, int decimals = 2);
+
+  template <typename T>
+  size_t println(const T &value) {
+    const size_t n = print(value);
+    return n + println();
+  }
+  size_t println(double value, int decimals) {
+    const size_t n = print(value, decimals);
+    return n + println();
+  }
+  size_t println() { return write("\r\n"); }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t printf_P(PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  static constexpr int DEC_BASE = 10;
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { timeoutMs_ = timeoutMs; }
+  unsigned long getTimeout() const { return timeoutMs_; }
+  // Waits up to the timeout for each byte, as the core does.
+  size_t readBytes(uint8_t *buffer, size_t size);
+  size_t readBytes(char *buffer, size_t size) { return readBytes(reinterpret_cast<uint8_t *>(buffer), size); }
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  int timedRead();
+
+  unsigned long timeoutMs_{1000};
+};
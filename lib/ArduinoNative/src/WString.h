@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+class __FlashStringHelper;
+
+// Arduino String on top of std::string. Conversions and formatting follow the
+// ESP8266 core (two decimals for floats, base argument for unsigned values).
+class String {
+public:
+  String() = default;
+  String(const char *text) : s_(text ? text : "") {}
+  String(const __FlashStringHelper *text) : String(reinterpret_cast<const char *>(text)) {}
+  String(const std::string &text) : s_(text) {}
+  explicit String(char c) : s_(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10) : String(static_cast<unsigned long>(value), base) {}
+  explicit String(int value, unsigned char base = 10) : String(static_cast<long>(value), base) {}
+  explicit String(unsigned int value, unsigned char base = 10) : String(static_cast<unsigned long>(value), base) {}
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(long long value) : s_(std::to_string(value)) {}
+  explicit String(unsigned long long value) : s_(std::to_string(value)) {}
+  explicit String(float value, unsigned char decimals = 2) : String(static_cast<double>(value), decimals) {}
+  explicit String(double value, unsigned char decimals = 2);
+
+  bool reserve(size_t size) {
+    s_.reserve(size);
+    return true;
+  }
+  size_t length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  const char *c_str() const { return s_.c_str(); }
+  const char *begin() const { return s_.c_str(); }
+  const char *end() const { return s_.c_str() + s_.size(); }
+  char charAt(size_t index) const { return index < s_.size() ? s_[index] : '\0'; }
+  char operator[](size_t index) const { return charAt(index); }
+  char &operator[](size_t index) { return s_[index]; }
+  void setCharAt(size_t index, char c) {
+    if (index < s_.size()) {
+      s_[index] = c;
+    }
+  }
+
+  bool concat(const String &other) {
+    s_ += other.s_;
+    return true;
+  }
+  bool concat(const char *text) {
+    if (text) {
+      s_ += text;
+    }
+    return text != nullptr;
+  }
+  bool concat(const char *text, size_t length) {
+    if (text) {
+      s_.append(text, length);
+    }
+    return text != nullptr;
+  }
+  bool concat(const __FlashStringHelper *text) { return concat(reinterpret_cast<const char *>(text)); }
+  bool concat(char c) {
+    s_ += c;
+    return true;
+  }
+  bool concat(unsigned char value) { return concat(String(value)); }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(long long value) { return concat(String(value)); }
+  bool concat(unsigned long long value) { return concat(String(value)); }
+  bool concat(float value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template <typename T>
+  String &operator+=(const T &value) {
+    concat(value);
+    return *this;
+  }
+
+  bool equals(const String &other) const { return s_ == other.s_; }
+  bool equals(const char *text) const { return text && s_ == text; }
+  bool operator==(const String &other) const { return equals(other); }
+  bool operator==(const char *text) const { return equals(text); }
+  bool operator==(const __FlashStringHelper *text) const { return equals(reinterpret_cast<const char *>(text)); }
+  bool operator!=(const String &other) const { return !equals(other); }
+  bool operator!=(const char *text) const { return !equals(text); }
+  bool operator<(const String &other) const { return s_ < other.s_; }
+  int compareTo(const String &other) const { return s_.compare(other.s_); }
+  bool equalsIgnoreCase(const String &other) const;
+
+  bool startsWith(const String &prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+  bool endsWith(const String &suffix) const {
+    return s_.size() >= suffix.s_.size() && s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const { return position(s_.find(c, from)); }
+  int indexOf(const String &text, unsigned int from = 0) const { return position(s_.find(text.s_, from)); }
+  int lastIndexOf(char c) const { return position(s_.rfind(c)); }
+  int lastIndexOf(const String &text) const { return position(s_.rfind(text.s_)); }
+  String substring(unsigned int from) const { return substring(from, static_cast<unsigned int>(s_.size())); }
+  String substring(unsigned int from, unsigned int to) const;
+
+  void remove(unsigned int index) {
+    if (index < s_.size()) {
+      s_.erase(index);
+    }
+  }
+  void remove(unsigned int index, unsigned int count) {
+    if (index < s_.size()) {
+      s_.erase(index, count);
+    }
+  }
+  void replace(const String &find, const String &replacement);
+  void replace(char find, char replacement);
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+  void clear() { s_.clear(); }
+
+  long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  double toDouble() const { return strtod(s_.c_str(), nullptr); }
+
+  const std::string &str() const { return s_; }
+
+private:
+  static int position(size_t index) { return index == std::string::npos ? -1 : static_cast<int>(index); }
+
+  std::string s_;
+};
+
+// Named by ArduinoJson's String adapter; the core's concatenation temporary.
+class StringSumHelper : public String {
+public:
+  using String::String;
+};
+
+template <typename T>
+String operator+(const String &lhs, const T &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+inline String operator+(const char *lhs, const String &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
+inline String operator+(const __FlashStringHelper *lhs, const String &rhs) {
+  String result(lhs);
+  result.concat(rhs);
+  return result;
+}
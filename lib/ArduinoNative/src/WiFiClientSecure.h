@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ESP8266WiFi.h"
+
+namespace BearSSL {
+
+class Session {};
+
+class X509List {
+public:
+  explicit X509List(const char *) {}
+};
+
+class PublicKey {
+public:
+  explicit PublicKey(const char *) {}
+};
+
+// No TLS on the host: connect() goes to the loopback handler when one is set,
+// else in plain TCP to native::tlsEndpoint() (a local fake server) whatever
+// host is asked for, and fails when neither is set.
+class WiFiClientSecure : public WiFiClient {
+public:
+  int connect(const char *host, uint16_t port) override;
+  using WiFiClient::connect;
+
+  void setInsecure() {}
+  void setKnownKey(const PublicKey *) {}
+  void setTrustAnchors(const X509List *) {}
+  void setFingerprint(const char *) {}
+  void setSession(Session *) {}
+  void setBufferSizes(int, int) {}
+  static bool probeMaxFragmentLength(const char *, uint16_t, uint16_t) { return false; }
+};
+
+}  // namespace BearSSL
+
+using BearSSL::WiFiClientSecure;
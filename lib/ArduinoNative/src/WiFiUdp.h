@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+#include "ESP8266WiFi.h"
+
+// Host UDP socket. Multicast joins on the given interface address, so several
+// native processes on one machine form a group over loopback.
+class WiFiUDP : public Stream {
+public:
+  WiFiUDP() = default;
+  WiFiUDP(const WiFiUDP &) = delete;
+  WiFiUDP &operator=(const WiFiUDP &) = delete;
+  ~WiFiUDP() override { stop(); }
+
+  uint8_t begin(uint16_t port);
+  uint8_t beginMulticast(IPAddress interfaceAddress, IPAddress group, uint16_t port);
+  void stop();
+
+  int beginPacket(const char *host, uint16_t port);
+  int beginPacket(IPAddress address, uint16_t port);
+  int beginPacketMulticast(IPAddress group, uint16_t port, IPAddress interfaceAddress, int ttl = 1);
+  int endPacket();
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  int parsePacket();
+  int available() override { return static_cast<int>(received_.size() - readPos_); }
+  int read() override;
+  int read(uint8_t *buffer, size_t size);
+  int read(char *buffer, size_t size) { return read(reinterpret_cast<uint8_t *>(buffer), size); }
+  int peek() override;
+  IPAddress remoteIP() const { return remoteIP_; }
+  uint16_t remotePort() const { return remotePort_; }
+
+private:
+  bool ensureSendSocket();
+
+  int receiveFd_{-1};
+  int sendFd_{-1};
+  uint32_t destinationAddress_{0};
+  uint16_t destinationPort_{0};
+  std::string outgoing_;
+  std::string received_;
+  size_t readPos_{0};
+  IPAddress remoteIP_;
+  uint16_t remotePort_{0};
+};
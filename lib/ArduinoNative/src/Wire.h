@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Arduino.h"
+
+// The only I2C device is the fake MLX90614, which does not go through the bus.
+class TwoWire {
+public:
+  void begin() {}
+  void begin(int sda, int scl) {
+    sda_ = sda;
+    scl_ = scl;
+  }
+  void setClock(uint32_t frequency) { frequency_ = frequency; }
+
+private:
+  int sda_{-1};
+  int scl_{-1};
+  uint32_t frequency_{100000};
+};
+
+extern TwoWire Wire;
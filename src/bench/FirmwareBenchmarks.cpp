@@ -0,0 +1,519 @@
+// Micro-benchmarks for the firmware hot paths. Built instead of main.cpp by the
+// nodemcu_bench and native_bench environments (see platformio.ini); prints one
+// Google Benchmark JSON document on the serial port / stdout at boot.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "bench/MicroBench.h"
+#include "config.h"
+#include "fleet/FleetNode.h"
+#include "history/HistoryStore.h"
+#include "metrics/MetricsServer.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
+#include "profiling/HeapMonitor.h"
+#include "protection/ProtectionController.h"
+#include "protection/ProtectionStorage.h"
+#include "sensor/MeasurementAggregator.h"
+#include "stream/SampleFrame.h"
+#include "telegram/FormBodyWriter.h"
+#include "telegram/MessageChunker.h"
+#include "telegram/TelegramCommandProcessor.h"
+#include "telegram/TelegramService.h"
+#include "timeseries/SeriesCodec.h"
+#include "timeseries/TimeSeriesLog.h"
+#include "trace/TraceFormat.h"
+
+#if !defined(ESP8266) && defined(HEAP_TRACK_CALL_SITES)
+#include <new>
+
+// libstdc++ allocates through its own malloc reference, which --wrap does not
+// reach; route operator new through this object so String growth is counted on
+// the host as it is on the device.
+void *operator new(size_t size) {
+  void *p = malloc(size);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+#endif
+
+namespace {
+constexpr unsigned long MIN_RUN_MS = 250;
+constexpr size_t TRACE_LENGTH = 64;
+constexpr uint32_t EXCURSION_PHASE = 32;  // Samples per phase of the excursion trace
+constexpr size_t CODEC_TRACE_POINTS = 512;  // About three 512 B blocks of real readings
+constexpr size_t RAW_POINT_BYTES = 8 + 4 + 4 + 1;  // Uncompressed SeriesPoint payload
+constexpr uint64_t CODEC_EPOCH_MS = 1700000000000ULL;
+constexpr size_t CODEC_DECODE_BLOCKS = 4;  // Encoded blocks kept for the decoder
+constexpr size_t SAMPLE_FRAMES = 64;       // Encoded stream frames the decoder cycles through
+
+protection::ProtectionSettings benchSettings{
+    config::OBJECT_TEMP_MIN_C,
+    config::OBJECT_TEMP_MAX_C,
+    config::OBJECT_TEMP_HYSTERESIS_C,
+    config::PROTECTION_MIN_SAMPLES,
+    config::PROTECTION_RENOTIFY_INTERVAL_MS,
+    config::TELEGRAM_REPORT_DEADBAND_C,
+    config::TELEGRAM_REPORT_MAX_SILENCE_MS,
+};
+
+// Same object graph as main.cpp, without the network, sensor and storage begin() calls.
+protection::ProtectionController protectionController(benchSettings);
+protection::ProtectionSettingsStorage protectionStorage;
+profiling::HeapMonitor heapMonitor;
+history::HistoryStore historyStore;
+timeseries::TimeSeriesLog timeSeriesLog;
+telegram::TelegramService telegramService;
+mqtt::MqttService mqttService;
+notify::NotificationBus notificationBus;  // No sinks: publish() only counts
+fleet::FleetNode fleetNode(notificationBus, telegramService);
+telegram::TelegramCommandProcessor commandProcessor(protectionController, protectionStorage, telegramService,
+                                                    heapMonitor, historyStore, timeSeriesLog, mqttService,
+                                                    notificationBus, fleetNode);
+
+sensor::MeasurementAggregator aggregator;
+sensor::MeasurementAggregator ambientAggregator;
+const metrics::MetricsSources metricsSources{protectionController, aggregator, ambientAggregator,
+                                             telegramService, mqttService, heapMonitor};
+float objectTrace[TRACE_LENGTH];
+sensor::MeasurementStats ambientStats;
+sensor::MeasurementStats objectStats;
+String reportText;
+volatile uint32_t sink = 0;
+
+// Time-series log input, stored compactly: 12 bytes a point instead of 24.
+struct CodecPoint {
+  uint32_t offsetMs;
+  int16_t objectCenti;
+  int16_t ambientCenti;
+  uint8_t flags;
+};
+
+struct CodecTrace {
+  CodecPoint points[CODEC_TRACE_POINTS];
+  size_t count = 0;
+  uint32_t spanMs = 0;  // Added on each pass so timestamps keep rising
+  bool recorded = false;
+};
+
+CodecTrace codecTrace;
+uint8_t codecBlock[config::TIMESERIES_BLOCK_BYTES];
+timeseries::BlockEncoder codecEncoder(codecBlock, sizeof(codecBlock));
+uint8_t codecDecodeBlocks[CODEC_DECODE_BLOCKS][config::TIMESERIES_BLOCK_BYTES];
+size_t codecDecodeLengths[CODEC_DECODE_BLOCKS];
+size_t codecDecodeCount = 0;
+size_t codecReadBlock = 0;
+timeseries::BlockDecoder codecDecoder(nullptr, 0);
+
+uint8_t sampleFrames[SAMPLE_FRAMES][stream::SAMPLE_FRAME_MAX_BYTES];
+size_t sampleFrameLengths[SAMPLE_FRAMES];
+String chunkerText;
+
+// A slow drift with sensor noise around the middle of the protection band.
+void buildTrace() {
+  const float middle = (config::OBJECT_TEMP_MIN_C + config::OBJECT_TEMP_MAX_C) * 0.5f;
+  for (size_t i = 0; i < TRACE_LENGTH; ++i) {
+    const float drift = 2.0f * sinf(static_cast<float>(i) * 6.2832f / TRACE_LENGTH);
+    const float noise = static_cast<float>(static_cast<int>((i * 37) % 11) - 5) * 0.02f;
+    objectTrace[i] = middle + drift + noise;
+  }
+  objectStats.min = middle - 2.0f;
+  objectStats.max = middle + 2.0f;
+  objectStats.average = middle;
+  objectStats.last = objectTrace[0];
+  objectStats.count = 13;
+  objectStats.coveredMs = objectStats.count * config::MEASUREMENT_INTERVAL_MS;
+  ambientStats = objectStats;
+  ambientStats.min = 21.40f;
+  ambientStats.max = 22.10f;
+  ambientStats.average = 21.75f;
+  ambientStats.last = 21.80f;
+}
+
+int16_t toCenti(float value) { return static_cast<int16_t>(lroundf(value * 100.0f)); }
+
+bool addCodecPoint(uint32_t offsetMs, float objectC, float ambientC, uint8_t flags) {
+  if (codecTrace.count >= CODEC_TRACE_POINTS) {
+    return false;
+  }
+  CodecPoint &point = codecTrace.points[codecTrace.count++];
+  point.offsetMs = offsetMs;
+  point.objectCenti = toCenti(objectC);
+  point.ambientCenti = toCenti(ambientC);
+  point.flags = flags;
+  codecTrace.spanMs = offsetMs + config::MEASUREMENT_INTERVAL_MS;
+  return true;
+}
+
+// Readings of one decision trace file (trace::TraceFormat) with the relay state
+// at the time, as main.cpp hands them to the time-series log.
+void loadTraceReadings(const char *path) {
+  File file = LittleFS.open(path, "r");
+  if (!file) {
+    return;
+  }
+  uint8_t frame[trace::TRACE_FRAME_MAX_BYTES];
+  uint8_t chunk[64];
+  size_t length = 0;
+  bool overlong = false;
+  uint8_t relays = 0;
+  uint32_t base = codecTrace.spanMs;
+  uint32_t lastUptime = 0;
+  int read = 0;
+  while (codecTrace.count < CODEC_TRACE_POINTS && (read = file.read(chunk, sizeof(chunk))) > 0) {
+    for (int i = 0; i < read; ++i) {
+      if (chunk[i] != 0) {
+        overlong |= length == sizeof(frame);
+        if (!overlong) {
+          frame[length++] = chunk[i];
+        }
+        continue;
+      }
+      trace::TraceRecord record;
+      const bool decoded = !overlong && length > 0 && trace::decodeRecord(frame, length, record);
+      length = 0;
+      overlong = false;
+      if (!decoded) {
+        continue;
+      }
+      if (record.uptimeMs < lastUptime) {
+        base += lastUptime;  // Reset: uptime starts over
+      }
+      lastUptime = record.uptimeMs;
+      if (record.type == trace::RecordType::Relays || record.type == trace::RecordType::Boot ||
+          record.type == trace::RecordType::Checkpoint || record.type == trace::RecordType::SafeState) {
+        relays = record.type == trace::RecordType::Relays ? record.flags : 0;
+      } else if (record.type == trace::RecordType::Reading && !(record.flags & trace::TRACE_READ_ERROR)) {
+        const uint8_t flags = (relays & trace::TRACE_HEATING ? history::HISTORY_HEATING : 0) |
+                              (relays & trace::TRACE_COOLING ? history::HISTORY_COOLING : 0);
+        addCodecPoint(base + record.uptimeMs, record.objectC, record.ambientC, flags);
+      }
+    }
+  }
+  file.close();
+}
+
+// A recorded trace on LittleFS (the board's own, or the --state directory of a
+// native run), so the codec sees real sensor noise and sampling jitter. Without
+// one a synthetic drift with noise stands in and the entry is named so.
+void buildCodecTrace() {
+  if (LittleFS.begin()) {
+    loadTraceReadings("/trace.1.bin");
+    loadTraceReadings("/trace.bin");
+  }
+  codecTrace.recorded = codecTrace.count > 0;
+  for (uint32_t i = 0; codecTrace.count < CODEC_TRACE_POINTS && !codecTrace.recorded; ++i) {
+    addCodecPoint(i * config::MEASUREMENT_INTERVAL_MS, objectTrace[i % TRACE_LENGTH], 21.75f, 0);
+  }
+}
+
+timeseries::SeriesPoint codecPoint(uint32_t i) {
+  const CodecPoint &stored = codecTrace.points[i % codecTrace.count];
+  timeseries::SeriesPoint point;
+  point.timestampMs = CODEC_EPOCH_MS + static_cast<uint64_t>(i / codecTrace.count) * codecTrace.spanMs + stored.offsetMs;
+  point.objectCenti = stored.objectCenti;
+  point.ambientCenti = stored.ambientCenti;
+  point.flags = stored.flags;
+  return point;
+}
+
+void keepCodecBlock() {
+  if (codecDecodeCount < CODEC_DECODE_BLOCKS) {
+    memcpy(codecDecodeBlocks[codecDecodeCount], codecBlock, codecEncoder.size());
+    codecDecodeLengths[codecDecodeCount++] = codecEncoder.size();
+  }
+}
+
+// One pass over the trace as the log writes it: bytes on flash per point, headers
+// included. The first blocks are kept for the decoder.
+float codecBytesPerPoint() {
+  uint32_t blocks = 1;
+  uint32_t bytes = 0;
+  codecEncoder.begin(0);
+  for (uint32_t i = 0; i < codecTrace.count; ++i) {
+    if (!codecEncoder.append(codecPoint(i))) {
+      keepCodecBlock();
+      bytes += codecEncoder.size();
+      codecEncoder.begin(blocks++);
+      codecEncoder.append(codecPoint(i));
+    }
+  }
+  keepCodecBlock();
+  bytes += codecEncoder.size();
+  return static_cast<float>(bytes) / static_cast<float>(codecTrace.count);
+}
+
+// TimeSeriesLog::append without the flash write: one point, a new block when full.
+void benchCodecAppend(uint32_t i, void *) {
+  const timeseries::SeriesPoint point = codecPoint(i);
+  if (!codecEncoder.append(point)) {
+    codecEncoder.begin(i);
+    codecEncoder.append(point);
+  }
+}
+
+// The read side of an export: one point, the next kept block when one runs out.
+void benchCodecDecode(uint32_t, void *) {
+  timeseries::SeriesPoint point;
+  while (!codecDecoder.next(point)) {
+    codecReadBlock = (codecReadBlock + 1) % codecDecodeCount;
+    codecDecoder = timeseries::BlockDecoder(codecDecodeBlocks[codecReadBlock], codecDecodeLengths[codecReadBlock]);
+  }
+  sink = sink + point.objectCenti;
+}
+
+// Stream input: zero bytes in the payload exercise the COBS path, so sweep through them.
+stream::SampleRecord sampleRecord(uint32_t i) {
+  stream::SampleRecord record;
+  record.sequence = static_cast<uint16_t>(i);
+  record.uptimeMs = 1000 + i * 10;
+  record.ambientCenti = static_cast<int16_t>(2000 + (i % 512));
+  record.objectCenti = static_cast<int16_t>(i % 7 == 0 ? stream::SAMPLE_INVALID_CENTI : -500 + (i % 9000));
+  record.flags = static_cast<uint8_t>(i & 0x03);
+  return record;
+}
+
+bool sameSampleRecord(const stream::SampleRecord &a, const stream::SampleRecord &b) {
+  return a.sequence == b.sequence && a.uptimeMs == b.uptimeMs && a.ambientCenti == b.ambientCenti &&
+         a.objectCenti == b.objectCenti && a.flags == b.flags;
+}
+
+// Encodes the frames the decoder reads and round-trips each of them; returns the
+// failures, counting a CRC that misses the CRC-16/CCITT-FALSE check value as one.
+uint32_t buildSampleFrames(float &bytesPerFrame) {
+  static const uint8_t CHECK[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  uint32_t failures = stream::crc16Ccitt(CHECK, sizeof(CHECK)) == 0x29B1 ? 0 : 1;
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < SAMPLE_FRAMES; ++i) {
+    sampleFrameLengths[i] = stream::encodeSampleFrame(sampleRecord(i), sampleFrames[i]);
+    stream::SampleRecord decoded;
+    if (sampleFrameLengths[i] > stream::SAMPLE_FRAME_MAX_BYTES ||
+        !stream::decodeSampleFrame(sampleFrames[i], sampleFrameLengths[i] - 1, decoded) ||
+        !sameSampleRecord(decoded, sampleRecord(i))) {
+      ++failures;
+    }
+    bytes += sampleFrameLengths[i];
+  }
+  bytesPerFrame = static_cast<float>(bytes) / SAMPLE_FRAMES;
+  return failures;
+}
+
+void benchSampleEncode(uint32_t i, void *) {
+  uint8_t frame[stream::SAMPLE_FRAME_MAX_BYTES];
+  sink = sink + stream::encodeSampleFrame(sampleRecord(i), frame);
+}
+
+void benchSampleDecode(uint32_t i, void *) {
+  const size_t frame = i % SAMPLE_FRAMES;
+  stream::SampleRecord record;
+  sink = sink + stream::decodeSampleFrame(sampleFrames[frame], sampleFrameLengths[frame] - 1, record);
+}
+
+void benchSampleCrc(uint32_t i, void *) {
+  sink = sink + stream::crc16Ccitt(sampleFrames[i % SAMPLE_FRAMES], stream::SAMPLE_PAYLOAD_BYTES - 2);
+}
+
+void benchAddSample(uint32_t i, void *) {
+  aggregator.addSample(objectTrace[i % TRACE_LENGTH], config::MEASUREMENT_INTERVAL_MS);
+}
+
+void benchProtectionSteady(uint32_t i, void *) {
+  sensor::MeasurementStats stats = objectStats;
+  stats.last = objectTrace[i % TRACE_LENGTH];
+  protectionController.handleProtection(stats, i * config::MEASUREMENT_INTERVAL_MS);
+}
+
+// Over the limit, back, under the limit, back: relays switch and alerts are
+// formatted and published once per phase.
+void benchProtectionExcursion(uint32_t i, void *) {
+  static const float PHASE_OFFSET_C[] = {1.5f, 0.0f, -1.5f, 0.0f};
+  const float middle = (config::OBJECT_TEMP_MIN_C + config::OBJECT_TEMP_MAX_C) * 0.5f;
+  const float offset = PHASE_OFFSET_C[(i / EXCURSION_PHASE) % 4];
+  sensor::MeasurementStats stats = objectStats;
+  if (offset > 0.0f) {
+    stats.last = config::OBJECT_TEMP_MAX_C + offset;
+  } else if (offset < 0.0f) {
+    stats.last = config::OBJECT_TEMP_MIN_C + offset;
+  } else {
+    stats.last = middle;
+  }
+  stats.average = stats.last;
+  protectionController.handleProtection(stats, i * config::MEASUREMENT_INTERVAL_MS);
+}
+
+void benchMeasurementReport(uint32_t, void *) {
+  const String report = protectionController.formatMeasurementReport(ambientStats, objectStats);
+  sink = sink + report.length();
+}
+
+class CountingPrint : public Print {
+public:
+  size_t write(uint8_t) override {
+    ++length;
+    return 1;
+  }
+  size_t write(const uint8_t *, size_t size) override {
+    length += size;
+    return size;
+  }
+
+  size_t length = 0;
+};
+
+// The sendMessage body: chat_id plus the percent-encoded report text.
+void benchFormEncode(uint32_t, void *) {
+  CountingPrint out;
+  telegram::FormBodyWriter body(out);
+  body.field("chat_id", config::TELEGRAM_ALERT_CHAT_ID, strlen(config::TELEGRAM_ALERT_CHAT_ID));
+  body.field("text", reportText.c_str(), reportText.length());
+  body.finish();
+  sink = sink + body.written();
+}
+
+// Reports joined until they pass the message limit, split as sendMessage does.
+void buildChunkerText() {
+  chunkerText.reserve(config::TELEGRAM_MAX_MESSAGE_UNITS + reportText.length() + 1);
+  while (chunkerText.length() <= config::TELEGRAM_MAX_MESSAGE_UNITS) {
+    chunkerText += reportText;
+    chunkerText += '\n';
+  }
+}
+
+size_t chunkText() {
+  telegram::MessageChunker chunker(chunkerText.c_str(), chunkerText.length(), config::TELEGRAM_MAX_MESSAGE_UNITS);
+  telegram::TextSpan span;
+  size_t spans = 0;
+  while (chunker.next(span)) {
+    ++spans;
+  }
+  return spans;
+}
+
+void benchChunker(uint32_t, void *) { sink = sink + chunkText(); }
+
+// A whole /metrics scrape through PrometheusWriter, without the socket.
+size_t writeMetricsPage() {
+  CountingPrint out;
+  metrics::writeMetrics(metricsSources, out);
+  return out.length;
+}
+
+void benchMetricsPage(uint32_t, void *) { sink = sink + writeMetricsPage(); }
+
+void collectReply(const String &text, void *) { sink = sink + text.length(); }
+
+void benchCommand(uint32_t i, void *context) {
+  const String &command = *static_cast<const String *>(context);
+  commandProcessor.processCommand(command, i * config::MEASUREMENT_INTERVAL_MS, objectStats, collectReply, nullptr);
+}
+
+// Tokenizer input: the longest shapes a command takes.
+const char *const TOKENIZER_INPUTS[] = {
+    "set hysteresis 1.5",
+    "  export 6h   csv ",
+    "@kulucka-2 set minsamples 12",
+    "history 2d",
+};
+constexpr size_t TOKENIZER_INPUT_COUNT = sizeof(TOKENIZER_INPUTS) / sizeof(TOKENIZER_INPUTS[0]);
+size_t tokenizerInputLengths[TOKENIZER_INPUT_COUNT];
+
+void benchTokenize(uint32_t i, void *) {
+  const size_t input = i % TOKENIZER_INPUT_COUNT;
+  telegram::CommandTokenizer args(TOKENIZER_INPUTS[input], tokenizerInputLengths[input]);
+  telegram::CommandToken token;
+  uint32_t hashes = 0;
+  while (args.next(token)) {
+    hashes ^= telegram::CommandTokenizer::hash(token);
+  }
+  sink = sink + hashes;
+}
+
+// Dispatch throughput: every command table entry and every set key is matched,
+// each rejected with a fixed catalog reply so no report is formatted.
+String dispatchCommands[] = {
+    String(F("history 5x")),        String(F("export soon")),      String(F("export 6h pdf")),
+    String(F("stream maybe")),      String(F("trace maybe")),      String(F("fleet")),
+    String(F("set min 22,5")),      String(F("set max x")),        String(F("set hysteresis -")),
+    String(F("set minsamples 1.5")), String(F("set renotify 1.5")), String(F("set deadband x")),
+    String(F("set silence 1.5")),   String(F("set color 3")),      String(F("config now")),
+    String(F("heap 1")),            String(F("stats 1")),
+};
+constexpr size_t DISPATCH_COMMAND_COUNT = sizeof(dispatchCommands) / sizeof(dispatchCommands[0]);
+
+void benchDispatch(uint32_t i, void *) {
+  commandProcessor.processCommand(dispatchCommands[i % DISPATCH_COMMAND_COUNT], i * config::MEASUREMENT_INTERVAL_MS,
+                                  objectStats, collectReply, nullptr);
+}
+
+String configCommand(F("config"));
+String invalidSetCommand(F("set hyst 1,5x"));
+String unknownCommand(F("durum nedir"));
+}  // namespace
+
+void setup() {
+  Serial.begin(115200);
+  delay(200);
+  Serial.println();
+  buildTrace();
+  protectionController.initializeHardware();
+  protectionController.setNotificationBus(&notificationBus);
+  reportText = protectionController.formatMeasurementReport(ambientStats, objectStats);
+  buildCodecTrace();
+  const float codecBytes = codecBytesPerPoint();
+  codecDecoder = timeseries::BlockDecoder(codecDecodeBlocks[0], codecDecodeLengths[0]);
+  float sampleFrameBytes = 0.0f;
+  const uint32_t sampleFailures = buildSampleFrames(sampleFrameBytes);
+  buildChunkerText();
+  for (size_t i = 0; i < TRACE_LENGTH; ++i) {
+    ambientAggregator.addSample(ambientStats.average, config::MEASUREMENT_INTERVAL_MS);
+  }
+
+  bench::MicroBench runner(Serial, MIN_RUN_MS);
+  runner.begin("tastan09_bench");
+  runner.run("MeasurementAggregator/addSample", benchAddSample, nullptr);
+  runner.run("ProtectionController/handleProtection/steady", benchProtectionSteady, nullptr);
+  runner.run("ProtectionController/handleProtection/excursion", benchProtectionExcursion, nullptr);
+  runner.run("ProtectionController/formatMeasurementReport", benchMeasurementReport, nullptr);
+  runner.run("FormBodyWriter/sendMessage_report", benchFormEncode, nullptr);
+  runner.counter("text_bytes", static_cast<float>(chunkerText.length()));
+  runner.counter("spans", static_cast<float>(chunkText()));
+  runner.run("MessageChunker/split/long_reply", benchChunker, nullptr);
+  runner.counter("page_bytes", static_cast<float>(writeMetricsPage()));
+  runner.run("PrometheusWriter/metrics_page", benchMetricsPage, nullptr);
+  runner.run("TelegramCommandProcessor/processCommand/config", benchCommand, &configCommand);
+  runner.run("TelegramCommandProcessor/processCommand/set_invalid", benchCommand, &invalidSetCommand);
+  runner.run("TelegramCommandProcessor/processCommand/unknown", benchCommand, &unknownCommand);
+  for (size_t i = 0; i < TOKENIZER_INPUT_COUNT; ++i) {
+    tokenizerInputLengths[i] = strlen(TOKENIZER_INPUTS[i]);
+  }
+  runner.run("CommandTokenizer/split_and_hash", benchTokenize, nullptr);
+  runner.run("TelegramCommandProcessor/dispatch/rejections", benchDispatch, nullptr);
+  runner.counter("trace_points", static_cast<float>(codecTrace.count));
+  runner.counter("bytes_per_point", codecBytes);
+  runner.counter("compression_ratio", RAW_POINT_BYTES / codecBytes);
+  codecEncoder.begin(0);
+  runner.run(codecTrace.recorded ? "SeriesCodec/append/recorded_trace" : "SeriesCodec/append/synthetic_trace",
+             benchCodecAppend, nullptr);
+  runner.counter("blocks", static_cast<float>(codecDecodeCount));
+  runner.run(codecTrace.recorded ? "SeriesCodec/decode/recorded_trace" : "SeriesCodec/decode/synthetic_trace",
+             benchCodecDecode, nullptr);
+  runner.counter("bytes_per_frame", sampleFrameBytes);
+  runner.counter("round_trip_failures", static_cast<float>(sampleFailures));
+  runner.run("SampleFrame/encode", benchSampleEncode, nullptr);
+  runner.run("SampleFrame/decode", benchSampleDecode, nullptr);
+  runner.run("SampleFrame/crc16/payload", benchSampleCrc, nullptr);
+  runner.end();
+}
+
+void loop() {
+#if defined(ESP8266)
+  delay(1000);  // Results stay on the monitor; reset the board to run again
+#else
+  exit(0);
+#endif
+}
@@ -0,0 +1,142 @@
+#include "bench/MicroBench.h"
+
+#include <stdarg.h>
+
+#include "profiling/AllocationTracker.h"
+
+#if !defined(ESP8266) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define BENCH_CYCLES_TSC 1
+#endif
+
+namespace bench {
+namespace {
+constexpr uint32_t MAX_ITERATIONS = 1UL << 24;
+constexpr uint32_t MAX_GROWTH = 10;
+constexpr size_t LINE_MAX_BYTES = 448;
+
+#if defined(ESP8266)
+const char PLATFORM[] = "esp8266";
+#else
+const char PLATFORM[] = "native";
+#endif
+
+// CCOUNT on the device. On an x86 host the native core only models an 80 MHz
+// counter from the clock, so the time-stamp counter is read instead.
+#if defined(BENCH_CYCLES_TSC)
+const char CYCLE_SOURCE[] = "tsc";
+uint64_t readCycles() { return __rdtsc(); }
+#else
+const char CYCLE_SOURCE[] = "ccount";
+uint32_t readCycles() { return ESP.getCycleCount(); }
+#endif
+
+uint32_t cyclesPerMicrosecond() {
+#if defined(BENCH_CYCLES_TSC)
+  const uint64_t startCycles = readCycles();
+  const uint32_t startMicros = micros();
+  delay(50);
+  return static_cast<uint32_t>((readCycles() - startCycles) / (micros() - startMicros));
+#else
+  return ESP.getCpuFreqMHz();
+#endif
+}
+}  // namespace
+
+void MicroBench::emit(PGM_P format, ...) {
+  char line[LINE_MAX_BYTES];
+  va_list args;
+  va_start(args, format);
+  const int length = vsnprintf_P(line, sizeof(line), format, args);
+  va_end(args);
+  if (length > 0) {
+    out_.write(reinterpret_cast<const uint8_t *>(line),
+               static_cast<size_t>(length) < sizeof(line) ? static_cast<size_t>(length) : sizeof(line) - 1);
+  }
+}
+
+void MicroBench::begin(const char *executable) {
+  written_ = 0;
+  out_.print(F("{\n  \"context\": {\n"));
+  emit(PSTR("    \"executable\": \"%s\",\n"), executable);
+  emit(PSTR("    \"platform\": \"%s\",\n"), PLATFORM);
+  emit(PSTR("    \"build\": \"%s %s\",\n"), __DATE__, __TIME__);
+  emit(PSTR("    \"num_cpus\": 1,\n    \"mhz_per_cpu\": %lu,\n"),
+                static_cast<unsigned long>(cyclesPerMicrosecond()));
+  emit(PSTR("    \"cycle_counter\": \"%s\",\n"), CYCLE_SOURCE);
+  emit(PSTR("    \"allocation_tracking\": %s,\n"),
+                profiling::allocationTrackingEnabled() ? "true" : "false");
+  emit(PSTR("    \"min_run_ms\": %lu,\n"), minRunMs_);
+  out_.print(F("    \"library_build_type\": \"release\"\n  },\n  \"benchmarks\": ["));
+}
+
+void MicroBench::counter(const char *name, float value) {
+  if (counters_ < MAX_COUNTERS) {
+    counterNames_[counters_] = name;
+    counterValues_[counters_] = value;
+    ++counters_;
+  }
+}
+
+BenchResult MicroBench::run(const char *name, BenchBody body, void *context) {
+  body(0, context);  // Warm-up: first-call allocations and cache fill stay out of the numbers
+
+  const uint32_t minRunUs = static_cast<uint32_t>(minRunMs_) * 1000UL;
+  uint32_t iterations = 1;
+  Sample sample = measure(body, context, iterations);
+  while (sample.micros < minRunUs && iterations < MAX_ITERATIONS) {
+    // Aim 40% past the target so the next batch normally finishes the search.
+    uint32_t growth = MAX_GROWTH;
+    if (sample.micros > 0) {
+      const uint32_t predicted = static_cast<uint32_t>(1.4f * minRunUs / sample.micros) + 1;
+      growth = predicted < 2 ? 2 : predicted > MAX_GROWTH ? MAX_GROWTH : predicted;
+    }
+    iterations = iterations * growth > MAX_ITERATIONS ? MAX_ITERATIONS : iterations * growth;
+    yield();
+    sample = measure(body, context, iterations);
+  }
+
+  BenchResult result;
+  result.iterations = iterations;
+  result.nsPerOp = sample.micros * 1000.0f / iterations;
+  result.cyclesPerOp = static_cast<float>(sample.cycles) / iterations;
+  result.allocationsPerOp = static_cast<float>(sample.allocations) / iterations;
+  result.bytesPerOp = static_cast<float>(sample.bytes) / iterations;
+  write(name, result);
+  return result;
+}
+
+void MicroBench::end() { out_.print(F("\n  ]\n}\n")); }
+
+MicroBench::Sample MicroBench::measure(BenchBody body, void *context, uint32_t iterations) {
+  const uint32_t allocations = profiling::allocationCalls();
+  const uint32_t bytes = profiling::allocatedBytes();
+  const auto startCycles = readCycles();
+  const uint32_t startMicros = micros();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    body(i, context);
+  }
+  Sample sample;
+  sample.micros = micros() - startMicros;
+  sample.cycles = static_cast<uint64_t>(readCycles() - startCycles);
+  sample.allocations = profiling::allocationCalls() - allocations;
+  sample.bytes = profiling::allocatedBytes() - bytes;
+  return sample;
+}
+
+void MicroBench::write(const char *name, const BenchResult &result) {
+  out_.print(written_++ == 0 ? F("\n") : F(",\n"));
+  emit(PSTR("    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                     "\"iterations\": %lu, \"real_time\": %.1f, \"cpu_time\": %.1f, \"time_unit\": \"ns\", "
+                     "\"cycles_per_iteration\": %.1f, \"allocs_per_iteration\": %.2f, "
+                     "\"bytes_per_iteration\": %.1f"),
+                name, name, static_cast<unsigned long>(result.iterations), result.nsPerOp, result.nsPerOp,
+                result.cyclesPerOp, result.allocationsPerOp, result.bytesPerOp);
+  for (size_t i = 0; i < counters_; ++i) {
+    emit(PSTR(", \"%s\": %.3f"), counterNames_[i], counterValues_[i]);
+  }
+  counters_ = 0;
+  out_.print('}');
+}
+
+}  // namespace bench
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace bench {
+
+// Body of one benchmark; iteration counts up from 0 within a batch so bodies
+// can walk through a table of inputs.
+using BenchBody = void (*)(uint32_t iteration, void *context);
+
+struct BenchResult {
+  uint32_t iterations = 0;
+  float nsPerOp = 0.0f;
+  float cyclesPerOp = 0.0f;
+  float allocationsPerOp = 0.0f;  // Needs HEAP_TRACK_CALL_SITES; 0 otherwise
+  float bytesPerOp = 0.0f;
+};
+
+// Runs bodies in growing batches until one batch lasts at least minRunMs, then
+// writes the result as an entry of a Google Benchmark JSON document, so the
+// same tooling reads host and device runs. Times come from micros(), cycles
+// from CCOUNT on the device (32-bit, so a batch must stay well under 53 s) and
+// from the time-stamp counter on an x86 host.
+class MicroBench {
+public:
+  MicroBench(Print &out, unsigned long minRunMs) : out_(out), minRunMs_(minRunMs) {}
+
+  void begin(const char *executable);
+  // Adds a user counter to the next run() entry, like Google Benchmark's
+  // state.counters; name must outlive that call.
+  void counter(const char *name, float value);
+  BenchResult run(const char *name, BenchBody body, void *context);
+  void end();
+
+private:
+  struct Sample {
+    uint32_t micros;
+    uint64_t cycles;
+    uint32_t allocations;
+    uint32_t bytes;
+  };
+
+  static Sample measure(BenchBody body, void *context, uint32_t iterations);
+  void write(const char *name, const BenchResult &result);
+  void emit(PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+
+  static constexpr size_t MAX_COUNTERS = 4;
+
+  Print &out_;
+  unsigned long minRunMs_;
+  size_t written_{0};
+  const char *counterNames_[MAX_COUNTERS] = {};
+  float counterValues_[MAX_COUNTERS] = {};
+  size_t counters_{0};
+};
+
+}  // namespace bench
@@ -0,0 +1,272 @@
+#include "e2e/FakeTelegramApi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace e2e {
+namespace {
+constexpr char API_HOST[] = "api.telegram.org";
+constexpr size_t OVERSIZED_BODY_BYTES = 6144;
+
+std::string jsonEscape(const std::string &text) {
+  std::string escaped;
+  escaped.reserve(text.size() + 8);
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string urlDecode(const std::string &text) {
+  std::string decoded;
+  decoded.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size()) {
+      decoded += static_cast<char>(strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+// Value of `key` in an "a=1&b=2" list, decoded; empty when missing.
+std::string formValue(const std::string &form, const char *key) {
+  const std::string prefix = std::string(key) + "=";
+  size_t start = 0;
+  while (start <= form.size()) {
+    size_t end = form.find('&', start);
+    if (end == std::string::npos) {
+      end = form.size();
+    }
+    if (form.compare(start, prefix.size(), prefix) == 0) {
+      return urlDecode(form.substr(start + prefix.size(), end - start - prefix.size()));
+    }
+    start = end + 1;
+  }
+  return std::string();
+}
+
+const char *reasonPhrase(int status) {
+  switch (status) {
+    case 200:
+      return "OK";
+    case 429:
+      return "Too Many Requests";
+    default:
+      return "Not Found";
+  }
+}
+}  // namespace
+
+void FakeTelegramApi::install() { native::setLoopbackHandler(onLoopback, this); }
+
+long FakeTelegramApi::injectMessage(const char *chatId, const char *text) {
+  updates_.push_back({nextUpdateId_, chatId, text, 0});
+  return nextUpdateId_++;
+}
+
+unsigned long FakeTelegramApi::polledAtMs(long updateId) const {
+  for (const Update &update : updates_) {
+    if (update.id == updateId) {
+      return update.polledMs;
+    }
+  }
+  return 0;
+}
+
+bool FakeTelegramApi::faultsArmed() const { return static_cast<long>(millis() - plan_.fromMs) >= 0; }
+
+bool FakeTelegramApi::onLoopback(const char *host, uint16_t, native::LoopbackEvent event,
+                                 native::LoopbackExchange &exchange, void *context) {
+  FakeTelegramApi &api = *static_cast<FakeTelegramApi *>(context);
+  if (strcmp(host, API_HOST) != 0) {
+    return false;  // MQTT and other peers stay unreachable
+  }
+  if (event == native::LoopbackEvent::Connect) {
+    ++api.counters_.connects;
+    if (api.faultsArmed() && api.plan_.refusedConnects > 0) {
+      --api.plan_.refusedConnects;
+      ++api.counters_.refused;
+      return false;
+    }
+    exchange.connectDelayMs = api.plan_.connectMs;
+    api.uploadSeenBytes_ = 0;
+    return true;
+  }
+  return api.accept(exchange);
+}
+
+// Waits for a complete request (Content-Length or chunked body), then answers it.
+bool FakeTelegramApi::accept(native::LoopbackExchange &exchange) {
+  const std::string &request = exchange.request;
+  if (!exchange.response.empty()) {
+    return true;
+  }
+  const size_t headEnd = request.find("\r\n\r\n");
+  if (headEnd == std::string::npos) {
+    return true;
+  }
+  const std::string head = request.substr(0, headEnd);
+  const size_t bodyStart = headEnd + 4;
+  if (head.find("Transfer-Encoding: chunked") != std::string::npos) {
+    if (uploadSeenBytes_ == 0) {
+      ++counters_.uploads;
+      if (firstUploadMs_ == 0) {
+        firstUploadMs_ = millis();
+      }
+    }
+    if (plan_.uploadBytesPerS > 0 && request.size() > uploadSeenBytes_) {
+      const uint64_t newBytes = request.size() - uploadSeenBytes_;
+      native::advanceMicros(newBytes * 1000000ULL / plan_.uploadBytesPerS);
+    }
+    uploadSeenBytes_ = request.size();
+    if (request.size() < bodyStart + 5 || request.compare(request.size() - 5, 5, "0\r\n\r\n") != 0) {
+      return true;
+    }
+  } else {
+    const size_t lengthAt = head.find("Content-Length:");
+    const size_t length = lengthAt == std::string::npos ? 0 : strtoul(head.c_str() + lengthAt + 15, nullptr, 10);
+    if (request.size() - bodyStart < length) {
+      return true;
+    }
+  }
+
+  // "POST /bot<token>/sendMessage HTTP/1.1" -> "sendMessage"
+  const size_t targetStart = head.find(' ') + 1;
+  const size_t targetEnd = head.find(' ', targetStart);
+  const std::string target = head.substr(targetStart, targetEnd - targetStart);
+  const size_t methodStart = target.find('/', 1) + 1;
+  const std::string method = target.substr(methodStart, target.find('?') - methodStart);
+  if (method == "getUpdates") {
+    handleGetUpdates(exchange, target);
+  } else if (method == "sendMessage" || method == "editMessageText" || method == "sendDocument") {
+    handleSend(exchange, method, request.substr(bodyStart));
+  } else {
+    answer(exchange, 404, "{\"ok\":false,\"error_code\":404,\"description\":\"Not Found\"}", plan_.sendLatencyMs);
+  }
+  return true;
+}
+
+void FakeTelegramApi::answer(native::LoopbackExchange &exchange, int status, const std::string &body,
+                             unsigned long latencyMs) {
+  char head[160];
+  snprintf(head, sizeof(head),
+           "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+           status, reasonPhrase(status), static_cast<unsigned>(body.size()));
+  exchange.response = head;
+  exchange.response += body;
+  exchange.readyAtMs = millis() + latencyMs;
+}
+
+void FakeTelegramApi::handleGetUpdates(native::LoopbackExchange &exchange, const std::string &target) {
+  ++counters_.polls;
+  if (static_cast<long>(millis() - pollsBlockedUntil_) < 0) {
+    ++counters_.earlyPolls;
+  }
+  if (faultsArmed() && plan_.throttledPolls > 0) {
+    --plan_.throttledPolls;
+    ++counters_.throttled;
+    char reply[160];
+    snprintf(reply, sizeof(reply),
+             "{\"ok\":false,\"error_code\":429,\"description\":\"Too Many Requests: retry after %u\","
+             "\"parameters\":{\"retry_after\":%u}}",
+             plan_.retryAfterS, plan_.retryAfterS);
+    answer(exchange, 429, reply, plan_.pollLatencyMs);
+    pollsBlockedUntil_ = exchange.readyAtMs + plan_.retryAfterS * 1000UL;
+    return;
+  }
+  if (faultsArmed() && plan_.hungPolls > 0) {
+    --plan_.hungPolls;
+    ++counters_.hung;
+    return;
+  }
+  const size_t query = target.find('?');
+  const long offset = query == std::string::npos ? 0 : atol(formValue(target.substr(query + 1), "offset").c_str());
+
+  std::string body = "{\"ok\":true,\"result\":[";
+  std::vector<Update *> carried;
+  for (Update &update : updates_) {
+    if (update.id < offset) {
+      continue;  // Confirmed by the client
+    }
+    if (!carried.empty()) {
+      body += ',';
+    }
+    char prefix[96];
+    snprintf(prefix, sizeof(prefix), "{\"update_id\":%ld,\"message\":{\"message_id\":%ld,\"date\":%lu,\"chat\":{\"id\":",
+             update.id, nextMessageId_++, millis() / 1000UL);
+    body += prefix;
+    body += update.chatId;
+    body += ",\"type\":\"group\"},\"text\":\"";
+    body += jsonEscape(update.text);
+    body += "\"}}";
+    carried.push_back(&update);
+  }
+  body += "]}";
+
+  const bool oversized = faultsArmed() && plan_.oversizedPolls > 0;
+  if (oversized) {
+    --plan_.oversizedPolls;
+    ++counters_.oversized;
+    body.append(OVERSIZED_BODY_BYTES > body.size() ? OVERSIZED_BODY_BYTES - body.size() : 0, ' ');
+  }
+  answer(exchange, 200, body, plan_.pollLatencyMs);
+  if (oversized) {
+    return;  // Dropped by the client, so these updates come again
+  }
+  for (Update *update : carried) {
+    if (update->polledMs == 0) {
+      update->polledMs = exchange.readyAtMs;
+    }
+  }
+}
+
+void FakeTelegramApi::handleSend(native::LoopbackExchange &exchange, const std::string &method,
+                                 const std::string &body) {
+  ++counters_.sends;
+  SentMessage message;
+  message.method = method;
+  message.receivedMs = millis();
+  if (method != "sendDocument") {
+    message.chatId = formValue(body, "chat_id");
+    message.text = formValue(body, "text");
+  }
+
+  if (faultsArmed() && plan_.hungSends > 0) {
+    --plan_.hungSends;
+    ++counters_.hung;
+    messages_.push_back(message);
+    return;
+  }
+  char reply[160];
+  if (faultsArmed() && plan_.throttledSends > 0) {
+    --plan_.throttledSends;
+    ++counters_.throttled;
+    message.status = 429;
+    snprintf(reply, sizeof(reply),
+             "{\"ok\":false,\"error_code\":429,\"description\":\"Too Many Requests: retry after %u\","
+             "\"parameters\":{\"retry_after\":%u}}",
+             plan_.retryAfterS, plan_.retryAfterS);
+  } else {
+    message.status = 200;
+    snprintf(reply, sizeof(reply), "{\"ok\":true,\"result\":{\"message_id\":%ld,\"date\":%lu,\"chat\":{\"id\":%s}}}",
+             nextMessageId_++, millis() / 1000UL, message.chatId.empty() ? "0" : message.chatId.c_str());
+  }
+  answer(exchange, message.status, reply, plan_.sendLatencyMs);
+  message.answeredMs = exchange.readyAtMs;
+  messages_.push_back(message);
+}
+
+}  // namespace e2e
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <NativeHost.h>
+
+#include <string>
+#include <vector>
+
+namespace e2e {
+
+// Faults the fake injects. Latencies apply to every request; the counted
+// faults are used up by the first matching requests at or after fromMs.
+struct FaultPlan {
+  unsigned long connectMs = 250;     // TCP + TLS handshake
+  unsigned long sendLatencyMs = 120;  // sendMessage / editMessageText / sendDocument answer
+  unsigned long pollLatencyMs = 100;  // getUpdates answer
+  unsigned long fromMs = 0;
+  uint8_t refusedConnects = 0;
+  uint8_t throttledSends = 0;  // Answered 429 with retry_after = retryAfterS
+  uint8_t retryAfterS = 5;
+  uint8_t hungSends = 0;  // Never answered; the client runs into its timeout
+  uint8_t hungPolls = 0;
+  uint8_t throttledPolls = 0;  // getUpdates answered 429 with retry_after = retryAfterS
+  uint8_t oversizedPolls = 0;  // Valid answer padded past TelegramService's JSON limit
+  uint16_t uploadBytesPerS = 0;  // Non-zero: chunked bodies (sendDocument) advance the clock like a slow uplink
+};
+
+struct ApiCounters {
+  uint32_t connects = 0;
+  uint32_t refused = 0;
+  uint32_t polls = 0;
+  uint32_t sends = 0;
+  uint32_t throttled = 0;
+  uint32_t hung = 0;
+  uint32_t oversized = 0;
+  uint32_t uploads = 0;  // sendDocument requests begun, answered or not
+  uint32_t earlyPolls = 0;  // getUpdates that arrived before a 429's retry_after ran out
+};
+
+// A sendMessage / editMessageText the fake received.
+struct SentMessage {
+  std::string method;
+  std::string chatId;
+  std::string text;
+  unsigned long receivedMs = 0;
+  unsigned long answeredMs = 0;  // When the answer became readable; 0 while hung
+  int status = 0;
+};
+
+// Bot API stand-in behind native::setLoopbackHandler(): answers getUpdates
+// from an injected message queue and records every message the firmware
+// sends, with the virtual times it arrived and was answered.
+class FakeTelegramApi {
+public:
+  explicit FakeTelegramApi(const FaultPlan &plan) : plan_(plan) {}
+
+  void install();
+  // Queues a chat message for getUpdates; returns its update_id.
+  long injectMessage(const char *chatId, const char *text);
+  // When the first getUpdates answer that the firmware can use carried the
+  // update; 0 if none did yet.
+  unsigned long polledAtMs(long updateId) const;
+  // When the first sendDocument request began; 0 if none did.
+  unsigned long firstUploadMs() const { return firstUploadMs_; }
+
+  const std::vector<SentMessage> &messages() const { return messages_; }
+  const ApiCounters &counters() const { return counters_; }
+
+private:
+  struct Update {
+    long id;
+    std::string chatId;
+    std::string text;
+    unsigned long polledMs;
+  };
+
+  static bool onLoopback(const char *host, uint16_t port, native::LoopbackEvent event,
+                         native::LoopbackExchange &exchange, void *context);
+  bool accept(native::LoopbackExchange &exchange);
+  void answer(native::LoopbackExchange &exchange, int status, const std::string &body, unsigned long latencyMs);
+  void handleGetUpdates(native::LoopbackExchange &exchange, const std::string &target);
+  void handleSend(native::LoopbackExchange &exchange, const std::string &method, const std::string &body);
+  bool faultsArmed() const;
+
+  FaultPlan plan_;
+  ApiCounters counters_;
+  std::vector<Update> updates_;
+  std::vector<SentMessage> messages_;
+  long nextUpdateId_{100};
+  long nextMessageId_{1};
+  size_t uploadSeenBytes_{0};  // Of the current chunked request, already paid for in uplink time
+  unsigned long firstUploadMs_{0};
+  unsigned long pollsBlockedUntil_{0};  // Set by a throttled getUpdates
+};
+
+}  // namespace e2e
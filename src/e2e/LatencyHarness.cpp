@@ -0,0 +1,403 @@
+// End-to-end latency harness, built instead of the native runner by
+// [env:native_e2e]. Each scenario runs the whole firmware (main.cpp) in a forked
+// child on the virtual clock, against FakeTelegramApi and a scripted sensor
+// trace, and measures crossing -> relay -> alert and command -> reply.
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "config.h"
+#include "e2e/FakeTelegramApi.h"
+
+void setup();
+void loop();
+
+namespace {
+// Trace: steady below the upper limit, then a ramp through it at RAMP_C_PER_S.
+constexpr unsigned long RAMP_START_MS = 60000;
+constexpr float START_BELOW_MAX_C = 5.0f;
+constexpr float PEAK_ABOVE_MAX_C = 3.0f;
+constexpr float RAMP_C_PER_S = 0.25f;
+constexpr float AMBIENT_C = 22.0f;
+constexpr unsigned long CROSSING_MS =
+    RAMP_START_MS + static_cast<unsigned long>(START_BELOW_MAX_C / RAMP_C_PER_S * 1000.0f);
+// After the startup messages, so fault budgets hit the alert path.
+constexpr unsigned long ALERT_FAULTS_FROM_MS = CROSSING_MS - 5000;
+// The command comes once the alert has settled.
+constexpr unsigned long COMMAND_AT_MS = 140000;
+// Export requested so that its upload is still running at the crossing.
+constexpr unsigned long EXPORT_AT_MS = CROSSING_MS - 6000;
+constexpr long EXPORT_ALERT_BUDGET_MS = 10000;
+constexpr unsigned long RUN_MS = 190000;
+constexpr char COMMAND_TEXT[] = "config";
+constexpr char REPLY_MARKER[] = "Koruma Ayarlari";
+constexpr char ALERT_MARKER[] = "UYARI";
+
+struct Scenario {
+  const char *name;
+  const char *description;
+  e2e::FaultPlan faults;
+  const char *exportCommand = nullptr;  // Sent at EXPORT_AT_MS when set
+};
+
+// Times are virtual milliseconds since boot; -1 when it never happened.
+struct ScenarioResult {
+  bool completed = false;
+  long sensedMs = -1;  // First read at or over the limit
+  long relayMs = -1;   // Cooling relay driven to its active level
+  long alertMs = -1;   // Alert answered 200 by the API
+  long commandMs = -1;
+  long polledMs = -1;  // getUpdates answer carrying the command readable
+  long replyMs = -1;   // Reply answered 200 by the API
+  long uploadMs = -1;  // First sendDocument request begun
+  e2e::ApiCounters api;
+};
+
+std::vector<Scenario> buildScenarios() {
+  std::vector<Scenario> scenarios;
+  e2e::FaultPlan faults;
+  scenarios.push_back({"baseline", "connect 250 ms, send 120 ms, poll 100 ms", faults});
+
+  faults = e2e::FaultPlan();
+  faults.connectMs = 1200;
+  faults.sendLatencyMs = 900;
+  faults.pollLatencyMs = 900;
+  scenarios.push_back({"slow_link", "connect 1200 ms, send/poll 900 ms", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = ALERT_FAULTS_FROM_MS;
+  faults.throttledSends = 2;
+  faults.retryAfterS = 5;
+  scenarios.push_back({"throttled", "first 2 sends after the crossing answered 429, retry_after 5", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = ALERT_FAULTS_FROM_MS;
+  faults.hungSends = 1;
+  scenarios.push_back({"send_timeout", "first send after the crossing never answered", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = ALERT_FAULTS_FROM_MS;
+  faults.refusedConnects = 3;
+  scenarios.push_back({"refused", "3 connects after the crossing refused", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = COMMAND_AT_MS;
+  faults.hungPolls = 2;
+  scenarios.push_back({"poll_timeout", "2 getUpdates after the command never answered", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = COMMAND_AT_MS;
+  faults.throttledPolls = 1;
+  faults.retryAfterS = 5;
+  scenarios.push_back({"throttled_poll", "first getUpdates after the command answered 429, retry_after 5", faults});
+
+  faults = e2e::FaultPlan();
+  faults.fromMs = COMMAND_AT_MS;
+  faults.oversizedPolls = 2;
+  scenarios.push_back({"oversized_poll", "2 getUpdates after the command padded to 6 KB", faults});
+
+  faults = e2e::FaultPlan();
+  faults.uploadBytesPerS = 50;
+  scenarios.push_back({"export_alert", "export 6 s before the crossing over a 50 B/s uplink", faults, "export 1h"});
+  return scenarios;
+}
+
+float traceObjectC(unsigned long ms) {
+  const float startC = config::OBJECT_TEMP_MAX_C - START_BELOW_MAX_C;
+  if (ms <= RAMP_START_MS) {
+    return startC;
+  }
+  const float rampedC = startC + RAMP_C_PER_S * static_cast<float>(ms - RAMP_START_MS) / 1000.0f;
+  return rampedC < config::OBJECT_TEMP_MAX_C + PEAK_ABOVE_MAX_C ? rampedC
+                                                                 : config::OBJECT_TEMP_MAX_C + PEAK_ABOVE_MAX_C;
+}
+
+bool traceSource(unsigned long nowMs, native::SensorReading &reading, void *context) {
+  ScenarioResult &result = *static_cast<ScenarioResult *>(context);
+  reading.ambientC = AMBIENT_C;
+  reading.objectC = traceObjectC(nowMs);
+  reading.ok = true;
+  if (result.sensedMs < 0 && reading.objectC >= config::OBJECT_TEMP_MAX_C) {
+    result.sensedMs = static_cast<long>(nowMs);
+  }
+  return true;
+}
+
+void onPin(uint8_t pin, uint8_t level, unsigned long ms, void *context) {
+  ScenarioResult &result = *static_cast<ScenarioResult *>(context);
+  if (result.relayMs < 0 && ms >= CROSSING_MS && pin == config::COOLING_RELAY_PIN &&
+      level == config::COOLING_RELAY_ACTIVE_LEVEL) {
+    result.relayMs = static_cast<long>(ms);
+  }
+}
+
+// First message containing `marker` that was received at or after `fromMs` and answered 200.
+long acknowledgedAt(const e2e::FakeTelegramApi &api, const char *marker, long fromMs) {
+  for (const e2e::SentMessage &message : api.messages()) {
+    if (message.status == 200 && static_cast<long>(message.receivedMs) >= fromMs &&
+        message.text.find(marker) != std::string::npos) {
+      return static_cast<long>(message.answeredMs);
+    }
+  }
+  return -1;
+}
+
+int removeEntry(const char *path, const struct stat *, int, struct FTW *) { return remove(path); }
+
+// Runs in the forked child: fresh firmware globals, its own state directory.
+ScenarioResult runScenario(const Scenario &scenario, const char *logDirectory) {
+  ScenarioResult result;
+  char stateDirectory[] = "/tmp/tastan09-e2e-XXXXXX";
+  if (!mkdtemp(stateDirectory)) {
+    return result;
+  }
+  native::setStateDirectory(stateDirectory);
+
+  // Serial output and core messages go to the scenario log.
+  String logPath("/dev/null");
+  if (logDirectory) {
+    logPath = String(logDirectory) + "/" + scenario.name + ".log";
+  }
+  const int logFd = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (logFd >= 0) {
+    dup2(logFd, STDOUT_FILENO);
+    dup2(logFd, STDERR_FILENO);
+    close(logFd);
+  }
+
+  native::useVirtualClock(true);
+  native::setMillis(0);
+  randomSeed(1);
+  e2e::FakeTelegramApi api(scenario.faults);
+  api.install();
+  native::setSensorSource(traceSource, &result);
+  native::setPinListener(onPin, &result);
+
+  long commandUpdateId = -1;
+  bool exportSent = false;
+  setup();
+  while (!native::stopRequested() && millis() < RUN_MS) {
+    if (scenario.exportCommand && !exportSent && millis() >= EXPORT_AT_MS) {
+      api.injectMessage(config::TELEGRAM_ALERT_CHAT_ID, scenario.exportCommand);
+      exportSent = true;
+    }
+    if (commandUpdateId < 0 && millis() >= COMMAND_AT_MS) {
+      commandUpdateId = api.injectMessage(config::TELEGRAM_ALERT_CHAT_ID, COMMAND_TEXT);
+      result.commandMs = static_cast<long>(millis());
+    }
+    loop();
+    yield();
+  }
+  Serial.flush();
+  fflush(stdout);
+
+  result.alertMs = acknowledgedAt(api, ALERT_MARKER, static_cast<long>(CROSSING_MS));
+  const unsigned long polledMs = api.polledAtMs(commandUpdateId);
+  if (polledMs > 0) {
+    result.polledMs = static_cast<long>(polledMs);
+    result.replyMs = acknowledgedAt(api, REPLY_MARKER, result.polledMs);
+  }
+  if (api.firstUploadMs() > 0) {
+    result.uploadMs = static_cast<long>(api.firstUploadMs());
+  }
+  result.api = api.counters();
+  result.completed = true;
+  nftw(stateDirectory, removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+  return result;
+}
+
+bool forkScenario(const Scenario &scenario, const char *logDirectory, ScenarioResult &result) {
+  int channel[2];
+  if (pipe(channel) != 0) {
+    return false;
+  }
+  fflush(stdout);
+  const pid_t child = fork();
+  if (child < 0) {
+    close(channel[0]);
+    close(channel[1]);
+    return false;
+  }
+  if (child == 0) {
+    close(channel[0]);
+    const ScenarioResult childResult = runScenario(scenario, logDirectory);
+    const ssize_t written = write(channel[1], &childResult, sizeof(childResult));
+    _exit(written == static_cast<ssize_t>(sizeof(childResult)) ? 0 : 1);
+  }
+  close(channel[1]);
+  const bool received = read(channel[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+  close(channel[0]);
+  int status = 0;
+  waitpid(child, &status, 0);
+  return received && WIFSIGNALED(status) == 0 && result.completed;
+}
+
+long since(long eventMs, long originMs) { return eventMs < 0 || originMs < 0 ? -1 : eventMs - originMs; }
+
+// Why a scenario does not count as passed, or nullptr. Every scenario has to
+// pass: the fault plans delay the chain but none of them may break it.
+const char *failureReason(const Scenario &scenario, const ScenarioResult &r) {
+  if (!r.completed) {
+    return "run did not complete";
+  }
+  if (scenario.exportCommand && (r.uploadMs < 0 || r.uploadMs > static_cast<long>(CROSSING_MS))) {
+    return "export upload did not start before the crossing";
+  }
+  if (r.relayMs < 0) {
+    return "cooling relay never switched after the crossing";
+  }
+  if (r.alertMs < 0) {
+    return "no alert acknowledged after the crossing";
+  }
+  if (r.replyMs < 0) {
+    return "command never answered";
+  }
+  if (r.api.earlyPolls > 0) {
+    return "getUpdates sent again before retry_after ran out";
+  }
+  if (scenario.exportCommand && since(r.alertMs, CROSSING_MS) > EXPORT_ALERT_BUDGET_MS) {
+    return "alert waited behind the export upload";
+  }
+  return nullptr;
+}
+
+void printCell(FILE *out, long value) {
+  if (value < 0) {
+    fprintf(out, " %9s", "-");
+  } else {
+    fprintf(out, " %9ld", value);
+  }
+}
+
+void printJsonValue(FILE *out, const char *key, long value, bool last = false) {
+  if (value < 0) {
+    fprintf(out, "\"%s\": null%s", key, last ? "" : ", ");
+  } else {
+    fprintf(out, "\"%s\": %ld%s", key, value, last ? "" : ", ");
+  }
+}
+
+void printTable(const std::vector<Scenario> &scenarios, const std::vector<ScenarioResult> &results) {
+  printf("crossing at %lu ms (%.1f C), command \"%s\" at %lu ms; latencies in virtual ms\n", CROSSING_MS,
+         config::OBJECT_TEMP_MAX_C, COMMAND_TEXT, COMMAND_AT_MS);
+  printf("%-16s %9s %9s %9s %9s %9s %6s %5s %5s %5s %5s\n", "scenario", "sensed", "relay", "alert", "polled",
+         "reply", "conn", "429", "hung", "big", "refus");
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    const ScenarioResult &r = results[i];
+    printf("%-16s", scenarios[i].name);
+    if (!r.completed) {
+      printf(" run failed\n");
+      continue;
+    }
+    printCell(stdout, since(r.sensedMs, CROSSING_MS));
+    printCell(stdout, since(r.relayMs, CROSSING_MS));
+    printCell(stdout, since(r.alertMs, CROSSING_MS));
+    printCell(stdout, since(r.polledMs, r.commandMs));
+    printCell(stdout, since(r.replyMs, r.commandMs));
+    printf(" %6u %5u %5u %5u %5u\n", r.api.connects, r.api.throttled, r.api.hung, r.api.oversized, r.api.refused);
+  }
+}
+
+bool writeJson(const char *path, const std::vector<Scenario> &scenarios, const std::vector<ScenarioResult> &results) {
+  FILE *out = fopen(path, "w");
+  if (!out) {
+    return false;
+  }
+  fprintf(out, "{\n  \"context\": {\"executable\": \"tastan09_e2e\", \"crossing_ms\": %lu, \"command_ms\": %lu, "
+               "\"run_ms\": %lu, \"object_max_c\": %.2f},\n  \"scenarios\": [",
+          CROSSING_MS, COMMAND_AT_MS, RUN_MS, config::OBJECT_TEMP_MAX_C);
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    const ScenarioResult &r = results[i];
+    fprintf(out, "%s\n    {\"name\": \"%s\", \"description\": \"%s\", \"completed\": %s, ", i == 0 ? "" : ",",
+            scenarios[i].name, scenarios[i].description, r.completed ? "true" : "false");
+    printJsonValue(out, "crossing_to_sensed_ms", since(r.sensedMs, CROSSING_MS));
+    printJsonValue(out, "crossing_to_relay_ms", since(r.relayMs, CROSSING_MS));
+    printJsonValue(out, "crossing_to_alert_ms", since(r.alertMs, CROSSING_MS));
+    printJsonValue(out, "command_to_poll_ms", since(r.polledMs, r.commandMs));
+    printJsonValue(out, "command_to_reply_ms", since(r.replyMs, r.commandMs));
+    fprintf(out,
+            "\"api\": {\"connects\": %u, \"refused\": %u, \"polls\": %u, \"sends\": %u, \"throttled\": %u, "
+            "\"hung\": %u, \"oversized\": %u, \"early_polls\": %u}}",
+            r.api.connects, r.api.refused, r.api.polls, r.api.sends, r.api.throttled, r.api.hung, r.api.oversized,
+            r.api.earlyPolls);
+  }
+  fprintf(out, "\n  ]\n}\n");
+  return fclose(out) == 0;
+}
+
+void printUsage(const char *program, const std::vector<Scenario> &scenarios) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --scenario <name>  run only this scenario (repeatable)\n"
+          "  --json <file>      also write the results as JSON\n"
+          "  --logs <dir>       keep each scenario's serial output as <dir>/<name>.log\n"
+          "Scenarios:\n",
+          program);
+  for (const Scenario &scenario : scenarios) {
+    fprintf(stderr, "  %-16s %s\n", scenario.name, scenario.description);
+  }
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  const std::vector<Scenario> all = buildScenarios();
+  std::vector<Scenario> selected;
+  const char *jsonPath = nullptr;
+  const char *logDirectory = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    const String option(argv[i]);
+    const bool hasValue = i + 1 < argc;
+    if (option == "--scenario" && hasValue) {
+      const String name(argv[++i]);
+      size_t found = 0;
+      for (const Scenario &scenario : all) {
+        if (name == scenario.name) {
+          selected.push_back(scenario);
+          ++found;
+        }
+      }
+      if (found == 0) {
+        printUsage(argv[0], all);
+        return 2;
+      }
+    } else if (option == "--json" && hasValue) {
+      jsonPath = argv[++i];
+    } else if (option == "--logs" && hasValue) {
+      logDirectory = argv[++i];
+    } else {
+      printUsage(argv[0], all);
+      return option == "--help" ? 0 : 2;
+    }
+  }
+  if (selected.empty()) {
+    selected = all;
+  }
+
+  std::vector<ScenarioResult> results(selected.size());
+  for (size_t i = 0; i < selected.size(); ++i) {
+    if (!forkScenario(selected[i], logDirectory, results[i])) {
+      results[i].completed = false;
+    }
+  }
+  printTable(selected, results);
+  bool complete = true;
+  for (size_t i = 0; i < selected.size(); ++i) {
+    const char *reason = failureReason(selected[i], results[i]);
+    if (reason) {
+      fprintf(stderr, "FAIL %s: %s\n", selected[i].name, reason);
+      complete = false;
+    }
+  }
+  if (jsonPath && !writeJson(jsonPath, selected, results)) {
+    fprintf(stderr, "%s could not be written\n", jsonPath);
+    return 2;
+  }
+  // Non-zero when any scenario failed (relay, alert or reply missing), so CI can gate on it.
+  return complete ? 0 : 1;
+}
@@ -0,0 +1,785 @@
+#include "fleet/FleetNode.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "history/HistoryStore.h"
+#include "logging/Log.h"
+#include "profiling/StageProfiler.h"
+#include "telegram/MessageChunker.h"
+#include "telegram/TelegramCommandProcessor.h"
+#include "telegram/TelegramService.h"
+#include "text/MessageCatalog.h"
+
+namespace fleet {
+namespace {
+constexpr size_t MAX_DATAGRAMS_PER_PASS = 8;
+constexpr size_t PAYLOAD_MAX = FLEET_DATAGRAM_MAX - FLEET_TAG_BYTES;  // Room left for the encoders
+constexpr size_t TRACK_WINDOW = 32;      // Width of Peer::received
+constexpr uint8_t MAX_NACK_RUN = 8;      // Sequence numbers covered by one NACK
+constexpr size_t EVENT_OVERHEAD_BYTES = FLEET_HEADER_BYTES + 2 + 1 + 1 + 1 + 2;
+constexpr size_t REPLY_OVERHEAD_BYTES = FLEET_HEADER_BYTES + 4 + 2 + 1 + 1 + 2;
+constexpr size_t UTF8_BYTES_PER_UNIT = 3;  // Worst case for MessageChunker's UTF-16 units
+
+int16_t toCenti(float celsius) {
+  const long centi = lroundf(celsius * 100.0f);
+  return static_cast<int16_t>(centi < INT16_MIN ? INT16_MIN : centi > INT16_MAX ? INT16_MAX : centi);
+}
+
+const char *formatCenti(char *out, size_t size, int16_t centi) {
+  const int magnitude = centi < 0 ? -centi : centi;
+  snprintf(out, size, "%s%d.%02d", centi < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+  return out;
+}
+}  // namespace
+
+text::MessageId roleName(Role role) {
+  switch (role) {
+    case Role::Electing:
+      return text::MessageId::FleetRoleElecting;
+    case Role::Member:
+      return text::MessageId::FleetRoleMember;
+    case Role::Gateway:
+      return text::MessageId::FleetRoleGateway;
+    case Role::Standalone:
+    default:
+      return text::MessageId::FleetRoleStandalone;
+  }
+}
+
+FleetNode::FleetNode(notify::NotificationBus &bus, telegram::TelegramService &telegram)
+    : bus_(bus), telegram_(telegram) {}
+
+void FleetNode::begin(const char *name, uint8_t priority) {
+  if (!config::ENABLE_FLEET || name == nullptr || name[0] == '\0') {
+    return;
+  }
+  strncpy(name_, name, FLEET_NAME_MAX);
+  name_[FLEET_NAME_MAX] = '\0';
+  id_ = nodeIdFor(name_);
+  key_ = keyFor(config::FLEET_KEY);
+  priority_ = priority;
+  session_ = static_cast<uint16_t>(random(1, 0x10000) ^ micros());
+  if (session_ == 0) {
+    session_ = 1;
+  }
+  group_.fromString(config::FLEET_MULTICAST_GROUP);
+  role_ = Role::Electing;
+}
+
+void FleetNode::update(unsigned long now, telegram::TelegramCommandProcessor &processor,
+                       const sensor::MeasurementStats &objectStats) {
+  if (role_ == Role::Standalone) {
+    return;
+  }
+  profiling::ScopedStageTimer timer(profiling::Stage::Fleet);
+  if (!listen(now)) {
+    return;
+  }
+  receive(now, processor, objectStats);
+  if (now - lastHeartbeat_ >= config::FLEET_HEARTBEAT_MS) {
+    sendHeartbeat(now);
+  }
+  elect(now);
+  if (role_ == Role::Gateway) {
+    serviceNacks(now);
+  }
+  serviceCommands(now);
+}
+
+void FleetNode::publishSample(float objectC, float ambientC, uint8_t flags) {
+  const unsigned long now = millis();
+  if (!listening_ || now - lastSample_ < config::FLEET_SAMPLE_INTERVAL_MS) {
+    return;
+  }
+  lastSample_ = now;
+  Sample body;
+  body.sequence = ++sampleSeq_;
+  body.objectCenti = toCenti(objectC);
+  body.ambientCenti = toCenti(ambientC);
+  body.flags = flags;
+  sendDatagram(encode(ownHeader(MessageType::Sample), body, buffer_, PAYLOAD_MAX));
+}
+
+void FleetNode::publishEvent(notify::Severity severity, notify::EventType type, const String &text) {
+  StoredEvent event;
+  event.severity = static_cast<uint8_t>(severity);
+  event.type = static_cast<uint8_t>(type);
+  event.text = text;
+  if (severity >= notify::Severity::Warning) {
+    if (++eventSeq_ == 0) {
+      eventSeq_ = 1;
+    }
+    event.sequence = eventSeq_;
+    stored_[storedNext_] = event;
+    storedNext_ = (storedNext_ + 1) % config::FLEET_RETRANSMIT_SLOTS;
+  }
+  if (listening_) {
+    sendEvent(event, false);
+  }
+}
+
+bool FleetNode::routeCommand(const char *target, size_t targetLength, const char *text, size_t length,
+                             const String &chatId, String &error) {
+  const unsigned long now = millis();
+  if (role_ != Role::Gateway) {
+    error = text::format(text::MessageId::FleetNotGateway);
+    return false;
+  }
+  if (config::FLEET_KEY[0] == '\0') {
+    error = text::format(text::MessageId::FleetNoKey);
+    return false;
+  }
+  const Peer *peer = findPeerByName(target, targetLength, now);
+  if (!peer) {
+    String name;
+    name.concat(target, targetLength);
+    error = text::format(text::MessageId::FleetUnknownNode, name);
+    return false;
+  }
+  PendingCommand *slot = nullptr;
+  for (PendingCommand &command : commands_) {
+    if (command.id == 0) {
+      slot = &command;
+      break;
+    }
+  }
+  if (!slot) {
+    error = text::format(text::MessageId::FleetCommandsFull);
+    return false;
+  }
+  if (++nextCommandId_ == 0) {
+    nextCommandId_ = 1;
+  }
+  slot->id = nextCommandId_;
+  slot->target = peer->id;
+  slot->chatId = chatId;
+  slot->text = String();
+  slot->text.concat(text, length);
+  slot->reply = String();
+  slot->nextPart = 0;
+  slot->tries = 1;
+  slot->answered = false;
+  slot->incomplete = false;
+  slot->sentAt = now;
+
+  Command body;
+  body.targetId = slot->target;
+  body.commandId = slot->id;
+  body.text = slot->text.c_str();
+  body.length = static_cast<uint16_t>(slot->text.length());
+  sendDatagram(encode(ownHeader(MessageType::Command), body, buffer_, PAYLOAD_MAX));
+  ++counters_.commandsRouted;
+  return true;
+}
+
+String FleetNode::formatNodes(unsigned long now) const {
+  using text::MessageId;
+  const String gateway = gatewayId_ == 0 ? String() : peerName(gatewayId_);
+  String message = text::format(MessageId::FleetNodes, name_[0] ? name_ : "-", roleName(role_),
+                                gatewayId_ == 0 ? text::Arg(MessageId::ValueNone) : text::Arg(gateway));
+  for (const Peer &peer : peers_) {
+    if (peer.id == 0) {
+      continue;
+    }
+    text::append(message, MessageId::FleetPeer, peer.name,
+                 peer.claimsGateway ? text::Arg(MessageId::FleetPeerGateway) : text::Arg(),
+                 alive(peer, now) ? text::Arg() : text::Arg(MessageId::FleetPeerSilent));
+    if (peer.hasSample) {
+      char object[8];
+      char ambient[8];
+      text::append(message, MessageId::FleetPeerSample, formatCenti(object, sizeof(object), peer.objectCenti),
+                   formatCenti(ambient, sizeof(ambient), peer.ambientCenti),
+                   peer.sampleFlags & history::HISTORY_HEATING ? text::Arg(MessageId::FleetPeerHeating) : text::Arg(),
+                   peer.sampleFlags & history::HISTORY_COOLING ? text::Arg(MessageId::FleetPeerCooling) : text::Arg());
+    }
+    text::append(message, MessageId::FleetPeerSeen, (now - peer.lastHeard) / 1000UL, peer.priority, peer.uptimeS);
+  }
+  return message;
+}
+
+String FleetNode::formatStats() const {
+  size_t peers = 0;
+  const unsigned long now = millis();
+  for (const Peer &peer : peers_) {
+    if (peer.id != 0 && alive(peer, now)) {
+      ++peers;
+    }
+  }
+  using text::MessageId;
+  const text::Arg trafficArgs[] = {roleName(role_),     peers,          counters_.sent,
+                                   counters_.sendFailures, counters_.received, counters_.malformed,
+                                   counters_.unauthenticated, counters_.eventsForwarded};
+  String message;
+  text::append(message, MessageId::FleetStats, trafficArgs, sizeof(trafficArgs) / sizeof(trafficArgs[0]));
+  text::append(message, MessageId::FleetStatsLoss, counters_.nacksSent, counters_.retransmits, counters_.eventsLost,
+               counters_.samplesLost);
+  const text::Arg commandArgs[] = {counters_.commandsRouted, counters_.commandTimeouts, counters_.commandsRefused,
+                                   counters_.commandsRepeated, counters_.roleChanges};
+  text::append(message, MessageId::FleetStatsCommands, commandArgs, sizeof(commandArgs) / sizeof(commandArgs[0]));
+  return message;
+}
+
+bool FleetNode::listen(unsigned long now) {
+  const IPAddress local = WiFi.localIP();
+  if (listening_ && local == joinedAddress_) {
+    return true;
+  }
+  udp_.stop();
+  listening_ = udp_.beginMulticast(local, group_, config::FLEET_PORT) != 0;
+  if (!listening_) {
+    LOG_WARN("Filo: %s:%u grubuna katilinamadi", config::FLEET_MULTICAST_GROUP,
+             static_cast<unsigned>(config::FLEET_PORT));
+    return false;
+  }
+  if (joinedAddress_ == IPAddress()) {
+    // First join: stay in the election state for one peer timeout so every live node is heard.
+    listeningSince_ = now;
+    lastHeartbeat_ = now - config::FLEET_HEARTBEAT_MS;
+  }
+  joinedAddress_ = local;
+  LOG_INFO("Filo: %s olarak %s:%u grubunda", name_, config::FLEET_MULTICAST_GROUP,
+           static_cast<unsigned>(config::FLEET_PORT));
+  return true;
+}
+
+void FleetNode::receive(unsigned long now, telegram::TelegramCommandProcessor &processor,
+                        const sensor::MeasurementStats &objectStats) {
+  for (size_t n = 0; n < MAX_DATAGRAMS_PER_PASS; ++n) {
+    const int size = udp_.parsePacket();
+    if (size <= 0) {
+      return;
+    }
+    const int length = udp_.read(buffer_, sizeof(buffer_));
+    if (length <= 0 || size > static_cast<int>(sizeof(buffer_))) {
+      ++counters_.malformed;
+      continue;
+    }
+    const size_t bytes = unseal(key_, buffer_, static_cast<size_t>(length));
+    if (bytes == 0) {
+      ++counters_.unauthenticated;  // Another fleet key, an old firmware or a forgery
+      continue;
+    }
+    Header header;
+    if (!parseHeader(buffer_, bytes, header)) {
+      ++counters_.malformed;
+      continue;
+    }
+    if (header.nodeId == id_) {
+      continue;  // Our own datagram looped back by the stack
+    }
+    ++counters_.received;
+    switch (header.type) {
+      case MessageType::Heartbeat:
+        handleHeartbeat(header, buffer_, bytes, now);
+        break;
+      case MessageType::Sample:
+        handleSample(header, buffer_, bytes, now);
+        break;
+      case MessageType::Event:
+        handleEvent(header, buffer_, bytes, now);
+        break;
+      case MessageType::Nack:
+        handleNack(buffer_, bytes);
+        break;
+      case MessageType::Command:
+        handleCommand(header, buffer_, bytes, now, processor, objectStats);
+        break;
+      case MessageType::Reply:
+        handleReply(header, buffer_, bytes, now);
+        break;
+      default:
+        ++counters_.malformed;
+        break;
+    }
+  }
+}
+
+void FleetNode::handleHeartbeat(const Header &header, const uint8_t *data, size_t length, unsigned long now) {
+  Heartbeat body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  Peer *peer = touchPeer(header, now);
+  if (!peer) {
+    return;
+  }
+  memcpy(peer->name, body.name, sizeof(peer->name));
+  peer->priority = body.priority;
+  peer->claimsGateway = body.gateway != 0;
+  peer->uptimeS = body.uptimeS;
+  if (!peer->tracking) {
+    // Nothing older than what the node reports now is requested.
+    peer->tracking = true;
+    peer->base = static_cast<uint16_t>(body.lastEventSeq + 1);
+    peer->highest = body.lastEventSeq;
+    peer->received = 0;
+    advanceBase(*peer);
+  } else if (sequenceDelta(body.lastEventSeq, peer->highest) > 0) {
+    peer->highest = body.lastEventSeq;
+  }
+}
+
+void FleetNode::handleSample(const Header &header, const uint8_t *data, size_t length, unsigned long now) {
+  Sample body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  Peer *peer = touchPeer(header, now);
+  if (!peer) {
+    return;
+  }
+  if (peer->hasSample) {
+    const int16_t gap = sequenceDelta(body.sequence, peer->sampleSeq);
+    if (gap <= 0) {
+      return;
+    }
+    counters_.samplesLost += static_cast<uint32_t>(gap - 1);
+  }
+  peer->hasSample = true;
+  peer->sampleSeq = body.sequence;
+  peer->objectCenti = body.objectCenti;
+  peer->ambientCenti = body.ambientCenti;
+  peer->sampleFlags = body.flags;
+}
+
+void FleetNode::handleEvent(const Header &header, const uint8_t *data, size_t length, unsigned long now) {
+  Event body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  Peer *peer = touchPeer(header, now);
+  if (!peer) {
+    return;
+  }
+  bool fresh = true;
+  if (body.sequence != 0) {
+    if (!peer->tracking) {
+      peer->tracking = true;
+      peer->base = body.sequence;
+      peer->highest = static_cast<uint16_t>(body.sequence - 1);
+      peer->received = 0;
+    }
+    markReceived(*peer, body.sequence, fresh);
+  }
+  if (!fresh) {
+    ++counters_.duplicates;
+    return;
+  }
+  if (role_ != Role::Gateway) {
+    return;  // Tracked anyway so a new gateway starts with current sequence state
+  }
+  const uint8_t severity = body.severity > static_cast<uint8_t>(notify::Severity::Alert)
+                               ? static_cast<uint8_t>(notify::Severity::Alert)
+                               : body.severity;
+  const uint8_t type = body.type > static_cast<uint8_t>(notify::EventType::System)
+                           ? static_cast<uint8_t>(notify::EventType::System)
+                           : body.type;
+  String text;
+  text.reserve(strlen(peer->name) + 3 + body.length);
+  text += '[';
+  text += peer->name;
+  text += F("] ");
+  text.concat(body.text, body.length);
+  bus_.publish(static_cast<notify::Severity>(severity), static_cast<notify::EventType>(type), text);
+  ++counters_.eventsForwarded;
+}
+
+void FleetNode::handleNack(const uint8_t *data, size_t length) {
+  Nack body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  if (body.targetId != id_) {
+    return;
+  }
+  for (uint8_t i = 0; i < body.count; ++i) {
+    const uint16_t sequence = static_cast<uint16_t>(body.firstSequence + i);
+    for (const StoredEvent &event : stored_) {
+      if (sequence != 0 && event.sequence == sequence) {
+        sendEvent(event, true);
+        ++counters_.retransmits;
+        break;
+      }
+    }
+  }
+}
+
+void FleetNode::handleCommand(const Header &header, const uint8_t *data, size_t length, unsigned long now,
+                              telegram::TelegramCommandProcessor &processor,
+                              const sensor::MeasurementStats &objectStats) {
+  Command body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  if (body.targetId != id_) {
+    return;
+  }
+  // Commands run with the Telegram chat's authority: only the elected gateway
+  // sends them, and only in a fleet with a key of its own.
+  if (role_ != Role::Member || header.nodeId != gatewayId_ || config::FLEET_KEY[0] == '\0') {
+    ++counters_.commandsRefused;
+    LOG_WARN("Filo: #%08lx komutu reddedildi", static_cast<unsigned long>(header.nodeId));
+    return;
+  }
+  replyTarget_ = header.nodeId;
+  replyCommandId_ = body.commandId;
+  replyPart_ = 0;
+  if (firstRun(header, body.commandId)) {
+    String text;
+    text.concat(body.text, body.length);
+    ++counters_.commandsExecuted;
+    processor.processCommand(text, now, objectStats, sendReply, this);
+  } else {
+    // The gateway lost the reply and asked again; say so instead of running it twice.
+    ++counters_.commandsRepeated;
+    sendReply(text::format(text::MessageId::FleetCommandRepeated), this);
+  }
+
+  Reply end;
+  end.targetId = replyTarget_;
+  end.commandId = replyCommandId_;
+  end.part = replyPart_;
+  end.last = 1;
+  sendDatagram(encode(ownHeader(MessageType::Reply), end, buffer_, PAYLOAD_MAX));
+  replyTarget_ = 0;
+}
+
+void FleetNode::handleReply(const Header &header, const uint8_t *data, size_t length, unsigned long now) {
+  Reply body;
+  if (!parse(data, length, body)) {
+    ++counters_.malformed;
+    return;
+  }
+  if (body.targetId != id_) {
+    return;
+  }
+  for (PendingCommand &command : commands_) {
+    if (command.id == 0 || command.id != body.commandId || command.target != header.nodeId) {
+      continue;
+    }
+    command.answered = true;
+    command.sentAt = now;
+    if (body.part != command.nextPart) {
+      command.incomplete = true;
+    }
+    command.nextPart = static_cast<uint8_t>(body.part + 1);
+    if (body.length > 0) {
+      command.reply.concat(body.text, body.length);
+    }
+    if (body.last) {
+      finishCommand(command, command.incomplete ? text::MessageId::FleetReplyPartLost : text::MessageId::FleetReply);
+    }
+    return;
+  }
+}
+
+void FleetNode::finishCommand(PendingCommand &command, text::MessageId message) {
+  const String node = peerName(command.target);
+  const text::Arg reply =
+      command.reply.length() > 0 ? text::Arg(command.reply) : text::Arg(text::MessageId::FleetReplyEmpty);
+  telegram_.sendDirect(text::format(message, node, reply), command.chatId);
+  command.id = 0;
+  command.chatId = String();
+  command.text = String();
+  command.reply = String();
+}
+
+bool FleetNode::firstRun(const Header &header, uint16_t commandId) {
+  if (header.nodeId != runGateway_ || header.session != runSession_) {
+    // A new gateway, or the same one restarted: its ids start over.
+    runGateway_ = header.nodeId;
+    runSession_ = header.session;
+    runNewest_ = commandId;
+    runSeen_ = 1;
+    return true;
+  }
+  const int16_t offset = sequenceDelta(commandId, runNewest_);
+  if (offset > 0) {
+    runSeen_ = offset >= static_cast<int16_t>(TRACK_WINDOW) ? 1 : (runSeen_ << offset) | 1;
+    runNewest_ = commandId;
+    return true;
+  }
+  if (-offset >= static_cast<int16_t>(TRACK_WINDOW)) {
+    return false;  // Too old to tell apart from a replay
+  }
+  const uint32_t bit = 1UL << -offset;
+  if (runSeen_ & bit) {
+    return false;
+  }
+  runSeen_ |= bit;
+  return true;
+}
+
+FleetNode::Peer *FleetNode::findPeer(uint32_t id) {
+  for (Peer &peer : peers_) {
+    if (peer.id == id) {
+      return &peer;
+    }
+  }
+  return nullptr;
+}
+
+const FleetNode::Peer *FleetNode::findPeerByName(const char *name, size_t length, unsigned long now) const {
+  for (const Peer &peer : peers_) {
+    if (peer.id != 0 && alive(peer, now) && strlen(peer.name) == length && strncmp(peer.name, name, length) == 0) {
+      return &peer;
+    }
+  }
+  return nullptr;
+}
+
+FleetNode::Peer *FleetNode::touchPeer(const Header &header, unsigned long now) {
+  Peer *peer = findPeer(header.nodeId);
+  if (!peer) {
+    // A free slot, otherwise the peer silent for the longest time once it has timed out.
+    for (Peer &candidate : peers_) {
+      if (candidate.id == 0) {
+        peer = &candidate;
+        break;
+      }
+      if (!alive(candidate, now) && (!peer || now - candidate.lastHeard > now - peer->lastHeard)) {
+        peer = &candidate;
+      }
+    }
+    if (!peer) {
+      ++counters_.peersRejected;
+      return nullptr;
+    }
+    *peer = Peer();
+    peer->id = header.nodeId;
+    peer->session = header.session;
+    snprintf(peer->name, sizeof(peer->name), "#%08lx", static_cast<unsigned long>(header.nodeId));
+  } else if (peer->session != header.session) {
+    // Restarted: its sequence numbers start over.
+    peer->session = header.session;
+    peer->tracking = false;
+    peer->nackTries = 0;
+    peer->hasSample = false;
+  }
+  peer->lastHeard = now;
+  return peer;
+}
+
+String FleetNode::peerName(uint32_t id) const {
+  if (id == id_) {
+    return String(name_);
+  }
+  for (const Peer &peer : peers_) {
+    if (peer.id == id) {
+      return String(peer.name);
+    }
+  }
+  char placeholder[12];
+  snprintf(placeholder, sizeof(placeholder), "#%08lx", static_cast<unsigned long>(id));
+  return String(placeholder);
+}
+
+bool FleetNode::alive(const Peer &peer, unsigned long now) const {
+  return now - peer.lastHeard < config::FLEET_PEER_TIMEOUT_MS;
+}
+
+void FleetNode::markReceived(Peer &peer, uint16_t sequence, bool &fresh) {
+  int16_t offset = sequenceDelta(sequence, peer.base);
+  if (offset < 0) {
+    fresh = false;  // Forwarded before, or given up on
+    return;
+  }
+  // Too far ahead for the window: whatever is still missing at the bottom is lost.
+  while (offset >= static_cast<int16_t>(TRACK_WINDOW)) {
+    if (peer.received == 0) {
+      const uint16_t skip = static_cast<uint16_t>(offset - (TRACK_WINDOW - 1));
+      counters_.eventsLost += skip;
+      peer.base = static_cast<uint16_t>(peer.base + skip);
+      offset = static_cast<int16_t>(offset - skip);
+      break;
+    }
+    if (!(peer.received & 1)) {
+      ++counters_.eventsLost;
+    }
+    peer.received >>= 1;
+    ++peer.base;
+    --offset;
+  }
+  const uint32_t bit = 1UL << offset;
+  if (peer.received & bit) {
+    fresh = false;
+    return;
+  }
+  peer.received |= bit;
+  fresh = true;
+  if (sequenceDelta(sequence, peer.highest) > 0) {
+    peer.highest = sequence;
+  }
+  advanceBase(peer);
+}
+
+void FleetNode::advanceBase(Peer &peer) {
+  for (;;) {
+    if (peer.base == 0) {
+      peer.received |= 1;  // 0 marks best-effort events and never arrives as a reliable one
+    }
+    if (!(peer.received & 1)) {
+      return;
+    }
+    peer.received >>= 1;
+    ++peer.base;
+    peer.nackTries = 0;
+  }
+}
+
+void FleetNode::serviceNacks(unsigned long now) {
+  for (Peer &peer : peers_) {
+    if (peer.id == 0 || !peer.tracking || !alive(peer, now)) {
+      continue;
+    }
+    const int16_t outstanding = sequenceDelta(peer.highest, peer.base);
+    if (outstanding < 0 || now - peer.lastNack < config::FLEET_NACK_INTERVAL_MS) {
+      continue;
+    }
+    if (peer.nackTries >= config::FLEET_NACK_RETRIES) {
+      // The sender no longer has it (retransmit buffer wrapped); stop asking.
+      ++counters_.eventsLost;
+      peer.received |= 1;
+      advanceBase(peer);
+      continue;
+    }
+    Nack body;
+    body.targetId = peer.id;
+    body.firstSequence = peer.base;
+    // Up to the last gap among the next MAX_NACK_RUN; the few already received come back as duplicates.
+    for (uint8_t i = 0; i < MAX_NACK_RUN && i <= outstanding; ++i) {
+      if (!(peer.received & (1UL << i))) {
+        body.count = static_cast<uint8_t>(i + 1);
+      }
+    }
+    peer.lastNack = now;
+    ++peer.nackTries;
+    if (sendDatagram(encode(ownHeader(MessageType::Nack), body, buffer_, PAYLOAD_MAX))) {
+      ++counters_.nacksSent;
+    }
+  }
+}
+
+void FleetNode::serviceCommands(unsigned long now) {
+  for (PendingCommand &command : commands_) {
+    if (command.id == 0 || now - command.sentAt < config::FLEET_COMMAND_RETRY_MS) {
+      continue;
+    }
+    if (command.answered) {
+      finishCommand(command, text::MessageId::FleetReplyEndLost);
+      continue;
+    }
+    if (command.tries >= config::FLEET_COMMAND_RETRIES) {
+      ++counters_.commandTimeouts;
+      finishCommand(command, text::MessageId::FleetNoReply);
+      continue;
+    }
+    Command body;
+    body.targetId = command.target;
+    body.commandId = command.id;
+    body.text = command.text.c_str();
+    body.length = static_cast<uint16_t>(command.text.length());
+    ++command.tries;
+    command.sentAt = now;
+    sendDatagram(encode(ownHeader(MessageType::Command), body, buffer_, PAYLOAD_MAX));
+  }
+}
+
+void FleetNode::elect(unsigned long now) {
+  Role next = Role::Electing;
+  uint32_t winner = 0;
+  if (now - listeningSince_ >= config::FLEET_PEER_TIMEOUT_MS) {
+    uint8_t best = priority_;
+    winner = priority_ > 0 ? id_ : 0;
+    for (const Peer &peer : peers_) {
+      if (peer.id == 0 || peer.priority == 0 || !alive(peer, now)) {
+        continue;
+      }
+      if (peer.priority > best || (peer.priority == best && (winner == 0 || peer.id < winner))) {
+        best = peer.priority;
+        winner = peer.id;
+      }
+    }
+    next = winner == id_ ? Role::Gateway : Role::Member;
+  }
+  gatewayId_ = winner;
+  if (next == role_) {
+    return;
+  }
+  role_ = next;
+  ++counters_.roleChanges;
+  char role[8];
+  text::render(role, sizeof(role), roleName(role_), nullptr, 0);
+  LOG_INFO("Filo: %s rolu %s", name_, role);
+  if (role_ == Role::Member && gatewayId_ == 0) {
+    LOG_WARN("Filo: gecit olabilecek dugum yok (FLEET_GATEWAY_PRIORITY)");
+  }
+  sendHeartbeat(now);  // Peers learn the new role without waiting a period
+}
+
+void FleetNode::sendHeartbeat(unsigned long now) {
+  lastHeartbeat_ = now;
+  Heartbeat body;
+  body.priority = priority_;
+  body.gateway = role_ == Role::Gateway ? 1 : 0;
+  body.lastEventSeq = eventSeq_;
+  body.uptimeS = now / 1000UL;
+  memcpy(body.name, name_, sizeof(body.name));
+  sendDatagram(encode(ownHeader(MessageType::Heartbeat), body, buffer_, PAYLOAD_MAX));
+}
+
+void FleetNode::sendEvent(const StoredEvent &event, bool retransmit) {
+  Event body;
+  body.sequence = event.sequence;
+  body.severity = event.severity;
+  body.type = event.type;
+  body.retransmit = retransmit ? 1 : 0;
+  body.text = event.text.c_str();
+  const size_t room = PAYLOAD_MAX - EVENT_OVERHEAD_BYTES;
+  body.length = static_cast<uint16_t>(event.text.length() < room ? event.text.length() : room);
+  sendDatagram(encode(ownHeader(MessageType::Event), body, buffer_, PAYLOAD_MAX));
+}
+
+bool FleetNode::sendDatagram(size_t length) {
+  length = seal(key_, buffer_, length, sizeof(buffer_));
+  if (length == 0 || !listening_ ||
+      !udp_.beginPacketMulticast(group_, config::FLEET_PORT, joinedAddress_, config::FLEET_MULTICAST_TTL) ||
+      udp_.write(buffer_, length) != length || !udp_.endPacket()) {
+    ++counters_.sendFailures;
+    return false;
+  }
+  ++counters_.sent;
+  return true;
+}
+
+Header FleetNode::ownHeader(MessageType type) const {
+  Header header;
+  header.type = type;
+  header.nodeId = id_;
+  header.session = session_;
+  return header;
+}
+
+void FleetNode::sendReply(const String &text, void *context) {
+  FleetNode &self = *static_cast<FleetNode *>(context);
+  const size_t maxUnits = (PAYLOAD_MAX - REPLY_OVERHEAD_BYTES) / UTF8_BYTES_PER_UNIT;
+  telegram::MessageChunker chunker(text.c_str(), text.length(), maxUnits);
+  telegram::TextSpan span;
+  while (chunker.next(span)) {
+    Reply body;
+    body.targetId = self.replyTarget_;
+    body.commandId = self.replyCommandId_;
+    body.part = self.replyPart_++;
+    body.text = text.c_str() + span.offset;
+    body.length = static_cast<uint16_t>(span.length);
+    self.sendDatagram(encode(self.ownHeader(MessageType::Reply), body, self.buffer_, PAYLOAD_MAX));
+  }
+}
+
+}  // namespace fleet
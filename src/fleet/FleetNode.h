@@ -0,0 +1,201 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#include "config.h"
+#include "fleet/FleetProtocol.h"
+#include "notify/NotificationBus.h"
+#include "sensor/MeasurementAggregator.h"
+#include "text/MessageCatalog.h"
+
+namespace telegram {
+class TelegramCommandProcessor;
+class TelegramService;
+}  // namespace telegram
+
+namespace fleet {
+
+enum class Role : uint8_t {
+  Standalone,  // Fleet mode off: this board talks to Telegram itself
+  Electing,    // Listening for peers before taking a role
+  Member,      // Telegram traffic goes through the gateway
+  Gateway,     // Does all Telegram I/O for the site
+};
+
+text::MessageId roleName(Role role);
+
+// Fleet mode for several boards on one LAN. Every node multicasts heartbeats,
+// compact samples and its notification events; the live node with the highest
+// FLEET_GATEWAY_PRIORITY (lowest id on ties) becomes the gateway, forwards the
+// others' events to its own notification bus and is the only one polling
+// Telegram. "@<node> <command>" sent to the bot runs on that node and the
+// reply comes back the same way. Warnings and alerts are sequenced: the gateway
+// NACKs gaps and the sender retransmits from a small buffer.
+class FleetNode {
+public:
+  struct Counters {
+    uint32_t sent = 0;
+    uint32_t sendFailures = 0;
+    uint32_t received = 0;
+    uint32_t malformed = 0;
+    uint32_t eventsForwarded = 0;  // Peer events put on the gateway's bus
+    uint32_t duplicates = 0;       // Already forwarded, dropped
+    uint32_t nacksSent = 0;
+    uint32_t retransmits = 0;      // Events resent after a NACK
+    uint32_t eventsLost = 0;       // Gateway gave up on a sequence number
+    uint32_t samplesLost = 0;      // Sample sequence gaps seen from peers
+    uint32_t commandsRouted = 0;
+    uint32_t commandTimeouts = 0;
+    uint32_t commandsExecuted = 0;
+    uint32_t commandsRepeated = 0;  // Retries of a command already run, answered without running it
+    uint32_t commandsRefused = 0;   // Not from the gateway, or no fleet key
+    uint32_t unauthenticated = 0;   // Tag missing or wrong
+    uint32_t roleChanges = 0;
+    uint32_t peersRejected = 0;    // Peer table full
+  };
+
+  FleetNode(notify::NotificationBus &bus, telegram::TelegramService &telegram);
+
+  // An empty name or config::ENABLE_FLEET == false leaves the node standalone.
+  void begin(const char *name, uint8_t priority);
+  void update(unsigned long now, telegram::TelegramCommandProcessor &processor,
+              const sensor::MeasurementStats &objectStats);
+
+  bool enabled() const { return role_ != Role::Standalone; }
+  Role role() const { return role_; }
+  bool ownsTelegram() const { return role_ == Role::Standalone || role_ == Role::Gateway; }
+  const char *name() const { return name_; }
+
+  void publishSample(float objectC, float ambientC, uint8_t flags);
+  void publishEvent(notify::Severity severity, notify::EventType type, const String &text);
+
+  // Gateway only. False with a message in error when the node is unknown or busy.
+  bool routeCommand(const char *target, size_t targetLength, const char *text, size_t length,
+                    const String &chatId, String &error);
+
+  const Counters &counters() const { return counters_; }
+  String formatNodes(unsigned long now) const;
+  String formatStats() const;
+
+private:
+  struct Peer {
+    uint32_t id = 0;
+    uint16_t session = 0;
+    char name[FLEET_NAME_MAX + 1] = {};
+    uint8_t priority = 0;
+    bool claimsGateway = false;
+    bool tracking = false;  // Event sequence state below is initialised
+    unsigned long lastHeard = 0;
+    uint32_t uptimeS = 0;
+    // Reliable event tracking: base is the oldest sequence not yet received,
+    // bit i of received means base + i arrived, highest is the newest known to exist.
+    uint16_t base = 0;
+    uint32_t received = 0;
+    uint16_t highest = 0;
+    uint8_t nackTries = 0;
+    unsigned long lastNack = 0;
+    // Last sample
+    bool hasSample = false;
+    uint16_t sampleSeq = 0;
+    int16_t objectCenti = 0;
+    int16_t ambientCenti = 0;
+    uint8_t sampleFlags = 0;
+  };
+
+  struct StoredEvent {
+    uint16_t sequence = 0;
+    uint8_t severity = 0;
+    uint8_t type = 0;
+    String text;
+  };
+
+  struct PendingCommand {
+    uint16_t id = 0;  // 0: free slot
+    uint32_t target = 0;
+    String chatId;
+    String text;
+    String reply;
+    uint8_t nextPart = 0;
+    uint8_t tries = 0;
+    bool answered = false;
+    bool incomplete = false;
+    unsigned long sentAt = 0;
+  };
+
+  bool listen(unsigned long now);
+  void receive(unsigned long now, telegram::TelegramCommandProcessor &processor,
+               const sensor::MeasurementStats &objectStats);
+  void handleHeartbeat(const Header &header, const uint8_t *data, size_t length, unsigned long now);
+  void handleSample(const Header &header, const uint8_t *data, size_t length, unsigned long now);
+  void handleEvent(const Header &header, const uint8_t *data, size_t length, unsigned long now);
+  void handleNack(const uint8_t *data, size_t length);
+  void handleCommand(const Header &header, const uint8_t *data, size_t length, unsigned long now,
+                     telegram::TelegramCommandProcessor &processor, const sensor::MeasurementStats &objectStats);
+  void handleReply(const Header &header, const uint8_t *data, size_t length, unsigned long now);
+  // message is one of the FleetReply* catalog texts, or FleetNoReply.
+  void finishCommand(PendingCommand &command, text::MessageId message);
+  bool firstRun(const Header &header, uint16_t commandId);
+
+  Peer *findPeer(uint32_t id);
+  const Peer *findPeerByName(const char *name, size_t length, unsigned long now) const;
+  Peer *touchPeer(const Header &header, unsigned long now);
+  String peerName(uint32_t id) const;
+  bool alive(const Peer &peer, unsigned long now) const;
+  void markReceived(Peer &peer, uint16_t sequence, bool &fresh);
+  void advanceBase(Peer &peer);
+  void serviceNacks(unsigned long now);
+  void serviceCommands(unsigned long now);
+  void elect(unsigned long now);
+  void sendHeartbeat(unsigned long now);
+  void sendEvent(const StoredEvent &event, bool retransmit);
+  // Signs the length bytes in buffer_ and sends them.
+  bool sendDatagram(size_t length);
+  Header ownHeader(MessageType type) const;
+  static void sendReply(const String &text, void *context);
+
+  notify::NotificationBus &bus_;
+  telegram::TelegramService &telegram_;
+  WiFiUDP udp_;
+  IPAddress group_;
+  IPAddress joinedAddress_;
+  bool listening_{false};
+
+  char name_[FLEET_NAME_MAX + 1] = {};
+  uint32_t id_{0};
+  uint16_t session_{0};
+  uint8_t priority_{0};
+  Role role_{Role::Standalone};
+  uint32_t gatewayId_{0};
+  unsigned long listeningSince_{0};
+  unsigned long lastHeartbeat_{0};
+  unsigned long lastSample_{0};
+  uint16_t sampleSeq_{0};
+
+  uint16_t eventSeq_{0};
+  StoredEvent stored_[config::FLEET_RETRANSMIT_SLOTS];
+  size_t storedNext_{0};
+
+  Peer peers_[config::FLEET_MAX_PEERS];
+  PendingCommand commands_[config::FLEET_PENDING_COMMANDS];
+  uint16_t nextCommandId_{0};
+
+  // Commands already run for the gateway session: the newest id and a bitmap of
+  // the ids below it (bit i: newest - i), so a retry never runs a command twice.
+  uint32_t runGateway_{0};
+  uint16_t runSession_{0};
+  uint16_t runNewest_{0};
+  uint32_t runSeen_{0};
+
+  // Set while a routed command runs on this node, read by sendReply().
+  uint32_t replyTarget_{0};
+  uint16_t replyCommandId_{0};
+  uint8_t replyPart_{0};
+
+  FleetKey key_;
+  uint8_t buffer_[FLEET_DATAGRAM_MAX];
+  Counters counters_;
+};
+
+}  // namespace fleet
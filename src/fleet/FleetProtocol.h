@@ -0,0 +1,121 @@
+#pragma once
+
+// Datagram format of the fleet multicast group. Free of Arduino dependencies so
+// the encoder and parser are the same code on the boards and on a host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace fleet {
+
+constexpr uint16_t FLEET_MAGIC = 0x4654;  // "TF" little endian
+constexpr uint8_t FLEET_VERSION = 2;  // 2: every datagram carries a SipHash tag
+constexpr size_t FLEET_HEADER_BYTES = 10;
+constexpr size_t FLEET_TAG_BYTES = 8;
+constexpr size_t FLEET_NAME_MAX = 15;
+constexpr size_t FLEET_DATAGRAM_MAX = 1200;  // Below the LAN MTU, so nothing is IP-fragmented
+
+enum class MessageType : uint8_t {
+  Heartbeat = 1,
+  Sample = 2,
+  Event = 3,
+  Nack = 4,
+  Command = 5,
+  Reply = 6,
+};
+
+// Every datagram starts with: u16 magic, u8 version, u8 type, u32 sender node id,
+// u16 sender session (random per boot, so a restarted node's sequence numbers
+// are not mistaken for duplicates). Fields below follow in order, little endian;
+// text fields are u16 length + bytes and point into the received buffer. The
+// last FLEET_TAG_BYTES are SipHash-2-4 of everything before them, keyed with
+// the fleet key, so only boards that share config::FLEET_KEY are heard.
+struct Header {
+  MessageType type = MessageType::Heartbeat;
+  uint32_t nodeId = 0;
+  uint16_t session = 0;
+};
+
+struct Heartbeat {
+  uint8_t priority = 0;       // Gateway election weight; 0 never becomes gateway
+  uint8_t gateway = 0;        // 1 while the sender believes it is the gateway
+  uint16_t lastEventSeq = 0;  // Newest reliable event, lets the gateway see a lost tail
+  uint32_t uptimeS = 0;
+  char name[FLEET_NAME_MAX + 1] = {};
+};
+
+struct Sample {
+  uint16_t sequence = 0;
+  int16_t objectCenti = 0;
+  int16_t ambientCenti = 0;
+  uint8_t flags = 0;  // history::HistoryFlags bits
+};
+
+// Warnings and alerts carry sequence 1..65535 and are retransmitted on NACK;
+// reports and info events use sequence 0 and are best effort.
+struct Event {
+  uint16_t sequence = 0;
+  uint8_t severity = 0;  // notify::Severity
+  uint8_t type = 0;      // notify::EventType
+  uint8_t retransmit = 0;
+  const char *text = nullptr;
+  uint16_t length = 0;
+};
+
+struct Nack {
+  uint32_t targetId = 0;
+  uint16_t firstSequence = 0;
+  uint8_t count = 0;
+};
+
+struct Command {
+  uint32_t targetId = 0;
+  uint16_t commandId = 0;
+  const char *text = nullptr;
+  uint16_t length = 0;
+};
+
+struct Reply {
+  uint32_t targetId = 0;  // The gateway that sent the command
+  uint16_t commandId = 0;
+  uint8_t part = 0;
+  uint8_t last = 0;
+  const char *text = nullptr;
+  uint16_t length = 0;
+};
+
+struct FleetKey {
+  uint64_t k0 = 0;
+  uint64_t k1 = 0;
+};
+
+uint32_t nodeIdFor(const char *name);
+// 128-bit SipHash key derived from the shared secret text.
+FleetKey keyFor(const char *secret);
+uint64_t sipHash(const FleetKey &key, const uint8_t *data, size_t length);
+// Appends the tag to the length bytes at out; returns the new length, 0 when it does not fit.
+size_t seal(const FleetKey &key, uint8_t *out, size_t length, size_t capacity);
+// Length of the datagram without its tag, 0 when the tag is missing or wrong.
+size_t unseal(const FleetKey &key, const uint8_t *data, size_t length);
+// Signed distance a - b on the 16-bit sequence circle.
+int16_t sequenceDelta(uint16_t a, uint16_t b);
+
+// Encoders return the datagram length, or 0 when it would exceed capacity.
+size_t encode(const Header &header, const Heartbeat &body, uint8_t *out, size_t capacity);
+size_t encode(const Header &header, const Sample &body, uint8_t *out, size_t capacity);
+size_t encode(const Header &header, const Event &body, uint8_t *out, size_t capacity);
+size_t encode(const Header &header, const Nack &body, uint8_t *out, size_t capacity);
+size_t encode(const Header &header, const Command &body, uint8_t *out, size_t capacity);
+size_t encode(const Header &header, const Reply &body, uint8_t *out, size_t capacity);
+
+// Parsers reject truncated input and unknown magic/version; the body parser
+// must match header.type.
+bool parseHeader(const uint8_t *data, size_t length, Header &header);
+bool parse(const uint8_t *data, size_t length, Heartbeat &body);
+bool parse(const uint8_t *data, size_t length, Sample &body);
+bool parse(const uint8_t *data, size_t length, Event &body);
+bool parse(const uint8_t *data, size_t length, Nack &body);
+bool parse(const uint8_t *data, size_t length, Command &body);
+bool parse(const uint8_t *data, size_t length, Reply &body);
+
+}  // namespace fleet
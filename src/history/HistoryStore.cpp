@@ -0,0 +1,229 @@
+#include "history/HistoryStore.h"
+
+#include <math.h>
+
+#include "text/MessageCatalog.h"
+
+namespace history {
+
+static_assert(config::HISTORY_COARSE_BUCKET_MS % config::HISTORY_FINE_BUCKET_MS == 0,
+              "Coarse history buckets must be a whole number of fine buckets");
+static_assert(config::HISTORY_FINE_BUCKETS > 0 && config::HISTORY_COARSE_BUCKETS > 0, "History tiers need slots");
+
+namespace {
+constexpr size_t SPAN_BYTES = 16;
+
+int16_t toDeci(float valueC) {
+  return static_cast<int16_t>(lroundf(valueC * 10.0f));
+}
+
+float fromDeci(int16_t value) {
+  return static_cast<float>(value) / 10.0f;
+}
+
+void appendDeci(String &out, int16_t value) {
+  if (value < 0) {
+    out += '-';
+  }
+  const unsigned int magnitude = static_cast<unsigned int>(value < 0 ? -value : value);
+  out += magnitude / 10;
+  out += '.';
+  out += magnitude % 10;
+}
+
+void appendAge(String &out, unsigned long ageMs) {
+  const unsigned long minutes = ageMs / 60000UL;
+  if (minutes < 180) {
+    text::append(out, text::MessageId::HistoryAgeMinutes, minutes);
+  } else {
+    text::append(out, text::MessageId::HistoryAgeHours, minutes / 60);
+  }
+}
+
+const char *formatSpan(char *out, size_t size, unsigned long spanMs) {
+  const unsigned long minutes = spanMs / 60000UL;
+  const bool hours = minutes >= 120 && minutes % 60 == 0;
+  const text::Arg count = hours ? minutes / 60 : minutes;
+  text::render(out, size, hours ? text::MessageId::SpanHours : text::MessageId::SpanMinutes, &count, 1);
+  return out;
+}
+
+}  // namespace
+
+void HistoryStore::Accumulator::add(float objectLo, float objectAvg, float objectHi, float ambientLo,
+                                    float ambientAvg, float ambientHi, uint8_t stateFlags, float sampleWeight) {
+  if (weight <= 0.0f) {
+    objectMin = objectLo;
+    objectMax = objectHi;
+    ambientMin = ambientLo;
+    ambientMax = ambientHi;
+  } else {
+    objectMin = fminf(objectMin, objectLo);
+    objectMax = fmaxf(objectMax, objectHi);
+    ambientMin = fminf(ambientMin, ambientLo);
+    ambientMax = fmaxf(ambientMax, ambientHi);
+  }
+  objectSum += objectAvg * sampleWeight;
+  ambientSum += ambientAvg * sampleWeight;
+  weight += sampleWeight;
+  flags |= stateFlags | HISTORY_HAS_DATA;
+}
+
+void HistoryStore::Accumulator::add(const HistoryBucket &bucket, float bucketWeight) {
+  if (!(bucket.flags & HISTORY_HAS_DATA)) {
+    return;
+  }
+  add(fromDeci(bucket.objectMin), fromDeci(bucket.objectAvg), fromDeci(bucket.objectMax),
+      fromDeci(bucket.ambientMin), fromDeci(bucket.ambientAvg), fromDeci(bucket.ambientMax), bucket.flags,
+      bucketWeight);
+}
+
+HistoryBucket HistoryStore::Accumulator::bucket() const {
+  HistoryBucket result;
+  if (weight <= 0.0f) {
+    return result;
+  }
+  result.objectMin = toDeci(objectMin);
+  result.objectAvg = toDeci(objectSum / weight);
+  result.objectMax = toDeci(objectMax);
+  result.ambientMin = toDeci(ambientMin);
+  result.ambientAvg = toDeci(ambientSum / weight);
+  result.ambientMax = toDeci(ambientMax);
+  result.flags = flags;
+  return result;
+}
+
+HistoryStore::Tier::Tier(HistoryBucket *slots, size_t capacity, unsigned long bucketMs)
+    : slots_(slots), capacity_(capacity), bucketMs_(bucketMs) {}
+
+void HistoryStore::Tier::start(unsigned long now) {
+  bucketStart_ = now;
+  pending_ = Accumulator();
+}
+
+HistoryBucket HistoryStore::Tier::close() {
+  const HistoryBucket closed = pending_.bucket();
+  slots_[head_] = closed;
+  head_ = (head_ + 1) % capacity_;
+  if (count_ < capacity_) {
+    ++count_;
+  }
+  bucketStart_ += bucketMs_;
+  pending_ = Accumulator();
+  return closed;
+}
+
+const HistoryBucket &HistoryStore::Tier::at(size_t age) const {
+  return slots_[(head_ + capacity_ - 1 - age) % capacity_];
+}
+
+HistoryStore::HistoryStore()
+    : fine_(fineSlots_, config::HISTORY_FINE_BUCKETS, config::HISTORY_FINE_BUCKET_MS),
+      coarse_(coarseSlots_, config::HISTORY_COARSE_BUCKETS, config::HISTORY_COARSE_BUCKET_MS) {}
+
+void HistoryStore::update(unsigned long now) {
+  if (!config::ENABLE_HISTORY) {
+    return;
+  }
+  if (!started_) {
+    started_ = true;
+    fine_.start(now);
+    coarse_.start(now);
+    return;
+  }
+
+  // Each closed fine bucket is folded into the open coarse bucket, so the coarse
+  // tier never rescans fine data.
+  while (fine_.due(now)) {
+    coarse_.pending().add(fine_.close(), 1.0f);
+    while (coarse_.due(fine_.bucketStart())) {
+      coarse_.close();
+    }
+  }
+}
+
+void HistoryStore::addSample(unsigned long now, float objectC, float ambientC, bool heating, bool cooling,
+                             unsigned long weightMs) {
+  if (!config::ENABLE_HISTORY) {
+    return;
+  }
+  update(now);
+  const uint8_t state = (heating ? HISTORY_HEATING : 0) | (cooling ? HISTORY_COOLING : 0);
+  fine_.pending().add(objectC, objectC, objectC, ambientC, ambientC, ambientC, state,
+                      static_cast<float>(weightMs));
+}
+
+String HistoryStore::formatTable(unsigned long rangeMs, unsigned long now) const {
+  if (!config::ENABLE_HISTORY) {
+    return text::format(text::MessageId::HistoryDisabled);
+  }
+
+  const unsigned long fineWindowMs = config::HISTORY_FINE_BUCKET_MS * config::HISTORY_FINE_BUCKETS;
+  const Tier &tier = (rangeMs <= fineWindowMs) ? fine_ : coarse_;
+  size_t buckets = (rangeMs + tier.bucketMs() - 1) / tier.bucketMs();
+  if (buckets > tier.count()) {
+    buckets = tier.count();
+  }
+  if (buckets == 0) {
+    return text::format(text::MessageId::HistoryEmpty);
+  }
+
+  const size_t group = (buckets + config::HISTORY_MAX_ROWS - 1) / config::HISTORY_MAX_ROWS;
+  const unsigned long stepMs = group * tier.bucketMs();
+  const unsigned long openMs = now - tier.bucketStart();
+
+  String message;
+  message.reserve(96 + ((buckets + group - 1) / group) * 32);
+  char span[SPAN_BYTES];
+  char step[SPAN_BYTES];
+  text::append(message, text::MessageId::HistoryHeader, formatSpan(span, sizeof(span), buckets * tier.bucketMs()),
+               formatSpan(step, sizeof(step), stepMs));
+
+  for (size_t age = 0; age < buckets; age += group) {
+    Accumulator row;
+    for (size_t i = age; i < age + group && i < buckets; ++i) {
+      row.add(tier.at(i), 1.0f);
+    }
+    message += '\n';
+    appendAge(message, openMs + age * tier.bucketMs());
+    message += ' ';
+    if (!(row.flags & HISTORY_HAS_DATA)) {
+      text::append(message, text::MessageId::HistoryNoData);
+      continue;
+    }
+    const HistoryBucket merged = row.bucket();
+    appendDeci(message, merged.objectMin);
+    message += '/';
+    appendDeci(message, merged.objectAvg);
+    message += '/';
+    appendDeci(message, merged.objectMax);
+    message += F(" | ");
+    appendDeci(message, merged.ambientAvg);
+    message += F(" | ");
+    if (merged.flags & HISTORY_HEATING) {
+      text::append(message, text::MessageId::HistoryHeating);
+    }
+    if (merged.flags & HISTORY_COOLING) {
+      text::append(message, text::MessageId::HistoryCooling);
+    }
+    if (!(merged.flags & (HISTORY_HEATING | HISTORY_COOLING))) {
+      message += '-';
+    }
+  }
+  return message;
+}
+
+String HistoryStore::formatMemoryLine() const {
+  char fine[SPAN_BYTES];
+  char coarse[SPAN_BYTES];
+  const text::Arg args[] = {static_cast<unsigned long>(sizeof(HistoryStore)),
+                            formatSpan(fine, sizeof(fine), config::HISTORY_FINE_BUCKET_MS),
+                            static_cast<unsigned long>(config::HISTORY_FINE_BUCKETS),
+                            formatSpan(coarse, sizeof(coarse), config::HISTORY_COARSE_BUCKET_MS),
+                            static_cast<unsigned long>(config::HISTORY_COARSE_BUCKETS)};
+  String line;
+  text::append(line, text::MessageId::HistoryMemory, args, sizeof(args) / sizeof(args[0]));
+  return line;
+}
+
+}  // namespace history
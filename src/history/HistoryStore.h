@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+namespace history {
+
+enum HistoryFlags : uint8_t {
+  HISTORY_HAS_DATA = 0x01,
+  HISTORY_HEATING = 0x02,  // Heating relay was on at some point in the bucket
+  HISTORY_COOLING = 0x04,
+};
+
+// Temperatures are stored in 0.1 C steps, which keeps -70..380 C inside int16_t.
+struct HistoryBucket {
+  int16_t objectMin = 0;
+  int16_t objectAvg = 0;
+  int16_t objectMax = 0;
+  int16_t ambientMin = 0;
+  int16_t ambientAvg = 0;
+  int16_t ambientMax = 0;
+  uint8_t flags = 0;
+};
+
+class HistoryStore {
+public:
+  HistoryStore();
+
+  // Closes every bucket that ended before now; buckets without samples are kept as gaps.
+  void update(unsigned long now);
+  void addSample(unsigned long now, float objectC, float ambientC, bool heating, bool cooling,
+                 unsigned long weightMs);
+
+  String formatTable(unsigned long rangeMs, unsigned long now) const;
+  String formatMemoryLine() const;
+
+private:
+  struct Accumulator {
+    float objectMin = 0.0f;
+    float objectMax = 0.0f;
+    float objectSum = 0.0f;
+    float ambientMin = 0.0f;
+    float ambientMax = 0.0f;
+    float ambientSum = 0.0f;
+    float weight = 0.0f;
+    uint8_t flags = 0;
+
+    void add(float objectLo, float objectAvg, float objectHi, float ambientLo, float ambientAvg, float ambientHi,
+             uint8_t stateFlags, float sampleWeight);
+    void add(const HistoryBucket &bucket, float bucketWeight);
+    HistoryBucket bucket() const;
+  };
+
+  class Tier {
+  public:
+    Tier(HistoryBucket *slots, size_t capacity, unsigned long bucketMs);
+
+    void start(unsigned long now);
+    bool due(unsigned long now) const { return now - bucketStart_ >= bucketMs_; }
+    HistoryBucket close();
+    Accumulator &pending() { return pending_; }
+
+    unsigned long bucketMs() const { return bucketMs_; }
+    unsigned long bucketStart() const { return bucketStart_; }
+    size_t capacity() const { return capacity_; }
+    size_t count() const { return count_; }
+    // age 0 is the most recently closed bucket.
+    const HistoryBucket &at(size_t age) const;
+
+  private:
+    HistoryBucket *slots_;
+    size_t capacity_;
+    unsigned long bucketMs_;
+    size_t head_{0};
+    size_t count_{0};
+    unsigned long bucketStart_{0};
+    Accumulator pending_;
+  };
+
+  HistoryBucket fineSlots_[config::HISTORY_FINE_BUCKETS];
+  HistoryBucket coarseSlots_[config::HISTORY_COARSE_BUCKETS];
+  Tier fine_;
+  Tier coarse_;
+  bool started_{false};
+};
+
+}  // namespace history
@@ -0,0 +1,173 @@
+#include "logging/Log.h"
+
+#include <stdarg.h>
+
+#include "text/MessageCatalog.h"
+
+namespace logging {
+namespace {
+constexpr size_t REPEAT_SLOTS = 8;
+constexpr char LEVEL_LETTERS[] = "EWID";
+constexpr char LINE_END[] = "\r\n";
+
+struct RepeatSlot {
+  uint32_t hash = 0;
+  unsigned long windowStart = 0;
+  uint32_t suppressed = 0;
+  bool used = false;
+};
+
+char ring[config::LOG_BUFFER_BYTES];
+size_t ringHead = 0;  // Next byte to send
+size_t ringCount = 0;
+bool muted = false;
+RepeatSlot repeats[REPEAT_SLOTS];
+LogStats counters;
+
+uint32_t fnv1a(uint32_t hash, const char *data, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+// Returns false when the identical line already went out in the current window.
+// Otherwise *foldedOut receives how many copies were held back since the last one.
+bool admitRepeat(uint32_t hash, unsigned long now, uint32_t *foldedOut) {
+  *foldedOut = 0;
+  if (config::LOG_REPEAT_WINDOW_MS == 0) {
+    return true;
+  }
+  RepeatSlot *victim = &repeats[0];
+  for (RepeatSlot &slot : repeats) {
+    if (slot.used && slot.hash == hash) {
+      if (now - slot.windowStart < config::LOG_REPEAT_WINDOW_MS) {
+        ++slot.suppressed;
+        ++counters.suppressed;
+        return false;
+      }
+      *foldedOut = slot.suppressed;
+      slot.suppressed = 0;
+      slot.windowStart = now;
+      return true;
+    }
+    if (!slot.used) {
+      victim = &slot;
+    } else if (victim->used && now - slot.windowStart > now - victim->windowStart) {
+      victim = &slot;
+    }
+  }
+  victim->used = true;
+  victim->hash = hash;
+  victim->windowStart = now;
+  victim->suppressed = 0;
+  return true;
+}
+
+void push(const char *data, size_t length) {
+  size_t tail = (ringHead + ringCount) % config::LOG_BUFFER_BYTES;
+  for (size_t i = 0; i < length; ++i) {
+    ring[tail] = data[i];
+    tail = tail + 1 == config::LOG_BUFFER_BYTES ? 0 : tail + 1;
+  }
+  ringCount += length;
+  if (ringCount > counters.highWaterBytes) {
+    counters.highWaterBytes = ringCount;
+  }
+}
+}  // namespace
+
+void write(Level level, PGM_P format, ...) {
+  const unsigned long now = millis();
+  char line[config::LOG_LINE_MAX];
+  const int prefix = snprintf_P(line, sizeof(line), PSTR("[%lu.%03lu] %c "), now / 1000UL, now % 1000UL,
+                                LEVEL_LETTERS[static_cast<uint8_t>(level) & 0x03]);
+  size_t length = prefix > 0 ? static_cast<size_t>(prefix) : 0;
+
+  va_list args;
+  va_start(args, format);
+  const int body = vsnprintf_P(line + length, sizeof(line) - length, format, args);
+  va_end(args);
+  if (body < 0) {
+    return;
+  }
+  const size_t bodyRoom = sizeof(line) - length - 1;
+  if (static_cast<size_t>(body) > bodyRoom) {
+    ++counters.truncated;
+    length = sizeof(line) - 1;
+  } else {
+    length += static_cast<size_t>(body);
+  }
+
+  // The timestamp is left out of the hash so identical messages match.
+  uint32_t folded = 0;
+  const uint32_t hash = fnv1a(2166136261UL ^ static_cast<uint8_t>(level), line + prefix, length - prefix);
+  if (!admitRepeat(hash, now, &folded)) {
+    return;
+  }
+
+  char suffix[28];
+  size_t suffixLength = 0;
+  if (folded > 0) {
+    suffixLength = static_cast<size_t>(
+        snprintf_P(suffix, sizeof(suffix), PSTR(" (+%lu tekrar)"), static_cast<unsigned long>(folded)));
+  }
+  const size_t total = length + suffixLength + sizeof(LINE_END) - 1;
+  if (total > config::LOG_BUFFER_BYTES - ringCount) {
+    ++counters.droppedLines;
+    counters.droppedBytes += total;
+    return;
+  }
+  push(line, length);
+  push(suffix, suffixLength);
+  push(LINE_END, sizeof(LINE_END) - 1);
+  ++counters.lines;
+}
+
+void update() {
+  while (!muted && ringCount > 0) {
+    const int room = Serial.availableForWrite();
+    if (room <= 0) {
+      return;
+    }
+    size_t chunk = config::LOG_BUFFER_BYTES - ringHead;  // Contiguous part up to the wrap
+    if (chunk > ringCount) {
+      chunk = ringCount;
+    }
+    if (chunk > static_cast<size_t>(room)) {
+      chunk = static_cast<size_t>(room);
+    }
+    const size_t written = Serial.write(reinterpret_cast<const uint8_t *>(ring + ringHead), chunk);
+    if (written == 0) {
+      return;
+    }
+    ringHead = (ringHead + written) % config::LOG_BUFFER_BYTES;
+    ringCount -= written;
+  }
+}
+
+void flush() {
+  while (!muted && ringCount > 0) {
+    update();
+    yield();
+  }
+  Serial.flush();
+}
+
+void setMuted(bool value) { muted = value; }
+
+size_t pendingBytes() { return ringCount; }
+
+const LogStats &stats() { return counters; }
+
+String formatStats() {
+  const text::Arg args[] = {counters.lines,      counters.droppedLines,   counters.droppedBytes,
+                            counters.suppressed, counters.truncated,      counters.highWaterBytes,
+                            config::LOG_BUFFER_BYTES};
+  String message;
+  text::append(message, text::MessageId::LogStats, args, sizeof(args) / sizeof(args[0]));
+  return message;
+}
+
+}  // namespace logging
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+namespace logging {
+
+enum class Level : uint8_t {
+  Error = 0,
+  Warn = 1,
+  Info = 2,
+  Debug = 3,
+};
+
+struct LogStats {
+  uint32_t lines = 0;         // Lines accepted into the ring
+  uint32_t droppedLines = 0;  // Ring full: line discarded
+  uint32_t droppedBytes = 0;
+  uint32_t suppressed = 0;    // Identical lines folded by the repeat limiter
+  uint32_t truncated = 0;     // Longer than LOG_LINE_MAX
+  size_t highWaterBytes = 0;  // Peak ring fill
+};
+
+constexpr bool enabled(Level level) { return static_cast<uint8_t>(level) <= config::LOG_LEVEL; }
+
+// Formats into a fixed line buffer and queues the line; never touches the UART
+// and never allocates. Lines that do not fit into the ring are counted and dropped.
+void write(Level level, PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+// Moves queued bytes into the UART FIFO without blocking; call once per loop() pass.
+void update();
+// Blocks until the ring is empty (setup and restart paths only).
+void flush();
+// While muted the UART belongs to someone else (binary sample stream); lines keep
+// queueing and are dropped once the ring is full.
+void setMuted(bool muted);
+
+size_t pendingBytes();
+const LogStats &stats();
+String formatStats();
+
+}  // namespace logging
+
+// The level test is a constant expression, so disabled levels compile to nothing:
+// neither the call nor its format string ends up in the image.
+#define LOG_AT(level, fmt, ...)                                  \
+  do {                                                           \
+    if (logging::enabled(level)) {                               \
+      logging::write((level), PSTR(fmt), ##__VA_ARGS__);         \
+    }                                                            \
+  } while (0)
+
+#define LOG_ERROR(fmt, ...) LOG_AT(logging::Level::Error, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(logging::Level::Warn, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(logging::Level::Info, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LOG_AT(logging::Level::Debug, fmt, ##__VA_ARGS__)
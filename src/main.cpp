@@ -3,12 +3,29 @@
 
 #include "blink/BlinkController.h"
 #include "config.h"
+#include "fleet/FleetNode.h"
+#include "history/HistoryStore.h"
+#include "logging/Log.h"
+#include "metrics/MetricsServer.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
+#include "notify/NotificationSinks.h"
+#include "profiling/HeapMonitor.h"
+#include "profiling/StageProfiler.h"
 #include "protection/ProtectionController.h"
 #include "protection/ProtectionStorage.h"
+#include "sensor/AdaptiveSampler.h"
 #include "sensor/MeasurementAggregator.h"
 #include "sensor/TemperatureSensor.h"
+#include "stream/SampleStream.h"
+#include "telegram/ReportDeadband.h"
 #include "telegram/TelegramCommandProcessor.h"
 #include "telegram/TelegramService.h"
+#include "text/MessageCatalog.h"
+#include "timeseries/TimeSeriesLog.h"
+#include "timeseries/WallClock.h"
+#include "trace/TraceRecorder.h"
+#include "watchdog/LoopWatchdog.h"
 
 namespace {
 constexpr uint8_t LED_PIN = LED_BUILTIN;
@@ -21,6 +38,13 @@ blink::LedMode activeLedMode = blink::LedMode::Normal;
 sensor::TemperatureSensor temperatureSensor;
 sensor::MeasurementAggregator ambientAggregator;
 sensor::MeasurementAggregator objectAggregator;
+sensor::AdaptiveSampler measurementSampler({
+    config::MEASUREMENT_INTERVAL_MS,
+    config::MEASUREMENT_INTERVAL_MIN_MS,
+    config::MEASUREMENT_INTERVAL_MAX_MS,
+    config::ADAPTIVE_SAMPLING_MARGIN_C,
+    config::ADAPTIVE_SAMPLING_SLOPE_C_PER_S,
+});
 
 protection::ProtectionSettings defaultProtectionSettings{
     config::OBJECT_TEMP_MIN_C,
@@ -28,32 +52,51 @@ protection::ProtectionSettings defaultProtectionSettings{
     config::OBJECT_TEMP_HYSTERESIS_C,
     config::PROTECTION_MIN_SAMPLES,
     config::PROTECTION_RENOTIFY_INTERVAL_MS,
+    config::TELEGRAM_REPORT_DEADBAND_C,
+    config::TELEGRAM_REPORT_MAX_SILENCE_MS,
 };
 
 protection::ProtectionController protectionController(defaultProtectionSettings);
 protection::ProtectionSettingsStorage protectionStorage;
 
+profiling::HeapMonitor heapMonitor;
+history::HistoryStore historyStore;
+timeseries::TimeSeriesLog timeSeriesLog;
+
 telegram::TelegramService telegramService;
-telegram::TelegramCommandProcessor commandProcessor(protectionController, protectionStorage, telegramService);
+mqtt::MqttService mqttService;
+
+notify::NotificationBus notificationBus;
+fleet::FleetNode fleetNode(notificationBus, telegramService);
+notify::TelegramSink telegramSink(telegramService, fleetNode);
+notify::SerialSink serialSink;
+notify::UdpSink udpSink;
+notify::FileLogSink fileLogSink;
+notify::MqttSink mqttSink(mqttService);
+notify::FleetSink fleetSink(fleetNode);
+
+telegram::TelegramCommandProcessor commandProcessor(protectionController, protectionStorage, telegramService,
+                                                    heapMonitor, historyStore, timeSeriesLog, mqttService,
+                                                    notificationBus, fleetNode);
 
-unsigned long lastTelegramReport = 0;
-telegram::TelegramService *globalTelegramService = nullptr;
+metrics::MetricsServer metricsServer({protectionController, objectAggregator, ambientAggregator, telegramService,
+                                      mqttService, heapMonitor});
+
+telegram::ReportDeadband reportDeadband;
+
+unsigned long lastReport = 0;
+bool sensorFaultReported = false;
 
 void setLedMode(blink::LedMode mode) {
   blinkController.setMode(mode);
   activeLedMode = mode;
 }
 
-void notifyProtectionEvent(const String &message) {
-  Serial.println(message);
-  if (globalTelegramService) {
-    globalTelegramService->sendAlert(message);
-  }
-}
+void maybeProcessMeasurement(unsigned long now);
 
 bool connectToWifi() {
   if (strlen(config::WIFI_SSID) == 0) {
-    Serial.println(F("Wi-Fi SSID bos. config.h dosyasini guncelleyin."));
+    LOG_ERROR("Wi-Fi SSID bos. config.h dosyasini guncelleyin.");
     setLedMode(blink::LedMode::WifiError);
     return false;
   }
@@ -62,21 +105,28 @@ bool connectToWifi() {
   WiFi.mode(WIFI_STA);
   WiFi.begin(config::WIFI_SSID, config::WIFI_PASSWORD);
 
-  Serial.print(F("Wi-Fi baglaniliyor"));
+  LOG_INFO("Wi-Fi baglaniliyor: %s", config::WIFI_SSID);
   const unsigned long start = millis();
   while (WiFi.status() != WL_CONNECTED && millis() - start < config::WIFI_CONNECT_TIMEOUT_MS) {
+    // Protection keeps running through the wait; it is also what feeds the watchdog.
+    maybeProcessMeasurement(millis());
     blinkController.update();
+    logging::update();
     delay(10);
   }
 
   if (WiFi.status() == WL_CONNECTED) {
-    Serial.println(F(" [BASARILI]"));
+    LOG_INFO("Wi-Fi baglandi, IP %s", WiFi.localIP().toString().c_str());
     setLedMode(blink::LedMode::Normal);
-    telegramService.trySendStartupMessage();
+    timeseries::beginWallClock();
+    metricsServer.begin();
+    if (fleetNode.ownsTelegram()) {
+      telegramService.trySendStartupMessage();
+    }
     return true;
   }
 
-  Serial.println(F(" [HATA]"));
+  LOG_WARN("Wi-Fi baglanamadi");
   setLedMode(blink::LedMode::WifiError);
   return false;
 }
@@ -89,99 +139,241 @@ void maybeProcessMeasurement(unsigned long now) {
   if (!temperatureSensor.ready()) {
     return;
   }
-  if (now - lastMeasurementAttempt < config::MEASUREMENT_INTERVAL_MS) {
+  const unsigned long intervalMs =
+      config::ENABLE_ADAPTIVE_SAMPLING ? measurementSampler.intervalMs() : config::MEASUREMENT_INTERVAL_MS;
+  if (now - lastMeasurementAttempt < intervalMs) {
     return;
   }
+  // Weight by the time that really passed: a loop held up by network I/O reads
+  // later than planned. Capped so one late read cannot stand for a long gap.
+  unsigned long weightMs = lastMeasurementAttempt == 0 ? intervalMs : now - lastMeasurementAttempt;
+  if (weightMs > config::MEASUREMENT_INTERVAL_MAX_MS) {
+    weightMs = config::MEASUREMENT_INTERVAL_MAX_MS;
+  }
   lastMeasurementAttempt = now;
 
   float ambientC = 0.0f;
   float objectC = 0.0f;
-  if (!temperatureSensor.read(ambientC, objectC)) {
-    Serial.println(F("Olcum alinamadi"));
+  const bool readOk = temperatureSensor.read(ambientC, objectC);
+  trace::recordReading(now, weightMs, readOk, ambientC, objectC);
+  if (!readOk) {
+    LOG_WARN("Olcum alinamadi");
     setLedMode(blink::LedMode::DataError);
+    if (!sensorFaultReported) {
+      sensorFaultReported = true;
+      notificationBus.publish(notify::Severity::Warning, notify::EventType::SensorFault,
+                              text::format(text::MessageId::SensorReadFailed));
+    }
     return;
   }
+  if (sensorFaultReported) {
+    sensorFaultReported = false;
+    notificationBus.publish(notify::Severity::Info, notify::EventType::SensorFault,
+                            text::format(text::MessageId::SensorRecovered));
+  }
 
-  ambientAggregator.addSample(ambientC);
-  objectAggregator.addSample(objectC);
-  Serial.print(F("MLX90614 -> Nesne: "));
-  Serial.print(objectC, 2);
-  Serial.print(F(" C, Ortam: "));
-  Serial.print(ambientC, 2);
-  Serial.println(F(" C"));
+  ambientAggregator.addSample(ambientC, weightMs);
+  objectAggregator.addSample(objectC, weightMs);
+  if (config::ENABLE_ADAPTIVE_SAMPLING) {
+    const protection::ProtectionSettings &limits = protectionController.settings();
+    measurementSampler.update(objectC, now, limits.minC, limits.maxC);
+  }
+  LOG_DEBUG("MLX90614 -> Nesne: %.2f C, Ortam: %.2f C", objectC, ambientC);
 
   if (activeLedMode == blink::LedMode::DataError) {
     setLedMode(blink::LedMode::Normal);
   }
 
   const sensor::MeasurementStats objectStats = objectAggregator.stats();
-  protectionController.handleProtection(objectStats, now);
+  {
+    profiling::ScopedStageTimer timer(profiling::Stage::Protection);
+    protectionController.handleProtection(objectStats, now);
+  }
+  watchdog::feed();
+  const bool heating = protectionController.heatingActive();
+  const bool cooling = protectionController.coolingActive();
+  historyStore.addSample(now, objectC, ambientC, heating, cooling, weightMs);
+  const uint8_t flags = (heating ? history::HISTORY_HEATING : 0) | (cooling ? history::HISTORY_COOLING : 0);
+
+  uint64_t timestampMs = 0;
+  const bool clockValid = timeseries::wallClockNowMs(timestampMs);
+  if (config::ENABLE_TIMESERIES_LOG && clockValid) {
+    timeseries::SeriesPoint point;
+    point.timestampMs = timestampMs;
+    point.objectCenti = static_cast<int32_t>(lroundf(objectC * 100.0f));
+    point.ambientCenti = static_cast<int32_t>(lroundf(ambientC * 100.0f));
+    point.flags = flags;
+    timeSeriesLog.append(point);
+  }
+  mqttService.publishSample(clockValid ? timestampMs : 0, objectC, ambientC, heating, cooling);
+  fleetNode.publishSample(objectC, ambientC, flags);
 }
 
-void maybeSendTelegramReport(unsigned long now) {
-  if (!telegramService.configured() || WiFi.status() != WL_CONNECTED) {
+// Raw reads for the binary serial stream, independent of the filtered measurement path
+// so the aggregators, flash log and MQTT keep their normal rate.
+void maybeStreamSample(unsigned long now) {
+  static unsigned long lastStreamRead = 0;
+  if (!stream::active() || !temperatureSensor.ready() || now - lastStreamRead < config::STREAM_SAMPLE_INTERVAL_MS) {
     return;
   }
+  lastStreamRead = now;
+  float ambientC = 0.0f;
+  float objectC = 0.0f;
+  const bool readOk = temperatureSensor.read(ambientC, objectC);
+  stream::emit(now, readOk, ambientC, objectC, protectionController.heatingActive(),
+               protectionController.coolingActive());
+}
 
-  if (now - lastTelegramReport < config::TELEGRAM_REPORT_INTERVAL_MS) {
+void maybePublishMqttWindow(unsigned long now) {
+  static unsigned long lastWindowPublish = 0;
+  if (config::MQTT_TELEMETRY_PER_SAMPLE || !mqttService.connected() ||
+      now - lastWindowPublish < config::TELEGRAM_REPORT_INTERVAL_MS) {
     return;
   }
-  lastTelegramReport = now;
+  lastWindowPublish = now;
+  if (!objectAggregator.hasSamples() || !ambientAggregator.hasSamples()) {
+    return;
+  }
+  uint64_t timestampMs = 0;
+  if (!timeseries::wallClockNowMs(timestampMs)) {
+    timestampMs = 0;
+  }
+  mqttService.publishWindow(timestampMs, objectAggregator.stats(), ambientAggregator.stats(),
+                            protectionController.heatingActive(), protectionController.coolingActive());
+}
+
+void maybePublishReport(unsigned long now) {
+  if (now - lastReport < config::TELEGRAM_REPORT_INTERVAL_MS) {
+    return;
+  }
+  lastReport = now;
 
   if (!objectAggregator.hasSamples() || !ambientAggregator.hasSamples()) {
     if (config::ENABLE_DATA_FETCH) {
-      telegramService.sendInfo(String(config::TELEGRAM_NO_DATA_MESSAGE));
+      notificationBus.publish(notify::Severity::Info, notify::EventType::Report,
+                              text::format(text::MessageId::NoData));
     }
     return;
   }
 
   const sensor::MeasurementStats ambientStats = ambientAggregator.stats();
   const sensor::MeasurementStats objectStats = objectAggregator.stats();
-  const String message = protectionController.formatMeasurementReport(ambientStats, objectStats);
-  if (telegramService.sendInfo(message)) {
+  const bool heating = protectionController.heatingActive();
+  const bool cooling = protectionController.coolingActive();
+  const protection::ProtectionSettings &settings = protectionController.settings();
+  if (!reportDeadband.shouldSend(ambientStats, objectStats, heating, cooling, now, settings.reportDeltaC,
+                                 settings.reportMaxSilenceMs)) {
+    reportDeadband.markSuppressed();
     ambientAggregator.reset();
     objectAggregator.reset();
+    trace::recordWindowReset(now);
+    return;
   }
+
+  String message;
+  size_t stateLength = 0;
+  {
+    profiling::ScopedStageTimer timer(profiling::Stage::ReportFormat);
+    message = protectionController.formatMeasurementReport(ambientStats, objectStats);
+    stateLength = message.length();
+    if (config::ENABLE_HEAP_MONITOR) {
+      message += '\n';
+      message += heapMonitor.formatReportLine();
+    }
+    if (reportDeadband.suppressedTotal() > 0) {
+      text::append(message, text::MessageId::ReportSuppressed, reportDeadband.suppressedSinceLastSend(),
+                   reportDeadband.suppressedTotal());
+    }
+  }
+  // Sinks retry on their own; a newer report supersedes one that is still queued.
+  notificationBus.publish(notify::Severity::Info, notify::EventType::Report, message, stateLength);
+  reportDeadband.markSent(ambientStats, objectStats, heating, cooling, now);
+  ambientAggregator.reset();
+  objectAggregator.reset();
+  trace::recordWindowReset(now);
 }
 
 void initializeProtectionHardware() {
   protectionController.initializeHardware();
-  protectionController.setNotificationCallback(notifyProtectionEvent);
+  protectionController.setNotificationBus(&notificationBus);
+  watchdog::begin(protectionController);
+}
+
+void handleStallEvents(unsigned long now) {
+  watchdog::StallEvent event;
+  if (!watchdog::takePendingEvent(event)) {
+    return;
+  }
+  protectionController.acknowledgeForcedSafeState(now);
+  trace::recordSafeState(now);
+  notificationBus.publish(notify::Severity::Alert, notify::EventType::Stall, watchdog::formatEvent(event));
 }
 
 }  // namespace
 
 void setup() {
   Serial.begin(115200);
+  profiling::begin();
   blinkController.begin(LED_PIN, LED_ACTIVE_LEVEL, LED_INACTIVE_LEVEL);
   setLedMode(blink::LedMode::Normal);
 
   protection::ProtectionSettings storedSettings = protectionController.settings();
   if (protectionStorage.load(storedSettings)) {
     protectionController.applySettings(storedSettings);
-    Serial.println(F("EEPROM: koruma ayarlari yuklendi."));
+    LOG_INFO("EEPROM: koruma ayarlari yuklendi.");
   } else if (protectionStorage.save(protectionController.settings())) {
-    Serial.println(F("EEPROM: varsayilan koruma ayarlari kaydedildi."));
+    LOG_INFO("EEPROM: varsayilan koruma ayarlari kaydedildi.");
+  }
+
+  if (timeSeriesLog.begin()) {
+    LOG_INFO("LittleFS: zaman serisi kaydi hazir.");
+  }
+  if (trace::begin(millis(), protectionController.settings())) {
+    LOG_INFO("LittleFS: karar kaydi hazir.");
+  }
+
+  notificationBus.addSink(serialSink);
+  notificationBus.addSink(telegramSink);
+  notificationBus.addSink(mqttSink);
+  notificationBus.addSink(udpSink);
+  notificationBus.addSink(fleetSink);
+  if (fileLogSink.begin()) {
+    notificationBus.addSink(fileLogSink);
   }
 
   if (config::ENABLE_DATA_FETCH) {
     if (temperatureSensor.begin(config::I2C_SDA_PIN, config::I2C_SCL_PIN)) {
-      Serial.println(F("MLX90614 hazir"));
+      LOG_INFO("MLX90614 hazir");
     } else {
-      Serial.println(F("MLX90614 baslatilamadi"));
+      LOG_ERROR("MLX90614 baslatilamadi");
       setLedMode(blink::LedMode::DataError);
+      notificationBus.publish(notify::Severity::Warning, notify::EventType::SensorFault,
+                              text::format(text::MessageId::SensorInitFailed));
     }
   }
 
   initializeProtectionHardware();
-  globalTelegramService = &telegramService;
 
+  fleetNode.begin(config::FLEET_NODE_NAME, config::FLEET_GATEWAY_PRIORITY);
   connectToWifi();
+  stream::begin();
 }
 
 void loop() {
+  profiling::ScopedStageTimer loopTimer(profiling::Stage::Loop);
   blinkController.update();
+  logging::update();
   const unsigned long now = millis();
+  heapMonitor.update(now);
+  historyStore.update(now);
+  timeSeriesLog.update(now);
+  trace::update(now);
+  notificationBus.update(now);
+  stream::update();
+  maybeStreamSample(now);
+  // Ahead of the Wi-Fi gate: relays stay supervised while the network is down.
+  maybeProcessMeasurement(now);
+  handleStallEvents(now);
 
   if (WiFi.status() != WL_CONNECTED) {
     static unsigned long lastRetry = 0;
@@ -193,10 +385,26 @@ void loop() {
     return;
   }
 
-  telegramService.trySendStartupMessage();
-  maybeProcessMeasurement(now);
-  maybeSendTelegramReport(now);
-  telegramService.pollUpdates(now, commandProcessor, objectAggregator.stats());
+  fleetNode.update(now, commandProcessor, objectAggregator.stats());
+  // Fleet members leave Telegram to the gateway; the bot allows a single poller per token.
+  const bool ownsTelegram = fleetNode.ownsTelegram();
+  if (ownsTelegram) {
+    telegramService.trySendStartupMessage();
+    telegramService.flushPending();
+    telegramService.serviceUpload();
+  }
+  // Again between the network phases, each of which may block for seconds.
+  maybeProcessMeasurement(millis());
+  metricsServer.update();
+  maybePublishMqttWindow(now);
+  maybePublishReport(now);
+  if (ownsTelegram) {
+    telegramService.pollUpdates(now, commandProcessor, objectAggregator.stats());
+    maybeProcessMeasurement(millis());
+  }
+  mqttService.update(now, commandProcessor, objectAggregator.stats());
+  // Measurements, commands and watchdog resets above are the only relay writers.
+  trace::recordRelays(now, protectionController.heatingActive(), protectionController.coolingActive());
 
   if (activeLedMode != blink::LedMode::DataError && activeLedMode != blink::LedMode::Normal) {
     setLedMode(blink::LedMode::Normal);
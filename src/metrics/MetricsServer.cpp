@@ -0,0 +1,199 @@
+#include "metrics/MetricsServer.h"
+
+#include "config.h"
+#include "metrics/PrometheusWriter.h"
+#include "profiling/StageProfiler.h"
+#include "watchdog/LoopWatchdog.h"
+
+namespace metrics {
+namespace {
+constexpr size_t CONTENT_BUFFER_SIZE = 512;
+
+// Collects small writes and hands them to the web server as chunked content.
+class ContentPrint : public Print {
+public:
+  explicit ContentPrint(ESP8266WebServer &server) : server_(server) {}
+  ~ContentPrint() override { flush(); }
+
+  size_t write(uint8_t c) override {
+    if (used_ == CONTENT_BUFFER_SIZE) {
+      flush();
+    }
+    buffer_[used_++] = static_cast<char>(c);
+    return 1;
+  }
+  using Print::write;
+
+  void flush() override {
+    if (used_ > 0) {
+      server_.sendContent(buffer_, used_);
+      used_ = 0;
+    }
+  }
+
+private:
+  ESP8266WebServer &server_;
+  char buffer_[CONTENT_BUFFER_SIZE];
+  size_t used_{0};
+};
+
+void writeWindow(PrometheusWriter &writer, const __FlashStringHelper *name, const __FlashStringHelper *help,
+                 const sensor::MeasurementAggregator &aggregator) {
+  writer.family(name, F("gauge"), help);
+  if (!aggregator.hasSamples()) {
+    return;
+  }
+  const sensor::MeasurementStats stats = aggregator.stats();
+  writer.sampleDecimal(name, stats.last, F("window"), F("last"));
+  writer.sampleDecimal(name, stats.min, F("window"), F("min"));
+  writer.sampleDecimal(name, stats.average, F("window"), F("avg"));
+  writer.sampleDecimal(name, stats.max, F("window"), F("max"));
+}
+
+void writeStageHistograms(PrometheusWriter &writer) {
+  writer.family(F("tastan_stage_duration_cycles"), F("histogram"),
+                F("Loop stage durations in CPU cycles (see tastan_cpu_frequency_mhz)"));
+  for (size_t i = 0; i < profiling::STAGE_COUNT; ++i) {
+    const profiling::Stage stage = static_cast<profiling::Stage>(i);
+    const profiling::StageHistogram &h = profiling::histogram(stage);
+    uint64_t cumulative = 0;
+    for (uint8_t bucket = 0; bucket < profiling::HISTOGRAM_BUCKETS - 1; ++bucket) {
+      cumulative += h.buckets[bucket];
+      writer.beginSample(F("tastan_stage_duration_cycles"), F("_bucket"));
+      writer.label(F("stage"), profiling::stageName(stage));
+      writer.label(F("le"), profiling::bucketUpperBound(bucket));
+      writer.value(cumulative);
+    }
+    writer.beginSample(F("tastan_stage_duration_cycles"), F("_bucket"));
+    writer.label(F("stage"), profiling::stageName(stage));
+    writer.label(F("le"), F("+Inf"));
+    writer.value(static_cast<uint64_t>(h.count));
+    writer.beginSample(F("tastan_stage_duration_cycles"), F("_sum"));
+    writer.label(F("stage"), profiling::stageName(stage));
+    writer.value(h.sumCycles);
+    writer.beginSample(F("tastan_stage_duration_cycles"), F("_count"));
+    writer.label(F("stage"), profiling::stageName(stage));
+    writer.value(static_cast<uint64_t>(h.count));
+  }
+}
+}  // namespace
+
+void writeMetrics(const MetricsSources &sources, Print &out) {
+  PrometheusWriter writer(out);
+
+  writer.family(F("tastan_uptime_seconds"), F("gauge"), F("Seconds since boot"));
+  writer.sample(F("tastan_uptime_seconds"), static_cast<uint64_t>(millis() / 1000UL));
+
+  writeWindow(writer, F("tastan_object_temperature_celsius"),
+              F("Object temperature over the current report window"), sources.object);
+  writeWindow(writer, F("tastan_ambient_temperature_celsius"),
+              F("Ambient temperature over the current report window"), sources.ambient);
+  writer.family(F("tastan_window_samples"), F("gauge"), F("Samples in the current report window"));
+  writer.sample(F("tastan_window_samples"), static_cast<uint64_t>(sources.object.stats().count));
+
+  const protection::ProtectionController &protection = sources.protection;
+  writer.family(F("tastan_relay_active"), F("gauge"), F("1 while the relay is energised"));
+  writer.sample(F("tastan_relay_active"), protection.heatingActive() ? 1ULL : 0ULL, F("relay"), F("heating"));
+  writer.sample(F("tastan_relay_active"), protection.coolingActive() ? 1ULL : 0ULL, F("relay"), F("cooling"));
+  writer.family(F("tastan_relay_switches_total"), F("counter"), F("Relay state changes since boot"));
+  writer.sample(F("tastan_relay_switches_total"), static_cast<uint64_t>(protection.heatingSwitchCount()),
+                F("relay"), F("heating"));
+  writer.sample(F("tastan_relay_switches_total"), static_cast<uint64_t>(protection.coolingSwitchCount()),
+                F("relay"), F("cooling"));
+  writer.family(F("tastan_loop_stalls_total"), F("counter"), F("Loop stalls that forced the relays off"));
+  writer.sample(F("tastan_loop_stalls_total"), static_cast<uint64_t>(watchdog::stallCount()));
+
+  const telegram::TelegramService::SendCounters &counters = sources.telegram.counters();
+  writer.family(F("tastan_telegram_messages_total"), F("counter"), F("Telegram send outcomes"));
+  writer.sample(F("tastan_telegram_messages_total"), static_cast<uint64_t>(counters.sent), F("result"), F("sent"));
+  writer.sample(F("tastan_telegram_messages_total"), static_cast<uint64_t>(counters.deferred), F("result"),
+                F("deferred"));
+  writer.sample(F("tastan_telegram_messages_total"), static_cast<uint64_t>(counters.dropped), F("result"),
+                F("dropped"));
+  writer.sample(F("tastan_telegram_messages_total"), static_cast<uint64_t>(counters.throttled), F("result"),
+                F("throttled"));
+  writer.family(F("tastan_telegram_transport_errors_total"), F("counter"), F("Failed Telegram connections"));
+  writer.sample(F("tastan_telegram_transport_errors_total"), static_cast<uint64_t>(counters.transportErrors));
+  writer.family(F("tastan_telegram_polls_total"), F("counter"), F("getUpdates outcomes"));
+  writer.sample(F("tastan_telegram_polls_total"), static_cast<uint64_t>(counters.polls), F("result"), F("ok"));
+  writer.sample(F("tastan_telegram_polls_total"), static_cast<uint64_t>(counters.pollErrors), F("result"),
+                F("error"));
+  writer.family(F("tastan_telegram_pending"), F("gauge"), F("Messages waiting in the retry queue"));
+  writer.sample(F("tastan_telegram_pending"), static_cast<uint64_t>(sources.telegram.pendingCount()));
+
+  const telegram::TelegramService::TlsStats &tls = sources.telegram.tlsStats();
+  writer.family(F("tastan_tls_handshakes_total"), F("counter"), F("TLS handshakes with api.telegram.org"));
+  writer.sample(F("tastan_tls_handshakes_total"), static_cast<uint64_t>(tls.handshakes));
+  writer.family(F("tastan_tls_handshake_seconds_total"), F("counter"), F("Time spent in TLS handshakes"));
+  writer.sampleDecimal(F("tastan_tls_handshake_seconds_total"), static_cast<float>(tls.totalMs) / 1000.0f);
+  writer.family(F("tastan_tls_handshake_max_seconds"), F("gauge"), F("Slowest TLS handshake since boot"));
+  writer.sampleDecimal(F("tastan_tls_handshake_max_seconds"), static_cast<float>(tls.maxMs) / 1000.0f);
+
+  if (sources.mqtt.configured()) {
+    const mqtt::MqttService::PublishStats &mqtt = sources.mqtt.stats();
+    writer.family(F("tastan_mqtt_connected"), F("gauge"), F("1 while the broker session is up"));
+    writer.sample(F("tastan_mqtt_connected"), sources.mqtt.connected() ? 1ULL : 0ULL);
+    writer.family(F("tastan_mqtt_publishes_total"), F("counter"), F("MQTT publish attempts"));
+    writer.sample(F("tastan_mqtt_publishes_total"), static_cast<uint64_t>(mqtt.published), F("result"), F("ok"));
+    writer.sample(F("tastan_mqtt_publishes_total"), static_cast<uint64_t>(mqtt.failed), F("result"), F("error"));
+    writer.family(F("tastan_mqtt_publish_write_seconds_total"), F("counter"),
+                  F("Time spent writing publishes to the socket"));
+    writer.sampleDecimal(F("tastan_mqtt_publish_write_seconds_total"),
+                         static_cast<float>(mqtt.totalWriteUs) / 1000000.0f);
+    writer.family(F("tastan_mqtt_acks_total"), F("counter"), F("QoS 1 events acknowledged by the broker"));
+    writer.sample(F("tastan_mqtt_acks_total"), static_cast<uint64_t>(mqtt.acked));
+    writer.family(F("tastan_mqtt_ack_seconds_total"), F("counter"), F("Sum of QoS 1 publish to PUBACK times"));
+    writer.sampleDecimal(F("tastan_mqtt_ack_seconds_total"), static_cast<float>(mqtt.totalAckMs) / 1000.0f);
+    writer.family(F("tastan_mqtt_retransmits_total"), F("counter"), F("QoS 1 retransmissions"));
+    writer.sample(F("tastan_mqtt_retransmits_total"), static_cast<uint64_t>(mqtt.retransmits));
+    writer.family(F("tastan_mqtt_events_pending"), F("gauge"), F("Events waiting for PUBACK"));
+    writer.sample(F("tastan_mqtt_events_pending"), static_cast<uint64_t>(sources.mqtt.pendingEvents()));
+  }
+
+  const profiling::HeapSample &heap = sources.heap.current();
+  writer.family(F("tastan_heap_free_bytes"), F("gauge"), F("Free heap"));
+  writer.sample(F("tastan_heap_free_bytes"), static_cast<uint64_t>(heap.freeBytes));
+  writer.family(F("tastan_heap_free_min_bytes"), F("gauge"), F("Lowest free heap since boot"));
+  writer.sample(F("tastan_heap_free_min_bytes"), static_cast<uint64_t>(sources.heap.low().freeBytes));
+  writer.family(F("tastan_heap_max_block_bytes"), F("gauge"), F("Largest free heap block"));
+  writer.sample(F("tastan_heap_max_block_bytes"), static_cast<uint64_t>(heap.maxBlockBytes));
+  writer.family(F("tastan_heap_fragmentation_percent"), F("gauge"), F("Heap fragmentation"));
+  writer.sample(F("tastan_heap_fragmentation_percent"), static_cast<uint64_t>(heap.fragmentationPct));
+
+  writer.family(F("tastan_cpu_frequency_mhz"), F("gauge"), F("CPU clock used to convert cycle histograms"));
+  writer.sample(F("tastan_cpu_frequency_mhz"), static_cast<uint64_t>(ESP.getCpuFreqMHz()));
+  if (config::ENABLE_STAGE_PROFILER) {
+    writeStageHistograms(writer);
+  }
+}
+
+MetricsServer::MetricsServer(const MetricsSources &sources)
+    : server_(config::METRICS_HTTP_PORT), sources_(sources) {}
+
+void MetricsServer::begin() {
+  if (!config::ENABLE_METRICS_SERVER || started_) {
+    return;
+  }
+  server_.on(F("/metrics"), HTTP_GET, [this]() { handleMetrics(); });
+  server_.onNotFound([this]() { server_.send(404, F("text/plain"), F("not found\n")); });
+  server_.begin();
+  started_ = true;
+}
+
+void MetricsServer::update() {
+  if (started_) {
+    server_.handleClient();
+  }
+}
+
+void MetricsServer::handleMetrics() {
+  profiling::ScopedStageTimer timer(profiling::Stage::Metrics);
+  server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server_.send(200, F("text/plain; version=0.0.4"), F(""));
+  ContentPrint content(server_);
+  writeMetrics(sources_, content);
+  content.flush();
+  server_.sendContent(F(""));
+}
+
+}  // namespace metrics
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+#include "mqtt/MqttService.h"
+#include "profiling/HeapMonitor.h"
+#include "protection/ProtectionController.h"
+#include "sensor/MeasurementAggregator.h"
+#include "telegram/TelegramService.h"
+
+namespace metrics {
+
+struct MetricsSources {
+  const protection::ProtectionController &protection;
+  const sensor::MeasurementAggregator &object;
+  const sensor::MeasurementAggregator &ambient;
+  const telegram::TelegramService &telegram;
+  const mqtt::MqttService &mqtt;
+  const profiling::HeapMonitor &heap;
+};
+
+// Renders every exported metric to `out`; shared by the HTTP handler and host builds.
+void writeMetrics(const MetricsSources &sources, Print &out);
+
+// Serves GET /metrics on config::METRICS_HTTP_PORT. update() only polls the
+// listening socket, so it is cheap to call from every loop() iteration.
+class MetricsServer {
+public:
+  explicit MetricsServer(const MetricsSources &sources);
+
+  void begin();
+  void update();
+
+private:
+  void handleMetrics();
+
+  ESP8266WebServer server_;
+  MetricsSources sources_;
+  bool started_{false};
+};
+
+}  // namespace metrics
@@ -0,0 +1,101 @@
+#include "metrics/PrometheusWriter.h"
+
+#include <math.h>
+
+namespace metrics {
+
+void PrometheusWriter::family(const __FlashStringHelper *name, const __FlashStringHelper *type,
+                              const __FlashStringHelper *help) {
+  out_.print(F("# HELP "));
+  out_.print(name);
+  out_.print(' ');
+  out_.print(help);
+  out_.print(F("\n# TYPE "));
+  out_.print(name);
+  out_.print(' ');
+  out_.print(type);
+  out_.print('\n');
+}
+
+void PrometheusWriter::beginSample(const __FlashStringHelper *name, const __FlashStringHelper *suffix) {
+  out_.print(name);
+  if (suffix) {
+    out_.print(suffix);
+  }
+  labelOpen_ = false;
+}
+
+void PrometheusWriter::label(const __FlashStringHelper *name, const __FlashStringHelper *value) {
+  openLabel();
+  out_.print(name);
+  out_.print(F("=\""));
+  out_.print(value);
+  out_.print('"');
+}
+
+void PrometheusWriter::label(const __FlashStringHelper *name, uint32_t value) {
+  openLabel();
+  out_.print(name);
+  out_.print(F("=\""));
+  writeUnsigned(value);
+  out_.print('"');
+}
+
+void PrometheusWriter::value(uint64_t value) {
+  if (labelOpen_) {
+    out_.print('}');
+  }
+  out_.print(' ');
+  writeUnsigned(value);
+  out_.print('\n');
+}
+
+void PrometheusWriter::valueDecimal(float value) {
+  if (labelOpen_) {
+    out_.print('}');
+  }
+  out_.print(' ');
+  if (isnan(value)) {
+    out_.print(F("NaN"));
+  } else {
+    out_.print(value, 3);
+  }
+  out_.print('\n');
+}
+
+void PrometheusWriter::sample(const __FlashStringHelper *name, uint64_t value, const __FlashStringHelper *labelName,
+                              const __FlashStringHelper *labelValue) {
+  beginSample(name);
+  if (labelName) {
+    label(labelName, labelValue);
+  }
+  this->value(value);
+}
+
+void PrometheusWriter::sampleDecimal(const __FlashStringHelper *name, float value,
+                                     const __FlashStringHelper *labelName, const __FlashStringHelper *labelValue) {
+  beginSample(name);
+  if (labelName) {
+    label(labelName, labelValue);
+  }
+  valueDecimal(value);
+}
+
+void PrometheusWriter::openLabel() {
+  out_.print(labelOpen_ ? ',' : '{');
+  labelOpen_ = true;
+}
+
+void PrometheusWriter::writeUnsigned(uint64_t value) {
+  char digits[21];
+  size_t n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (n > 0) {
+    out_.print(digits[--n]);
+  }
+}
+
+}  // namespace metrics
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace metrics {
+
+// Writes Prometheus text exposition format (version 0.0.4) straight to a Print,
+// one token at a time, so a scrape never builds the response in RAM.
+class PrometheusWriter {
+public:
+  explicit PrometheusWriter(Print &out) : out_(out) {}
+
+  void family(const __FlashStringHelper *name, const __FlashStringHelper *type, const __FlashStringHelper *help);
+
+  // A sample line is beginSample(), any number of label() calls and value()/valueDecimal().
+  void beginSample(const __FlashStringHelper *name, const __FlashStringHelper *suffix = nullptr);
+  void label(const __FlashStringHelper *name, const __FlashStringHelper *value);
+  void label(const __FlashStringHelper *name, uint32_t value);
+  void value(uint64_t value);
+  void valueDecimal(float value);
+
+  void sample(const __FlashStringHelper *name, uint64_t value, const __FlashStringHelper *labelName = nullptr,
+              const __FlashStringHelper *labelValue = nullptr);
+  void sampleDecimal(const __FlashStringHelper *name, float value, const __FlashStringHelper *labelName = nullptr,
+                     const __FlashStringHelper *labelValue = nullptr);
+
+private:
+  void openLabel();
+  void writeUnsigned(uint64_t value);
+
+  Print &out_;
+  bool labelOpen_{false};
+};
+
+}  // namespace metrics
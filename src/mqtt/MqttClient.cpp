@@ -0,0 +1,345 @@
+#include "mqtt/MqttClient.h"
+
+#include <string.h>
+
+namespace mqtt {
+namespace {
+constexpr uint8_t PACKET_CONNECT = 0x10;
+constexpr uint8_t PACKET_CONNACK = 0x20;
+constexpr uint8_t PACKET_PUBLISH = 0x30;
+constexpr uint8_t PACKET_PUBACK = 0x40;
+constexpr uint8_t PACKET_SUBSCRIBE = 0x82;  // Reserved flags 0b0010 are mandatory
+constexpr uint8_t PACKET_SUBACK = 0x90;
+constexpr uint8_t PACKET_PINGREQ = 0xC0;
+constexpr uint8_t PACKET_PINGRESP = 0xD0;
+constexpr uint8_t PACKET_DISCONNECT = 0xE0;
+
+constexpr uint8_t CONNECT_CLEAN_SESSION = 0x02;
+constexpr uint8_t CONNECT_WILL = 0x04;
+constexpr uint8_t CONNECT_WILL_RETAIN = 0x20;
+constexpr uint8_t CONNECT_PASSWORD = 0x40;
+constexpr uint8_t CONNECT_USERNAME = 0x80;
+
+constexpr size_t FIXED_HEADER_MAX_BYTES = 5;
+constexpr size_t READ_BUDGET_BYTES = 2 * config::MQTT_MAX_PACKET_BYTES;  // Per loop() call
+
+size_t putString(uint8_t *out, const char *text, size_t length) {
+  out[0] = static_cast<uint8_t>(length >> 8);
+  out[1] = static_cast<uint8_t>(length);
+  memcpy(out + 2, text, length);
+  return 2 + length;
+}
+
+size_t putUint16(uint8_t *out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value >> 8);
+  out[1] = static_cast<uint8_t>(value);
+  return 2;
+}
+
+uint16_t getUint16(const uint8_t *in) {
+  return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+}  // namespace
+
+MqttClient::MqttClient(Client &transport) : transport_(transport) {}
+
+void MqttClient::setHandlers(MessageHandler onMessage, AckHandler onAck, void *context) {
+  onMessage_ = onMessage;
+  onAck_ = onAck;
+  context_ = context;
+}
+
+bool MqttClient::connect(const ConnectOptions &options, unsigned long timeoutMs) {
+  session_ = false;
+  connackReceived_ = false;
+  connectResult_ = 0xFF;
+  pingOutstanding_ = false;
+  rxState_ = RxState::Header;
+
+  const size_t clientIdLength = strlen(options.clientId);
+  const size_t willTopicLength = strlen(options.willTopic);
+  const size_t willMessageLength = strlen(options.willMessage);
+  const size_t usernameLength = strlen(options.username);
+  const size_t passwordLength = strlen(options.password);
+
+  uint8_t flags = CONNECT_CLEAN_SESSION;
+  size_t remaining = 10 + 2 + clientIdLength;
+  if (willTopicLength > 0) {
+    flags |= CONNECT_WILL | CONNECT_WILL_RETAIN;
+    remaining += 2 + willTopicLength + 2 + willMessageLength;
+  }
+  if (usernameLength > 0) {
+    flags |= CONNECT_USERNAME;
+    remaining += 2 + usernameLength;
+    if (passwordLength > 0) {
+      flags |= CONNECT_PASSWORD;
+      remaining += 2 + passwordLength;
+    }
+  }
+  if (remaining + FIXED_HEADER_MAX_BYTES > sizeof(txBuffer_)) {
+    return false;
+  }
+
+  size_t n = beginPacket(PACKET_CONNECT, remaining);
+  n += putString(txBuffer_ + n, "MQTT", 4);
+  txBuffer_[n++] = 4;  // Protocol level 3.1.1
+  txBuffer_[n++] = flags;
+  n += putUint16(txBuffer_ + n, options.keepAliveS);
+  n += putString(txBuffer_ + n, options.clientId, clientIdLength);
+  if (flags & CONNECT_WILL) {
+    n += putString(txBuffer_ + n, options.willTopic, willTopicLength);
+    n += putString(txBuffer_ + n, options.willMessage, willMessageLength);
+  }
+  if (flags & CONNECT_USERNAME) {
+    n += putString(txBuffer_ + n, options.username, usernameLength);
+  }
+  if (flags & CONNECT_PASSWORD) {
+    n += putString(txBuffer_ + n, options.password, passwordLength);
+  }
+  if (!writePacket(n)) {
+    return false;
+  }
+
+  const unsigned long start = millis();
+  while (!connackReceived_ && millis() - start < timeoutMs) {
+    if (!transport_.connected() || !readIncoming(READ_BUDGET_BYTES)) {
+      return false;
+    }
+    if (!connackReceived_) {
+      delay(1);
+    }
+  }
+  if (!connackReceived_ || connectResult_ != 0) {
+    transport_.stop();
+    return false;
+  }
+  session_ = true;
+  keepAliveMs_ = static_cast<unsigned long>(options.keepAliveS) * 1000UL;
+  lastInbound_ = millis();
+  return true;
+}
+
+bool MqttClient::connected() {
+  if (session_ && !transport_.connected()) {
+    session_ = false;
+  }
+  return session_;
+}
+
+void MqttClient::disconnect() {
+  if (session_) {
+    sendEmpty(PACKET_DISCONNECT);
+  }
+  session_ = false;
+  transport_.stop();
+}
+
+bool MqttClient::publish(const char *topic, const uint8_t *payload, size_t length, uint8_t qos, bool retain,
+                         uint16_t packetId, bool duplicate) {
+  if (!session_) {
+    return false;
+  }
+  const size_t topicLength = strlen(topic);
+  const size_t remaining = 2 + topicLength + (qos > 0 ? 2 : 0) + length;
+  if (remaining + FIXED_HEADER_MAX_BYTES > sizeof(txBuffer_)) {
+    return false;
+  }
+  uint8_t header = PACKET_PUBLISH | static_cast<uint8_t>(qos << 1);
+  if (retain) {
+    header |= 0x01;
+  }
+  if (duplicate && qos > 0) {
+    header |= 0x08;
+  }
+  size_t n = beginPacket(header, remaining);
+  n += putString(txBuffer_ + n, topic, topicLength);
+  if (qos > 0) {
+    n += putUint16(txBuffer_ + n, packetId);
+  }
+  memcpy(txBuffer_ + n, payload, length);
+  return writePacket(n + length);
+}
+
+bool MqttClient::subscribe(const char *topic, uint8_t qos, uint16_t packetId) {
+  if (!session_) {
+    return false;
+  }
+  const size_t topicLength = strlen(topic);
+  const size_t remaining = 2 + 2 + topicLength + 1;
+  if (remaining + FIXED_HEADER_MAX_BYTES > sizeof(txBuffer_)) {
+    return false;
+  }
+  size_t n = beginPacket(PACKET_SUBSCRIBE, remaining);
+  n += putUint16(txBuffer_ + n, packetId);
+  n += putString(txBuffer_ + n, topic, topicLength);
+  txBuffer_[n++] = qos;
+  return writePacket(n);
+}
+
+uint16_t MqttClient::nextPacketId() {
+  if (++packetId_ == 0) {
+    packetId_ = 1;  // 0 is not a valid packet identifier
+  }
+  return packetId_;
+}
+
+bool MqttClient::loop() {
+  if (!connected()) {
+    return false;
+  }
+  if (!readIncoming(READ_BUDGET_BYTES)) {
+    disconnect();
+    return false;
+  }
+  if (keepAliveMs_ == 0) {
+    return true;
+  }
+  const unsigned long now = millis();
+  if (pingOutstanding_ && now - lastInbound_ > keepAliveMs_) {
+    disconnect();
+    return false;
+  }
+  if (!pingOutstanding_ && (now - lastOutbound_ >= keepAliveMs_ || now - lastInbound_ >= keepAliveMs_)) {
+    if (!sendEmpty(PACKET_PINGREQ)) {
+      disconnect();
+      return false;
+    }
+    pingOutstanding_ = true;
+  }
+  return true;
+}
+
+size_t MqttClient::beginPacket(uint8_t header, size_t remainingLength) {
+  size_t n = 0;
+  txBuffer_[n++] = header;
+  do {
+    uint8_t digit = remainingLength % 128;
+    remainingLength /= 128;
+    if (remainingLength > 0) {
+      digit |= 0x80;
+    }
+    txBuffer_[n++] = digit;
+  } while (remainingLength > 0);
+  return n;
+}
+
+bool MqttClient::writePacket(size_t length) {
+  if (transport_.write(txBuffer_, length) != length) {
+    return false;
+  }
+  lastOutbound_ = millis();
+  return true;
+}
+
+bool MqttClient::sendEmpty(uint8_t header) {
+  const uint8_t packet[2] = {header, 0};
+  if (transport_.write(packet, sizeof(packet)) != sizeof(packet)) {
+    return false;
+  }
+  lastOutbound_ = millis();
+  return true;
+}
+
+bool MqttClient::readIncoming(size_t budget) {
+  while (budget > 0 && transport_.available() > 0) {
+    if (rxState_ == RxState::Header || rxState_ == RxState::Length) {
+      const int c = transport_.read();
+      if (c < 0) {
+        return true;
+      }
+      --budget;
+      if (rxState_ == RxState::Header) {
+        rxHeader_ = static_cast<uint8_t>(c);
+        rxLength_ = 0;
+        rxLengthShift_ = 0;
+        rxUsed_ = 0;
+        rxState_ = RxState::Length;
+        continue;
+      }
+      rxLength_ |= static_cast<uint32_t>(c & 0x7F) << rxLengthShift_;
+      rxLengthShift_ += 7;
+      if (c & 0x80) {
+        if (rxLengthShift_ >= 28) {
+          return false;  // Malformed remaining length
+        }
+        continue;
+      }
+      rxState_ = rxLength_ > sizeof(rxBuffer_) ? RxState::Skip : RxState::Body;
+    } else {
+      size_t chunk = rxLength_ - rxUsed_;
+      if (chunk > budget) {
+        chunk = budget;
+      }
+      uint8_t *target = rxBuffer_ + rxUsed_;
+      if (rxState_ == RxState::Skip) {
+        target = rxBuffer_;
+        if (chunk > sizeof(rxBuffer_)) {
+          chunk = sizeof(rxBuffer_);
+        }
+      }
+      const int got = transport_.read(target, chunk);
+      if (got <= 0) {
+        return true;
+      }
+      rxUsed_ += static_cast<size_t>(got);
+      budget -= static_cast<size_t>(got);
+    }
+
+    if ((rxState_ == RxState::Body || rxState_ == RxState::Skip) && rxUsed_ == rxLength_) {
+      lastInbound_ = millis();
+      if (rxState_ == RxState::Body) {
+        handlePacket();
+      }
+      rxState_ = RxState::Header;
+    }
+  }
+  return true;
+}
+
+void MqttClient::handlePacket() {
+  const uint8_t type = rxHeader_ & 0xF0;
+  switch (type) {
+    case PACKET_CONNACK:
+      if (rxLength_ >= 2) {
+        connackReceived_ = true;
+        connectResult_ = rxBuffer_[1];
+      }
+      break;
+    case PACKET_PUBLISH: {
+      if (rxLength_ < 2) {
+        break;
+      }
+      const uint8_t qos = (rxHeader_ >> 1) & 0x03;
+      const size_t topicLength = getUint16(rxBuffer_);
+      size_t position = 2 + topicLength;
+      if (position + (qos > 0 ? 2 : 0) > rxLength_) {
+        break;
+      }
+      if (qos > 0) {
+        uint8_t ack[4] = {PACKET_PUBACK, 2, rxBuffer_[position], rxBuffer_[position + 1]};
+        position += 2;
+        if (transport_.write(ack, sizeof(ack)) == sizeof(ack)) {
+          lastOutbound_ = millis();
+        }
+      }
+      if (onMessage_) {
+        onMessage_(reinterpret_cast<const char *>(rxBuffer_ + 2), topicLength, rxBuffer_ + position,
+                   rxLength_ - position, context_);
+      }
+      break;
+    }
+    case PACKET_PUBACK:
+      if (rxLength_ >= 2 && onAck_) {
+        onAck_(getUint16(rxBuffer_), context_);
+      }
+      break;
+    case PACKET_PINGRESP:
+      pingOutstanding_ = false;
+      break;
+    case PACKET_SUBACK:
+    default:
+      break;
+  }
+}
+
+}  // namespace mqtt
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "config.h"
+
+namespace mqtt {
+
+struct ConnectOptions {
+  const char *clientId = "";
+  const char *username = "";
+  const char *password = "";
+  const char *willTopic = "";  // Empty: no last will
+  const char *willMessage = "";
+  uint16_t keepAliveS = 30;
+};
+
+// Topic is not NUL-terminated; compare with topicLength.
+using MessageHandler = void (*)(const char *topic, size_t topicLength, const uint8_t *payload, size_t length,
+                                void *context);
+using AckHandler = void (*)(uint16_t packetId, void *context);
+
+// Minimal MQTT 3.1.1 client: clean session, QoS 0/1 publish, QoS 1 subscribe.
+// Every outgoing packet is assembled in one buffer and handed to the socket with
+// a single write, so a publish leaves as one TCP segment.
+class MqttClient {
+public:
+  explicit MqttClient(Client &transport);
+
+  void setHandlers(MessageHandler onMessage, AckHandler onAck, void *context);
+
+  // Sends CONNECT on an already connected transport and waits for CONNACK.
+  bool connect(const ConnectOptions &options, unsigned long timeoutMs);
+  bool connected();
+  void disconnect();
+
+  bool publish(const char *topic, const uint8_t *payload, size_t length, uint8_t qos, bool retain,
+               uint16_t packetId = 0, bool duplicate = false);
+  bool subscribe(const char *topic, uint8_t qos, uint16_t packetId);
+  uint16_t nextPacketId();
+
+  // Dispatches buffered packets and keeps the session alive. Returns false when
+  // the broker stopped answering or the socket closed.
+  bool loop();
+
+  uint8_t lastConnectResult() const { return connectResult_; }
+
+private:
+  enum class RxState : uint8_t {
+    Header,
+    Length,
+    Body,
+    Skip,  // Packet larger than the receive buffer; drained and dropped
+  };
+
+  bool writePacket(size_t length);
+  bool sendEmpty(uint8_t header);
+  size_t beginPacket(uint8_t header, size_t remainingLength);
+  bool readIncoming(size_t budget);
+  void handlePacket();
+
+  Client &transport_;
+  MessageHandler onMessage_{nullptr};
+  AckHandler onAck_{nullptr};
+  void *context_{nullptr};
+
+  uint8_t txBuffer_[config::MQTT_MAX_PACKET_BYTES];
+  uint8_t rxBuffer_[config::MQTT_MAX_PACKET_BYTES];
+  RxState rxState_{RxState::Header};
+  uint8_t rxHeader_{0};
+  uint32_t rxLength_{0};
+  uint8_t rxLengthShift_{0};
+  size_t rxUsed_{0};
+
+  bool session_{false};
+  bool connackReceived_{false};
+  uint8_t connectResult_{0xFF};
+  bool pingOutstanding_{false};
+  unsigned long keepAliveMs_{0};
+  uint16_t packetId_{0};
+  unsigned long lastOutbound_{0};
+  unsigned long lastInbound_{0};
+};
+
+}  // namespace mqtt
@@ -0,0 +1,360 @@
+#include "mqtt/MqttService.h"
+
+#include <string.h>
+
+#include "logging/Log.h"
+#include "profiling/StageProfiler.h"
+#include "telegram/MessageChunker.h"
+#include "telegram/TelegramCommandProcessor.h"
+#include "text/MessageCatalog.h"
+#include "watchdog/LoopWatchdog.h"
+
+namespace mqtt {
+namespace {
+constexpr unsigned long RATE_WINDOW_MS = 10000;
+constexpr char STATUS_ONLINE[] = "online";
+constexpr char STATUS_OFFLINE[] = "offline";
+constexpr size_t TOPIC_OVERHEAD_BYTES = 2 + 5;  // Topic length prefix + fixed header
+constexpr size_t UTF8_BYTES_PER_UNIT = 3;       // Worst case for MessageChunker's UTF-16 units
+
+// Appends a value rounded to 0.01 without float formatting.
+size_t appendCenti(char *out, size_t size, float value) {
+  const long centi = lroundf(value * 100.0f);
+  const unsigned long magnitude = static_cast<unsigned long>(centi < 0 ? -centi : centi);
+  return static_cast<size_t>(snprintf(out, size, "%s%lu.%02lu", centi < 0 ? "-" : "", magnitude / 100,
+                                      magnitude % 100));
+}
+
+size_t appendTimestamp(char *out, size_t size, uint64_t timestampMs) {
+  if (timestampMs == 0) {
+    return static_cast<size_t>(snprintf(out, size, "\"up\":%lu", static_cast<unsigned long>(millis())));
+  }
+  return static_cast<size_t>(snprintf(out, size, "\"ts\":%lu%03u", static_cast<unsigned long>(timestampMs / 1000ULL),
+                                      static_cast<unsigned>(timestampMs % 1000ULL)));
+}
+
+size_t appendWindow(char *out, size_t size, const char *key, const sensor::MeasurementStats &stats) {
+  size_t n = static_cast<size_t>(snprintf(out, size, ",\"%s\":[", key));
+  n += appendCenti(out + n, size - n, stats.min);
+  out[n++] = ',';
+  n += appendCenti(out + n, size - n, stats.average);
+  out[n++] = ',';
+  n += appendCenti(out + n, size - n, stats.max);
+  out[n++] = ',';
+  n += appendCenti(out + n, size - n, stats.last);
+  out[n++] = ']';
+  return n;
+}
+}  // namespace
+
+MqttService::MqttService() : client_(socket_) {
+  buildTopic(telemetryTopic_, "telemetry");
+  buildTopic(eventTopic_, "event");
+  buildTopic(statusTopic_, "status");
+  buildTopic(commandTopic_, "cmd");
+  buildTopic(replyTopic_, "cmd/reply");
+  client_.setHandlers(onMessage, onAck, this);
+}
+
+bool MqttService::configured() const {
+  return config::ENABLE_MQTT && strlen(config::MQTT_BROKER_HOST) > 0;
+}
+
+void MqttService::update(unsigned long now, telegram::TelegramCommandProcessor &processor,
+                         const sensor::MeasurementStats &objectStats) {
+  if (!configured()) {
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    if (connected_) {
+      handleDisconnect(now);
+    }
+    return;
+  }
+
+  watchdog::StageGuard stage(profiling::Stage::Mqtt);
+  profiling::ScopedStageTimer timer(profiling::Stage::Mqtt);
+  if (!connected_) {
+    if (now - lastAttempt_ < retryDelayMs_) {
+      return;
+    }
+    lastAttempt_ = now;
+    if (!tryConnect(now)) {
+      ++stats_.connectFailures;
+      retryDelayMs_ = retryDelayMs_ == 0 ? config::MQTT_RECONNECT_BASE_MS : retryDelayMs_ * 2;
+      if (retryDelayMs_ > config::MQTT_RECONNECT_MAX_MS) {
+        retryDelayMs_ = config::MQTT_RECONNECT_MAX_MS;
+      }
+      return;
+    }
+  }
+
+  processor_ = &processor;
+  objectStats_ = &objectStats;
+  const bool alive = client_.loop();
+  processor_ = nullptr;
+  objectStats_ = nullptr;
+  if (!alive) {
+    handleDisconnect(now);
+    return;
+  }
+  serviceEvents();
+  updateRate(now);
+}
+
+void MqttService::publishSample(uint64_t timestampMs, float objectC, float ambientC, bool heating, bool cooling) {
+  if (!connected_ || !config::MQTT_TELEMETRY_PER_SAMPLE) {
+    return;
+  }
+  char payload[128];
+  size_t n = 0;
+  payload[n++] = '{';
+  n += appendTimestamp(payload + n, sizeof(payload) - n, timestampMs);
+  n += static_cast<size_t>(snprintf(payload + n, sizeof(payload) - n, ",\"obj\":"));
+  n += appendCenti(payload + n, sizeof(payload) - n, objectC);
+  n += static_cast<size_t>(snprintf(payload + n, sizeof(payload) - n, ",\"amb\":"));
+  n += appendCenti(payload + n, sizeof(payload) - n, ambientC);
+  n += static_cast<size_t>(snprintf(payload + n, sizeof(payload) - n, ",\"heat\":%d,\"cool\":%d}", heating ? 1 : 0,
+                                    cooling ? 1 : 0));
+  publishTelemetry(payload, n);
+}
+
+void MqttService::publishWindow(uint64_t timestampMs, const sensor::MeasurementStats &objectStats,
+                                const sensor::MeasurementStats &ambientStats, bool heating, bool cooling) {
+  if (!connected_ || config::MQTT_TELEMETRY_PER_SAMPLE) {
+    return;
+  }
+  char payload[192];
+  size_t n = 0;
+  payload[n++] = '{';
+  n += appendTimestamp(payload + n, sizeof(payload) - n, timestampMs);
+  n += static_cast<size_t>(snprintf(payload + n, sizeof(payload) - n, ",\"n\":%lu",
+                                    static_cast<unsigned long>(objectStats.count)));
+  n += appendWindow(payload + n, sizeof(payload) - n, "obj", objectStats);
+  n += appendWindow(payload + n, sizeof(payload) - n, "amb", ambientStats);
+  n += static_cast<size_t>(snprintf(payload + n, sizeof(payload) - n, ",\"heat\":%d,\"cool\":%d}", heating ? 1 : 0,
+                                    cooling ? 1 : 0));
+  publishTelemetry(payload, n);
+}
+
+void MqttService::publishEvent(const String &message) {
+  if (!configured()) {
+    return;
+  }
+  if (eventCount_ == config::MQTT_QOS1_QUEUE) {
+    eventHead_ = (eventHead_ + 1) % config::MQTT_QOS1_QUEUE;
+    --eventCount_;
+    ++stats_.droppedEvents;
+  }
+  PendingEvent &event = events_[(eventHead_ + eventCount_) % config::MQTT_QOS1_QUEUE];
+  event.payload = message;
+  event.packetId = client_.nextPacketId();
+  event.sent = false;
+  ++eventCount_;
+  if (connected_) {
+    serviceEvents();
+  }
+}
+
+String MqttService::formatStats() const {
+  using text::MessageId;
+  if (!configured()) {
+    return text::format(MessageId::MqttOff);
+  }
+  String message = text::format(MessageId::MqttStats,
+                                connected_ ? MessageId::MqttConnected : MessageId::MqttDisconnected,
+                                stats_.published, String(stats_.ratePerSecond, 1), stats_.failed);
+  if (stats_.published > 0) {
+    text::append(message, MessageId::MqttWriteTimes,
+                 static_cast<unsigned long>(stats_.totalWriteUs / stats_.published), stats_.maxWriteUs);
+  }
+  text::append(message, MessageId::MqttAcks, stats_.acked);
+  if (stats_.acked > 0) {
+    text::append(message, MessageId::MqttAckTimes, stats_.lastAckMs,
+                 static_cast<unsigned long>(stats_.totalAckMs / stats_.acked), stats_.maxAckMs);
+  }
+  const text::Arg queueArgs[] = {stats_.retransmits, eventCount_,      stats_.droppedEvents,
+                                 stats_.commands,    stats_.connects,  stats_.connectFailures};
+  text::append(message, MessageId::MqttQueue, queueArgs, sizeof(queueArgs) / sizeof(queueArgs[0]));
+  return message;
+}
+
+bool MqttService::tryConnect(unsigned long now) {
+  socket_.setTimeout(config::MQTT_CONNECT_TIMEOUT_MS);
+  if (!socket_.connect(config::MQTT_BROKER_HOST, config::MQTT_BROKER_PORT)) {
+    return false;
+  }
+  socket_.setNoDelay(true);
+
+  ConnectOptions options;
+  options.clientId = config::MQTT_CLIENT_ID;
+  options.username = config::MQTT_USERNAME;
+  options.password = config::MQTT_PASSWORD;
+  options.willTopic = statusTopic_;
+  options.willMessage = STATUS_OFFLINE;
+  options.keepAliveS = config::MQTT_KEEPALIVE_S;
+  // One budget for TCP connect and CONNACK keeps the attempt below the loop stall budget.
+  const unsigned long elapsed = millis() - now;
+  const unsigned long remaining =
+      elapsed < config::MQTT_CONNECT_TIMEOUT_MS ? config::MQTT_CONNECT_TIMEOUT_MS - elapsed : 0;
+  if (!client_.connect(options, remaining)) {
+    LOG_WARN("MQTT baglanti reddedildi, kod %d", static_cast<int>(client_.lastConnectResult()));
+    client_.disconnect();
+    return false;
+  }
+  // The command topic carries full "set" authority; without broker ACLs anyone on the broker has it.
+  if (config::MQTT_ACCEPT_COMMANDS) {
+    if (!client_.subscribe(commandTopic_, 1, client_.nextPacketId())) {
+      client_.disconnect();
+      return false;
+    }
+    if (strlen(config::MQTT_USERNAME) == 0) {
+      LOG_WARN("MQTT: komut konusu kullanici adi olmadan acik.");
+    }
+  }
+  publishTimed(statusTopic_, STATUS_ONLINE, strlen(STATUS_ONLINE), 0, true);
+
+  connected_ = true;
+  retryDelayMs_ = 0;
+  ++stats_.connects;
+  rateWindowStart_ = now;
+  rateWindowCount_ = 0;
+  // Clean session: the broker forgot unacknowledged events, so they go out again.
+  for (size_t i = 0; i < eventCount_; ++i) {
+    PendingEvent &event = events_[(eventHead_ + i) % config::MQTT_QOS1_QUEUE];
+    event.sent = false;
+  }
+  serviceEvents();
+  LOG_INFO("MQTT: baglandi.");
+  return true;
+}
+
+void MqttService::handleDisconnect(unsigned long now) {
+  connected_ = false;
+  client_.disconnect();
+  lastAttempt_ = now;
+  retryDelayMs_ = config::MQTT_RECONNECT_BASE_MS;
+  LOG_WARN("MQTT: baglanti koptu.");
+}
+
+bool MqttService::publishTimed(const char *topic, const char *payload, size_t length, uint8_t qos, bool retain,
+                               uint16_t packetId, bool duplicate) {
+  const uint32_t start = micros();
+  const bool ok = client_.publish(topic, reinterpret_cast<const uint8_t *>(payload), length, qos, retain, packetId,
+                                  duplicate);
+  const uint32_t elapsedUs = micros() - start;
+  if (!ok) {
+    ++stats_.failed;
+    return false;
+  }
+  ++stats_.published;
+  ++rateWindowCount_;
+  stats_.lastWriteUs = elapsedUs;
+  stats_.totalWriteUs += elapsedUs;
+  if (elapsedUs > stats_.maxWriteUs) {
+    stats_.maxWriteUs = elapsedUs;
+  }
+  return true;
+}
+
+void MqttService::publishTelemetry(const char *payload, size_t length) {
+  watchdog::StageGuard stage(profiling::Stage::Mqtt);
+  profiling::ScopedStageTimer timer(profiling::Stage::Mqtt);
+  publishTimed(telemetryTopic_, payload, length, 0, true);
+}
+
+void MqttService::serviceEvents() {
+  const unsigned long now = millis();
+  for (size_t i = 0; i < eventCount_ && connected_; ++i) {
+    PendingEvent &event = events_[(eventHead_ + i) % config::MQTT_QOS1_QUEUE];
+    if (event.sent && now - event.sentAt < config::MQTT_ACK_TIMEOUT_MS) {
+      continue;
+    }
+    if (!publishTimed(eventTopic_, event.payload.c_str(), event.payload.length(), 1, true, event.packetId,
+                      event.sent)) {
+      return;
+    }
+    if (event.sent) {
+      ++stats_.retransmits;
+    }
+    event.sent = true;
+    event.sentAt = now;
+  }
+}
+
+void MqttService::updateRate(unsigned long now) {
+  const unsigned long elapsed = now - rateWindowStart_;
+  if (elapsed < RATE_WINDOW_MS) {
+    return;
+  }
+  stats_.ratePerSecond = static_cast<float>(rateWindowCount_) * 1000.0f / static_cast<float>(elapsed);
+  rateWindowStart_ = now;
+  rateWindowCount_ = 0;
+}
+
+void MqttService::buildTopic(char *out, const char *suffix) const {
+  snprintf(out, sizeof(telemetryTopic_), "%s/%s", config::MQTT_TOPIC_PREFIX, suffix);
+}
+
+void MqttService::onMessage(const char *topic, size_t topicLength, const uint8_t *payload, size_t length,
+                            void *context) {
+  MqttService &self = *static_cast<MqttService *>(context);
+  if (!config::MQTT_ACCEPT_COMMANDS || topicLength != strlen(self.commandTopic_) ||
+      strncmp(topic, self.commandTopic_, topicLength) != 0 || !self.processor_) {
+    return;
+  }
+  String text;
+  text.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    text += static_cast<char>(payload[i]);
+  }
+  text.trim();
+  if (text.length() == 0) {
+    return;
+  }
+  ++self.stats_.commands;
+  watchdog::StageGuard commandStage(profiling::Stage::Command);
+  profiling::ScopedStageTimer timer(profiling::Stage::Command);
+  self.processor_->processCommand(text, millis(), *self.objectStats_, sendReply, &self);
+}
+
+void MqttService::onAck(uint16_t packetId, void *context) {
+  MqttService &self = *static_cast<MqttService *>(context);
+  for (size_t i = 0; i < self.eventCount_; ++i) {
+    PendingEvent &event = self.events_[(self.eventHead_ + i) % config::MQTT_QOS1_QUEUE];
+    if (!event.sent || event.packetId != packetId) {
+      continue;
+    }
+    const uint32_t rttMs = millis() - event.sentAt;
+    ++self.stats_.acked;
+    self.stats_.lastAckMs = rttMs;
+    self.stats_.totalAckMs += rttMs;
+    if (rttMs > self.stats_.maxAckMs) {
+      self.stats_.maxAckMs = rttMs;
+    }
+    // Acks normally arrive in order; close the gap when one overtakes another.
+    for (size_t j = i; j + 1 < self.eventCount_; ++j) {
+      self.events_[(self.eventHead_ + j) % config::MQTT_QOS1_QUEUE] =
+          self.events_[(self.eventHead_ + j + 1) % config::MQTT_QOS1_QUEUE];
+    }
+    PendingEvent &last = self.events_[(self.eventHead_ + self.eventCount_ - 1) % config::MQTT_QOS1_QUEUE];
+    last.payload = String();
+    --self.eventCount_;
+    return;
+  }
+}
+
+void MqttService::sendReply(const String &text, void *context) {
+  MqttService &self = *static_cast<MqttService *>(context);
+  const size_t maxUnits =
+      (config::MQTT_MAX_PACKET_BYTES - TOPIC_OVERHEAD_BYTES - strlen(self.replyTopic_)) / UTF8_BYTES_PER_UNIT;
+  telegram::MessageChunker chunker(text.c_str(), text.length(), maxUnits);
+  telegram::TextSpan span;
+  while (chunker.next(span)) {
+    if (!self.publishTimed(self.replyTopic_, text.c_str() + span.offset, span.length, 0, false)) {
+      return;
+    }
+  }
+}
+
+}  // namespace mqtt
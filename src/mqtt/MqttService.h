@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "config.h"
+#include "mqtt/MqttClient.h"
+#include "sensor/MeasurementAggregator.h"
+
+namespace telegram {
+class TelegramCommandProcessor;
+}
+
+namespace mqtt {
+
+// Keeps one persistent broker connection next to Telegram. Telemetry goes to
+// <prefix>/telemetry (QoS 0, retained), protection events to <prefix>/event
+// (QoS 1, retained, retransmitted until acknowledged) and the commands the
+// Telegram bot understands are accepted on <prefix>/cmd.
+class MqttService {
+public:
+  struct PublishStats {
+    uint32_t published = 0;    // All PUBLISH packets written, including retransmissions
+    uint32_t failed = 0;
+    uint32_t acked = 0;
+    uint32_t retransmits = 0;
+    uint32_t droppedEvents = 0;  // Evicted from a full QoS 1 queue
+    uint32_t commands = 0;
+    uint32_t connects = 0;
+    uint32_t connectFailures = 0;
+    uint32_t lastWriteUs = 0;  // Time spent handing one publish to the socket
+    uint32_t maxWriteUs = 0;
+    uint64_t totalWriteUs = 0;
+    uint32_t lastAckMs = 0;    // QoS 1 publish -> PUBACK round trip
+    uint32_t maxAckMs = 0;
+    uint64_t totalAckMs = 0;
+    float ratePerSecond = 0.0f;  // Publishes per second over the last rate window
+  };
+
+  MqttService();
+
+  bool configured() const;
+  bool connected() const { return connected_; }
+
+  void update(unsigned long now, telegram::TelegramCommandProcessor &processor,
+              const sensor::MeasurementStats &objectStats);
+
+  void publishSample(uint64_t timestampMs, float objectC, float ambientC, bool heating, bool cooling);
+  void publishWindow(uint64_t timestampMs, const sensor::MeasurementStats &objectStats,
+                     const sensor::MeasurementStats &ambientStats, bool heating, bool cooling);
+  // Queued while disconnected; delivered at least once.
+  void publishEvent(const String &message);
+
+  const PublishStats &stats() const { return stats_; }
+  size_t pendingEvents() const { return eventCount_; }
+  String formatStats() const;
+
+private:
+  struct PendingEvent {
+    String payload;
+    uint16_t packetId = 0;
+    bool sent = false;
+    unsigned long sentAt = 0;
+  };
+
+  bool tryConnect(unsigned long now);
+  void handleDisconnect(unsigned long now);
+  bool publishTimed(const char *topic, const char *payload, size_t length, uint8_t qos, bool retain,
+                    uint16_t packetId = 0, bool duplicate = false);
+  void publishTelemetry(const char *payload, size_t length);
+  void serviceEvents();
+  void updateRate(unsigned long now);
+  void buildTopic(char *out, const char *suffix) const;
+
+  static void onMessage(const char *topic, size_t topicLength, const uint8_t *payload, size_t length,
+                        void *context);
+  static void onAck(uint16_t packetId, void *context);
+  static void sendReply(const String &text, void *context);
+
+  WiFiClient socket_;
+  MqttClient client_;
+  bool connected_{false};
+  unsigned long lastAttempt_{0};
+  unsigned long retryDelayMs_{0};
+
+  char telemetryTopic_[48];
+  char eventTopic_[48];
+  char statusTopic_[48];
+  char commandTopic_[48];
+  char replyTopic_[48];
+
+  PendingEvent events_[config::MQTT_QOS1_QUEUE];
+  size_t eventHead_{0};
+  size_t eventCount_{0};
+
+  // Valid only while update() runs the client loop; commands are handled from onMessage.
+  telegram::TelegramCommandProcessor *processor_{nullptr};
+  const sensor::MeasurementStats *objectStats_{nullptr};
+
+  PublishStats stats_;
+  unsigned long rateWindowStart_{0};
+  uint32_t rateWindowCount_{0};
+};
+
+}  // namespace mqtt
@@ -0,0 +1,194 @@
+#include "notify/NotificationBus.h"
+
+#include "profiling/StageProfiler.h"
+#include "text/MessageCatalog.h"
+
+namespace notify {
+
+static_assert(NotificationBus::MAX_SINKS <= 8, "pendingSinks is an 8-bit mask");
+
+const __FlashStringHelper *severityName(Severity severity) {
+  switch (severity) {
+    case Severity::Alert:
+      return F("ALARM");
+    case Severity::Warning:
+      return F("UYARI");
+    case Severity::Info:
+    default:
+      return F("BILGI");
+  }
+}
+
+const __FlashStringHelper *typeName(EventType type) {
+  switch (type) {
+    case EventType::Report:
+      return F("rapor");
+    case EventType::Protection:
+      return F("koruma");
+    case EventType::Stall:
+      return F("takilma");
+    case EventType::SensorFault:
+      return F("sensor");
+    case EventType::System:
+    default:
+      return F("sistem");
+  }
+}
+
+bool NotificationBus::addSink(NotificationSink &sink) {
+  if (sinkCount_ == MAX_SINKS) {
+    return false;
+  }
+  sinks_[sinkCount_++].sink = &sink;
+  return true;
+}
+
+void NotificationBus::publish(Severity severity, EventType type, const String &text, size_t stateLength) {
+  Notification notification;
+  notification.severity = severity;
+  notification.type = type;
+  notification.createdMs = millis();
+
+  uint8_t routes = 0;
+  for (size_t i = 0; i < sinkCount_; ++i) {
+    if (sinks_[i].sink->accepts(notification)) {
+      routes |= static_cast<uint8_t>(1U << i);
+    }
+  }
+  if (routes == 0) {
+    ++unrouted_;
+    return;
+  }
+  if (count_ == config::NOTIFY_QUEUE_LENGTH) {
+    evictOne();
+  }
+  Slot &slot = slotAt(count_++);
+  slot.notification = notification;
+  slot.notification.text = text;
+  slot.notification.stateLength = stateLength < text.length() ? stateLength : text.length();
+  slot.pendingSinks = routes;
+  ++published_;
+}
+
+void NotificationBus::update(unsigned long now) {
+  if (count_ == 0) {
+    return;
+  }
+  profiling::ScopedStageTimer timer(profiling::Stage::Notify);
+
+  // Fastest measured sink first; sinks that never delivered sort as zero so they get measured.
+  uint8_t order[MAX_SINKS];
+  for (size_t i = 0; i < sinkCount_; ++i) {
+    size_t j = i;
+    while (j > 0 && sinks_[order[j - 1]].latencyUs > sinks_[i].latencyUs) {
+      order[j] = order[j - 1];
+      --j;
+    }
+    order[j] = static_cast<uint8_t>(i);
+  }
+  for (size_t i = 0; i < sinkCount_ && count_ > 0; ++i) {
+    serviceSink(order[i], now);
+  }
+
+  while (count_ > 0 && slots_[head_].pendingSinks == 0) {
+    slots_[head_].notification.text = String();
+    head_ = (head_ + 1) % config::NOTIFY_QUEUE_LENGTH;
+    --count_;
+  }
+}
+
+String NotificationBus::formatStats() const {
+  using text::MessageId;
+  String message = text::format(MessageId::NotifyStats, count_, config::NOTIFY_QUEUE_LENGTH, published_, dropped_);
+  text::append(message, MessageId::NotifyUnrouted, unrouted_);
+  for (size_t i = 0; i < sinkCount_; ++i) {
+    const SinkState &state = sinks_[i];
+    const String average(static_cast<float>(state.latencyUs) / 1000.0f, 1);
+    const String maximum(static_cast<float>(state.maxLatencyUs) / 1000.0f, 1);
+    const text::Arg args[] = {state.sink->name(),
+                              state.sink->healthy() ? MessageId::NotifySinkReady : MessageId::NotifySinkWaiting,
+                              state.delivered,
+                              state.batches,
+                              average,
+                              maximum,
+                              state.failures};
+    text::append(message, MessageId::NotifySink, args, sizeof(args) / sizeof(args[0]));
+  }
+  return message;
+}
+
+void NotificationBus::evictOne() {
+  // Oldest event of the lowest severity goes first, so a burst of reports cannot push out an alert.
+  size_t victim = 0;
+  for (size_t i = 1; i < count_; ++i) {
+    if (slotAt(i).notification.severity < slotAt(victim).notification.severity) {
+      victim = i;
+    }
+  }
+  removeAt(victim);
+  ++dropped_;
+}
+
+void NotificationBus::removeAt(size_t index) {
+  for (size_t i = index; i + 1 < count_; ++i) {
+    Slot &target = slotAt(i);
+    Slot &source = slotAt(i + 1);
+    target.notification = source.notification;
+    target.pendingSinks = source.pendingSinks;
+  }
+  Slot &last = slotAt(count_ - 1);
+  last.notification.text = String();
+  last.pendingSinks = 0;
+  --count_;
+}
+
+void NotificationBus::serviceSink(size_t sinkIndex, unsigned long now) {
+  SinkState &state = sinks_[sinkIndex];
+  if (state.waiting && static_cast<long>(now - state.retryAt) < 0) {
+    return;
+  }
+  state.waiting = false;
+  if (!state.sink->healthy()) {
+    return;
+  }
+
+  const uint8_t bit = static_cast<uint8_t>(1U << sinkIndex);
+  const Notification *batch[config::NOTIFY_BATCH_MAX];
+  size_t positions[config::NOTIFY_BATCH_MAX];
+  size_t batchCount = 0;
+  for (size_t i = 0; i < count_ && batchCount < config::NOTIFY_BATCH_MAX; ++i) {
+    Slot &slot = slotAt(i);
+    if (slot.pendingSinks & bit) {
+      batch[batchCount] = &slot.notification;
+      positions[batchCount] = i;
+      ++batchCount;
+    }
+  }
+  if (batchCount == 0) {
+    return;
+  }
+
+  const uint32_t start = micros();
+  size_t consumed = state.sink->deliver(batch, batchCount);
+  const uint32_t elapsedUs = micros() - start;
+  if (consumed > batchCount) {
+    consumed = batchCount;
+  }
+  for (size_t i = 0; i < consumed; ++i) {
+    slotAt(positions[i]).pendingSinks &= static_cast<uint8_t>(~bit);
+  }
+  if (consumed == 0) {
+    ++state.failures;
+    state.waiting = true;
+    state.retryAt = now + config::NOTIFY_RETRY_MS;
+    return;
+  }
+  state.delivered += consumed;
+  ++state.batches;
+  state.latencyUs = state.batches == 1 ? elapsedUs : state.latencyUs - state.latencyUs / 4 + elapsedUs / 4;
+  if (elapsedUs > state.maxLatencyUs) {
+    state.maxLatencyUs = elapsedUs;
+  }
+}
+
+}  // namespace notify
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+namespace notify {
+
+enum class Severity : uint8_t {
+  Info,
+  Warning,
+  Alert,
+};
+
+enum class EventType : uint8_t {
+  Report,
+  Protection,
+  Stall,
+  SensorFault,
+  System,
+};
+
+const __FlashStringHelper *severityName(Severity severity);
+const __FlashStringHelper *typeName(EventType type);
+
+struct Notification {
+  Severity severity = Severity::Info;
+  EventType type = EventType::System;
+  unsigned long createdMs = 0;
+  String text;
+  // Leading bytes of text that describe state; the rest is telemetry (heap,
+  // counters) that on its own does not make a report worth re-sending.
+  size_t stateLength = 0;
+};
+
+class NotificationSink {
+public:
+  virtual ~NotificationSink() = default;
+
+  virtual const __FlashStringHelper *name() const = 0;
+  virtual bool accepts(const Notification &notification) const = 0;
+  // False while the sink cannot deliver (no network, backoff); its events stay queued.
+  virtual bool healthy() const = 0;
+  // Delivers a batch in queue order and returns how many leading entries were consumed.
+  virtual size_t deliver(const Notification *const *batch, size_t count) = 0;
+};
+
+// Fixed-size queue between event producers and the sinks. publish() only copies
+// the event, so producers never wait on a sink's network I/O; update() hands each
+// healthy sink one batch per call, fastest sink first, so alerts reach the
+// lowest-latency channel before the slow ones are tried.
+class NotificationBus {
+public:
+  static constexpr size_t MAX_SINKS = 6;
+
+  bool addSink(NotificationSink &sink);
+  void publish(Severity severity, EventType type, const String &text, size_t stateLength = SIZE_MAX);
+  void update(unsigned long now);
+
+  size_t pendingCount() const { return count_; }
+  String formatStats() const;
+
+private:
+  struct Slot {
+    Notification notification;
+    uint8_t pendingSinks = 0;  // Bit i set: sinks_[i] still has to deliver it
+  };
+
+  struct SinkState {
+    NotificationSink *sink = nullptr;
+    uint32_t delivered = 0;
+    uint32_t batches = 0;
+    uint32_t failures = 0;
+    uint32_t latencyUs = 0;  // Moving average of one batch delivery
+    uint32_t maxLatencyUs = 0;
+    unsigned long retryAt = 0;
+    bool waiting = false;
+  };
+
+  Slot &slotAt(size_t index) { return slots_[(head_ + index) % config::NOTIFY_QUEUE_LENGTH]; }
+  void evictOne();
+  void removeAt(size_t index);
+  void serviceSink(size_t sinkIndex, unsigned long now);
+
+  Slot slots_[config::NOTIFY_QUEUE_LENGTH];
+  size_t head_{0};
+  size_t count_{0};
+  SinkState sinks_[MAX_SINKS];
+  size_t sinkCount_{0};
+  uint32_t published_{0};
+  uint32_t dropped_{0};
+  uint32_t unrouted_{0};
+};
+
+}  // namespace notify
@@ -0,0 +1,217 @@
+#include "notify/NotificationSinks.h"
+
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+
+#include "logging/Log.h"
+#include "timeseries/WallClock.h"
+
+namespace notify {
+namespace {
+constexpr char LOG_PATH[] = "/events.log";
+constexpr char LOG_ROTATED_PATH[] = "/events.1.log";
+constexpr size_t UDP_MAX_DATAGRAM_BYTES = 1400;  // Stays below a typical path MTU
+
+// One line per event: newlines inside the text become " | ".
+void printLine(Print &out, const Notification &notification, uint64_t timestampMs) {
+  if (timestampMs > 0) {
+    out.print(static_cast<unsigned long>(timestampMs / 1000ULL));
+  } else {
+    out.print(F("up+"));
+    out.print(notification.createdMs / 1000UL);
+  }
+  out.print(' ');
+  out.print(severityName(notification.severity));
+  out.print(' ');
+  out.print(typeName(notification.type));
+  out.print(' ');
+  const char *text = notification.text.c_str();
+  for (size_t i = 0; i < notification.text.length(); ++i) {
+    if (text[i] == '\n') {
+      out.print(F(" | "));
+    } else {
+      out.print(text[i]);
+    }
+  }
+  out.print('\n');
+}
+
+uint64_t eventTimestampMs(const Notification &notification) {
+  uint64_t nowMs = 0;
+  if (!timeseries::wallClockNowMs(nowMs)) {
+    return 0;
+  }
+  return nowMs - (millis() - notification.createdMs);
+}
+
+bool alertInBatch(const Notification *const *batch, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (batch[i]->severity == Severity::Alert) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool laterReportInBatch(const Notification *const *batch, size_t from, size_t count) {
+  for (size_t i = from; i < count; ++i) {
+    if (batch[i]->type == EventType::Report) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace
+
+bool TelegramSink::accepts(const Notification &notification) const {
+  return service_.configured() &&
+         (notification.type == EventType::Report || notification.severity != Severity::Info);
+}
+
+bool TelegramSink::healthy() const {
+  return fleet_.role() != fleet::Role::Electing && WiFi.status() == WL_CONNECTED && !service_.inBackoff(millis());
+}
+
+size_t TelegramSink::deliver(const Notification *const *batch, size_t count) {
+  if (!fleet_.ownsTelegram()) {
+    return count;  // FleetSink hands them to the gateway
+  }
+  // An export upload holds the only TLS connection the heap allows. Warnings and
+  // reports wait for it; an alert cancels it instead of waiting out the export.
+  if (service_.uploadActive()) {
+    if (!alertInBatch(batch, count)) {
+      return 0;
+    }
+    service_.preemptUpload();
+  }
+  // At most one HTTPS request per call keeps a batch well inside the loop stall budget.
+  size_t consumed = 0;
+  while (consumed < count && batch[consumed]->type == EventType::Report) {
+    if (laterReportInBatch(batch, consumed + 1, count)) {
+      ++consumed;  // Superseded by a newer report; only the latest window matters
+      continue;
+    }
+    return service_.sendInfo(batch[consumed]->text, batch[consumed]->stateLength) ? consumed + 1 : consumed;
+  }
+  if (consumed == count) {
+    return consumed;
+  }
+
+  String text;
+  size_t end = consumed;
+  while (end < count && batch[end]->type != EventType::Report) {
+    if (end > consumed) {
+      text += F("\n\n");
+    }
+    text += batch[end]->text;
+    ++end;
+  }
+  // Undelivered alerts stay in TelegramService's retry queue, so the batch counts as consumed.
+  service_.sendAlert(text);
+  return end;
+}
+
+bool SerialSink::accepts(const Notification &notification) const {
+  return notification.type != EventType::Report;
+}
+
+size_t SerialSink::deliver(const Notification *const *batch, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    const Notification &notification = *batch[i];
+    const logging::Level level = notification.severity == Severity::Alert     ? logging::Level::Error
+                                 : notification.severity == Severity::Warning ? logging::Level::Warn
+                                                                              : logging::Level::Info;
+    if (!logging::enabled(level)) {
+      continue;
+    }
+    // Names are flash strings; copied out so the formatter reads RAM only.
+    char severity[8];
+    char type[12];
+    strncpy_P(severity, reinterpret_cast<PGM_P>(severityName(notification.severity)), sizeof(severity) - 1);
+    severity[sizeof(severity) - 1] = '\0';
+    strncpy_P(type, reinterpret_cast<PGM_P>(typeName(notification.type)), sizeof(type) - 1);
+    type[sizeof(type) - 1] = '\0';
+    logging::write(level, PSTR("[%s][%s] %s"), severity, type, notification.text.c_str());
+  }
+  return count;
+}
+
+bool UdpSink::accepts(const Notification &) const {
+  return strlen(config::NOTIFY_UDP_HOST) > 0;
+}
+
+bool UdpSink::healthy() const {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+size_t UdpSink::deliver(const Notification *const *batch, size_t count) {
+  if (!udp_.beginPacket(config::NOTIFY_UDP_HOST, config::NOTIFY_UDP_PORT)) {
+    return 0;
+  }
+  size_t used = 0;
+  size_t consumed = 0;
+  while (consumed < count) {
+    const size_t estimate = batch[consumed]->text.length() + 48;
+    if (consumed > 0 && used + estimate > UDP_MAX_DATAGRAM_BYTES) {
+      break;
+    }
+    printLine(udp_, *batch[consumed], eventTimestampMs(*batch[consumed]));
+    used += estimate;
+    ++consumed;
+  }
+  return udp_.endPacket() ? consumed : 0;
+}
+
+bool FileLogSink::begin() {
+  mounted_ = config::NOTIFY_FILE_LOG && LittleFS.begin();
+  return mounted_;
+}
+
+bool FileLogSink::accepts(const Notification &notification) const {
+  return config::NOTIFY_FILE_LOG && notification.type != EventType::Report;
+}
+
+size_t FileLogSink::deliver(const Notification *const *batch, size_t count) {
+  File file = LittleFS.open(LOG_PATH, "a");
+  if (file && file.size() >= config::NOTIFY_FILE_MAX_BYTES) {
+    file.close();
+    LittleFS.remove(LOG_ROTATED_PATH);
+    LittleFS.rename(LOG_PATH, LOG_ROTATED_PATH);
+    file = LittleFS.open(LOG_PATH, "a");
+  }
+  if (!file) {
+    return 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    printLine(file, *batch[i], eventTimestampMs(*batch[i]));
+  }
+  file.close();
+  return count;
+}
+
+bool MqttSink::accepts(const Notification &notification) const {
+  return service_.configured() && notification.type != EventType::Report;
+}
+
+size_t MqttSink::deliver(const Notification *const *batch, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    service_.publishEvent(batch[i]->text);
+  }
+  return count;
+}
+
+bool FleetSink::accepts(const Notification &notification) const {
+  return fleet_.enabled() && notification.type != EventType::Report;
+}
+
+size_t FleetSink::deliver(const Notification *const *batch, size_t count) {
+  if (fleet_.role() == fleet::Role::Gateway) {
+    return count;  // Its own TelegramSink already has them
+  }
+  for (size_t i = 0; i < count; ++i) {
+    fleet_.publishEvent(batch[i]->severity, batch[i]->type, batch[i]->text);
+  }
+  return count;
+}
+
+}  // namespace notify
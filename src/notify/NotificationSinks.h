@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#include "fleet/FleetNode.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
+#include "telegram/TelegramService.h"
+
+namespace notify {
+
+// Warnings and alerts to the alert chat, reports to the info chat (dashboard).
+// Once accepted, alerts are owned by TelegramService's retry queue. On a fleet
+// member the gateway sends instead, so events are consumed without a request.
+class TelegramSink : public NotificationSink {
+public:
+  TelegramSink(telegram::TelegramService &service, const fleet::FleetNode &fleet)
+      : service_(service), fleet_(fleet) {}
+
+  const __FlashStringHelper *name() const override { return F("telegram"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override;
+  size_t deliver(const Notification *const *batch, size_t count) override;
+
+private:
+  telegram::TelegramService &service_;
+  const fleet::FleetNode &fleet_;
+};
+
+class SerialSink : public NotificationSink {
+public:
+  const __FlashStringHelper *name() const override { return F("serial"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override { return true; }
+  size_t deliver(const Notification *const *batch, size_t count) override;
+};
+
+// One datagram per batch to config::NOTIFY_UDP_HOST, one line per event.
+class UdpSink : public NotificationSink {
+public:
+  const __FlashStringHelper *name() const override { return F("udp"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override;
+  size_t deliver(const Notification *const *batch, size_t count) override;
+
+private:
+  WiFiUDP udp_;
+};
+
+// Appends to /events.log on LittleFS, rotating to /events.1.log at NOTIFY_FILE_MAX_BYTES.
+class FileLogSink : public NotificationSink {
+public:
+  bool begin();
+
+  const __FlashStringHelper *name() const override { return F("dosya"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override { return mounted_; }
+  size_t deliver(const Notification *const *batch, size_t count) override;
+
+private:
+  bool mounted_{false};
+};
+
+// Events (not reports, which already go out as telemetry) to <prefix>/event at QoS 1.
+class MqttSink : public NotificationSink {
+public:
+  explicit MqttSink(mqtt::MqttService &service) : service_(service) {}
+
+  const __FlashStringHelper *name() const override { return F("mqtt"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override { return service_.configured(); }
+  size_t deliver(const Notification *const *batch, size_t count) override;
+
+private:
+  mqtt::MqttService &service_;
+};
+
+// Events (not reports; the gateway sees samples) to the fleet gateway. Held
+// back while the node is still electing, a no-op on the gateway itself.
+class FleetSink : public NotificationSink {
+public:
+  explicit FleetSink(fleet::FleetNode &fleet) : fleet_(fleet) {}
+
+  const __FlashStringHelper *name() const override { return F("filo"); }
+  bool accepts(const Notification &notification) const override;
+  bool healthy() const override { return fleet_.role() != fleet::Role::Electing; }
+  size_t deliver(const Notification *const *batch, size_t count) override;
+
+private:
+  fleet::FleetNode &fleet_;
+};
+
+}  // namespace notify
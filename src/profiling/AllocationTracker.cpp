@@ -0,0 +1,118 @@
+#include "profiling/AllocationTracker.h"
+
+#include <stdlib.h>
+
+#include "profiling/StageProfiler.h"
+
+namespace profiling {
+namespace {
+#if defined(HEAP_TRACK_CALL_SITES)
+AllocationSite sites[ALLOCATION_SITE_CAPACITY];
+Stage activeStage = Stage::Count;
+size_t siteCount = 0;
+uint32_t overflowCalls = 0;
+uint32_t totalCalls = 0;
+uint32_t totalBytes = 0;
+
+void noteAllocation(const void *caller, size_t bytes) {
+  ++totalCalls;
+  totalBytes += static_cast<uint32_t>(bytes);
+  const uintptr_t address = reinterpret_cast<uintptr_t>(caller);
+  for (size_t i = 0; i < siteCount; ++i) {
+    if (sites[i].caller == address && sites[i].stage == activeStage) {
+      ++sites[i].calls;
+      sites[i].bytes += static_cast<uint32_t>(bytes);
+      return;
+    }
+  }
+  if (siteCount < ALLOCATION_SITE_CAPACITY) {
+    sites[siteCount++] = AllocationSite{activeStage, address, 1, static_cast<uint32_t>(bytes)};
+    return;
+  }
+  ++overflowCalls;
+}
+#endif
+}  // namespace
+
+bool allocationTrackingEnabled() {
+#if defined(HEAP_TRACK_CALL_SITES)
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t allocationSiteCount() {
+#if defined(HEAP_TRACK_CALL_SITES)
+  return siteCount;
+#else
+  return 0;
+#endif
+}
+
+bool allocationSite(size_t index, AllocationSite &site) {
+#if defined(HEAP_TRACK_CALL_SITES)
+  if (index >= siteCount) {
+    return false;
+  }
+  site = sites[index];
+  return true;
+#else
+  (void)index;
+  (void)site;
+  return false;
+#endif
+}
+
+uint32_t untrackedAllocations() {
+#if defined(HEAP_TRACK_CALL_SITES)
+  return overflowCalls;
+#else
+  return 0;
+#endif
+}
+
+uint32_t allocationCalls() {
+#if defined(HEAP_TRACK_CALL_SITES)
+  return totalCalls;
+#else
+  return 0;
+#endif
+}
+
+uint32_t allocatedBytes() {
+#if defined(HEAP_TRACK_CALL_SITES)
+  return totalBytes;
+#else
+  return 0;
+#endif
+}
+
+#if defined(HEAP_TRACK_CALL_SITES)
+AllocationScope::AllocationScope(Stage stage) : previous_(activeStage) {
+  activeStage = stage;
+}
+
+AllocationScope::~AllocationScope() {
+  activeStage = previous_;
+}
+#endif
+
+}  // namespace profiling
+
+#if defined(HEAP_TRACK_CALL_SITES)
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  profiling::noteAllocation(__builtin_return_address(0), size);
+  return __real_malloc(size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  profiling::noteAllocation(__builtin_return_address(0), size);
+  return __real_realloc(ptr, size);
+}
+}
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace profiling {
+
+enum class Stage : uint8_t;  // StageProfiler.h
+
+// Call-site attribution is only compiled in debug builds that link with
+// -DHEAP_TRACK_CALL_SITES -Wl,--wrap=malloc -Wl,--wrap=realloc.
+// The return address alone mostly names String or libstdc++ internals, so a
+// site is the innermost AllocationScope's stage together with that address.
+struct AllocationSite {
+  Stage stage;  // Stage::Count outside every scope
+  uintptr_t caller;
+  uint32_t calls;
+  uint32_t bytes;
+};
+
+constexpr size_t ALLOCATION_SITE_CAPACITY = 32;
+
+bool allocationTrackingEnabled();
+size_t allocationSiteCount();
+bool allocationSite(size_t index, AllocationSite &site);
+uint32_t untrackedAllocations();
+// Running totals over all call sites (malloc and realloc calls, requested bytes).
+uint32_t allocationCalls();
+uint32_t allocatedBytes();
+
+// Tags allocations made while it is alive with `stage`; scopes nest and the
+// innermost wins. ScopedStageTimer holds one, so every profiled stage is tagged.
+class AllocationScope {
+public:
+#if defined(HEAP_TRACK_CALL_SITES)
+  explicit AllocationScope(Stage stage);
+  ~AllocationScope();
+#else
+  explicit AllocationScope(Stage) {}
+#endif
+
+  AllocationScope(const AllocationScope &) = delete;
+  AllocationScope &operator=(const AllocationScope &) = delete;
+
+#if defined(HEAP_TRACK_CALL_SITES)
+private:
+  Stage previous_;
+#endif
+};
+
+}  // namespace profiling
@@ -0,0 +1,145 @@
+#include "profiling/HeapMonitor.h"
+
+#include "config.h"
+#include "profiling/AllocationTracker.h"
+#include "profiling/StageProfiler.h"
+#include "text/MessageCatalog.h"
+
+namespace profiling {
+
+void HeapMonitor::update(unsigned long now) {
+  if (!config::ENABLE_HEAP_MONITOR) {
+    return;
+  }
+  if (hasSamples_ && now - lastSample_ < config::HEAP_SAMPLE_INTERVAL_MS) {
+    return;
+  }
+  lastSample_ = now;
+  sample();
+
+  if (!windowOpen_) {
+    windowOpen_ = true;
+    windowStart_ = now;
+    window_ = current_;
+  } else if (now - windowStart_ >= config::HEAP_HISTORY_INTERVAL_MS) {
+    closeHistoryWindow();
+    windowStart_ = now;
+    window_ = current_;
+  }
+}
+
+void HeapMonitor::sample() {
+  if (!config::ENABLE_HEAP_MONITOR) {
+    return;
+  }
+  current_ = read();
+  if (!hasSamples_) {
+    low_ = high_ = current_;
+    hasSamples_ = true;
+    return;
+  }
+
+  if (current_.freeBytes < low_.freeBytes) {
+    low_.freeBytes = current_.freeBytes;
+  }
+  if (current_.maxBlockBytes < low_.maxBlockBytes) {
+    low_.maxBlockBytes = current_.maxBlockBytes;
+  }
+  if (current_.fragmentationPct < low_.fragmentationPct) {
+    low_.fragmentationPct = current_.fragmentationPct;
+  }
+  if (current_.freeBytes > high_.freeBytes) {
+    high_.freeBytes = current_.freeBytes;
+  }
+  if (current_.maxBlockBytes > high_.maxBlockBytes) {
+    high_.maxBlockBytes = current_.maxBlockBytes;
+  }
+  if (current_.fragmentationPct > high_.fragmentationPct) {
+    high_.fragmentationPct = current_.fragmentationPct;
+  }
+
+  if (windowOpen_) {
+    if (current_.freeBytes < window_.freeBytes) {
+      window_.freeBytes = current_.freeBytes;
+    }
+    if (current_.maxBlockBytes < window_.maxBlockBytes) {
+      window_.maxBlockBytes = current_.maxBlockBytes;
+    }
+    if (current_.fragmentationPct > window_.fragmentationPct) {
+      window_.fragmentationPct = current_.fragmentationPct;
+    }
+  }
+}
+
+HeapSample HeapMonitor::read() {
+  HeapSample s;
+  s.freeBytes = ESP.getFreeHeap();
+  s.maxBlockBytes = ESP.getMaxFreeBlockSize();
+  s.fragmentationPct = ESP.getHeapFragmentation();
+  return s;
+}
+
+void HeapMonitor::closeHistoryWindow() {
+  history_[historyHead_] = window_;
+  historyHead_ = (historyHead_ + 1) % HISTORY_LENGTH;
+  if (historyCount_ < HISTORY_LENGTH) {
+    ++historyCount_;
+  }
+}
+
+String HeapMonitor::formatReportLine() const {
+  return text::format(text::MessageId::HeapLine, current_.freeBytes, current_.maxBlockBytes,
+                      current_.fragmentationPct, low_.freeBytes);
+}
+
+String HeapMonitor::formatReport() const {
+  if (!config::ENABLE_HEAP_MONITOR) {
+    return text::format(text::MessageId::HeapMonitorDisabled);
+  }
+
+  String message;
+  message.reserve(256 + HISTORY_LENGTH * 24);
+  const text::Arg args[] = {current_.freeBytes,        low_.freeBytes,        high_.freeBytes,
+                            current_.maxBlockBytes,    low_.maxBlockBytes,    high_.maxBlockBytes,
+                            current_.fragmentationPct, low_.fragmentationPct, high_.fragmentationPct};
+  text::append(message, text::MessageId::HeapReport, args, sizeof(args) / sizeof(args[0]));
+
+  if (historyCount_ > 0) {
+    text::append(message, text::MessageId::HeapHistoryHeader, historyCount_);
+    const size_t start = (historyHead_ + HISTORY_LENGTH - historyCount_) % HISTORY_LENGTH;
+    for (size_t i = 0; i < historyCount_; ++i) {
+      const HeapSample &s = history_[(start + i) % HISTORY_LENGTH];
+      message += F("\n  ");
+      message += s.freeBytes;
+      message += '/';
+      message += s.maxBlockBytes;
+      message += F("/%");
+      message += s.fragmentationPct;
+    }
+  }
+
+  if (allocationTrackingEnabled()) {
+    text::append(message, text::MessageId::HeapSitesHeader);
+    AllocationSite site;
+    for (size_t i = 0; allocationSite(i, site); ++i) {
+      message += F("\n  ");
+      if (site.stage == Stage::Count) {
+        message += '-';  // setup() or a path without a stage timer
+      } else {
+        message += stageName(site.stage);
+      }
+      message += F(" 0x");
+      message += String(static_cast<unsigned long>(site.caller), HEX);
+      message += ' ';
+      message += site.calls;
+      message += ' ';
+      message += site.bytes;
+    }
+    if (untrackedAllocations() > 0) {
+      text::append(message, text::MessageId::HeapSitesUntracked, untrackedAllocations());
+    }
+  }
+  return message;
+}
+
+}  // namespace profiling
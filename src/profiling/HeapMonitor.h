@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace profiling {
+
+struct HeapSample {
+  uint32_t freeBytes = 0;
+  uint32_t maxBlockBytes = 0;
+  uint8_t fragmentationPct = 0;
+};
+
+class HeapMonitor {
+public:
+  static constexpr size_t HISTORY_LENGTH = 12;
+
+  void update(unsigned long now);
+  void sample();
+  const HeapSample &current() const { return current_; }
+  const HeapSample &low() const { return low_; }
+
+  String formatReportLine() const;
+  String formatReport() const;
+
+private:
+  static HeapSample read();
+  void closeHistoryWindow();
+
+  HeapSample current_;
+  HeapSample low_;
+  HeapSample high_;
+  HeapSample window_;
+  HeapSample history_[HISTORY_LENGTH];
+  size_t historyCount_{0};
+  size_t historyHead_{0};
+  bool hasSamples_{false};
+  bool windowOpen_{false};
+  unsigned long lastSample_{0};
+  unsigned long windowStart_{0};
+};
+
+}  // namespace profiling
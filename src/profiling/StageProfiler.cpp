@@ -0,0 +1,146 @@
+#include "profiling/StageProfiler.h"
+
+#include "text/MessageCatalog.h"
+
+namespace profiling {
+namespace {
+constexpr uint8_t CALIBRATION_ROUNDS = 32;
+
+StageHistogram histograms[STAGE_COUNT];
+uint32_t calibratedOverhead = 0;
+
+uint8_t bucketFor(uint32_t cycles) {
+  if (cycles == 0) {
+    return 0;
+  }
+  const uint8_t bits = static_cast<uint8_t>(32 - __builtin_clz(cycles));
+  return bits < HISTOGRAM_BUCKETS ? bits : HISTOGRAM_BUCKETS - 1;
+}
+
+uint32_t percentileCycles(const StageHistogram &h, uint8_t percent) {
+  if (h.count == 0) {
+    return 0;
+  }
+  const uint32_t target = static_cast<uint32_t>((static_cast<uint64_t>(h.count) * percent + 99) / 100);
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    cumulative += h.buckets[i];
+    if (cumulative >= target) {
+      const uint32_t bound = bucketUpperBound(i);
+      return bound < h.maxCycles ? bound : h.maxCycles;
+    }
+  }
+  return h.maxCycles;
+}
+
+unsigned long cyclesToMicros(uint32_t cycles) {
+  const uint32_t mhz = ESP.getCpuFreqMHz();
+  return mhz > 0 ? cycles / mhz : cycles;
+}
+}  // namespace
+
+const __FlashStringHelper *stageName(Stage stage) {
+  switch (stage) {
+    case Stage::Loop:
+      return F("loop");
+    case Stage::SensorRead:
+      return F("sensor");
+    case Stage::Protection:
+      return F("koruma");
+    case Stage::ReportFormat:
+      return F("rapor");
+    case Stage::TelegramSend:
+      return F("tg_send");
+    case Stage::TelegramPoll:
+      return F("tg_poll");
+    case Stage::JsonParse:
+      return F("json");
+    case Stage::Command:
+      return F("komut");
+    case Stage::Metrics:
+      return F("metrics");
+    case Stage::Mqtt:
+      return F("mqtt");
+    case Stage::Notify:
+      return F("bildirim");
+    case Stage::Fleet:
+      return F("filo");
+    case Stage::Count:
+    default:
+      return F("?");
+  }
+}
+
+uint32_t bucketUpperBound(uint8_t bucket) {
+  if (bucket == 0) {
+    return 0;
+  }
+  if (bucket >= HISTOGRAM_BUCKETS - 1) {
+    return UINT32_MAX;
+  }
+  return (1UL << bucket) - 1;
+}
+
+void begin() {
+  if (!config::ENABLE_STAGE_PROFILER) {
+    return;
+  }
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < CALIBRATION_ROUNDS; ++i) {
+    const uint32_t start = ESP.getCycleCount();
+    { ScopedStageTimer timer(Stage::Loop); }
+    total += ESP.getCycleCount() - start;
+  }
+  calibratedOverhead = total / CALIBRATION_ROUNDS;
+  reset();
+}
+
+void record(Stage stage, uint32_t cycles) {
+  const size_t index = static_cast<size_t>(stage);
+  if (index >= STAGE_COUNT) {
+    return;
+  }
+  StageHistogram &h = histograms[index];
+  ++h.buckets[bucketFor(cycles)];
+  ++h.count;
+  h.sumCycles += cycles;
+  if (cycles > h.maxCycles) {
+    h.maxCycles = cycles;
+  }
+}
+
+void reset() {
+  memset(histograms, 0, sizeof(histograms));
+}
+
+const StageHistogram &histogram(Stage stage) {
+  return histograms[static_cast<size_t>(stage)];
+}
+
+uint32_t overheadCycles() {
+  return calibratedOverhead;
+}
+
+String formatReport() {
+  if (!config::ENABLE_STAGE_PROFILER) {
+    return text::format(text::MessageId::ProfilerDisabled);
+  }
+
+  String message;
+  message.reserve(64 + STAGE_COUNT * 56);
+  text::append(message, text::MessageId::ProfilerHeader);
+  for (size_t i = 0; i < STAGE_COUNT; ++i) {
+    const Stage stage = static_cast<Stage>(i);
+    const StageHistogram &h = histograms[i];
+    text::append(message, text::MessageId::ProfilerStage, stageName(stage), h.count);
+    if (h.count > 0) {
+      text::append(message, text::MessageId::ProfilerPercentiles, cyclesToMicros(percentileCycles(h, 50)),
+                   cyclesToMicros(percentileCycles(h, 99)), cyclesToMicros(h.maxCycles));
+    }
+    message += '\n';
+  }
+  text::append(message, text::MessageId::ProfilerOverhead, calibratedOverhead);
+  return message;
+}
+
+}  // namespace profiling
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "profiling/AllocationTracker.h"
+
+namespace profiling {
+
+enum class Stage : uint8_t {
+  Loop,
+  SensorRead,
+  Protection,
+  ReportFormat,
+  TelegramSend,
+  TelegramPoll,
+  JsonParse,
+  Command,
+  Metrics,
+  Mqtt,
+  Notify,
+  Fleet,
+  Count,
+};
+
+constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::Count);
+constexpr size_t HISTOGRAM_BUCKETS = 32;  // Bucket i holds durations in [2^(i-1), 2^i) cycles
+
+struct StageHistogram {
+  uint32_t buckets[HISTOGRAM_BUCKETS];
+  uint32_t count;
+  uint32_t maxCycles;
+  uint64_t sumCycles;
+};
+
+// Measures the cost of an empty timer so reports can state the instrumentation overhead.
+void begin();
+void record(Stage stage, uint32_t cycles);
+void reset();
+const __FlashStringHelper *stageName(Stage stage);
+const StageHistogram &histogram(Stage stage);
+// Inclusive upper bound in cycles; the last bucket is unbounded (UINT32_MAX).
+uint32_t bucketUpperBound(uint8_t bucket);
+uint32_t overheadCycles();
+String formatReport();
+
+class ScopedStageTimer {
+public:
+  explicit ScopedStageTimer(Stage stage) : stage_(stage), allocations_(stage) {
+    if (config::ENABLE_STAGE_PROFILER) {
+      start_ = ESP.getCycleCount();
+    }
+  }
+
+  ~ScopedStageTimer() {
+    if (config::ENABLE_STAGE_PROFILER) {
+      record(stage_, ESP.getCycleCount() - start_);
+    }
+  }
+
+  ScopedStageTimer(const ScopedStageTimer &) = delete;
+  ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+  Stage stage_;
+  uint32_t start_{0};
+  AllocationScope allocations_;
+};
+
+}  // namespace profiling
@@ -5,18 +5,26 @@
 #include <Arduino.h>
 
 #include "config.h"
+#include "logging/Log.h"
+#include "text/MessageCatalog.h"
 
 namespace protection {
 namespace {
+using text::MessageId;
+
 uint8_t inactiveLevel(uint8_t activeLevel) {
   return activeLevel == HIGH ? LOW : HIGH;
 }
+
+void appendStats(String &message, const sensor::MeasurementStats &stats) {
+  text::append(message, MessageId::ReportStats, stats.average, stats.min, stats.max, stats.last);
+}
 }
 
 ProtectionController::ProtectionController(const ProtectionSettings &settings) : settings_(settings) {}
 
-void ProtectionController::setNotificationCallback(NotificationCallback callback) {
-  notifyCallback_ = callback;
+void ProtectionController::setNotificationBus(notify::NotificationBus *bus) {
+  bus_ = bus;
 }
 
 void ProtectionController::initializeHardware() {
@@ -35,6 +43,28 @@ void ProtectionController::initializeHardware() {
   lastCoolingNotifyMillis_ = 0;
 }
 
+void IRAM_ATTR ProtectionController::forceSafeState() {
+  if (!config::ENABLE_PROTECTION) {
+    return;
+  }
+  digitalWrite(config::HEATING_RELAY_PIN, config::HEATING_RELAY_ACTIVE_LEVEL == HIGH ? LOW : HIGH);
+  digitalWrite(config::COOLING_RELAY_PIN, config::COOLING_RELAY_ACTIVE_LEVEL == HIGH ? LOW : HIGH);
+  forcedSafe_ = true;
+}
+
+bool ProtectionController::acknowledgeForcedSafeState(unsigned long now) {
+  if (!forcedSafe_) {
+    return false;
+  }
+  forcedSafe_ = false;
+  heatingSwitches_ += heatingRelayState_ ? 1 : 0;
+  coolingSwitches_ += coolingRelayState_ ? 1 : 0;
+  heatingRelayState_ = false;
+  coolingRelayState_ = false;
+  lastRelaySwitchMillis_ = now;
+  return true;
+}
+
 void ProtectionController::applySettings(const ProtectionSettings &settings) {
   settings_ = settings;
 }
@@ -46,7 +76,7 @@ void ProtectionController::resetRenotifyTimers(unsigned long now) {
 
 bool ProtectionController::setMin(float value, String &errorMessage) {
   if (value >= settings_.maxC) {
-    errorMessage = F("Min degeri maksimumdan kucuk olmali.");
+    errorMessage = text::format(MessageId::MinNotBelowMax);
     return false;
   }
   settings_.minC = value;
@@ -55,7 +85,7 @@ bool ProtectionController::setMin(float value, String &errorMessage) {
 
 bool ProtectionController::setMax(float value, String &errorMessage) {
   if (value <= settings_.minC) {
-    errorMessage = F("Max degeri minimumdan buyuk olmali.");
+    errorMessage = text::format(MessageId::MaxNotAboveMin);
     return false;
   }
   settings_.maxC = value;
@@ -65,7 +95,7 @@ bool ProtectionController::setMax(float value, String &errorMessage) {
 bool ProtectionController::setHysteresis(float value, String &errorMessage) {
   const float span = settings_.maxC - settings_.minC;
   if (value <= 0.0f || value >= span) {
-    errorMessage = F("Histerezis pozitif olmali ve araligin tamamindan kucuk olmali.");
+    errorMessage = text::format(MessageId::HysteresisOutOfRange);
     return false;
   }
   settings_.hysteresisC = value;
@@ -74,7 +104,7 @@ bool ProtectionController::setHysteresis(float value, String &errorMessage) {
 
 bool ProtectionController::setMinSamples(size_t value, String &errorMessage) {
   if (value < 1 || value > 3600) {
-    errorMessage = F("minSamples 1 ile 3600 arasinda olmali.");
+    errorMessage = text::format(MessageId::OutOfRange, F("minsamples"), 1, 3600, MessageId::UnitNone);
     return false;
   }
   settings_.minSamples = value;
@@ -83,22 +113,42 @@ bool ProtectionController::setMinSamples(size_t value, String &errorMessage) {
 
 bool ProtectionController::setRenotifySeconds(unsigned long seconds, String &errorMessage) {
   if (seconds < 10 || seconds > 86400) {
-    errorMessage = F("renotify 10 ile 86400 saniye arasinda olmali.");
+    errorMessage = text::format(MessageId::OutOfRange, F("renotify"), 10, 86400, MessageId::UnitSeconds);
     return false;
   }
   settings_.renotifyIntervalMs = seconds * 1000UL;
   return true;
 }
 
+bool ProtectionController::setReportDeadband(float value, String &errorMessage) {
+  if (value < 0.0f || value > 10.0f) {
+    errorMessage = text::format(MessageId::DeadbandOutOfRange);
+    return false;
+  }
+  settings_.reportDeltaC = value;
+  return true;
+}
+
+bool ProtectionController::setReportSilenceSeconds(unsigned long seconds, String &errorMessage) {
+  const unsigned long minSeconds = config::TELEGRAM_REPORT_INTERVAL_MS / 1000UL;
+  if (seconds < minSeconds || seconds > 86400) {
+    errorMessage = text::format(MessageId::OutOfRange, F("silence"), minSeconds, 86400, MessageId::UnitSeconds);
+    return false;
+  }
+  settings_.reportMaxSilenceMs = seconds * 1000UL;
+  return true;
+}
+
 void ProtectionController::handleProtection(const sensor::MeasurementStats &objectStats, unsigned long now) {
   if (!config::ENABLE_PROTECTION) {
     return;
   }
+  acknowledgeForcedSafeState(now);
 
-  const size_t sampleCount = objectStats.count;
-  if (sampleCount == 0) {
+  if (objectStats.count == 0) {
     return;
   }
+  const size_t sampleCount = objectStats.count;
 
   const bool relayActive = heatingRelayState_ || coolingRelayState_;
   if (!relayActive && sampleCount < settings_.minSamples) {
@@ -152,6 +202,8 @@ void ProtectionController::handleProtection(const sensor::MeasurementStats &obje
       return;
     }
 
+    heatingSwitches_ += desiredHeating != heatingRelayState_ ? 1 : 0;
+    coolingSwitches_ += desiredCooling != coolingRelayState_ ? 1 : 0;
     heatingRelayState_ = desiredHeating;
     coolingRelayState_ = desiredCooling;
     writeRelay(config::HEATING_RELAY_PIN, config::HEATING_RELAY_ACTIVE_LEVEL, heatingRelayState_);
@@ -159,56 +211,28 @@ void ProtectionController::handleProtection(const sensor::MeasurementStats &obje
     lastRelaySwitchMillis_ = now;
 
     if (heatingRelayState_) {
-      String message = F("UYARI: Nesne sicakligi alt sinirin altinda. Son: ");
-      message += String(current, 2);
-      message += F(" C (< ");
-      message += String(lower, 2);
-      message += F(" C). Ortalama: ");
-      message += String(average, 2);
-      message += F(" C. Isitma baslatiliyor.");
-      notify(message);
+      notifyReading(notify::Severity::Alert, MessageId::HeatingStarted, MessageId::ReadingBelow, current, lower,
+                    average);
       lastHeatingNotifyMillis_ = now;
     } else if (coolingRelayState_) {
-      String message = F("UYARI: Nesne sicakligi ust sinirin ustunde. Son: ");
-      message += String(current, 2);
-      message += F(" C (> ");
-      message += String(upper, 2);
-      message += F(" C). Ortalama: ");
-      message += String(average, 2);
-      message += F(" C. Sogutma baslatiliyor.");
-      notify(message);
+      notifyReading(notify::Severity::Alert, MessageId::CoolingStarted, MessageId::ReadingAbove, current, upper,
+                    average);
       lastCoolingNotifyMillis_ = now;
     } else {
-      String message = F("Bilgi: Nesne sicakligi guvenli araliga dondu. Son: ");
-      message += String(current, 2);
-      message += F(" C, ortalama: ");
-      message += String(average, 2);
-      message += F(" C. Koruma devre disi.");
-      notify(message);
+      notifyReading(notify::Severity::Warning, MessageId::BackInRange, MessageId::ReadingBelow, current, lower,
+                    average);
       lastHeatingNotifyMillis_ = now;
       lastCoolingNotifyMillis_ = now;
     }
   } else {
     if (heatingRelayState_ && (now - lastHeatingNotifyMillis_) >= settings_.renotifyIntervalMs) {
-      String message = F("Bilgi: Isitma koruma modu suruyor. Son olcum: ");
-      message += String(current, 2);
-      message += F(" C (< ");
-      message += String(lower, 2);
-      message += F(" C). Ortalama: ");
-      message += String(average, 2);
-      message += F(" C.");
-      notify(message);
+      notifyReading(notify::Severity::Warning, MessageId::HeatingContinues, MessageId::ReadingBelow, current, lower,
+                    average);
       lastHeatingNotifyMillis_ = now;
     }
     if (coolingRelayState_ && (now - lastCoolingNotifyMillis_) >= settings_.renotifyIntervalMs) {
-      String message = F("Bilgi: Sogutma koruma modu suruyor. Son olcum: ");
-      message += String(current, 2);
-      message += F(" C (> ");
-      message += String(upper, 2);
-      message += F(" C). Ortalama: ");
-      message += String(average, 2);
-      message += F(" C.");
-      notify(message);
+      notifyReading(notify::Severity::Warning, MessageId::CoolingContinues, MessageId::ReadingAbove, current, upper,
+                    average);
       lastCoolingNotifyMillis_ = now;
     }
 
@@ -220,84 +244,65 @@ void ProtectionController::handleProtection(const sensor::MeasurementStats &obje
 }
 
 String ProtectionController::formatProtectionConfig() const {
+  const unsigned long minSamples = static_cast<unsigned long>(settings_.minSamples);
+  const unsigned long renotifySeconds = settings_.renotifyIntervalMs / 1000UL;
+  const unsigned long silenceSeconds = settings_.reportMaxSilenceMs / 1000UL;
+  const text::Arg lines[][3] = {
+      {MessageId::LabelMin, settings_.minC, MessageId::UnitCelsius},
+      {MessageId::LabelMax, settings_.maxC, MessageId::UnitCelsius},
+      {MessageId::LabelHysteresis, settings_.hysteresisC, MessageId::UnitCelsius},
+      {MessageId::LabelMinSamples, minSamples, MessageId::UnitNone},
+      {MessageId::LabelRenotify, renotifySeconds, MessageId::UnitSeconds},
+      {MessageId::LabelDeadband, settings_.reportDeltaC, MessageId::UnitCelsius},
+      {MessageId::LabelSilence, silenceSeconds, MessageId::UnitSeconds},
+  };
+  const text::Arg usage(MessageId::Usage);
+
   String message;
-  message.reserve(320);
-  message += F("Koruma Ayarlari\n");
-  message += F("- min: ");
-  message += String(settings_.minC, 2);
-  message += F(" C\n- max: ");
-  message += String(settings_.maxC, 2);
-  message += F(" C\n- histerezis: ");
-  message += String(settings_.hysteresisC, 2);
-  message += F(" C\n- min ornek sayisi: ");
-  message += static_cast<unsigned long>(settings_.minSamples);
-  message += F("\n- renotify: ");
-  message += settings_.renotifyIntervalMs / 1000UL;
-  message += F(" sn\n\nKomutlar:\n");
-  message += F("config\n");
-  message += F("set min <deger_C>\n");
-  message += F("set max <deger_C>\n");
-  message += F("set hysteresis <deger_C>\n");
-  message += F("set minsamples <tam_sayi>\n");
-  message += F("set renotify <saniye>\n");
-  message += F("\nNot: min < max olmali, histerezis pozitif ve aralik icinde olmalidir. Tum degisiklikler EEPROM'a kaydedilir.");
+  message.reserve(640);
+  text::append(message, MessageId::ConfigHeader);
+  for (const text::Arg *line : lines) {
+    text::append(message, MessageId::ConfigLine, line, 3);
+  }
+  text::append(message, MessageId::ConfigFooter, &usage, 1);
   return message;
 }
 
 String ProtectionController::formatMeasurementReport(const sensor::MeasurementStats &ambientStats,
                                                      const sensor::MeasurementStats &objectStats) const {
   if (objectStats.count == 0 || ambientStats.count == 0) {
-    return String(config::TELEGRAM_NO_DATA_MESSAGE);
+    return text::format(MessageId::NoData);
   }
 
-  String message;
-  message.reserve(320);
-  message += F("Olcum Raporu\n");
-  message += F("Ornek sayisi: ");
-  message += static_cast<unsigned long>(objectStats.count);
-  message += F("\nNesne (C)\n");
-  message += F("  Ortalama: ");
-  message += String(objectStats.average, 2);
-  message += F("\n  Min: ");
-  message += String(objectStats.min, 2);
-  message += F("\n  Maks: ");
-  message += String(objectStats.max, 2);
-  message += F("\n  Son: ");
-  message += String(objectStats.last, 2);
-  message += F("\nOrtam (C)\n");
-  message += F("  Ortalama: ");
-  message += String(ambientStats.average, 2);
-  message += F("\n  Min: ");
-  message += String(ambientStats.min, 2);
-  message += F("\n  Maks: ");
-  message += String(ambientStats.max, 2);
-  message += F("\n  Son: ");
-  message += String(ambientStats.last, 2);
-  message += F("\nKoruma: ");
+  MessageId state = MessageId::ProtectionNormal;
   if (!config::ENABLE_PROTECTION) {
-    message += F("Devre disi");
+    state = MessageId::ProtectionDisabled;
   } else if (heatingRelayState_) {
-    message += F("Isitma aktif");
+    state = MessageId::ProtectionHeating;
   } else if (coolingRelayState_) {
-    message += F("Sogutma aktif");
-  } else {
-    message += F("Normal");
+    state = MessageId::ProtectionCooling;
   }
-  message += F("\nSinirlar: ");
-  message += String(settings_.minC, 2);
-  message += F(" - ");
-  message += String(settings_.maxC, 2);
-  message += F(" C, histerezis: ");
-  message += String(settings_.hysteresisC, 2);
-  message += F(" C");
+
+  String message;
+  message.reserve(320);
+  text::append(message, MessageId::ReportHeader, static_cast<unsigned long>(objectStats.count));
+  appendStats(message, objectStats);
+  text::append(message, MessageId::ReportAmbient);
+  appendStats(message, ambientStats);
+  text::append(message, MessageId::ReportFooter, state, settings_.minC, settings_.maxC, settings_.hysteresisC);
   return message;
 }
 
-void ProtectionController::notify(const String &message) const {
-  if (notifyCallback_) {
-    notifyCallback_(message);
+void ProtectionController::notifyReading(notify::Severity severity, text::MessageId id, text::MessageId reading,
+                                         float current, float limit, float average) const {
+  notify(severity, text::format(id, current, limit, average, reading));
+}
+
+void ProtectionController::notify(notify::Severity severity, const String &message) const {
+  if (bus_) {
+    bus_->publish(severity, notify::EventType::Protection, message);
   } else {
-    Serial.println(message);
+    LOG_WARN("%s", message.c_str());
   }
 }
 
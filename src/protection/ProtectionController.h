@@ -2,23 +2,28 @@
 
 #include <Arduino.h>
 
+#include "notify/NotificationBus.h"
 #include "protection/ProtectionSettings.h"
 #include "sensor/MeasurementAggregator.h"
+#include "text/MessageCatalog.h"
 
 namespace protection {
 
 class ProtectionController {
 public:
-  using NotificationCallback = void (*)(const String &message);
-
   explicit ProtectionController(const ProtectionSettings &settings);
 
-  void setNotificationCallback(NotificationCallback callback);
+  void setNotificationBus(notify::NotificationBus *bus);
   void initializeHardware();
   void handleProtection(const sensor::MeasurementStats &objectStats, unsigned long now);
+  // Interrupt-safe: only drives the relay pins; state is reconciled by acknowledgeForcedSafeState().
+  void forceSafeState();
+  bool acknowledgeForcedSafeState(unsigned long now);
 
   bool heatingActive() const { return heatingRelayState_; }
   bool coolingActive() const { return coolingRelayState_; }
+  uint32_t heatingSwitchCount() const { return heatingSwitches_; }
+  uint32_t coolingSwitchCount() const { return coolingSwitches_; }
 
   const ProtectionSettings &settings() const { return settings_; }
   void applySettings(const ProtectionSettings &settings);
@@ -29,22 +34,30 @@ public:
   bool setHysteresis(float value, String &errorMessage);
   bool setMinSamples(size_t value, String &errorMessage);
   bool setRenotifySeconds(unsigned long seconds, String &errorMessage);
+  bool setReportDeadband(float value, String &errorMessage);
+  bool setReportSilenceSeconds(unsigned long seconds, String &errorMessage);
 
   String formatProtectionConfig() const;
   String formatMeasurementReport(const sensor::MeasurementStats &ambientStats,
                                  const sensor::MeasurementStats &objectStats) const;
 
 private:
-  void notify(const String &message) const;
+  // id: alert text; reading: ReadingBelow or ReadingAbove, filled with current, limit and average.
+  void notifyReading(notify::Severity severity, text::MessageId id, text::MessageId reading, float current,
+                     float limit, float average) const;
+  void notify(notify::Severity severity, const String &message) const;
   void writeRelay(uint8_t pin, uint8_t activeLevel, bool enabled) const;
 
   ProtectionSettings settings_;
   bool heatingRelayState_{false};
   bool coolingRelayState_{false};
   unsigned long lastRelaySwitchMillis_{0};
+  uint32_t heatingSwitches_{0};
+  uint32_t coolingSwitches_{0};
   unsigned long lastHeatingNotifyMillis_{0};
   unsigned long lastCoolingNotifyMillis_{0};
-  NotificationCallback notifyCallback_{nullptr};
+  volatile bool forcedSafe_{false};
+  notify::NotificationBus *bus_{nullptr};
 };
 
 }  // namespace protection
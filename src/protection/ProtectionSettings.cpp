@@ -1,5 +1,7 @@
 #include "protection/ProtectionSettings.h"
 
+#include "config.h"
+
 namespace protection {
 
 bool validateProtectionSettings(const ProtectionSettings &settings) {
@@ -16,6 +18,12 @@ bool validateProtectionSettings(const ProtectionSettings &settings) {
   if (settings.renotifyIntervalMs < 10000UL || settings.renotifyIntervalMs > 86400000UL) {
     return false;
   }
+  if (settings.reportDeltaC < 0.0f || settings.reportDeltaC > 10.0f) {
+    return false;
+  }
+  if (settings.reportMaxSilenceMs < config::TELEGRAM_REPORT_INTERVAL_MS || settings.reportMaxSilenceMs > 86400000UL) {
+    return false;
+  }
   return true;
 }
 
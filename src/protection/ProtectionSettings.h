@@ -10,6 +10,8 @@ struct ProtectionSettings {
   float hysteresisC;
   size_t minSamples;
   unsigned long renotifyIntervalMs;
+  float reportDeltaC;               // 0 disables deadband reporting
+  unsigned long reportMaxSilenceMs;
 };
 
 bool validateProtectionSettings(const ProtectionSettings &settings);
@@ -2,13 +2,15 @@
 
 #include <Arduino.h>
 
+#include "logging/Log.h"
 #include "protection/ProtectionSettings.h"
 
 namespace protection {
 namespace {
 constexpr size_t EEPROM_STORAGE_SIZE = 128;
 constexpr uint32_t SETTINGS_SIGNATURE = 0x5450524F;  // 'TPRO'
-constexpr uint16_t SETTINGS_VERSION = 1;
+constexpr uint16_t SETTINGS_VERSION = 2;
+constexpr uint16_t SETTINGS_VERSION_V1 = 1;
 
 struct StoredProtectionSettings {
   uint32_t signature;
@@ -19,10 +21,27 @@ struct StoredProtectionSettings {
   float hysteresisC;
   uint16_t minSamples;
   uint32_t renotifyMs;
+  float reportDeltaC;
+  uint32_t reportMaxSilenceMs;
   uint32_t checksum;
 };
 
-uint32_t calculateChecksum(const StoredProtectionSettings &record) {
+struct StoredProtectionSettingsV1 {
+  uint32_t signature;
+  uint16_t version;
+  uint16_t reserved;
+  float minC;
+  float maxC;
+  float hysteresisC;
+  uint16_t minSamples;
+  uint32_t renotifyMs;
+  uint32_t checksum;
+};
+
+static_assert(sizeof(StoredProtectionSettings) <= EEPROM_STORAGE_SIZE, "EEPROM record exceeds storage size");
+
+template <typename Record>
+uint32_t calculateChecksum(const Record &record) {
   const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
   const size_t length = sizeof(record) - sizeof(record.checksum);
   uint32_t sum = 0;
@@ -42,6 +61,8 @@ StoredProtectionSettings buildRecord(const ProtectionSettings &settings) {
   record.hysteresisC = settings.hysteresisC;
   record.minSamples = static_cast<uint16_t>(settings.minSamples);
   record.renotifyMs = static_cast<uint32_t>(settings.renotifyIntervalMs);
+  record.reportDeltaC = settings.reportDeltaC;
+  record.reportMaxSilenceMs = static_cast<uint32_t>(settings.reportMaxSilenceMs);
   record.checksum = calculateChecksum(record);
   return record;
 }
@@ -62,7 +83,7 @@ bool ProtectionSettingsStorage::init() {
     return true;
   }
   if (!beginEeprom(EEPROM_STORAGE_SIZE)) {
-    Serial.println(F("EEPROM baslatilamadi"));
+    LOG_ERROR("EEPROM baslatilamadi");
     return false;
   }
   initialized_ = true;
@@ -76,13 +97,19 @@ bool ProtectionSettingsStorage::load(ProtectionSettings &settings) {
 
   StoredProtectionSettings record{};
   EEPROM.get(0, record);
-  if (record.signature != SETTINGS_SIGNATURE || record.version != SETTINGS_VERSION) {
+  if (record.signature != SETTINGS_SIGNATURE) {
+    return false;
+  }
+  if (record.version == SETTINGS_VERSION_V1) {
+    return loadV1(settings);
+  }
+  if (record.version != SETTINGS_VERSION) {
     return false;
   }
 
   const uint32_t expectedChecksum = calculateChecksum(record);
   if (record.checksum != expectedChecksum) {
-    Serial.println(F("EEPROM: koruma ayarlari checksum hatasi"));
+    LOG_WARN("EEPROM: koruma ayarlari checksum hatasi");
     return false;
   }
 
@@ -92,14 +119,42 @@ bool ProtectionSettingsStorage::load(ProtectionSettings &settings) {
       record.hysteresisC,
       static_cast<size_t>(record.minSamples),
       static_cast<unsigned long>(record.renotifyMs),
+      record.reportDeltaC,
+      static_cast<unsigned long>(record.reportMaxSilenceMs),
   };
 
   if (!validateProtectionSettings(candidate)) {
-    Serial.println(F("EEPROM: koruma ayarlari gecersiz"));
+    LOG_WARN("EEPROM: koruma ayarlari gecersiz");
+    return false;
+  }
+
+  settings = candidate;
+  return true;
+}
+
+bool ProtectionSettingsStorage::loadV1(ProtectionSettings &settings) {
+  StoredProtectionSettingsV1 record{};
+  EEPROM.get(0, record);
+  if (record.checksum != calculateChecksum(record)) {
+    LOG_WARN("EEPROM: koruma ayarlari checksum hatasi");
+    return false;
+  }
+
+  // v1 records predate report deadband settings; keep the caller's defaults for them.
+  ProtectionSettings candidate = settings;
+  candidate.minC = record.minC;
+  candidate.maxC = record.maxC;
+  candidate.hysteresisC = record.hysteresisC;
+  candidate.minSamples = static_cast<size_t>(record.minSamples);
+  candidate.renotifyIntervalMs = static_cast<unsigned long>(record.renotifyMs);
+
+  if (!validateProtectionSettings(candidate)) {
+    LOG_WARN("EEPROM: koruma ayarlari gecersiz");
     return false;
   }
 
   settings = candidate;
+  LOG_INFO("EEPROM: v1 koruma ayarlari tasindi");
   return true;
 }
 
@@ -111,7 +166,7 @@ bool ProtectionSettingsStorage::save(const ProtectionSettings &settings) {
   StoredProtectionSettings record = buildRecord(settings);
   EEPROM.put(0, record);
   if (!EEPROM.commit()) {
-    Serial.println(F("EEPROM: commit basarisiz"));
+    LOG_ERROR("EEPROM: commit basarisiz");
     return false;
   }
   return true;
@@ -13,6 +13,7 @@ public:
 
 private:
   bool init();
+  bool loadV1(ProtectionSettings &settings);
 
   bool initialized_{false};
 };
@@ -0,0 +1,429 @@
+// Decision trace replayer, built instead of the native runner by
+// [env:native_replay]. Feeds a trace recorded by src/trace ("trace export", or
+// <state>/littlefs/trace*.bin of a native run) through the same aggregators,
+// ProtectionController and TelegramCommandProcessor on the virtual clock, and
+// diffs the relay states and settings it arrives at against the recorded ones.
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <ftw.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include "config.h"
+#include "fleet/FleetNode.h"
+#include "history/HistoryStore.h"
+#include "logging/Log.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
+#include "profiling/HeapMonitor.h"
+#include "protection/ProtectionController.h"
+#include "protection/ProtectionStorage.h"
+#include "sensor/MeasurementAggregator.h"
+#include "telegram/TelegramCommandProcessor.h"
+#include "telegram/TelegramService.h"
+#include "timeseries/TimeSeriesLog.h"
+#include "trace/TraceFormat.h"
+
+namespace {
+using trace::RecordType;
+using trace::TraceRecord;
+
+struct Options {
+  std::vector<const char *> files;
+  std::vector<String> whatIf;  // Commands run at the start of every session
+  size_t maxDiffs = 20;
+  bool verbose = false;
+};
+
+// Same object graph as main.cpp, without sinks, sensor and network; one per
+// recorded boot (or resynchronising checkpoint).
+struct Session {
+  explicit Session(const protection::ProtectionSettings &settings)
+      : controller(settings),
+        fleet(bus, service),
+        processor(controller, storage, service, heap, history, series, mqtt, bus, fleet) {}
+
+  protection::ProtectionController controller;
+  protection::ProtectionSettingsStorage storage;
+  profiling::HeapMonitor heap;
+  history::HistoryStore history;
+  timeseries::TimeSeriesLog series;
+  telegram::TelegramService service;
+  mqtt::MqttService mqtt;
+  notify::NotificationBus bus;  // No sinks: publish() only counts
+  fleet::FleetNode fleet;
+  telegram::TelegramCommandProcessor processor;
+  sensor::MeasurementAggregator ambient;
+  sensor::MeasurementAggregator object;
+};
+
+struct SessionReport {
+  unsigned long startMs = 0;
+  unsigned long endMs = 0;
+  bool fromCheckpoint = false;
+  bool synced = false;  // Diffs count from here on
+  unsigned long syncedAtMs = 0;
+  uint32_t readings = 0;
+  uint32_t readErrors = 0;
+  uint32_t windowResets = 0;
+  uint32_t commands = 0;
+  uint32_t truncatedCommands = 0;
+  uint32_t safeStates = 0;
+  uint32_t recordedSwitches = 0;
+  uint32_t replayedSwitches = 0;
+  uint32_t relayDivergences = 0;
+  uint32_t settingsChecked = 0;
+  uint32_t settingsDiffering = 0;
+};
+
+struct Replay {
+  Options options;
+  std::unique_ptr<Session> session;
+  std::vector<SessionReport> reports;
+  uint8_t recordedFlags = 0;
+  uint8_t replayedFlags = 0;  // As of the last comparison
+  bool diverged = false;
+  bool comparePending = false;
+  unsigned long lastDecisionMs = 0;
+  size_t diffsPrinted = 0;
+  uint32_t badFrames = 0;
+  uint32_t orphanRecords = 0;  // Before the first Boot or Checkpoint
+};
+
+const char *relayName(uint8_t flags) {
+  switch (flags & (trace::TRACE_HEATING | trace::TRACE_COOLING)) {
+    case trace::TRACE_HEATING:
+      return "heating";
+    case trace::TRACE_COOLING:
+      return "cooling";
+    case trace::TRACE_HEATING | trace::TRACE_COOLING:
+      return "heating+cooling";
+    default:
+      return "off";
+  }
+}
+
+uint8_t replayFlags(const Session &session) {
+  return (session.controller.heatingActive() ? trace::TRACE_HEATING : 0) |
+         (session.controller.coolingActive() ? trace::TRACE_COOLING : 0);
+}
+
+bool sameSettings(const protection::ProtectionSettings &a, const protection::ProtectionSettings &b) {
+  return a.minC == b.minC && a.maxC == b.maxC && a.hysteresisC == b.hysteresisC && a.minSamples == b.minSamples &&
+         a.renotifyIntervalMs == b.renotifyIntervalMs && a.reportDeltaC == b.reportDeltaC &&
+         a.reportMaxSilenceMs == b.reportMaxSilenceMs;
+}
+
+void printDiff(Replay &replay, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void printDiff(Replay &replay, const char *format, ...) {
+  if (replay.diffsPrinted++ >= replay.options.maxDiffs) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  printf("session %u, ", static_cast<unsigned>(replay.reports.size()));
+  vprintf(format, args);
+  printf("\n");
+  va_end(args);
+}
+
+void printReply(const String &text, void *context) {
+  if (static_cast<Replay *>(context)->options.verbose) {
+    printf("    < %s\n", text.c_str());
+  }
+}
+
+void runCommand(Replay &replay, const String &text, unsigned long now) {
+  if (replay.options.verbose) {
+    printf("  t=%lu ms > %s\n", now, text.c_str());
+  }
+  replay.session->processor.processCommand(text, now, replay.session->object.stats(), printReply, &replay);
+}
+
+// Relay state once every record of one loop() pass has been replayed.
+void compareRelays(Replay &replay) {
+  if (!replay.session || !replay.comparePending) {
+    return;
+  }
+  replay.comparePending = false;
+  SessionReport &report = replay.reports.back();
+  const uint8_t flags = replayFlags(*replay.session);
+  if (flags != replay.replayedFlags) {
+    replay.replayedFlags = flags;
+    report.replayedSwitches += report.synced ? 1 : 0;
+    if (replay.options.verbose) {
+      printf("  t=%lu ms replayed relays: %s\n", replay.lastDecisionMs, relayName(flags));
+    }
+  }
+  if (!report.synced) {
+    return;
+  }
+  const bool differs = flags != replay.recordedFlags;
+  if (differs && !replay.diverged) {
+    ++report.relayDivergences;
+    printDiff(replay, "t=%lu ms: relays recorded %s, replayed %s (object last %.2f C)", replay.lastDecisionMs,
+              relayName(replay.recordedFlags), relayName(flags), replay.session->object.stats().last);
+  } else if (!differs && replay.diverged) {
+    printDiff(replay, "t=%lu ms: relays back in step (%s)", replay.lastDecisionMs, relayName(flags));
+  }
+  replay.diverged = differs;
+}
+
+void startSession(Replay &replay, const TraceRecord &record) {
+  compareRelays(replay);
+  replay.session.reset(new Session(record.settings));
+  replay.recordedFlags = record.flags & (trace::TRACE_HEATING | trace::TRACE_COOLING);
+  replay.replayedFlags = 0;
+  replay.diverged = false;
+  replay.comparePending = false;
+
+  SessionReport report;
+  report.startMs = record.uptimeMs;
+  report.endMs = record.uptimeMs;
+  report.fromCheckpoint = record.type == RecordType::Checkpoint;
+  // After a gap the window contents and relay history are unknown; diffs start once
+  // a report window closes with both sides agreeing on the relays.
+  report.synced = !report.fromCheckpoint;
+  report.syncedAtMs = record.uptimeMs;
+  replay.reports.push_back(report);
+  for (const String &command : replay.options.whatIf) {
+    runCommand(replay, command, record.uptimeMs);
+  }
+  replay.comparePending = true;
+}
+
+void checkSettings(Replay &replay, const TraceRecord &record) {
+  SessionReport &report = replay.reports.back();
+  ++report.settingsChecked;
+  const protection::ProtectionSettings &replayed = replay.session->controller.settings();
+  if (sameSettings(replayed, record.settings)) {
+    return;
+  }
+  ++report.settingsDiffering;
+  printDiff(replay, "t=%lu ms: settings recorded min %.2f max %.2f hyst %.2f samples %u, replayed min %.2f max %.2f "
+                    "hyst %.2f samples %u",
+            static_cast<unsigned long>(record.uptimeMs), record.settings.minC, record.settings.maxC,
+            record.settings.hysteresisC, static_cast<unsigned>(record.settings.minSamples), replayed.minC,
+            replayed.maxC, replayed.hysteresisC, static_cast<unsigned>(replayed.minSamples));
+}
+
+void replayRecord(Replay &replay, const TraceRecord &record) {
+  native::setMillis(record.uptimeMs);
+  if (record.type == RecordType::Boot ||
+      (record.type == RecordType::Checkpoint && (!replay.session || (record.flags & trace::TRACE_GAP)))) {
+    startSession(replay, record);
+    return;
+  }
+  if (!replay.session) {
+    ++replay.orphanRecords;
+    return;
+  }
+  Session &session = *replay.session;
+  SessionReport &report = replay.reports.back();
+  report.endMs = record.uptimeMs;
+
+  switch (record.type) {
+    case RecordType::Reading:
+      compareRelays(replay);
+      ++report.readings;
+      if (record.flags & trace::TRACE_READ_ERROR) {
+        ++report.readErrors;
+        break;
+      }
+      session.ambient.addSample(record.ambientC, record.intervalMs);
+      session.object.addSample(record.objectC, record.intervalMs);
+      session.controller.handleProtection(session.object.stats(), record.uptimeMs);
+      replay.lastDecisionMs = record.uptimeMs;
+      replay.comparePending = true;
+      break;
+    case RecordType::WindowReset:
+      ++report.windowResets;
+      session.ambient.reset();
+      session.object.reset();
+      if (!report.synced && replayFlags(session) == replay.recordedFlags) {
+        report.synced = true;
+        report.syncedAtMs = record.uptimeMs;
+        replay.replayedFlags = replay.recordedFlags;
+      }
+      break;
+    case RecordType::Relays:
+      replay.recordedFlags = record.flags & (trace::TRACE_HEATING | trace::TRACE_COOLING);
+      report.recordedSwitches += report.synced ? 1 : 0;
+      if (replay.options.verbose) {
+        printf("  t=%lu ms recorded relays: %s\n", static_cast<unsigned long>(record.uptimeMs),
+               relayName(record.flags));
+      }
+      break;
+    case RecordType::Command:
+      ++report.commands;
+      if (record.flags & trace::TRACE_TRUNCATED) {
+        ++report.truncatedCommands;
+        printDiff(replay, "t=%lu ms: command cut at %u bytes, not replayed: %s",
+                  static_cast<unsigned long>(record.uptimeMs), static_cast<unsigned>(trace::TRACE_COMMAND_MAX),
+                  record.text);
+        break;
+      }
+      runCommand(replay, String(record.text), record.uptimeMs);
+      replay.lastDecisionMs = record.uptimeMs;
+      replay.comparePending = true;
+      break;
+    case RecordType::Settings:
+      checkSettings(replay, record);
+      break;
+    case RecordType::SafeState:
+      ++report.safeStates;
+      session.controller.forceSafeState();
+      session.controller.acknowledgeForcedSafeState(record.uptimeMs);
+      replay.lastDecisionMs = record.uptimeMs;
+      replay.comparePending = true;
+      break;
+    case RecordType::Checkpoint:
+      // File rotation without lost records: the state must carry straight on.
+      compareRelays(replay);
+      checkSettings(replay, record);
+      break;
+    case RecordType::Boot:
+      break;
+  }
+}
+
+bool readFile(const char *path, std::vector<uint8_t> &data) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  uint8_t chunk[4096];
+  size_t read = 0;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.insert(data.end(), chunk, chunk + read);
+  }
+  const bool ok = ferror(file) == 0;
+  fclose(file);
+  return ok;
+}
+
+void replayBytes(Replay &replay, const std::vector<uint8_t> &data) {
+  size_t start = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (data[i] != 0) {
+      continue;
+    }
+    if (i > start) {
+      TraceRecord record;
+      if (trace::decodeRecord(data.data() + start, i - start, record)) {
+        replayRecord(replay, record);
+      } else {
+        ++replay.badFrames;
+      }
+    }
+    start = i + 1;
+  }
+  if (start < data.size()) {
+    ++replay.badFrames;  // Cut off by a power loss or an export in progress
+  }
+}
+
+bool printReports(const Replay &replay) {
+  bool matches = true;
+  for (size_t i = 0; i < replay.reports.size(); ++i) {
+    const SessionReport &r = replay.reports[i];
+    printf("session %u: %s at %lu ms, %.1f min of trace", static_cast<unsigned>(i + 1),
+           r.fromCheckpoint ? "checkpoint" : "boot", r.startMs, static_cast<double>(r.endMs - r.startMs) / 60000.0);
+    if (!r.fromCheckpoint) {
+      printf("\n");
+    } else if (r.synced) {
+      printf(", compared from %lu ms\n", r.syncedAtMs);
+    } else {
+      printf(", never back in step: not compared\n");
+    }
+    printf("  records   %u readings (%u read errors), %u window resets, %u commands, %u watchdog resets\n",
+           r.readings, r.readErrors, r.windowResets, r.commands, r.safeStates);
+    printf("  relays    recorded %u switches, replayed %u, %u divergences\n", r.recordedSwitches, r.replayedSwitches,
+           r.relayDivergences);
+    printf("  settings  %u checked, %u differ\n", r.settingsChecked, r.settingsDiffering);
+    matches &= r.relayDivergences == 0 && r.settingsDiffering == 0 && r.truncatedCommands == 0;
+  }
+  if (replay.badFrames > 0 || replay.orphanRecords > 0) {
+    printf("skipped: %u damaged frames, %u records before the first boot/checkpoint\n", replay.badFrames,
+           replay.orphanRecords);
+  }
+  return matches;
+}
+
+int removeEntry(const char *path, const struct stat *, int, struct FTW *) { return remove(path); }
+
+void printUsage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options] <trace file>...\n"
+          "  Files are replayed in the given order: trace.1.bin before trace.bin.\n"
+          "  --what-if <command>  run this command at the start of every session, e.g. \"set max 28\"\n"
+          "                       (repeatable); the diff then shows what it would have changed\n"
+          "  --max-diffs <n>      print at most n divergences (default 20)\n"
+          "  --verbose            print every relay change, command and reply\n",
+          program);
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  Replay replay;
+  for (int i = 1; i < argc; ++i) {
+    const String option(argv[i]);
+    const bool hasValue = i + 1 < argc;
+    if (option == "--what-if" && hasValue) {
+      replay.options.whatIf.push_back(String(argv[++i]));
+    } else if (option == "--max-diffs" && hasValue) {
+      replay.options.maxDiffs = strtoul(argv[++i], nullptr, 10);
+    } else if (option == "--verbose") {
+      replay.options.verbose = true;
+    } else if (option.startsWith("--")) {
+      printUsage(argv[0]);
+      return option == "--help" ? 0 : 2;
+    } else {
+      replay.options.files.push_back(argv[i]);
+    }
+  }
+  if (replay.options.files.empty()) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data;
+  for (const char *path : replay.options.files) {
+    if (!readFile(path, data)) {
+      fprintf(stderr, "%s could not be read\n", path);
+      return 2;
+    }
+    data.push_back(0);  // A frame cut at the end of one file must not swallow the next
+  }
+
+  // "set" saves to EEPROM; keep that away from the native runner's state.
+  char stateDirectory[] = "/tmp/tastan09-replay-XXXXXX";
+  if (!mkdtemp(stateDirectory)) {
+    return 2;
+  }
+  native::setStateDirectory(stateDirectory);
+  native::useVirtualClock(true);
+  native::setWifiConnected(false);
+  logging::setMuted(true);
+
+  replayBytes(replay, data);
+  compareRelays(replay);
+  replay.session.reset();
+  nftw(stateDirectory, removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+
+  if (replay.reports.empty()) {
+    fprintf(stderr, "no boot or checkpoint record found\n");
+    return 2;
+  }
+  const bool matches = printReports(replay);
+  if (replay.diffsPrinted > replay.options.maxDiffs) {
+    printf("(%u more differences not printed)\n", static_cast<unsigned>(replay.diffsPrinted - replay.options.maxDiffs));
+  }
+  printf("%s\n", matches ? "replay matches the recording" : "replay differs from the recording");
+  // Non-zero on any difference, so a logic change can be gated on recorded traces.
+  return matches ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include "sensor/AdaptiveSampler.h"
+
+#include <math.h>
+
+namespace sensor {
+namespace {
+constexpr float SLOPE_SMOOTHING = 0.5f;
+
+float clampUnit(float value) {
+  if (value < 0.0f) {
+    return 0.0f;
+  }
+  if (value > 1.0f) {
+    return 1.0f;
+  }
+  return value;
+}
+}  // namespace
+
+AdaptiveSampler::AdaptiveSampler(const AdaptiveSamplerSettings &settings)
+    : settings_(settings), intervalMs_(settings.nominalIntervalMs) {}
+
+void AdaptiveSampler::update(float value, unsigned long now, float minC, float maxC) {
+  if (hasLast_ && now != lastMillis_) {
+    const float seconds = static_cast<float>(now - lastMillis_) / 1000.0f;
+    const float instant = (value - lastValue_) / seconds;
+    slope_ += SLOPE_SMOOTHING * (instant - slope_);
+  }
+  lastValue_ = value;
+  lastMillis_ = now;
+  hasLast_ = true;
+
+  float distance = 0.0f;
+  if (value > minC && value < maxC) {
+    distance = fminf(value - minC, maxC - value);
+  }
+  const float proximity = settings_.marginC > 0.0f ? clampUnit(distance / settings_.marginC) : 1.0f;
+  const float calmness =
+      settings_.slopeCPerSecond > 0.0f ? clampUnit(1.0f - fabsf(slope_) / settings_.slopeCPerSecond) : 1.0f;
+  const float factor = fminf(proximity, calmness);
+
+  const unsigned long span = settings_.maxIntervalMs - settings_.minIntervalMs;
+  intervalMs_ = settings_.minIntervalMs + static_cast<unsigned long>(static_cast<float>(span) * factor);
+}
+
+}  // namespace sensor
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace sensor {
+
+struct AdaptiveSamplerSettings {
+  unsigned long nominalIntervalMs;
+  unsigned long minIntervalMs;
+  unsigned long maxIntervalMs;
+  float marginC;
+  float slopeCPerSecond;
+};
+
+// Chooses the next measurement interval from the distance to the protection
+// limits and the recent slope: fast near minC/maxC or on steep ramps, slow in
+// the middle of the band.
+class AdaptiveSampler {
+public:
+  explicit AdaptiveSampler(const AdaptiveSamplerSettings &settings);
+
+  void update(float value, unsigned long now, float minC, float maxC);
+  unsigned long intervalMs() const { return intervalMs_; }
+  float slopeCPerSecond() const { return slope_; }
+
+private:
+  AdaptiveSamplerSettings settings_;
+  unsigned long intervalMs_;
+  float lastValue_{0.0f};
+  unsigned long lastMillis_{0};
+  float slope_{0.0f};
+  bool hasLast_{false};
+};
+
+}  // namespace sensor
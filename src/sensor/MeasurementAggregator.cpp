@@ -5,12 +5,16 @@ namespace sensor {
 void MeasurementAggregator::reset() {
   min_ = 0.0f;
   max_ = 0.0f;
-  sum_ = 0.0f;
+  weightedSum_ = 0.0f;
   last_ = 0.0f;
   count_ = 0;
+  coveredMs_ = 0;
 }
 
-void MeasurementAggregator::addSample(float value) {
+void MeasurementAggregator::addSample(float value, unsigned long weightMs) {
+  if (weightMs == 0) {
+    weightMs = 1;
+  }
   if (count_ == 0) {
     min_ = max_ = value;
   } else {
@@ -21,7 +25,8 @@ void MeasurementAggregator::addSample(float value) {
       max_ = value;
     }
   }
-  sum_ += value;
+  weightedSum_ += value * static_cast<float>(weightMs);
+  coveredMs_ += weightMs;
   last_ = value;
   ++count_;
 }
@@ -33,11 +38,12 @@ bool MeasurementAggregator::hasSamples() const {
 MeasurementStats MeasurementAggregator::stats() const {
   MeasurementStats s;
   s.count = count_;
+  s.coveredMs = coveredMs_;
   if (count_ > 0) {
     s.min = min_;
     s.max = max_;
     s.last = last_;
-    s.average = sum_ / static_cast<float>(count_);
+    s.average = weightedSum_ / static_cast<float>(coveredMs_);
   }
   return s;
 }
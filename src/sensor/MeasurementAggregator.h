@@ -10,21 +10,25 @@ struct MeasurementStats {
   float average = 0.0f;
   float last = 0.0f;
   size_t count = 0;
+  unsigned long coveredMs = 0;  // Sum of sample weights; time span represented by the window
 };
 
 class MeasurementAggregator {
 public:
   void reset();
-  void addSample(float value);
+  // weightMs is the sampling interval the value stands for, so the average
+  // stays time-weighted when the cadence changes.
+  void addSample(float value, unsigned long weightMs);
   bool hasSamples() const;
   MeasurementStats stats() const;
 
 private:
   float min_{0.0f};
   float max_{0.0f};
-  float sum_{0.0f};
+  float weightedSum_{0.0f};
   float last_{0.0f};
   size_t count_{0};
+  unsigned long coveredMs_{0};
 };
 
 }  // namespace sensor
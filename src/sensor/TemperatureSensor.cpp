@@ -3,6 +3,9 @@
 #include <Wire.h>
 #include <math.h>
 
+#include "profiling/StageProfiler.h"
+#include "watchdog/LoopWatchdog.h"
+
 namespace sensor {
 
 bool TemperatureSensor::begin(uint8_t sdaPin, uint8_t sclPin) {
@@ -17,6 +20,8 @@ bool TemperatureSensor::read(float &ambientC, float &objectC) const {
     return false;
   }
 
+  watchdog::StageGuard stage(profiling::Stage::SensorRead);
+  profiling::ScopedStageTimer timer(profiling::Stage::SensorRead);
   const float ambient = sensor_.readAmbientTempC();
   const float object = sensor_.readObjectTempC();
   if (isnan(ambient) || isnan(object)) {
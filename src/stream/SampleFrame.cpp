@@ -0,0 +1,114 @@
+#include "stream/SampleFrame.h"
+
+namespace stream {
+namespace {
+constexpr size_t SAMPLE_DATA_BYTES = SAMPLE_PAYLOAD_BYTES - 2;
+
+// Nibble table: 32 bytes instead of 512, about half the cost of the bitwise loop.
+const uint16_t CRC16_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+void putLe(uint8_t *out, uint32_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t getLe(const uint8_t *in, size_t bytes) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+uint16_t crc16Ccitt(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; ++i) {
+    crc = static_cast<uint16_t>((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = static_cast<uint16_t>((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+size_t cobsEncode(const uint8_t *in, size_t length, uint8_t *out) {
+  size_t codeIndex = 0;
+  size_t written = 1;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; ++i) {
+    if (in[i] == 0) {
+      out[codeIndex] = code;
+      codeIndex = written++;
+      code = 1;
+      continue;
+    }
+    out[written++] = in[i];
+    if (++code == 0xFF) {
+      out[codeIndex] = code;
+      codeIndex = written++;
+      code = 1;
+    }
+  }
+  out[codeIndex] = code;
+  return written;
+}
+
+size_t cobsDecode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity) {
+  size_t read = 0;
+  size_t written = 0;
+  while (read < length) {
+    const uint8_t code = in[read++];
+    if (code == 0 || read + code - 1 > length) {
+      return 0;
+    }
+    for (uint8_t i = 1; i < code; ++i) {
+      if (written == capacity || in[read] == 0) {
+        return 0;
+      }
+      out[written++] = in[read++];
+    }
+    if (code != 0xFF && read < length) {
+      if (written == capacity) {
+        return 0;
+      }
+      out[written++] = 0;
+    }
+  }
+  return written;
+}
+
+size_t encodeSampleFrame(const SampleRecord &record, uint8_t *out) {
+  uint8_t payload[SAMPLE_PAYLOAD_BYTES];
+  payload[0] = SAMPLE_FRAME_TYPE;
+  putLe(payload + 1, record.sequence, 2);
+  putLe(payload + 3, record.uptimeMs, 4);
+  putLe(payload + 7, static_cast<uint16_t>(record.ambientCenti), 2);
+  putLe(payload + 9, static_cast<uint16_t>(record.objectCenti), 2);
+  payload[11] = record.flags;
+  putLe(payload + SAMPLE_DATA_BYTES, crc16Ccitt(payload, SAMPLE_DATA_BYTES), 2);
+
+  const size_t encoded = cobsEncode(payload, sizeof(payload), out);
+  out[encoded] = 0;
+  return encoded + 1;
+}
+
+bool decodeSampleFrame(const uint8_t *frame, size_t length, SampleRecord &record) {
+  uint8_t payload[SAMPLE_PAYLOAD_BYTES + 1];
+  if (cobsDecode(frame, length, payload, sizeof(payload)) != SAMPLE_PAYLOAD_BYTES ||
+      payload[0] != SAMPLE_FRAME_TYPE ||
+      getLe(payload + SAMPLE_DATA_BYTES, 2) != crc16Ccitt(payload, SAMPLE_DATA_BYTES)) {
+    return false;
+  }
+  record.sequence = static_cast<uint16_t>(getLe(payload + 1, 2));
+  record.uptimeMs = getLe(payload + 3, 4);
+  record.ambientCenti = static_cast<int16_t>(getLe(payload + 7, 2));
+  record.objectCenti = static_cast<int16_t>(getLe(payload + 9, 2));
+  record.flags = payload[11];
+  return true;
+}
+
+}  // namespace stream
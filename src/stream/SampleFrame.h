@@ -0,0 +1,44 @@
+#pragma once
+
+// Wire format of the binary serial sample stream. Free of Arduino dependencies
+// so host tools can build the same code.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace stream {
+
+constexpr uint8_t SAMPLE_FRAME_TYPE = 0x01;
+constexpr size_t SAMPLE_PAYLOAD_BYTES = 14;  // 12 data + CRC-16
+// COBS adds one byte per 254 payload bytes, then the 0x00 delimiter.
+constexpr size_t SAMPLE_FRAME_MAX_BYTES = SAMPLE_PAYLOAD_BYTES + SAMPLE_PAYLOAD_BYTES / 254 + 2;
+constexpr int16_t SAMPLE_INVALID_CENTI = INT16_MIN;  // Temperature field of a failed read
+
+enum SampleFlags : uint8_t {
+  SAMPLE_HEATING = 0x01,
+  SAMPLE_COOLING = 0x02,
+  SAMPLE_READ_ERROR = 0x04,
+};
+
+struct SampleRecord {
+  uint16_t sequence = 0;     // Wraps; gaps mean frames lost on the device or the wire
+  uint32_t uptimeMs = 0;     // millis() at the read
+  int16_t ambientCenti = 0;  // 0.01 C
+  int16_t objectCenti = 0;
+  uint8_t flags = 0;         // SampleFlags
+};
+
+// Payload layout (little endian), COBS encoded and terminated by 0x00:
+//   u8 type, u16 sequence, u32 uptimeMs, i16 ambient, i16 object, u8 flags,
+//   u16 CRC-16/CCITT-FALSE over the preceding 12 bytes
+size_t encodeSampleFrame(const SampleRecord &record, uint8_t *out);
+// Takes one frame without its delimiter; false on COBS, length, type or CRC errors.
+bool decodeSampleFrame(const uint8_t *frame, size_t length, SampleRecord &record);
+
+uint16_t crc16Ccitt(const uint8_t *data, size_t length);
+// out needs length + length / 254 + 1 bytes; no delimiter is written.
+size_t cobsEncode(const uint8_t *in, size_t length, uint8_t *out);
+// Returns the decoded length, or 0 when the input is not valid COBS.
+size_t cobsDecode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity);
+
+}  // namespace stream
@@ -0,0 +1,127 @@
+#include "stream/SampleStream.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "config.h"
+#include "logging/Log.h"
+#include "text/MessageCatalog.h"
+
+namespace stream {
+namespace {
+constexpr size_t CONTROL_LINE_MAX = 16;
+
+bool streaming = false;
+uint16_t nextSequence = 0;
+StreamStats counters;
+char controlLine[CONTROL_LINE_MAX];
+size_t controlLength = 0;
+bool controlOverflow = false;
+
+int16_t toCenti(float celsius) {
+  const long centi = lroundf(celsius * 100.0f);
+  if (centi <= SAMPLE_INVALID_CENTI || centi > INT16_MAX) {
+    return SAMPLE_INVALID_CENTI;
+  }
+  return static_cast<int16_t>(centi);
+}
+
+void handleControlLine() {
+  if (strcmp_P(controlLine, PSTR("stream on")) == 0) {
+    setActive(true);
+  } else if (strcmp_P(controlLine, PSTR("stream off")) == 0) {
+    setActive(false);
+  }
+}
+}  // namespace
+
+void begin() {
+  if (config::ENABLE_SAMPLE_STREAM && config::STREAM_START_ACTIVE) {
+    setActive(true);
+  }
+}
+
+void setActive(bool value) {
+  if (!config::ENABLE_SAMPLE_STREAM || value == streaming) {
+    return;
+  }
+  if (value) {
+    // Finish the log line in flight, then a lone delimiter so the decoder syncs on the first frame.
+    logging::flush();
+    logging::setMuted(true);
+    Serial.write(static_cast<uint8_t>(0));
+    counters = StreamStats();
+    counters.startedMs = millis();
+    streaming = true;
+    return;
+  }
+  streaming = false;
+  Serial.flush();
+  logging::setMuted(false);
+  LOG_INFO("Ikili akis kapandi: %lu cerceve, %lu dusen", static_cast<unsigned long>(counters.frames),
+           static_cast<unsigned long>(counters.dropped));
+}
+
+bool active() { return streaming; }
+
+void emit(unsigned long uptimeMs, bool readOk, float ambientC, float objectC, bool heating, bool cooling) {
+  if (!streaming) {
+    return;
+  }
+  SampleRecord record;
+  record.sequence = nextSequence++;
+  record.uptimeMs = static_cast<uint32_t>(uptimeMs);
+  record.ambientCenti = readOk ? toCenti(ambientC) : SAMPLE_INVALID_CENTI;
+  record.objectCenti = readOk ? toCenti(objectC) : SAMPLE_INVALID_CENTI;
+  record.flags = (heating ? SAMPLE_HEATING : 0) | (cooling ? SAMPLE_COOLING : 0) | (readOk ? 0 : SAMPLE_READ_ERROR);
+
+  uint8_t frame[SAMPLE_FRAME_MAX_BYTES];
+  const size_t length = encodeSampleFrame(record, frame);
+  // A partial frame would cost the next one too, so write whole frames or nothing.
+  if (Serial.availableForWrite() < static_cast<int>(length)) {
+    ++counters.dropped;
+    return;
+  }
+  Serial.write(frame, length);
+  ++counters.frames;
+  counters.bytes += length;
+}
+
+void update() {
+  if (!config::ENABLE_SAMPLE_STREAM) {
+    return;
+  }
+  while (Serial.available() > 0) {
+    const int c = Serial.read();
+    if (c == '\r' || c == '\n') {
+      if (!controlOverflow && controlLength > 0) {
+        controlLine[controlLength] = '\0';
+        handleControlLine();
+      }
+      controlLength = 0;
+      controlOverflow = false;
+    } else if (controlLength + 1 < CONTROL_LINE_MAX) {
+      controlLine[controlLength++] = static_cast<char>(c);
+    } else {
+      controlOverflow = true;
+    }
+  }
+}
+
+const StreamStats &stats() { return counters; }
+
+String formatStats() {
+  String message = text::format(text::MessageId::StreamStats,
+                                streaming ? text::MessageId::StateOn : text::MessageId::StateOff, counters.frames,
+                                counters.dropped, counters.bytes);
+  if (streaming) {
+    const unsigned long elapsedMs = millis() - counters.startedMs;
+    if (elapsedMs > 0) {
+      text::append(message, text::MessageId::StreamRate,
+                   String(static_cast<float>(counters.frames) * 1000.0f / static_cast<float>(elapsedMs), 1));
+    }
+  }
+  return message;
+}
+
+}  // namespace stream
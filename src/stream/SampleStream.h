@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "stream/SampleFrame.h"
+
+namespace stream {
+
+// Counts the current (or last) streaming session.
+struct StreamStats {
+  uint32_t frames = 0;   // Frames handed to the UART
+  uint32_t dropped = 0;  // UART FIFO full: frame skipped, its sequence number stays consumed
+  uint32_t bytes = 0;
+  unsigned long startedMs = 0;
+};
+
+// Binary sample stream on the serial port (see SampleFrame.h for the wire format).
+// While active, text logging is muted so the two never interleave; the port
+// accepts "stream on" / "stream off" lines so a host tool can switch it without
+// Telegram or MQTT (tools/sample_stream.py does).
+void begin();
+void setActive(bool active);
+bool active();
+// Frames one sensor read; never blocks on the UART.
+void emit(unsigned long uptimeMs, bool readOk, float ambientC, float objectC, bool heating, bool cooling);
+// Reads control lines from the serial port; call once per loop() pass.
+void update();
+
+const StreamStats &stats();
+String formatStats();
+
+}  // namespace stream
@@ -0,0 +1,56 @@
+#include "telegram/ChunkedBodyWriter.h"
+
+namespace telegram {
+
+size_t ChunkedBodyWriter::write(uint8_t c) {
+  if (used_ == CHUNK_SIZE && !flushChunk()) {
+    return 0;
+  }
+  buffer_[used_++] = c;
+  return 1;
+}
+
+size_t ChunkedBodyWriter::write(const uint8_t *data, size_t length) {
+  size_t written = 0;
+  while (written < length) {
+    if (used_ == CHUNK_SIZE && !flushChunk()) {
+      break;
+    }
+    size_t n = CHUNK_SIZE - used_;
+    if (n > length - written) {
+      n = length - written;
+    }
+    memcpy(buffer_ + used_, data + written, n);
+    used_ += n;
+    written += n;
+  }
+  return written;
+}
+
+bool ChunkedBodyWriter::flushChunk() {
+  if (used_ == 0 || failed_) {
+    used_ = 0;
+    return !failed_;
+  }
+  char size[8];
+  const int sizeLength = snprintf(size, sizeof(size), "%X\r\n", static_cast<unsigned>(used_));
+  if (writeRaw(reinterpret_cast<const uint8_t *>(size), static_cast<size_t>(sizeLength)) &&
+      writeRaw(buffer_, used_) && writeRaw(reinterpret_cast<const uint8_t *>("\r\n"), 2)) {
+    payloadBytes_ += used_;
+  }
+  used_ = 0;
+  return !failed_;
+}
+
+bool ChunkedBodyWriter::finish() {
+  return flushChunk() && writeRaw(reinterpret_cast<const uint8_t *>("0\r\n\r\n"), 5);
+}
+
+bool ChunkedBodyWriter::writeRaw(const uint8_t *data, size_t length) {
+  if (!failed_) {
+    failed_ = out_.write(data, length) != length;
+  }
+  return !failed_;
+}
+
+}  // namespace telegram
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace telegram {
+
+// Print adapter that frames everything written to it as HTTP/1.1 chunked
+// transfer encoding, one chunk per filled buffer, so a request body can be
+// produced incrementally without knowing its length up front.
+class ChunkedBodyWriter : public Print {
+public:
+  static constexpr size_t CHUNK_SIZE = 256;
+
+  explicit ChunkedBodyWriter(Print &out) : out_(out) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t length) override;
+  using Print::write;
+
+  // Sends the buffered bytes as one chunk.
+  bool flushChunk();
+  // Sends the terminating zero-length chunk.
+  bool finish();
+  bool ok() const { return !failed_; }
+  size_t payloadBytes() const { return payloadBytes_; }
+
+private:
+  bool writeRaw(const uint8_t *data, size_t length);
+
+  Print &out_;
+  uint8_t buffer_[CHUNK_SIZE];
+  size_t used_{0};
+  size_t payloadBytes_{0};
+  bool failed_{false};
+};
+
+}  // namespace telegram
@@ -0,0 +1,100 @@
+#include "telegram/CommandTokenizer.h"
+
+namespace telegram {
+namespace {
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+}  // namespace
+
+bool CommandTokenizer::next(CommandToken &token) {
+  skipSpace();
+  if (position_ >= end_) {
+    return false;
+  }
+  token.text = position_;
+  while (position_ < end_ && !isSpace(*position_)) {
+    ++position_;
+  }
+  token.length = static_cast<size_t>(position_ - token.text);
+  return true;
+}
+
+CommandToken CommandTokenizer::rest() {
+  skipSpace();
+  CommandToken token;
+  token.text = position_;
+  const char *last = end_;
+  while (last > position_ && isSpace(*(last - 1))) {
+    --last;
+  }
+  token.length = static_cast<size_t>(last - position_);
+  position_ = end_;
+  return token;
+}
+
+bool CommandTokenizer::atEnd() {
+  skipSpace();
+  return position_ >= end_;
+}
+
+uint32_t CommandTokenizer::hash(const CommandToken &token) {
+  uint32_t value = COMMAND_HASH_OFFSET;
+  for (size_t i = 0; i < token.length; ++i) {
+    value = (value ^ static_cast<uint8_t>(asciiLower(token.text[i]))) * COMMAND_HASH_PRIME;
+  }
+  return value;
+}
+
+bool CommandTokenizer::equals(const CommandToken &token, const char *name) {
+  size_t i = 0;
+  for (; i < token.length; ++i) {
+    if (name[i] == '\0' || asciiLower(token.text[i]) != name[i]) {
+      return false;
+    }
+  }
+  return name[i] == '\0';
+}
+
+bool CommandTokenizer::parseDuration(const CommandToken &token, unsigned long &durationMs) {
+  uint32_t value = 0;
+  size_t i = 0;
+  for (; i < token.length && token.text[i] >= '0' && token.text[i] <= '9'; ++i) {
+    value = value * 10 + static_cast<uint32_t>(token.text[i] - '0');
+    if (value > 100000UL) {
+      return false;
+    }
+  }
+  if (i == 0 || value == 0 || i + 1 < token.length) {
+    return false;
+  }
+
+  uint32_t unitMs = 60000UL;
+  if (i < token.length) {
+    switch (asciiLower(token.text[i])) {
+      case 'm':
+        break;
+      case 'h':
+        unitMs = 3600000UL;
+        break;
+      case 'd':
+        unitMs = 86400000UL;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (value > UINT32_MAX / unitMs) {
+    return false;
+  }
+  durationMs = value * unitMs;
+  return true;
+}
+
+void CommandTokenizer::skipSpace() {
+  while (position_ < end_ && isSpace(*position_)) {
+    ++position_;
+  }
+}
+
+}  // namespace telegram
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace telegram {
+
+constexpr uint32_t COMMAND_HASH_OFFSET = 2166136261UL;  // FNV-1a
+constexpr uint32_t COMMAND_HASH_PRIME = 16777619UL;
+
+constexpr char asciiLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Case-insensitive FNV-1a; evaluated at compile time for the command tables.
+constexpr uint32_t commandHash(const char *text, uint32_t hash = COMMAND_HASH_OFFSET) {
+  return *text ? commandHash(text + 1, (hash ^ static_cast<uint8_t>(asciiLower(*text))) * COMMAND_HASH_PRIME)
+               : hash;
+}
+
+struct CommandToken {
+  const char *text = nullptr;
+  size_t length = 0;
+};
+
+// Splits a command in place into whitespace separated tokens without copying.
+class CommandTokenizer {
+public:
+  CommandTokenizer(const char *text, size_t length) : end_(text + length), position_(text) {}
+
+  bool next(CommandToken &token);
+  // Remaining text with surrounding whitespace removed; consumes the tokenizer.
+  CommandToken rest();
+  bool atEnd();
+
+  static uint32_t hash(const CommandToken &token);
+  static bool equals(const CommandToken &token, const char *name);
+  // Accepts "<n>m", "<n>h", "<n>d" or plain minutes; rejects values that overflow 32-bit milliseconds.
+  static bool parseDuration(const CommandToken &token, unsigned long &durationMs);
+
+private:
+  void skipSpace();
+
+  const char *end_;
+  const char *position_;
+};
+
+}  // namespace telegram
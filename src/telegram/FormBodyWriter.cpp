@@ -0,0 +1,73 @@
+#include "telegram/FormBodyWriter.h"
+
+namespace telegram {
+namespace {
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+bool isUnreserved(uint8_t c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' ||
+         c == '.' || c == '~';
+}
+}  // namespace
+
+size_t FormBodyWriter::encodedLength(const char *value, size_t length) {
+  size_t total = 0;
+  for (size_t i = 0; i < length; ++i) {
+    const uint8_t c = static_cast<uint8_t>(value[i]);
+    total += (isUnreserved(c) || c == ' ') ? 1 : 3;
+  }
+  return total;
+}
+
+size_t FormBodyWriter::fieldLength(const char *name, const char *value, size_t valueLength, bool first) {
+  return (first ? 0 : 1) + strlen(name) + 1 + encodedLength(value, valueLength);
+}
+
+void FormBodyWriter::field(const char *name, const char *value, size_t valueLength) {
+  if (!first_) {
+    put('&');
+  }
+  first_ = false;
+  for (const char *p = name; *p; ++p) {
+    put(*p);
+  }
+  put('=');
+  for (size_t i = 0; i < valueLength; ++i) {
+    const uint8_t c = static_cast<uint8_t>(value[i]);
+    if (isUnreserved(c)) {
+      put(static_cast<char>(c));
+    } else if (c == ' ') {
+      put('+');
+    } else {
+      put('%');
+      put(HEX_DIGITS[(c >> 4) & 0x0F]);
+      put(HEX_DIGITS[c & 0x0F]);
+    }
+  }
+}
+
+bool FormBodyWriter::finish() {
+  flush();
+  return !failed_;
+}
+
+void FormBodyWriter::put(char c) {
+  if (used_ == CHUNK_SIZE) {
+    flush();
+  }
+  buffer_[used_++] = c;
+}
+
+void FormBodyWriter::flush() {
+  if (used_ == 0) {
+    return;
+  }
+  if (!failed_) {
+    const size_t sent = out_.write(reinterpret_cast<const uint8_t *>(buffer_), used_);
+    written_ += sent;
+    failed_ = sent != used_;
+  }
+  used_ = 0;
+}
+
+}  // namespace telegram
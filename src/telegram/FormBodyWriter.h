@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace telegram {
+
+// Writes an application/x-www-form-urlencoded body to a Print in fixed-size
+// chunks, percent-encoding values on the fly so no encoded copy is built.
+class FormBodyWriter {
+public:
+  static constexpr size_t CHUNK_SIZE = 128;
+
+  explicit FormBodyWriter(Print &out) : out_(out) {}
+
+  static size_t encodedLength(const char *value, size_t length);
+  static size_t fieldLength(const char *name, const char *value, size_t valueLength, bool first);
+
+  void field(const char *name, const char *value, size_t valueLength);
+  bool finish();
+  size_t written() const { return written_; }
+
+private:
+  void put(char c);
+  void flush();
+
+  Print &out_;
+  char buffer_[CHUNK_SIZE];
+  size_t used_{0};
+  size_t written_{0};
+  bool first_{true};
+  bool failed_{false};
+};
+
+}  // namespace telegram
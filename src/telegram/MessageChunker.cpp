@@ -0,0 +1,79 @@
+#include "telegram/MessageChunker.h"
+
+namespace telegram {
+
+MessageChunker::MessageChunker(const char *text, size_t length, size_t maxUnits)
+    : text_(text), length_(length), maxUnits_(maxUnits > 0 ? maxUnits : 1) {
+  size_t units = 0;
+  for (size_t i = 0; i < length_ && units <= maxUnits_;) {
+    const size_t width = sequenceLength(static_cast<uint8_t>(text_[i]));
+    units += width == 4 ? 2 : 1;
+    i += width;
+  }
+  fitsInOne_ = units <= maxUnits_;
+}
+
+bool MessageChunker::next(TextSpan &span) {
+  if (position_ >= length_) {
+    return false;
+  }
+
+  size_t units = 0;
+  size_t end = position_;
+  size_t lastBreak = 0;  // Offset just past the last '\n' inside the window
+  while (end < length_) {
+    size_t width = sequenceLength(static_cast<uint8_t>(text_[end]));
+    if (end + width > length_) {
+      width = length_ - end;
+    }
+    const size_t cost = width == 4 ? 2 : 1;
+    if (units + cost > maxUnits_) {
+      break;
+    }
+    units += cost;
+    end += width;
+    if (text_[end - 1] == '\n') {
+      lastBreak = end;
+    }
+  }
+
+  if (end == position_) {
+    // A 4-byte sequence under a 1-unit limit: sent on its own rather than never.
+    end += sequenceLength(static_cast<uint8_t>(text_[end]));
+    if (end > length_) {
+      end = length_;
+    }
+  }
+
+  if (end < length_ && lastBreak > position_) {
+    span.offset = position_;
+    span.length = lastBreak - 1 - position_;  // Drop the newline itself
+    position_ = lastBreak;
+  } else {
+    span.offset = position_;
+    span.length = end - position_;
+    position_ = end;
+  }
+  if (span.length == 0) {
+    return next(span);  // Blank line at a chunk boundary
+  }
+  return true;
+}
+
+size_t MessageChunker::sequenceLength(uint8_t lead) {
+  if (lead < 0x80) {
+    return 1;
+  }
+  if ((lead & 0xE0) == 0xC0) {
+    return 2;
+  }
+  if ((lead & 0xF0) == 0xE0) {
+    return 3;
+  }
+  if ((lead & 0xF8) == 0xF0) {
+    return 4;
+  }
+  return 1;  // Stray continuation or invalid byte: treat as a single unit
+}
+
+}  // namespace telegram
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace telegram {
+
+struct TextSpan {
+  size_t offset;
+  size_t length;
+};
+
+// Splits a UTF-8 text into spans that fit Telegram's message limit (counted in
+// UTF-16 code units, as Telegram does). Spans end at line breaks where
+// possible and never inside a multi-byte sequence; the text is not copied.
+class MessageChunker {
+public:
+  MessageChunker(const char *text, size_t length, size_t maxUnits);
+
+  bool next(TextSpan &span);
+  bool single() const { return fitsInOne_; }
+
+private:
+  static size_t sequenceLength(uint8_t lead);
+
+  const char *text_;
+  size_t length_;
+  size_t maxUnits_;
+  size_t position_{0};
+  bool fitsInOne_{false};
+};
+
+}  // namespace telegram
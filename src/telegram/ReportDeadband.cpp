@@ -0,0 +1,47 @@
+#include "telegram/ReportDeadband.h"
+
+#include <math.h>
+
+namespace telegram {
+namespace {
+bool moved(float current, float reference, float deltaC) {
+  return fabsf(current - reference) > deltaC;
+}
+}  // namespace
+
+bool ReportDeadband::shouldSend(const sensor::MeasurementStats &ambientStats,
+                                const sensor::MeasurementStats &objectStats, bool heating, bool cooling,
+                                unsigned long now, float deltaC, unsigned long maxSilenceMs) {
+  if (deltaC <= 0.0f || !hasSent_) {
+    return true;
+  }
+  if (heating != heating_ || cooling != cooling_) {
+    return true;
+  }
+  if (now - lastSentMillis_ >= maxSilenceMs) {
+    return true;
+  }
+  return moved(objectStats.average, objectAverage_, deltaC) || moved(objectStats.min, objectMin_, deltaC) ||
+         moved(objectStats.max, objectMax_, deltaC) || moved(ambientStats.average, ambientAverage_, deltaC);
+}
+
+void ReportDeadband::markSent(const sensor::MeasurementStats &ambientStats,
+                              const sensor::MeasurementStats &objectStats, bool heating, bool cooling,
+                              unsigned long now) {
+  hasSent_ = true;
+  objectAverage_ = objectStats.average;
+  objectMin_ = objectStats.min;
+  objectMax_ = objectStats.max;
+  ambientAverage_ = ambientStats.average;
+  heating_ = heating;
+  cooling_ = cooling;
+  lastSentMillis_ = now;
+  suppressedSinceSend_ = 0;
+}
+
+void ReportDeadband::markSuppressed() {
+  ++suppressedSinceSend_;
+  ++suppressedTotal_;
+}
+
+}  // namespace telegram
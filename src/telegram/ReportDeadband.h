@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "sensor/MeasurementAggregator.h"
+
+namespace telegram {
+
+// Suppresses periodic reports whose content has not moved by more than the
+// configured delta since the last report that was actually sent.
+class ReportDeadband {
+public:
+  bool shouldSend(const sensor::MeasurementStats &ambientStats, const sensor::MeasurementStats &objectStats,
+                  bool heating, bool cooling, unsigned long now, float deltaC, unsigned long maxSilenceMs);
+  void markSent(const sensor::MeasurementStats &ambientStats, const sensor::MeasurementStats &objectStats,
+                bool heating, bool cooling, unsigned long now);
+  void markSuppressed();
+
+  uint32_t suppressedSinceLastSend() const { return suppressedSinceSend_; }
+  uint32_t suppressedTotal() const { return suppressedTotal_; }
+
+private:
+  bool hasSent_{false};
+  float objectAverage_{0.0f};
+  float objectMin_{0.0f};
+  float objectMax_{0.0f};
+  float ambientAverage_{0.0f};
+  bool heating_{false};
+  bool cooling_{false};
+  unsigned long lastSentMillis_{0};
+  uint32_t suppressedSinceSend_{0};
+  uint32_t suppressedTotal_{0};
+};
+
+}  // namespace telegram
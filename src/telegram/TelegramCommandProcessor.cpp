@@ -1,172 +1,435 @@
 #include "telegram/TelegramCommandProcessor.h"
 
+#include <stdlib.h>
+
 #include "config.h"
+#include "logging/Log.h"
+#include "profiling/StageProfiler.h"
+#include "stream/SampleStream.h"
+#include "text/MessageCatalog.h"
+#include "timeseries/WallClock.h"
+#include "trace/TraceRecorder.h"
+#include "watchdog/LoopWatchdog.h"
 
 namespace telegram {
 
+using Protection = protection::ProtectionController;
+using text::MessageId;
+
+const TelegramCommandProcessor::CommandEntry TelegramCommandProcessor::COMMANDS[] = {
+    {commandHash("config"), "config", false, &TelegramCommandProcessor::handleConfig},
+    {commandHash("stats"), "stats", false, &TelegramCommandProcessor::handleStats},
+    {commandHash("heap"), "heap", false, &TelegramCommandProcessor::handleHeap},
+    {commandHash("history"), "history", true, &TelegramCommandProcessor::handleHistory},
+    {commandHash("export"), "export", true, &TelegramCommandProcessor::handleExport},
+    {commandHash("set"), "set", true, &TelegramCommandProcessor::handleSet},
+    {commandHash("stream"), "stream", true, &TelegramCommandProcessor::handleStream},
+    {commandHash("fleet"), "fleet", false, &TelegramCommandProcessor::handleFleet},
+    {commandHash("trace"), "trace", true, &TelegramCommandProcessor::handleTrace},
+};
+const size_t TelegramCommandProcessor::COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+const TelegramCommandProcessor::SettingEntry TelegramCommandProcessor::SETTINGS[] = {
+    {commandHash("min"), "min", ArgumentType::Decimal,
+     [](Protection &p, float v, String &e) { return p.setMin(v, e); }, MessageId::LabelMin, MessageId::UnitCelsius},
+    {commandHash("max"), "max", ArgumentType::Decimal,
+     [](Protection &p, float v, String &e) { return p.setMax(v, e); }, MessageId::LabelMax, MessageId::UnitCelsius},
+    {commandHash("hysteresis"), "hysteresis", ArgumentType::Decimal,
+     [](Protection &p, float v, String &e) { return p.setHysteresis(v, e); }, MessageId::LabelHysteresis, MessageId::UnitCelsius},
+    {commandHash("minsamples"), "minsamples", ArgumentType::Integer,
+     [](Protection &p, float v, String &e) { return p.setMinSamples(static_cast<size_t>(v), e); },
+     MessageId::LabelMinSamples, MessageId::UnitNone},
+    {commandHash("renotify"), "renotify", ArgumentType::Integer,
+     [](Protection &p, float v, String &e) { return p.setRenotifySeconds(static_cast<unsigned long>(v), e); },
+     MessageId::LabelRenotify, MessageId::UnitSeconds},
+    {commandHash("deadband"), "deadband", ArgumentType::Decimal,
+     [](Protection &p, float v, String &e) { return p.setReportDeadband(v, e); }, MessageId::LabelDeadband, MessageId::UnitCelsius},
+    {commandHash("silence"), "silence", ArgumentType::Integer,
+     [](Protection &p, float v, String &e) { return p.setReportSilenceSeconds(static_cast<unsigned long>(v), e); },
+     MessageId::LabelSilence, MessageId::UnitSeconds},
+};
+const size_t TelegramCommandProcessor::SETTING_COUNT = sizeof(SETTINGS) / sizeof(SETTINGS[0]);
+
 TelegramCommandProcessor::TelegramCommandProcessor(protection::ProtectionController &protection,
                                                    protection::ProtectionSettingsStorage &storage,
-                                                   TelegramService &service)
-    : protection_(protection), storage_(storage), service_(service) {}
+                                                   TelegramService &service,
+                                                   profiling::HeapMonitor &heapMonitor,
+                                                   history::HistoryStore &history,
+                                                   timeseries::TimeSeriesLog &seriesLog,
+                                                   const mqtt::MqttService &mqttService,
+                                                   const notify::NotificationBus &notificationBus,
+                                                   fleet::FleetNode &fleet)
+    : protection_(protection),
+      storage_(storage),
+      service_(service),
+      heapMonitor_(heapMonitor),
+      history_(history),
+      seriesLog_(seriesLog),
+      mqttService_(mqttService),
+      notificationBus_(notificationBus),
+      fleet_(fleet) {}
 
 void TelegramCommandProcessor::processCommand(const String &text, const String &chatId, unsigned long now,
                                               const sensor::MeasurementStats &objectStats) {
-  String trimmed = text;
-  trimmed.trim();
-  if (trimmed.length() == 0) {
-    return;
-  }
+  trace::recordCommand(now, text);
+  dispatch(text, chatId, now, objectStats);
+}
 
-  String lower = trimmed;
-  lower.toLowerCase();
+void TelegramCommandProcessor::processCommand(const String &text, unsigned long now,
+                                              const sensor::MeasurementStats &objectStats, ReplyFunction replyTo,
+                                              void *context) {
+  replyOverride_ = replyTo;
+  replyContext_ = context;
+  trace::recordCommand(now, text);
+  dispatch(text, String(), now, objectStats);
+  replyOverride_ = nullptr;
+  replyContext_ = nullptr;
+}
 
-  if (lower == F("config")) {
-    service_.sendDirect(protection_.formatProtectionConfig(), chatId);
+void TelegramCommandProcessor::dispatch(const String &text, const String &chatId, unsigned long now,
+                                        const sensor::MeasurementStats &objectStats) {
+  CommandTokenizer args(text.c_str(), text.length());
+  CommandToken name;
+  if (!args.next(name)) {
     return;
   }
-
-  if (!lower.startsWith(F("set "))) {
-    service_.sendDirect(F("Bilinmeyen komut. 'config' veya 'set ...' kullanin."), chatId);
+  if (name.text[0] == '@') {
+    routeToNode(name, args, chatId, now, objectStats);
     return;
   }
 
-  const int keyStart = 4;
-  const int spaceIndex = lower.indexOf(' ', keyStart);
-  if (spaceIndex < 0) {
-    service_.sendDirect(F("Eksik parametre. Ornek: set min 22.5"), chatId);
+  const uint32_t hash = CommandTokenizer::hash(name);
+  for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+    const CommandEntry &command = COMMANDS[i];
+    if (command.hash != hash || !CommandTokenizer::equals(name, command.name)) {
+      continue;
+    }
+    if (!command.takesArguments && !args.atEnd()) {
+      break;
+    }
+    (this->*command.handler)(args, chatId, now, objectStats);
     return;
   }
 
-  const String key = lower.substring(keyStart, spaceIndex);
-  String valueText = trimmed.substring(spaceIndex + 1);
-  valueText.trim();
-  if (valueText.length() == 0) {
-    service_.sendDirect(F("Deger bulunamadi. Ornek: set max 28.0"), chatId);
+  reply(MessageId::UnknownCommand, chatId, MessageId::Usage);
+}
+
+void TelegramCommandProcessor::reply(const String &text, const String &chatId) {
+  if (replyOverride_) {
+    replyOverride_(text, replyContext_);
     return;
   }
+  service_.sendDirect(text, chatId);
+}
 
-  bool updated = false;
-  String response;
-  const protection::ProtectionSettings previousSettings = protection_.settings();
+void TelegramCommandProcessor::reply(text::MessageId id, const String &chatId, text::Arg arg) {
+  reply(text::format(id, arg), chatId);
+}
 
-  if (key == F("min")) {
-    if (!isValidNumber(valueText, true)) {
-      service_.sendDirect(F("Gecersiz sayi. Ondalik icin nokta kullanin."), chatId);
-      return;
-    }
-    const float newMin = valueText.toFloat();
-    String error;
-    if (!protection_.setMin(newMin, error)) {
-      service_.sendDirect(error, chatId);
-      return;
-    }
-    response = F("Ayar guncellendi: min = ");
-    response += String(newMin, 2);
-    response += F(" C");
-    updated = true;
-  } else if (key == F("max")) {
-    if (!isValidNumber(valueText, true)) {
-      service_.sendDirect(F("Gecersiz sayi. Ondalik icin nokta kullanin."), chatId);
-      return;
-    }
-    const float newMax = valueText.toFloat();
-    String error;
-    if (!protection_.setMax(newMax, error)) {
-      service_.sendDirect(error, chatId);
-      return;
-    }
-    response = F("Ayar guncellendi: max = ");
-    response += String(newMax, 2);
-    response += F(" C");
-    updated = true;
-  } else if (key == F("hysteresis")) {
-    if (!isValidNumber(valueText, true)) {
-      service_.sendDirect(F("Gecersiz sayi. Ondalik icin nokta kullanin."), chatId);
-      return;
-    }
-    const float newH = valueText.toFloat();
-    String error;
-    if (!protection_.setHysteresis(newH, error)) {
-      service_.sendDirect(error, chatId);
+void TelegramCommandProcessor::handleConfig(CommandTokenizer &, const String &chatId, unsigned long,
+                                            const sensor::MeasurementStats &) {
+  reply(protection_.formatProtectionConfig(), chatId);
+}
+
+void TelegramCommandProcessor::handleStats(CommandTokenizer &, const String &chatId, unsigned long,
+                                           const sensor::MeasurementStats &) {
+  String report = profiling::formatReport();
+  report += '\n';
+  report += watchdog::formatReport();
+  report += '\n';
+  report += service_.formatStats();
+  if (config::ENABLE_HISTORY) {
+    report += '\n';
+    report += history_.formatMemoryLine();
+  }
+  if (config::ENABLE_TIMESERIES_LOG) {
+    report += '\n';
+    report += seriesLog_.formatStats();
+  }
+  if (config::ENABLE_MQTT) {
+    report += '\n';
+    report += mqttService_.formatStats();
+  }
+  report += '\n';
+  report += notificationBus_.formatStats();
+  report += '\n';
+  report += logging::formatStats();
+  if (config::ENABLE_SAMPLE_STREAM) {
+    report += '\n';
+    report += stream::formatStats();
+  }
+  if (config::ENABLE_TRACE_RECORDER) {
+    report += '\n';
+    report += trace::formatStats();
+  }
+  if (fleet_.enabled()) {
+    report += '\n';
+    report += fleet_.formatStats();
+  }
+  reply(report, chatId);
+}
+
+void TelegramCommandProcessor::handleHeap(CommandTokenizer &, const String &chatId, unsigned long,
+                                          const sensor::MeasurementStats &) {
+  heapMonitor_.sample();
+  reply(heapMonitor_.formatReport(), chatId);
+}
+
+void TelegramCommandProcessor::handleHistory(CommandTokenizer &args, const String &chatId, unsigned long now,
+                                             const sensor::MeasurementStats &) {
+  unsigned long rangeMs = config::HISTORY_DEFAULT_RANGE_MS;
+  const CommandToken range = args.rest();
+  if (range.length > 0 && !CommandTokenizer::parseDuration(range, rangeMs)) {
+    reply(MessageId::InvalidHistoryRange, chatId);
+    return;
+  }
+  history_.update(now);
+  reply(history_.formatTable(rangeMs, now), chatId);
+}
+
+void TelegramCommandProcessor::handleExport(CommandTokenizer &args, const String &chatId, unsigned long,
+                                            const sensor::MeasurementStats &) {
+  CommandToken rangeToken;
+  CommandToken formatToken;
+  unsigned long rangeMs = 0;
+  timeseries::ExportFormat format = timeseries::ExportFormat::Csv;
+  if (!args.next(rangeToken) || !CommandTokenizer::parseDuration(rangeToken, rangeMs)) {
+    reply(MessageId::InvalidExportRange, chatId);
+    return;
+  }
+  if (args.next(formatToken)) {
+    if (CommandTokenizer::equals(formatToken, "bin")) {
+      format = timeseries::ExportFormat::Binary;
+    } else if (!CommandTokenizer::equals(formatToken, "csv") || !args.atEnd()) {
+      reply(MessageId::InvalidExportFormat, chatId);
       return;
     }
-    response = F("Ayar guncellendi: histerezis = ");
-    response += String(newH, 2);
-    response += F(" C");
-    updated = true;
-  } else if (key == F("minsamples")) {
-    if (!isValidNumber(valueText, false)) {
-      service_.sendDirect(F("Gecersiz tam sayi."), chatId);
+  }
+  if (replyOverride_) {
+    reply(MessageId::TelegramOnly, chatId, F("export"));
+    return;
+  }
+  if (!seriesLog_.ready()) {
+    reply(MessageId::SeriesLogDisabled, chatId);
+    return;
+  }
+  if (service_.uploadActive()) {
+    reply(MessageId::UploadBusy, chatId);
+    return;
+  }
+  uint64_t nowMs = 0;
+  if (!timeseries::wallClockNowMs(nowMs)) {
+    reply(MessageId::ClockNotSynced, chatId);
+    return;
+  }
+
+  const uint64_t fromMs = nowMs > rangeMs ? nowMs - rangeMs : 0;
+  exportJob_.log = &seriesLog_;
+  seriesLog_.beginExport(exportJob_.cursor, fromMs, nowMs, format);
+
+  const bool binary = format == timeseries::ExportFormat::Binary;
+  char fileName[40];
+  snprintf(fileName, sizeof(fileName), "olcum_%lu.%s", static_cast<unsigned long>(fromMs / 1000ULL),
+           binary ? "tsx" : "csv");
+  if (!service_.startDocument(chatId, fileName, binary ? "application/octet-stream" : "text/csv", writeExportPiece,
+                              &exportJob_)) {
+    reply(MessageId::DocumentFailed, chatId);
+  }
+}
+
+bool TelegramCommandProcessor::writeExportPiece(Print &out, void *context) {
+  ExportJob &job = *static_cast<ExportJob *>(context);
+  return job.log->exportNext(job.cursor, out);
+}
+
+void TelegramCommandProcessor::handleStream(CommandTokenizer &args, const String &chatId, unsigned long,
+                                            const sensor::MeasurementStats &) {
+  if (!config::ENABLE_SAMPLE_STREAM) {
+    reply(MessageId::DisabledInBuild, chatId, MessageId::FeatureStream);
+    return;
+  }
+  CommandToken state;
+  if (args.next(state)) {
+    if (!args.atEnd()) {
+      reply(MessageId::UsageHint, chatId, MessageId::SyntaxStream);
       return;
     }
-    const long newSamples = valueText.toInt();
-    if (newSamples < 0) {
-      service_.sendDirect(F("Gecersiz tam sayi."), chatId);
+    if (CommandTokenizer::equals(state, "on")) {
+      stream::setActive(true);
+    } else if (CommandTokenizer::equals(state, "off")) {
+      stream::setActive(false);
+    } else {
+      reply(MessageId::UsageHint, chatId, MessageId::SyntaxStream);
       return;
     }
-    String error;
-    if (!protection_.setMinSamples(static_cast<size_t>(newSamples), error)) {
-      service_.sendDirect(error, chatId);
+  }
+  reply(stream::formatStats(), chatId);
+}
+
+void TelegramCommandProcessor::handleTrace(CommandTokenizer &args, const String &chatId, unsigned long now,
+                                           const sensor::MeasurementStats &) {
+  if (!config::ENABLE_TRACE_RECORDER) {
+    reply(MessageId::DisabledInBuild, chatId, MessageId::FeatureTrace);
+    return;
+  }
+  CommandToken action;
+  if (args.next(action)) {
+    if (!args.atEnd()) {
+      reply(MessageId::UsageHint, chatId, MessageId::SyntaxTrace);
       return;
     }
-    response = F("Ayar guncellendi: min ornek sayisi = ");
-    response += static_cast<unsigned long>(protection_.settings().minSamples);
-    updated = true;
-  } else if (key == F("renotify")) {
-    if (!isValidNumber(valueText, false)) {
-      service_.sendDirect(F("Gecersiz tam sayi."), chatId);
+    if (CommandTokenizer::equals(action, "on")) {
+      trace::setActive(true);
+    } else if (CommandTokenizer::equals(action, "off")) {
+      trace::setActive(false);
+    } else if (CommandTokenizer::equals(action, "clear")) {
+      trace::clear();
+    } else if (CommandTokenizer::equals(action, "export")) {
+      exportTrace(chatId, now);
       return;
-    }
-    const long seconds = valueText.toInt();
-    if (seconds < 0) {
-      service_.sendDirect(F("Gecersiz tam sayi."), chatId);
+    } else {
+      reply(MessageId::UsageHint, chatId, MessageId::SyntaxTrace);
       return;
     }
-    String error;
-    if (!protection_.setRenotifySeconds(static_cast<unsigned long>(seconds), error)) {
-      service_.sendDirect(error, chatId);
-      return;
+  }
+  reply(trace::formatStats(), chatId);
+}
+
+void TelegramCommandProcessor::exportTrace(const String &chatId, unsigned long now) {
+  if (replyOverride_) {
+    reply(MessageId::TelegramOnly, chatId, F("trace export"));
+    return;
+  }
+  if (service_.uploadActive()) {
+    reply(MessageId::UploadBusy, chatId);
+    return;
+  }
+  trace::flush();
+  traceExport_ = trace::ExportCursor();
+  char fileName[32];
+  snprintf(fileName, sizeof(fileName), "karar_%lu.bin", now / 1000UL);
+  if (!service_.startDocument(chatId, fileName, "application/octet-stream", writeTracePiece, &traceExport_)) {
+    reply(MessageId::DocumentFailed, chatId);
+  }
+}
+
+bool TelegramCommandProcessor::writeTracePiece(Print &out, void *context) {
+  return trace::exportNext(*static_cast<trace::ExportCursor *>(context), out);
+}
+
+void TelegramCommandProcessor::handleFleet(CommandTokenizer &, const String &chatId, unsigned long now,
+                                           const sensor::MeasurementStats &) {
+  if (!fleet_.enabled()) {
+    reply(MessageId::FleetDisabled, chatId);
+    return;
+  }
+  reply(fleet_.formatNodes(now), chatId);
+}
+
+void TelegramCommandProcessor::routeToNode(const CommandToken &target, CommandTokenizer &args, const String &chatId,
+                                           unsigned long now, const sensor::MeasurementStats &objectStats) {
+  const char *node = target.text + 1;
+  const size_t nodeLength = target.length - 1;
+  const CommandToken command = args.rest();
+  if (nodeLength == 0 || command.length == 0) {
+    reply(MessageId::UsageHint, chatId, MessageId::SyntaxRoute);
+    return;
+  }
+  String text;
+  text.concat(command.text, command.length);
+  if (strlen(fleet_.name()) == nodeLength && strncmp(fleet_.name(), node, nodeLength) == 0) {
+    dispatch(text, chatId, now, objectStats);
+    return;
+  }
+  if (replyOverride_) {
+    reply(MessageId::TelegramOnly, chatId, MessageId::RemoteCommands);
+    return;
+  }
+  if (!fleet_.enabled()) {
+    reply(MessageId::FleetDisabled, chatId);
+    return;
+  }
+  String error;
+  if (!fleet_.routeCommand(node, nodeLength, command.text, command.length, chatId, error)) {
+    reply(error, chatId);
+  }
+}
+
+void TelegramCommandProcessor::handleSet(CommandTokenizer &args, const String &chatId, unsigned long now,
+                                         const sensor::MeasurementStats &objectStats) {
+  CommandToken key;
+  if (!args.next(key) || args.atEnd()) {
+    reply(MessageId::SetMissingParameter, chatId);
+    return;
+  }
+  const CommandToken valueText = args.rest();
+  if (valueText.length == 0) {
+    reply(MessageId::SetMissingValue, chatId);
+    return;
+  }
+
+  const uint32_t hash = CommandTokenizer::hash(key);
+  const SettingEntry *setting = nullptr;
+  for (size_t i = 0; i < SETTING_COUNT; ++i) {
+    if (SETTINGS[i].hash == hash && CommandTokenizer::equals(key, SETTINGS[i].name)) {
+      setting = &SETTINGS[i];
+      break;
     }
-    response = F("Ayar guncellendi: renotify = ");
-    response += seconds;
-    response += F(" sn");
-    updated = true;
-  } else {
-    service_.sendDirect(F("Bilinmeyen ayar anahtari. 'config' yazarak yardim alabilirsiniz."), chatId);
+  }
+  if (!setting) {
+    reply(MessageId::SetUnknownKey, chatId);
+    return;
+  }
+
+  const bool decimal = setting->type == ArgumentType::Decimal;
+  if (!isValidNumber(valueText, decimal)) {
+    reply(decimal ? MessageId::InvalidDecimal : MessageId::InvalidInteger, chatId);
+    return;
+  }
+  // The token points into the NUL-terminated command text and was validated above,
+  // so the parser stops at the token end.
+  const float value = decimal ? strtof(valueText.text, nullptr) : static_cast<float>(strtol(valueText.text, nullptr, 10));
+  if (!decimal && value < 0.0f) {
+    reply(MessageId::InvalidInteger, chatId);
     return;
   }
 
-  if (!updated) {
+  const protection::ProtectionSettings previousSettings = protection_.settings();
+  String error;
+  if (!setting->apply(protection_, value, error)) {
+    reply(error, chatId);
     return;
   }
 
   if (!protection::validateProtectionSettings(protection_.settings())) {
     protection_.applySettings(previousSettings);
-    service_.sendDirect(F("Ayar guncellenemedi: yeni degerler uyumsuz."), chatId);
+    reply(MessageId::SettingsIncompatible, chatId);
     return;
   }
 
-  if (storage_.save(protection_.settings())) {
-    response += F(" (kaydedildi)");
+  const bool saved = storage_.save(protection_.settings());
+  if (saved) {
+    trace::recordSettings(now, protection_.settings());
   } else {
     protection_.applySettings(previousSettings);
-    response += F(" (EEPROM kaydedilemedi, eski ayarlar korunuyor)");
   }
-
-  service_.sendDirect(response, chatId);
-  service_.sendDirect(protection_.formatProtectionConfig(), chatId);
+  const text::Arg shown = decimal ? text::Arg(value) : text::Arg(static_cast<long>(value));
+  reply(text::format(MessageId::SettingUpdated, setting->label, shown, setting->unit,
+                     saved ? MessageId::SettingSaved : MessageId::SettingNotSaved),
+        chatId);
+  reply(protection_.formatProtectionConfig(), chatId);
   protection_.handleProtection(objectStats, now);
 }
 
-bool TelegramCommandProcessor::isValidNumber(const String &value, bool allowDecimal) const {
-  if (value.length() == 0) {
+bool TelegramCommandProcessor::isValidNumber(const CommandToken &value, bool allowDecimal) {
+  if (value.length == 0) {
     return false;
   }
   bool seenDigit = false;
   bool seenDecimal = false;
-  size_t start = (value[0] == '-' ? 1 : 0);
-  for (size_t i = start; i < value.length(); ++i) {
-    const char c = value[i];
+  const size_t start = (value.text[0] == '-' ? 1 : 0);
+  for (size_t i = start; i < value.length; ++i) {
+    const char c = value.text[i];
     if (c >= '0' && c <= '9') {
       seenDigit = true;
       continue;
@@ -181,4 +444,3 @@ bool TelegramCommandProcessor::isValidNumber(const String &value, bool allowDeci
 }
 
 }  // namespace telegram
-
@@ -2,28 +2,123 @@
 
 #include <Arduino.h>
 
+#include "fleet/FleetNode.h"
+#include "history/HistoryStore.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
 #include "protection/ProtectionController.h"
+#include "profiling/HeapMonitor.h"
 #include "protection/ProtectionStorage.h"
+#include "telegram/CommandTokenizer.h"
+#include "timeseries/TimeSeriesLog.h"
 #include "telegram/TelegramService.h"
+#include "text/MessageCatalog.h"
+#include "trace/TraceRecorder.h"
 
 namespace telegram {
 
 class TelegramCommandProcessor {
 public:
+  // Routes replies to a channel other than Telegram (e.g. the MQTT reply topic).
+  using ReplyFunction = void (*)(const String &text, void *context);
+
   TelegramCommandProcessor(protection::ProtectionController &protection,
                            protection::ProtectionSettingsStorage &storage,
-                           TelegramService &service);
+                           TelegramService &service,
+                           profiling::HeapMonitor &heapMonitor,
+                           history::HistoryStore &history,
+                           timeseries::TimeSeriesLog &seriesLog,
+                           const mqtt::MqttService &mqttService,
+                           const notify::NotificationBus &notificationBus,
+                           fleet::FleetNode &fleet);
 
+  // Both entry points put the command in the decision trace before running it.
   void processCommand(const String &text, const String &chatId, unsigned long now,
                       const sensor::MeasurementStats &objectStats);
+  void processCommand(const String &text, unsigned long now, const sensor::MeasurementStats &objectStats,
+                      ReplyFunction replyTo, void *context);
 
 private:
-  bool isValidNumber(const String &value, bool allowDecimal) const;
+  using CommandHandler = void (TelegramCommandProcessor::*)(CommandTokenizer &args, const String &chatId,
+                                                           unsigned long now,
+                                                           const sensor::MeasurementStats &objectStats);
+  using SettingSetter = bool (*)(protection::ProtectionController &protection, float value, String &error);
+
+  enum class ArgumentType : uint8_t {
+    Decimal,
+    Integer,
+  };
+
+  struct CommandEntry {
+    uint32_t hash;
+    const char *name;
+    bool takesArguments;
+    CommandHandler handler;
+  };
+
+  struct SettingEntry {
+    uint32_t hash;
+    const char *name;
+    ArgumentType type;
+    SettingSetter apply;
+    text::MessageId label;  // Shared with the config listing
+    text::MessageId unit;
+  };
+
+  struct ExportJob {
+    timeseries::TimeSeriesLog *log = nullptr;
+    timeseries::ExportCursor cursor;
+  };
+
+  static const CommandEntry COMMANDS[];
+  static const size_t COMMAND_COUNT;
+  static const SettingEntry SETTINGS[];
+  static const size_t SETTING_COUNT;
+
+  void dispatch(const String &text, const String &chatId, unsigned long now,
+                const sensor::MeasurementStats &objectStats);
+  void handleConfig(CommandTokenizer &args, const String &chatId, unsigned long now,
+                    const sensor::MeasurementStats &objectStats);
+  void handleStats(CommandTokenizer &args, const String &chatId, unsigned long now,
+                   const sensor::MeasurementStats &objectStats);
+  void handleHeap(CommandTokenizer &args, const String &chatId, unsigned long now,
+                  const sensor::MeasurementStats &objectStats);
+  void handleHistory(CommandTokenizer &args, const String &chatId, unsigned long now,
+                     const sensor::MeasurementStats &objectStats);
+  void handleExport(CommandTokenizer &args, const String &chatId, unsigned long now,
+                    const sensor::MeasurementStats &objectStats);
+  void handleStream(CommandTokenizer &args, const String &chatId, unsigned long now,
+                    const sensor::MeasurementStats &objectStats);
+  void handleTrace(CommandTokenizer &args, const String &chatId, unsigned long now,
+                   const sensor::MeasurementStats &objectStats);
+  void handleFleet(CommandTokenizer &args, const String &chatId, unsigned long now,
+                   const sensor::MeasurementStats &objectStats);
+  void handleSet(CommandTokenizer &args, const String &chatId, unsigned long now,
+                 const sensor::MeasurementStats &objectStats);
+  // "@<node> <command>": runs here when <node> is this board, otherwise goes through the fleet.
+  void routeToNode(const CommandToken &target, CommandTokenizer &args, const String &chatId, unsigned long now,
+                   const sensor::MeasurementStats &objectStats);
+
+  void reply(const String &text, const String &chatId);
+  void reply(text::MessageId id, const String &chatId, text::Arg arg = text::Arg());
+  void exportTrace(const String &chatId, unsigned long now);
+  static bool writeExportPiece(Print &out, void *context);
+  static bool writeTracePiece(Print &out, void *context);
+  static bool isValidNumber(const CommandToken &value, bool allowDecimal);
 
   protection::ProtectionController &protection_;
   protection::ProtectionSettingsStorage &storage_;
   TelegramService &service_;
+  profiling::HeapMonitor &heapMonitor_;
+  history::HistoryStore &history_;
+  timeseries::TimeSeriesLog &seriesLog_;
+  const mqtt::MqttService &mqttService_;
+  const notify::NotificationBus &notificationBus_;
+  fleet::FleetNode &fleet_;
+  ExportJob exportJob_;
+  trace::ExportCursor traceExport_;
+  ReplyFunction replyOverride_{nullptr};
+  void *replyContext_{nullptr};
 };
 
 }  // namespace telegram
-
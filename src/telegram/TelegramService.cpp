@@ -6,18 +6,170 @@
 #include <WiFiClientSecure.h>
 
 #include "config.h"
+#include "logging/Log.h"
+#include "profiling/StageProfiler.h"
+#include "telegram/ChunkedBodyWriter.h"
+#include "telegram/FormBodyWriter.h"
+#include "telegram/MessageChunker.h"
 #include "telegram/TelegramCommandProcessor.h"
+#include "text/MessageCatalog.h"
+#include "watchdog/LoopWatchdog.h"
 
 namespace telegram {
 namespace {
 constexpr unsigned long TELEGRAM_POLL_INTERVAL_MS = 2000;
 constexpr size_t TELEGRAM_MAX_JSON_SIZE = 4096;
+constexpr unsigned long TELEGRAM_RESPONSE_TIMEOUT_MS = 3000;
+constexpr char TELEGRAM_HOST[] = "api.telegram.org";
+constexpr uint16_t TELEGRAM_PORT = 443;
+constexpr int TLS_MAX_RECORD_BYTES = 16384;
+constexpr int HTTP_TRANSPORT_ERROR = -1;
+constexpr size_t HTTP_LINE_BUFFER_SIZE = 64;
+constexpr char MESSAGE_ID_KEY[] = "\"message_id\":";
+constexpr char RETRY_AFTER_KEY[] = "\"retry_after\":";
+constexpr char MULTIPART_BOUNDARY[] = "tastan09-export-7d1f3a9c";
+constexpr unsigned long UPLOAD_SLICE_MS = 50;  // Upload time per loop() iteration
+
+// Scans the response body for the first numeric value of `key` one byte at a
+// time, so the JSON reply never has to be buffered.
+bool readJsonLong(WiFiClient &stream, int remaining, const char *key, long &result) {
+  const size_t keyLength = strlen(key);
+  size_t matched = 0;
+  bool inValue = false;
+  long value = 0;
+  const unsigned long start = millis();
+  while (remaining != 0 && millis() - start < TELEGRAM_RESPONSE_TIMEOUT_MS) {
+    if (!stream.available()) {
+      if (!stream.connected()) {
+        break;
+      }
+      delay(1);
+      continue;
+    }
+    const int c = stream.read();
+    if (c < 0) {
+      continue;
+    }
+    if (remaining > 0) {
+      --remaining;
+    }
+
+    if (matched < keyLength) {
+      if (c == key[matched]) {
+        ++matched;
+      } else {
+        matched = (c == key[0]) ? 1 : 0;
+      }
+      continue;
+    }
+    if (c >= '0' && c <= '9') {
+      value = value * 10 + (c - '0');
+      inValue = true;
+      continue;
+    }
+    if (c == ' ' && !inValue) {
+      continue;
+    }
+    break;
+  }
+  if (!inValue) {
+    return false;
+  }
+  result = value;
+  return true;
 }
 
+// Reads one CRLF-terminated line; characters past the buffer are discarded.
+bool readLine(WiFiClient &client, char *buffer, size_t size, unsigned long deadline) {
+  size_t length = 0;
+  while (static_cast<long>(millis() - deadline) < 0) {
+    if (!client.available()) {
+      if (!client.connected()) {
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    const int c = client.read();
+    if (c < 0) {
+      continue;
+    }
+    if (c == '\n') {
+      if (length > 0 && buffer[length - 1] == '\r') {
+        --length;
+      }
+      buffer[length] = '\0';
+      return true;
+    }
+    if (length + 1 < size) {
+      buffer[length++] = static_cast<char>(c);
+    }
+  }
+  return false;
+}
+
+// Parses the status line and headers; returns the HTTP status or a negative
+// transport error and leaves the stream at the start of the body.
+int readResponseHead(WiFiClient &client, int &contentLength) {
+  const unsigned long deadline = millis() + TELEGRAM_RESPONSE_TIMEOUT_MS;
+  char line[HTTP_LINE_BUFFER_SIZE];
+  if (!readLine(client, line, sizeof(line), deadline) || strncmp(line, "HTTP/1.", 7) != 0) {
+    return HTTP_TRANSPORT_ERROR;
+  }
+  const char *status = strchr(line, ' ');
+  if (!status) {
+    return HTTP_TRANSPORT_ERROR;
+  }
+  const int httpCode = atoi(status + 1);
+
+  contentLength = -1;
+  while (readLine(client, line, sizeof(line), deadline)) {
+    if (line[0] == '\0') {
+      return httpCode;
+    }
+    if (strncasecmp(line, "content-length:", 15) == 0) {
+      contentLength = atoi(line + 15);
+    }
+  }
+  return HTTP_TRANSPORT_ERROR;
+}
+
+// Reads the whole body into out. Without a Content-Length the body ends when
+// the server closes; false if it ran past limit or stopped short.
+bool readBody(WiFiClient &client, int contentLength, size_t limit, String &out) {
+  const size_t expected = contentLength >= 0 ? static_cast<size_t>(contentLength) : limit + 1;
+  if (contentLength >= 0) {
+    out.reserve(expected);
+  }
+  uint8_t buffer[HTTP_LINE_BUFFER_SIZE];
+  const unsigned long deadline = millis() + TELEGRAM_RESPONSE_TIMEOUT_MS;
+  while (out.length() < expected && static_cast<long>(millis() - deadline) < 0) {
+    if (!client.available()) {
+      if (!client.connected()) {
+        break;
+      }
+      delay(1);
+      continue;
+    }
+    const size_t wanted = expected - out.length() < sizeof(buffer) ? expected - out.length() : sizeof(buffer);
+    const int received = client.read(buffer, wanted);
+    if (received > 0) {
+      out.concat(reinterpret_cast<const char *>(buffer), static_cast<size_t>(received));
+    }
+  }
+  return contentLength >= 0 ? out.length() == expected : !client.connected() && out.length() <= limit;
+}
+}  // namespace
+
 TelegramService::TelegramService()
     : alertChatId_(String(config::TELEGRAM_ALERT_CHAT_ID)),
       infoChatId_(String(config::TELEGRAM_INFO_CHAT_ID)),
-      secondaryChatId_(String(config::TELEGRAM_SECONDARY_CHAT_ID)) {}
+      secondaryChatId_(String(config::TELEGRAM_SECONDARY_CHAT_ID)),
+      globalBucket_(config::TELEGRAM_GLOBAL_BURST, config::TELEGRAM_GLOBAL_REFILL_MS),
+      alertBucket_(config::TELEGRAM_CHAT_BURST, config::TELEGRAM_CHAT_REFILL_MS),
+      infoBucket_(config::TELEGRAM_CHAT_BURST, config::TELEGRAM_CHAT_REFILL_MS),
+      secondaryBucket_(config::TELEGRAM_CHAT_BURST, config::TELEGRAM_CHAT_REFILL_MS),
+      otherBucket_(config::TELEGRAM_CHAT_BURST, config::TELEGRAM_CHAT_REFILL_MS) {}
 
 bool TelegramService::configured() const {
   return config::ENABLE_TELEGRAM && strlen(config::TELEGRAM_BOT_TOKEN) > 0;
@@ -26,16 +178,23 @@ bool TelegramService::configured() const {
 bool TelegramService::sendAlert(const String &text) {
   bool sent = false;
   if (alertChatId_.length() > 0) {
-    sent |= sendMessageInternal(text, alertChatId_);
+    sent |= sendMessageInternal(text, alertChatId_, true);
   } else if (infoChatId_.length() > 0) {
-    sent |= sendMessageInternal(text, infoChatId_);
+    sent |= sendMessageInternal(text, infoChatId_, true);
   }
-  sent |= sendToSecondary(text, alertChatId_, infoChatId_);
+  sent |= sendToSecondary(text, alertChatId_, infoChatId_, true);
   return sent;
 }
 
-bool TelegramService::sendInfo(const String &text) {
+bool TelegramService::sendInfo(const String &text, size_t stateLength) {
   if (infoChatId_.length() > 0) {
+    if (config::TELEGRAM_DASHBOARD_MODE) {
+      bool sent = updateDashboard(text, stateLength, infoChatId_, infoDashboard_);
+      if (secondaryEligible(infoChatId_, alertChatId_)) {
+        sent |= updateDashboard(text, stateLength, secondaryChatId_, secondaryDashboard_);
+      }
+      return sent;
+    }
     bool sent = sendMessageInternal(text, infoChatId_);
     sent |= sendToSecondary(text, infoChatId_, alertChatId_);
     return sent;
@@ -44,7 +203,57 @@ bool TelegramService::sendInfo(const String &text) {
 }
 
 bool TelegramService::sendDirect(const String &text, const String &chatId) {
-  return sendMessageInternal(text, chatId);
+  return sendMessageInternal(text, chatId, true);
+}
+
+void TelegramService::flushPending() {
+  while (pendingCount_ > 0) {
+    PendingMessage &pending = pending_[pendingHead_];
+    size_t consumed = 0;
+    const SendResult result = sendChunks(pending.text, pending.chatId, consumed);
+    if (result == SendResult::Retry) {
+      if (consumed > 0) {
+        pending.text.remove(0, consumed);
+      }
+      return;
+    }
+    if (result == SendResult::Failed) {
+      ++counters_.dropped;
+    }
+    pending.text = String();
+    pending.chatId = String();
+    pendingHead_ = (pendingHead_ + 1) % PENDING_CAPACITY;
+    --pendingCount_;
+  }
+}
+
+String TelegramService::formatStats() const {
+  using text::MessageId;
+  const text::Arg sendArgs[] = {counters_.sent,      counters_.deferred,        counters_.dropped,
+                                counters_.throttled, counters_.transportErrors, pendingCount_,
+                                tlsStats_.handshakes};
+  String message;
+  text::append(message, MessageId::TelegramStats, sendArgs, sizeof(sendArgs) / sizeof(sendArgs[0]));
+  if (tlsStats_.handshakes > 0) {
+    const text::Arg tlsArgs[] = {tlsStats_.lastMs, tlsStats_.totalMs / tlsStats_.handshakes, tlsStats_.maxMs,
+                                 tlsStats_.lastHeapBytes, tlsStats_.maxHeapBytes};
+    text::append(message, MessageId::TlsStats, tlsArgs, sizeof(tlsArgs) / sizeof(tlsArgs[0]));
+  }
+  text::append(message, MessageId::TlsMfln,
+               mflnProbed_ ? text::Arg(mflnSupported_ ? MessageId::ValueYes : MessageId::ValueNone)
+                           : text::Arg(F("?")));
+  if (uploadStats_.completed + uploadStats_.failed > 0) {
+    const text::Arg uploadArgs[] = {uploadStats_.completed, uploadStats_.failed, uploadStats_.preempted,
+                                    uploadStats_.lastBytes, uploadStats_.lastMs};
+    text::append(message, MessageId::UploadStats, uploadArgs, sizeof(uploadArgs) / sizeof(uploadArgs[0]));
+    if (uploadStats_.lastMs > 0) {
+      text::append(message, MessageId::UploadRate,
+                   static_cast<unsigned long>(static_cast<uint64_t>(uploadStats_.lastBytes) * 1000ULL /
+                                              uploadStats_.lastMs));
+    }
+    text::append(message, MessageId::UploadMinHeap, uploadStats_.lastMinFreeHeap);
+  }
+  return message;
 }
 
 void TelegramService::trySendStartupMessage() {
@@ -53,11 +262,11 @@ void TelegramService::trySendStartupMessage() {
   }
 
   bool sentAny = false;
-  if (strlen(config::TELEGRAM_START_MESSAGE) > 0) {
-    sentAny |= broadcast(String(config::TELEGRAM_START_MESSAGE));
+  if (text::measure(text::MessageId::Start, nullptr, 0) > 0) {
+    sentAny |= broadcast(text::format(text::MessageId::Start));
   }
-  if (strlen(config::TELEGRAM_USAGE_MESSAGE) > 0) {
-    sentAny |= broadcast(String(config::TELEGRAM_USAGE_MESSAGE));
+  if (text::measure(text::MessageId::Usage, nullptr, 0) > 0) {
+    sentAny |= broadcast(text::format(text::MessageId::Usage));
   }
   if (sentAny) {
     startupMessageSent_ = true;
@@ -69,52 +278,83 @@ void TelegramService::pollUpdates(unsigned long now, TelegramCommandProcessor &p
   if (!configured() || WiFi.status() != WL_CONNECTED) {
     return;
   }
-  if (now - lastPoll_ < TELEGRAM_POLL_INTERVAL_MS) {
+  if (upload_.active || now - lastPoll_ < TELEGRAM_POLL_INTERVAL_MS) {
     return;
   }
-  lastPoll_ = now;
-
-  WiFiClientSecure client;
-  if (config::TELEGRAM_ALLOW_INSECURE_TLS) {
-    client.setInsecure();
-  }
-
-  HTTPClient https;
-  String url = String(F("https://api.telegram.org/bot")) + config::TELEGRAM_BOT_TOKEN + F("/getUpdates?timeout=0");
-  if (lastUpdateId_ > 0) {
-    url += F("&offset=");
-    url += String(lastUpdateId_ + 1);
-  }
-
-  if (!https.begin(client, url)) {
-    Serial.println(F("Telegram: getUpdates baslatilamadi"));
+  if (!admitPoll(now)) {
     return;
   }
+  lastPoll_ = now;
 
-  const int httpCode = https.GET();
-  if (httpCode != HTTP_CODE_OK) {
-    Serial.print(F("Telegram getUpdates HTTP hatasi: "));
-    Serial.println(httpCode);
-    https.end();
-    return;
-  }
+  watchdog::StageGuard stage(profiling::Stage::TelegramPoll);
+  String payload;
+  {
+    profiling::ScopedStageTimer timer(profiling::Stage::TelegramPoll);
+    WiFiClientSecure client;
+    prepareClient(client);
+    if (!connectClient(client)) {
+      LOG_WARN("Telegram: getUpdates baglantisi kurulamadi");
+      ++counters_.pollErrors;
+      registerTransportFailure(millis());
+      return;
+    }
 
-  const String payload = https.getString();
-  https.end();
-  if (payload.length() == 0) {
-    return;
+    char head[192];
+    snprintf_P(head, sizeof(head),
+               PSTR("GET /bot%s/getUpdates?timeout=0&offset=%ld HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n"),
+               config::TELEGRAM_BOT_TOKEN, lastUpdateId_ > 0 ? lastUpdateId_ + 1 : 0L, TELEGRAM_HOST);
+    client.write(reinterpret_cast<const uint8_t *>(head), strlen(head));
+
+    int responseLength = -1;
+    const int httpCode = readResponseHead(client, responseLength);
+    if (httpCode < 0) {
+      LOG_WARN("Telegram getUpdates baglanti hatasi: %d", httpCode);
+      client.stop();
+      ++counters_.pollErrors;
+      registerTransportFailure(millis());
+      return;
+    }
+    transportFailures_ = 0;
+
+    if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+      long retryAfter = 0;
+      if (!readJsonLong(client, responseLength, RETRY_AFTER_KEY, retryAfter) || retryAfter <= 0) {
+        retryAfter = 1;
+      }
+      client.stop();
+      ++counters_.throttled;
+      // A throttled poll is bot-wide, not tied to a chat.
+      globalBucket_.blockUntil(millis() + static_cast<unsigned long>(retryAfter) * 1000UL);
+      LOG_WARN("Telegram getUpdates 429, bekleme sn: %ld", static_cast<long>(retryAfter));
+      return;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+      LOG_WARN("Telegram getUpdates HTTP hatasi: %d", httpCode);
+      client.stop();
+      ++counters_.pollErrors;
+      return;
+    }
+    ++counters_.polls;
+    if (responseLength > static_cast<int>(TELEGRAM_MAX_JSON_SIZE) ||
+        !readBody(client, responseLength, TELEGRAM_MAX_JSON_SIZE, payload)) {
+      LOG_WARN("Telegram: yanit verisi cok buyuk veya eksik");
+      client.stop();
+      return;
+    }
+    client.stop();
   }
-
-  if (payload.length() > TELEGRAM_MAX_JSON_SIZE) {
-    Serial.println(F("Telegram: yanit verisi cok buyuk"));
+  if (payload.length() == 0) {
     return;
   }
 
   JsonDocument doc;
-  const DeserializationError error = deserializeJson(doc, payload);
+  DeserializationError error;
+  {
+    profiling::ScopedStageTimer timer(profiling::Stage::JsonParse);
+    error = deserializeJson(doc, payload);
+  }
   if (error) {
-    Serial.print(F("Telegram JSON hatasi: "));
-    Serial.println(error.c_str());
+    LOG_WARN("Telegram JSON hatasi: %s", error.c_str());
     return;
   }
 
@@ -136,8 +376,7 @@ void TelegramService::pollUpdates(unsigned long now, TelegramCommandProcessor &p
 
     const String chatId = messageObj["chat"]["id"].as<String>();
     if (!isAuthorizedChat(chatId)) {
-      Serial.print(F("Telegram: yetkisiz chat: "));
-      Serial.println(chatId);
+      LOG_WARN("Telegram: yetkisiz chat: %s", chatId.c_str());
       continue;
     }
 
@@ -147,6 +386,8 @@ void TelegramService::pollUpdates(unsigned long now, TelegramCommandProcessor &p
       continue;
     }
 
+    watchdog::StageGuard commandStage(profiling::Stage::Command);
+    profiling::ScopedStageTimer timer(profiling::Stage::Command);
     processor.processCommand(text, chatId, now, objectStats);
   }
 }
@@ -170,14 +411,63 @@ bool TelegramService::isAuthorizedChat(const String &chatId) const {
   return false;
 }
 
-bool TelegramService::sendToSecondary(const String &text, const String &avoid1, const String &avoid2) {
+bool TelegramService::secondaryEligible(const String &avoid1, const String &avoid2) const {
   if (secondaryChatId_.length() == 0) {
     return false;
   }
   if ((avoid1.length() > 0 && secondaryChatId_ == avoid1) || (avoid2.length() > 0 && secondaryChatId_ == avoid2)) {
     return false;
   }
-  return sendMessageInternal(text, secondaryChatId_);
+  return true;
+}
+
+bool TelegramService::sendToSecondary(const String &text, const String &avoid1, const String &avoid2,
+                                      bool queueIfLimited) {
+  if (!secondaryEligible(avoid1, avoid2)) {
+    return false;
+  }
+  return sendMessageInternal(text, secondaryChatId_, queueIfLimited);
+}
+
+bool TelegramService::updateDashboard(const String &text, size_t stateLength, const String &chatId,
+                                      DashboardSlot &slot) {
+  if (!MessageChunker(text.c_str(), text.length(), config::TELEGRAM_MAX_MESSAGE_UNITS).single()) {
+    // A multi-part report cannot be edited in place; post it as regular messages.
+    return sendMessageInternal(text, chatId);
+  }
+
+  if (stateLength > text.length()) {
+    stateLength = text.length();
+  }
+  if (slot.messageId != 0) {
+    // Only a state change is worth an edit; heap and counter lines in the tail
+    // would otherwise defeat the skip on every report.
+    if (slot.stateText.length() == stateLength && memcmp(slot.stateText.c_str(), text.c_str(), stateLength) == 0) {
+      return true;
+    }
+    const SendResult edit = postMessage(F("editMessageText"), text.c_str(), text.length(), chatId, slot.messageId, nullptr);
+    if (edit == SendResult::Sent) {
+      slot.stateText = text.substring(0, stateLength);
+      return true;
+    }
+    if (edit == SendResult::Retry) {
+      ++counters_.deferred;
+      return false;
+    }
+    LOG_INFO("Telegram: pano duzenlenemedi, yeni mesaj gonderiliyor");
+  }
+
+  long messageId = 0;
+  const SendResult result = postMessage(F("sendMessage"), text.c_str(), text.length(), chatId, 0, &messageId);
+  if (result != SendResult::Sent) {
+    if (result == SendResult::Retry) {
+      ++counters_.deferred;
+    }
+    return false;
+  }
+  slot.messageId = messageId;
+  slot.stateText = text.substring(0, stateLength);
+  return true;
 }
 
 bool TelegramService::broadcast(const String &text) {
@@ -194,64 +484,390 @@ bool TelegramService::broadcast(const String &text) {
   return sent;
 }
 
-bool TelegramService::sendMessageInternal(const String &text, const String &chatId) {
-  if (!configured()) {
+bool TelegramService::sendMessageInternal(const String &text, const String &chatId, bool queueIfLimited) {
+  size_t consumed = 0;
+  const SendResult result = sendChunks(text, chatId, consumed);
+  if (result != SendResult::Retry) {
+    return result == SendResult::Sent;
+  }
+  if (queueIfLimited) {
+    enqueuePending(consumed > 0 ? text.substring(consumed) : text, chatId);
+  } else {
+    ++counters_.deferred;
+  }
+  return false;
+}
+
+TelegramService::SendResult TelegramService::sendChunks(const String &text, const String &chatId, size_t &consumed) {
+  MessageChunker chunker(text.c_str(), text.length(), config::TELEGRAM_MAX_MESSAGE_UNITS);
+  TextSpan span;
+  consumed = 0;
+  while (chunker.next(span)) {
+    const SendResult result = postMessage(F("sendMessage"), text.c_str() + span.offset, span.length, chatId, 0, nullptr);
+    if (result != SendResult::Sent) {
+      consumed = span.offset;
+      return result;
+    }
+  }
+  consumed = text.length();
+  return SendResult::Sent;
+}
+
+void TelegramService::enqueuePending(const String &text, const String &chatId) {
+  if (pendingCount_ == PENDING_CAPACITY) {
+    pendingHead_ = (pendingHead_ + 1) % PENDING_CAPACITY;
+    --pendingCount_;
+    ++counters_.dropped;
+  }
+  PendingMessage &slot = pending_[(pendingHead_ + pendingCount_) % PENDING_CAPACITY];
+  slot.text = text;
+  slot.chatId = chatId;
+  ++pendingCount_;
+  ++counters_.deferred;
+}
+
+TokenBucket &TelegramService::bucketFor(const String &chatId) {
+  if (alertChatId_.length() > 0 && chatId == alertChatId_) {
+    return alertBucket_;
+  }
+  if (infoChatId_.length() > 0 && chatId == infoChatId_) {
+    return infoBucket_;
+  }
+  if (secondaryChatId_.length() > 0 && chatId == secondaryChatId_) {
+    return secondaryBucket_;
+  }
+  return otherBucket_;
+}
+
+bool TelegramService::backoffElapsed(unsigned long now) {
+  if (backoffActive_) {
+    if (static_cast<long>(now - backoffUntil_) < 0) {
+      return false;
+    }
+    backoffActive_ = false;
+  }
+  return true;
+}
+
+bool TelegramService::admitSend(const String &chatId, unsigned long now) {
+  if (!backoffElapsed(now)) {
     return false;
   }
-  if (chatId.length() == 0) {
+  TokenBucket &chatBucket = bucketFor(chatId);
+  if (!globalBucket_.ready(now) || !chatBucket.ready(now)) {
     return false;
   }
-  if (WiFi.status() != WL_CONNECTED) {
+  globalBucket_.take();
+  chatBucket.take();
+  return true;
+}
+
+// getUpdates spends the bot-wide budget and waits out the same backoff as
+// sends, but belongs to no chat bucket.
+bool TelegramService::admitPoll(unsigned long now) {
+  if (!backoffElapsed(now) || !globalBucket_.ready(now)) {
     return false;
   }
+  globalBucket_.take();
+  return true;
+}
+
+void TelegramService::registerTransportFailure(unsigned long now) {
+  ++counters_.transportErrors;
+  if (transportFailures_ < 16) {
+    ++transportFailures_;
+  }
+  const uint8_t shift = transportFailures_ - 1 < 10 ? transportFailures_ - 1 : 10;
+  unsigned long delayMs = config::TELEGRAM_BACKOFF_BASE_MS << shift;
+  if (delayMs > config::TELEGRAM_BACKOFF_MAX_MS) {
+    delayMs = config::TELEGRAM_BACKOFF_MAX_MS;
+  }
+  delayMs += static_cast<unsigned long>(random(static_cast<long>(delayMs / 2 + 1)));
+  backoffUntil_ = now + delayMs;
+  backoffActive_ = true;
+}
 
+TelegramService::SendResult TelegramService::postMessage(const __FlashStringHelper *method, const char *text,
+                                                         size_t textLength, const String &chatId, long editMessageId,
+                                                         long *sentMessageId) {
+  if (!configured()) {
+    return SendResult::Failed;
+  }
+  if (chatId.length() == 0) {
+    return SendResult::Failed;
+  }
+  if (WiFi.status() != WL_CONNECTED || upload_.active) {
+    return SendResult::Retry;
+  }
+  if (!admitSend(chatId, millis())) {
+    return SendResult::Retry;
+  }
+
+  watchdog::StageGuard stage(profiling::Stage::TelegramSend);
+  profiling::ScopedStageTimer timer(profiling::Stage::TelegramSend);
   WiFiClientSecure client;
-  if (config::TELEGRAM_ALLOW_INSECURE_TLS) {
-    client.setInsecure();
+  prepareClient(client);
+  if (!connectClient(client)) {
+    LOG_WARN("Telegram: baglanti kurulamadi");
+    registerTransportFailure(millis());
+    return SendResult::Retry;
+  }
+
+  char messageIdText[12] = "";
+  if (editMessageId != 0) {
+    snprintf(messageIdText, sizeof(messageIdText), "%ld", editMessageId);
+  }
+  const size_t messageIdLength = strlen(messageIdText);
+  size_t contentLength = FormBodyWriter::fieldLength("chat_id", chatId.c_str(), chatId.length(), true);
+  if (messageIdLength > 0) {
+    contentLength += FormBodyWriter::fieldLength("message_id", messageIdText, messageIdLength, false);
+  }
+  contentLength += FormBodyWriter::fieldLength("text", text, textLength, false);
+
+  char methodName[24];
+  strncpy_P(methodName, reinterpret_cast<const char *>(method), sizeof(methodName) - 1);
+  methodName[sizeof(methodName) - 1] = '\0';
+  char head[256];
+  snprintf_P(head, sizeof(head),
+             PSTR("POST /bot%s/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"
+                  "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: %u\r\n\r\n"),
+             config::TELEGRAM_BOT_TOKEN, methodName, TELEGRAM_HOST,
+             static_cast<unsigned>(contentLength));
+  client.write(reinterpret_cast<const uint8_t *>(head), strlen(head));
+
+  FormBodyWriter body(client);
+  body.field("chat_id", chatId.c_str(), chatId.length());
+  if (messageIdLength > 0) {
+    body.field("message_id", messageIdText, messageIdLength);
+  }
+  body.field("text", text, textLength);
+  if (!body.finish()) {
+    LOG_WARN("Telegram: istek govdesi yazilamadi");
+    client.stop();
+    registerTransportFailure(millis());
+    return SendResult::Retry;
+  }
+
+  int responseLength = -1;
+  const int httpCode = readResponseHead(client, responseLength);
+  if (httpCode < 0) {
+    LOG_WARN("Telegram baglanti hatasi: %d", httpCode);
+    client.stop();
+    registerTransportFailure(millis());
+    return SendResult::Retry;
+  }
+  transportFailures_ = 0;
+
+  if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+    long retryAfter = 0;
+    if (!readJsonLong(client, responseLength, RETRY_AFTER_KEY, retryAfter) || retryAfter <= 0) {
+      retryAfter = 1;
+    }
+    client.stop();
+    ++counters_.throttled;
+    bucketFor(chatId).blockUntil(millis() + static_cast<unsigned long>(retryAfter) * 1000UL);
+    LOG_WARN("Telegram 429, bekleme sn: %ld", static_cast<long>(retryAfter));
+    return SendResult::Retry;
   }
 
-  HTTPClient https;
-  const String url = String(F("https://api.telegram.org/bot")) + config::TELEGRAM_BOT_TOKEN + F("/sendMessage");
-  if (!https.begin(client, url)) {
-    Serial.println(F("Telegram: baglanti kurulamadi"));
+  if (httpCode < 200 || httpCode >= 300) {
+    LOG_WARN("Telegram HTTP hatasi: %d", httpCode);
+    client.stop();
+    return SendResult::Failed;
+  }
+
+  if (sentMessageId && !readJsonLong(client, responseLength, MESSAGE_ID_KEY, *sentMessageId)) {
+    *sentMessageId = 0;
+  }
+  client.stop();
+  ++counters_.sent;
+  LOG_DEBUG("Telegram mesaji gonderildi");
+  return SendResult::Sent;
+}
+
+bool TelegramService::startDocument(const String &chatId, const char *fileName, const char *mimeType,
+                                    DocumentWriter writer, void *context) {
+  if (!configured() || chatId.length() == 0 || WiFi.status() != WL_CONNECTED || upload_.active) {
+    return false;
+  }
+  if (!admitSend(chatId, millis())) {
     return false;
   }
 
-  https.addHeader(F("Content-Type"), F("application/x-www-form-urlencoded"));
-  const String payload = String(F("chat_id=")) + chatId + F("&text=") + urlEncode(text);
-  const int httpCode = https.POST(payload);
-  if (httpCode < 200 || httpCode >= 300) {
-    Serial.print(F("Telegram HTTP hatasi: "));
-    Serial.println(httpCode);
-    https.end();
+  watchdog::StageGuard stage(profiling::Stage::TelegramSend);
+  profiling::ScopedStageTimer timer(profiling::Stage::TelegramSend);
+  prepareClient(uploadClient_);
+  if (!connectClient(uploadClient_)) {
+    LOG_WARN("Telegram: belge icin baglanti kurulamadi");
+    registerTransportFailure(millis());
+    return false;
+  }
+
+  char head[256];
+  snprintf_P(head, sizeof(head),
+             PSTR("POST /bot%s/sendDocument HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n"
+                  "Content-Type: multipart/form-data; boundary=%s\r\nTransfer-Encoding: chunked\r\n\r\n"),
+             config::TELEGRAM_BOT_TOKEN, TELEGRAM_HOST, MULTIPART_BOUNDARY);
+  uploadClient_.write(reinterpret_cast<const uint8_t *>(head), strlen(head));
+
+  ChunkedBodyWriter body(uploadClient_);
+  const int partLength =
+      snprintf_P(head, sizeof(head),
+                 PSTR("--%s\r\nContent-Disposition: form-data; name=\"chat_id\"\r\n\r\n%s\r\n"
+                      "--%s\r\nContent-Disposition: form-data; name=\"document\"; filename=\"%s\"\r\n"
+                      "Content-Type: %s\r\n\r\n"),
+                 MULTIPART_BOUNDARY, chatId.c_str(), MULTIPART_BOUNDARY, fileName, mimeType);
+  if (partLength <= 0 || static_cast<size_t>(partLength) >= sizeof(head)) {
+    uploadClient_.stop();
+    return false;
+  }
+  body.write(reinterpret_cast<const uint8_t *>(head), static_cast<size_t>(partLength));
+  if (!body.flushChunk()) {
+    uploadClient_.stop();
+    registerTransportFailure(millis());
     return false;
   }
 
-  https.end();
-  Serial.println(F("Telegram mesaji gonderildi"));
+  upload_.active = true;
+  upload_.chatId = chatId;
+  upload_.writer = writer;
+  upload_.context = context;
+  upload_.startMs = millis();
+  upload_.bytes = 0;
+  upload_.minFreeHeap = ESP.getFreeHeap();
   return true;
 }
 
-String TelegramService::urlEncode(const String &value) {
-  String encoded;
-  encoded.reserve(value.length() * 3);
-  const char hex[] = "0123456789ABCDEF";
+void TelegramService::serviceUpload() {
+  if (!upload_.active) {
+    return;
+  }
 
-  for (size_t i = 0; i < value.length(); ++i) {
-    const uint8_t c = static_cast<uint8_t>(value[i]);
-    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' ||
-        c == '~') {
-      encoded += static_cast<char>(c);
-    } else if (c == ' ') {
-      encoded += '+';
-    } else {
-      encoded += '%';
-      encoded += hex[(c >> 4) & 0x0F];
-      encoded += hex[c & 0x0F];
+  watchdog::StageGuard stage(profiling::Stage::TelegramSend);
+  profiling::ScopedStageTimer timer(profiling::Stage::TelegramSend);
+  ChunkedBodyWriter body(uploadClient_);
+  const unsigned long sliceStart = millis();
+  bool more = true;
+  while (more && body.ok() && millis() - sliceStart < UPLOAD_SLICE_MS) {
+    more = upload_.writer(body, upload_.context);
+  }
+  body.flushChunk();
+  upload_.bytes += body.payloadBytes();
+  const uint32_t freeHeap = ESP.getFreeHeap();
+  if (freeHeap < upload_.minFreeHeap) {
+    upload_.minFreeHeap = freeHeap;
+  }
+  if (!body.ok()) {
+    LOG_WARN("Telegram: belge akisi kesildi");
+    registerTransportFailure(millis());
+    finishUpload(false);
+    return;
+  }
+  if (more) {
+    return;
+  }
+
+  char tail[48];
+  const int tailLength = snprintf_P(tail, sizeof(tail), PSTR("\r\n--%s--\r\n"), MULTIPART_BOUNDARY);
+  body.write(reinterpret_cast<const uint8_t *>(tail), static_cast<size_t>(tailLength));
+  if (!body.finish()) {
+    registerTransportFailure(millis());
+    finishUpload(false);
+    return;
+  }
+
+  int responseLength = -1;
+  const int httpCode = readResponseHead(uploadClient_, responseLength);
+  if (httpCode < 0) {
+    registerTransportFailure(millis());
+    finishUpload(false);
+    return;
+  }
+  transportFailures_ = 0;
+  if (httpCode == HTTP_CODE_TOO_MANY_REQUESTS) {
+    long retryAfter = 0;
+    if (!readJsonLong(uploadClient_, responseLength, RETRY_AFTER_KEY, retryAfter) || retryAfter <= 0) {
+      retryAfter = 1;
     }
+    ++counters_.throttled;
+    bucketFor(upload_.chatId).blockUntil(millis() + static_cast<unsigned long>(retryAfter) * 1000UL);
+  }
+  if (httpCode < 200 || httpCode >= 300) {
+    LOG_WARN("Telegram sendDocument HTTP hatasi: %d", httpCode);
+    finishUpload(false);
+    return;
+  }
+  finishUpload(true);
+}
+
+void TelegramService::preemptUpload() {
+  if (!upload_.active) {
+    return;
   }
+  LOG_WARN("Telegram: belge gonderimi uyari icin kesildi, bayt: %lu", static_cast<unsigned long>(upload_.bytes));
+  ++uploadStats_.preempted;
+  finishUpload(false);
+}
+
+void TelegramService::finishUpload(bool success) {
+  uploadClient_.stop();
+  uploadStats_.lastBytes = upload_.bytes;
+  uploadStats_.lastMs = millis() - upload_.startMs;
+  uploadStats_.lastMinFreeHeap = upload_.minFreeHeap;
+  const String chatId = upload_.chatId;
+  upload_ = UploadState();
+
+  if (success) {
+    ++uploadStats_.completed;
+    ++counters_.sent;
+    LOG_INFO("Telegram belgesi gonderildi, bayt: %lu", static_cast<unsigned long>(uploadStats_.lastBytes));
+    return;
+  }
+  ++uploadStats_.failed;
+  enqueuePending(text::format(text::MessageId::DocumentFailed), chatId);
+}
 
-  return encoded;
+void TelegramService::prepareClient(WiFiClientSecure &client) {
+  if (strlen(config::TELEGRAM_TLS_PUBLIC_KEY) > 0) {
+    static BearSSL::PublicKey pinnedKey(config::TELEGRAM_TLS_PUBLIC_KEY);
+    client.setKnownKey(&pinnedKey);
+  } else if (config::TELEGRAM_ALLOW_INSECURE_TLS) {
+    client.setInsecure();
+  }
+
+  if (!mflnProbed_) {
+    mflnSupported_ =
+        WiFiClientSecure::probeMaxFragmentLength(TELEGRAM_HOST, TELEGRAM_PORT, config::TELEGRAM_TLS_RX_BUFFER_BYTES);
+    mflnProbed_ = true;
+  }
+  // Without MFLN the server may send full 16 KB records, so only the TX side can shrink.
+  client.setBufferSizes(mflnSupported_ ? config::TELEGRAM_TLS_RX_BUFFER_BYTES : TLS_MAX_RECORD_BYTES,
+                        config::TELEGRAM_TLS_TX_BUFFER_BYTES);
+  client.setSession(&tlsSession_);
+  client.setTimeout(TELEGRAM_RESPONSE_TIMEOUT_MS);
+}
+
+bool TelegramService::connectClient(WiFiClientSecure &client) {
+  const uint32_t heapBefore = ESP.getFreeHeap();
+  const unsigned long start = millis();
+  if (!client.connect(TELEGRAM_HOST, TELEGRAM_PORT)) {
+    return false;
+  }
+  const unsigned long elapsed = millis() - start;
+  const uint32_t heapAfter = ESP.getFreeHeap();
+  const uint32_t heapUsed = heapBefore > heapAfter ? heapBefore - heapAfter : 0;
+
+  ++tlsStats_.handshakes;
+  tlsStats_.lastMs = elapsed;
+  tlsStats_.totalMs += elapsed;
+  if (elapsed > tlsStats_.maxMs) {
+    tlsStats_.maxMs = elapsed;
+  }
+  tlsStats_.lastHeapBytes = heapUsed;
+  if (heapUsed > tlsStats_.maxHeapBytes) {
+    tlsStats_.maxHeapBytes = heapUsed;
+  }
+  return true;
 }
 
 }  // namespace telegram
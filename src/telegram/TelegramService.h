@@ -1,8 +1,10 @@
 #pragma once
 
 #include <Arduino.h>
+#include <WiFiClientSecure.h>
 
 #include "sensor/MeasurementAggregator.h"
+#include "telegram/TokenBucket.h"
 
 namespace telegram {
 
@@ -10,24 +12,118 @@ class TelegramCommandProcessor;
 
 class TelegramService {
 public:
+  struct SendCounters {
+    uint32_t sent = 0;
+    uint32_t deferred = 0;
+    uint32_t dropped = 0;
+    uint32_t throttled = 0;
+    uint32_t transportErrors = 0;
+    uint32_t polls = 0;
+    uint32_t pollErrors = 0;
+  };
+
+  struct TlsStats {
+    uint32_t handshakes = 0;
+    uint32_t lastMs = 0;
+    uint32_t maxMs = 0;
+    uint32_t totalMs = 0;
+    uint32_t lastHeapBytes = 0;  // Free heap consumed by connect() (buffers + handshake state)
+    uint32_t maxHeapBytes = 0;
+  };
+
+  // Writes the next piece of a streamed document; returns false once done.
+  using DocumentWriter = bool (*)(Print &out, void *context);
+
   TelegramService();
 
   bool configured() const;
   bool sendAlert(const String &text);
-  bool sendInfo(const String &text);
+  // Dashboard mode skips the edit while the first stateLength bytes are unchanged.
+  bool sendInfo(const String &text, size_t stateLength = SIZE_MAX);
   bool sendDirect(const String &text, const String &chatId);
   void trySendStartupMessage();
+  // Retries alerts and replies that were deferred by rate limiting or backoff.
+  void flushPending();
+  String formatStats() const;
+  const SendCounters &counters() const { return counters_; }
+  const TlsStats &tlsStats() const { return tlsStats_; }
+  size_t pendingCount() const { return pendingCount_; }
   void pollUpdates(unsigned long now, TelegramCommandProcessor &processor,
                    const sensor::MeasurementStats &objectStats);
 
+  // Opens a multipart sendDocument upload whose file body is produced by
+  // `writer` in time slices from serviceUpload(), so loop() keeps running while
+  // a large export is sent. Only one upload runs at a time; other sends are
+  // deferred to the pending queue meanwhile.
+  bool startDocument(const String &chatId, const char *fileName, const char *mimeType, DocumentWriter writer,
+                     void *context);
+  void serviceUpload();
+  bool uploadActive() const { return upload_.active; }
+  // Drops the running upload so an alert does not wait for the whole export;
+  // the requester is told to ask again.
+  void preemptUpload();
+  bool inBackoff(unsigned long now) const { return backoffActive_ && static_cast<long>(now - backoffUntil_) < 0; }
+
   void resetStartupFlag() { startupMessageSent_ = false; }
 
 private:
+  enum class SendResult : uint8_t {
+    Sent,
+    Retry,   // Rate limited, throttled (429) or transport error; worth retrying later
+    Failed,  // Rejected by Telegram or not configured
+  };
+
+  struct PendingMessage {
+    String chatId;
+    String text;
+  };
+
+  struct UploadState {
+    bool active = false;
+    String chatId;
+    DocumentWriter writer = nullptr;
+    void *context = nullptr;
+    unsigned long startMs = 0;
+    uint32_t bytes = 0;
+    uint32_t minFreeHeap = 0;
+  };
+
+  struct UploadStats {
+    uint32_t completed = 0;
+    uint32_t failed = 0;
+    uint32_t preempted = 0;  // Also counted in failed
+    uint32_t lastBytes = 0;
+    uint32_t lastMs = 0;
+    uint32_t lastMinFreeHeap = 0;
+  };
+
+  static constexpr size_t PENDING_CAPACITY = 4;
+
+  // Last report message per chat in dashboard mode; edited in place instead of
+  // posting a new message every report.
+  struct DashboardSlot {
+    long messageId = 0;
+    String stateText;  // State part of the text last shown; compared byte for byte
+  };
+
   bool isAuthorizedChat(const String &chatId) const;
-  bool sendMessageInternal(const String &text, const String &chatId);
-  bool sendToSecondary(const String &text, const String &avoid1, const String &avoid2);
+  bool sendMessageInternal(const String &text, const String &chatId, bool queueIfLimited = false);
+  SendResult sendChunks(const String &text, const String &chatId, size_t &consumed);
+  SendResult postMessage(const __FlashStringHelper *method, const char *text, size_t textLength,
+                         const String &chatId, long editMessageId, long *sentMessageId);
+  void enqueuePending(const String &text, const String &chatId);
+  TokenBucket &bucketFor(const String &chatId);
+  bool backoffElapsed(unsigned long now);
+  bool admitSend(const String &chatId, unsigned long now);
+  bool admitPoll(unsigned long now);
+  void registerTransportFailure(unsigned long now);
+  void prepareClient(WiFiClientSecure &client);
+  bool connectClient(WiFiClientSecure &client);
+  void finishUpload(bool success);
+  bool updateDashboard(const String &text, size_t stateLength, const String &chatId, DashboardSlot &slot);
+  bool secondaryEligible(const String &avoid1, const String &avoid2) const;
+  bool sendToSecondary(const String &text, const String &avoid1, const String &avoid2, bool queueIfLimited = false);
   bool broadcast(const String &text);
-  static String urlEncode(const String &value);
 
   bool startupMessageSent_{false};
   long lastUpdateId_{0};
@@ -35,6 +131,27 @@ private:
   String alertChatId_;
   String infoChatId_;
   String secondaryChatId_;
+  DashboardSlot infoDashboard_;
+  DashboardSlot secondaryDashboard_;
+  TokenBucket globalBucket_;
+  TokenBucket alertBucket_;
+  TokenBucket infoBucket_;
+  TokenBucket secondaryBucket_;
+  TokenBucket otherBucket_;
+  uint8_t transportFailures_{0};
+  bool backoffActive_{false};
+  unsigned long backoffUntil_{0};
+  PendingMessage pending_[PENDING_CAPACITY];
+  size_t pendingHead_{0};
+  size_t pendingCount_{0};
+  SendCounters counters_;
+  BearSSL::Session tlsSession_;
+  TlsStats tlsStats_;
+  WiFiClientSecure uploadClient_;
+  UploadState upload_;
+  UploadStats uploadStats_;
+  bool mflnProbed_{false};
+  bool mflnSupported_{false};
 };
 
 }  // namespace telegram
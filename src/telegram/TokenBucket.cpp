@@ -0,0 +1,52 @@
+#include "telegram/TokenBucket.h"
+
+namespace telegram {
+
+TokenBucket::TokenBucket(uint8_t capacity, unsigned long refillIntervalMs)
+    : capacity_(capacity), tokens_(capacity), refillIntervalMs_(refillIntervalMs) {}
+
+bool TokenBucket::ready(unsigned long now) {
+  if (blocked_) {
+    if (static_cast<long>(now - blockedUntil_) < 0) {
+      return false;
+    }
+    blocked_ = false;
+  }
+  refill(now);
+  return tokens_ > 0;
+}
+
+void TokenBucket::take() {
+  if (tokens_ > 0) {
+    --tokens_;
+  }
+}
+
+void TokenBucket::blockUntil(unsigned long until) {
+  if (blocked_ && static_cast<long>(until - blockedUntil_) <= 0) {
+    return;
+  }
+  blockedUntil_ = until;
+  blocked_ = true;
+}
+
+void TokenBucket::refill(unsigned long now) {
+  if (tokens_ >= capacity_) {
+    lastRefill_ = now;
+    return;
+  }
+  if (refillIntervalMs_ == 0) {
+    tokens_ = capacity_;
+    return;
+  }
+  const unsigned long elapsed = now - lastRefill_;
+  const unsigned long earned = elapsed / refillIntervalMs_;
+  if (earned == 0) {
+    return;
+  }
+  const unsigned long total = tokens_ + earned;
+  tokens_ = total >= capacity_ ? capacity_ : static_cast<uint8_t>(total);
+  lastRefill_ += earned * refillIntervalMs_;
+}
+
+}  // namespace telegram
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace telegram {
+
+class TokenBucket {
+public:
+  TokenBucket(uint8_t capacity, unsigned long refillIntervalMs);
+
+  bool ready(unsigned long now);
+  void take();
+  void blockUntil(unsigned long until);
+
+private:
+  void refill(unsigned long now);
+
+  uint8_t capacity_;
+  uint8_t tokens_;
+  unsigned long refillIntervalMs_;
+  unsigned long lastRefill_{0};
+  unsigned long blockedUntil_{0};
+  bool blocked_{false};
+};
+
+}  // namespace telegram
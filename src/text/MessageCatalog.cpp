@@ -0,0 +1,227 @@
+#include "text/MessageCatalog.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace text {
+namespace {
+#define TEXT_MESSAGE_TEXT(id, text) const char TR_##id[] PROGMEM = text;
+TEXT_MESSAGES_TR(TEXT_MESSAGE_TEXT)
+#undef TEXT_MESSAGE_TEXT
+
+const char *const CATALOG_TR[] PROGMEM = {
+#define TEXT_MESSAGE_ENTRY(id, text) TR_##id,
+    TEXT_MESSAGES_TR(TEXT_MESSAGE_ENTRY)
+#undef TEXT_MESSAGE_ENTRY
+};
+static_assert(sizeof(CATALOG_TR) / sizeof(CATALOG_TR[0]) == static_cast<size_t>(MessageId::Count),
+              "catalog and MessageId out of step");
+
+constexpr uint8_t MAX_NESTING = 2;  // Message arguments inside message arguments
+constexpr size_t CHUNK_BYTES = 64;
+constexpr size_t NUMBER_BYTES = 24;
+constexpr size_t NOT_A_SLOT = static_cast<size_t>(-1);
+
+size_t digitCount(unsigned long value) {
+  size_t digits = 1;
+  while (value >= 10) {
+    value /= 10;
+    ++digits;
+  }
+  return digits;
+}
+
+// "%.2f" length without formatting: one extra byte covers a rounding carry.
+size_t decimalBound(float value) {
+  if (!(fabsf(value) < 1e9f)) {
+    return NUMBER_BYTES - 1;  // nan, inf or too wide for the buffer
+  }
+  return (value < 0.0f ? 1 : 0) + digitCount(static_cast<unsigned long>(fabsf(value))) + 4;
+}
+
+size_t writeFlash(Print &out, PGM_P text, size_t length) {
+  char chunk[CHUNK_BYTES];
+  size_t written = 0;
+  while (length > 0) {
+    const size_t piece = length < sizeof(chunk) ? length : sizeof(chunk);
+    memcpy_P(chunk, text, piece);
+    written += out.write(reinterpret_cast<const uint8_t *>(chunk), piece);
+    text += piece;
+    length -= piece;
+  }
+  return written;
+}
+
+// "{n}" at text[0]: n, otherwise NOT_A_SLOT. The caller checked that two more bytes follow.
+size_t slotIndex(PGM_P text) {
+  const char digit = static_cast<char>(pgm_read_byte(text + 1));
+  return digit >= '0' && digit <= '9' && pgm_read_byte(text + 2) == '}' ? static_cast<size_t>(digit - '0') : NOT_A_SLOT;
+}
+
+class CountingPrint : public Print {
+public:
+  using Print::write;
+  size_t write(uint8_t) override {
+    ++length;
+    return 1;
+  }
+  size_t write(const uint8_t *, size_t size) override {
+    length += size;
+    return size;
+  }
+
+  size_t length = 0;
+};
+
+class StringPrint : public Print {
+public:
+  explicit StringPrint(String &out) : out_(out) {}
+  using Print::write;
+  size_t write(uint8_t c) override { return out_.concat(static_cast<char>(c)) ? 1 : 0; }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    return out_.concat(reinterpret_cast<const char *>(buffer), size) ? size : 0;
+  }
+
+private:
+  String &out_;
+};
+
+// Keeps room for the terminator; counts what did not fit as written.
+class BufferPrint : public Print {
+public:
+  BufferPrint(char *buffer, size_t size) : buffer_(buffer), size_(size) {}
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *data, size_t size) override {
+    for (size_t i = 0; i < size; ++i, ++length) {
+      if (length + 1 < size_) {
+        buffer_[length] = static_cast<char>(data[i]);
+      }
+    }
+    return size;
+  }
+
+  size_t length = 0;
+
+private:
+  char *buffer_;
+  size_t size_;
+};
+}  // namespace
+
+class Renderer {
+public:
+  // estimate: numbers count their upper bound instead of being formatted and written.
+  static size_t message(Print &out, MessageId id, const Arg *args, size_t count, uint8_t depth, bool estimate) {
+    if (static_cast<size_t>(id) >= static_cast<size_t>(MessageId::Count)) {
+      return 0;
+    }
+    // Copied to RAM a chunk at a time: flash is read in words and the literal
+    // runs between slots are written from the chunk.
+    PGM_P text = static_cast<PGM_P>(pgm_read_ptr(&CATALOG_TR[static_cast<size_t>(id)]));
+    const size_t length = strlen_P(text);
+    char chunk[CHUNK_BYTES];
+    size_t written = 0;
+    size_t offset = 0;
+    while (offset < length) {
+      const size_t piece = length - offset < sizeof(chunk) ? length - offset : sizeof(chunk);
+      memcpy_P(chunk, text + offset, piece);
+      const char *brace = static_cast<const char *>(memchr(chunk, '{', piece));
+      const size_t literal = brace ? static_cast<size_t>(brace - chunk) : piece;
+      written += out.write(chunk, literal);
+      offset += literal;
+      if (!brace) {
+        continue;
+      }
+      const size_t slot = offset + 2 < length ? slotIndex(text + offset) : NOT_A_SLOT;
+      if (slot == NOT_A_SLOT) {
+        written += out.write(static_cast<uint8_t>('{'));
+        ++offset;
+        continue;
+      }
+      if (slot < count) {
+        written += argument(out, args[slot], args, count, depth, estimate);
+      }
+      offset += 3;
+    }
+    return written;
+  }
+
+private:
+  static size_t argument(Print &out, const Arg &arg, const Arg *args, size_t count, uint8_t depth, bool estimate) {
+    char digits[NUMBER_BYTES];
+    int length = 0;
+    switch (arg.kind_) {
+      case Arg::Kind::None:
+        return 0;
+      case Arg::Kind::Decimal:
+        if (estimate) {
+          return decimalBound(arg.value_.decimal);
+        }
+        length = snprintf_P(digits, sizeof(digits), PSTR("%.2f"), static_cast<double>(arg.value_.decimal));
+        break;
+      case Arg::Kind::Signed:
+        if (estimate) {
+          const long value = arg.value_.integer;
+          return value < 0 ? 1 + digitCount(0UL - static_cast<unsigned long>(value)) : digitCount(value);
+        }
+        length = snprintf_P(digits, sizeof(digits), PSTR("%ld"), arg.value_.integer);
+        break;
+      case Arg::Kind::Unsigned:
+        if (estimate) {
+          return digitCount(arg.value_.count);
+        }
+        length = snprintf_P(digits, sizeof(digits), PSTR("%lu"), arg.value_.count);
+        break;
+      case Arg::Kind::Text:
+        return arg.value_.text ? out.write(arg.value_.text, strlen(arg.value_.text)) : 0;
+      case Arg::Kind::FlashText:
+        return arg.value_.text ? writeFlash(out, arg.value_.text, strlen_P(arg.value_.text)) : 0;
+      case Arg::Kind::Message:
+        return depth < MAX_NESTING ? message(out, arg.value_.message, args, count, depth + 1, estimate) : 0;
+    }
+    if (length <= 0) {
+      return 0;
+    }
+    const size_t used = static_cast<size_t>(length) < sizeof(digits) ? static_cast<size_t>(length) : sizeof(digits) - 1;
+    return out.write(digits, used);
+  }
+};
+
+size_t render(Print &out, MessageId id, const Arg *args, size_t count) {
+  return Renderer::message(out, id, args, count, 0, false);
+}
+
+size_t render(char *buffer, size_t size, MessageId id, const Arg *args, size_t count) {
+  BufferPrint out(buffer, size);
+  Renderer::message(out, id, args, count, 0, false);
+  if (size > 0) {
+    buffer[out.length < size ? out.length : size - 1] = '\0';
+  }
+  return out.length;
+}
+
+size_t measure(MessageId id, const Arg *args, size_t count) {
+  CountingPrint out;
+  return Renderer::message(out, id, args, count, 0, true);
+}
+
+void append(String &out, MessageId id, const Arg *args, size_t count) {
+  out.reserve(out.length() + measure(id, args, count));
+  StringPrint sink(out);
+  Renderer::message(sink, id, args, count, 0, false);
+}
+
+void append(String &out, MessageId id, Arg a0, Arg a1, Arg a2, Arg a3) {
+  const Arg args[] = {a0, a1, a2, a3};
+  append(out, id, args, sizeof(args) / sizeof(args[0]));
+}
+
+String format(MessageId id, Arg a0, Arg a1, Arg a2, Arg a3) {
+  String message;
+  append(message, id, a0, a1, a2, a3);
+  return message;
+}
+
+}  // namespace text
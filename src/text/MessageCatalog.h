@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "text/MessagesTr.h"
+
+namespace text {
+
+enum class MessageId : uint8_t {
+#define TEXT_MESSAGE_ID(id, text) id,
+  TEXT_MESSAGES_TR(TEXT_MESSAGE_ID)
+#undef TEXT_MESSAGE_ID
+  Count
+};
+
+// One slot value. Pointers are not copied: the argument must outlive the
+// render call, which holds for temporaries passed straight to it.
+class Arg {
+public:
+  Arg() : kind_(Kind::None) { value_.text = nullptr; }
+  Arg(float value) : kind_(Kind::Decimal) { value_.decimal = value; }  // Two decimals, like String(value, 2)
+  Arg(int value) : Arg(static_cast<long>(value)) {}
+  Arg(long value) : kind_(Kind::Signed) { value_.integer = value; }
+  Arg(unsigned int value) : Arg(static_cast<unsigned long>(value)) {}
+  Arg(unsigned long value) : kind_(Kind::Unsigned) { value_.count = value; }
+  Arg(const char *value) : kind_(Kind::Text) { value_.text = value; }
+  Arg(const __FlashStringHelper *value) : kind_(Kind::FlashText) {
+    value_.text = reinterpret_cast<const char *>(value);
+  }
+  Arg(const String &value) : Arg(value.c_str()) {}
+  // Rendered in place with the same arguments as the message it fills.
+  Arg(MessageId id) : kind_(Kind::Message) { value_.message = id; }
+
+private:
+  friend class Renderer;
+
+  enum class Kind : uint8_t {
+    None,
+    Decimal,
+    Signed,
+    Unsigned,
+    Text,
+    FlashText,
+    Message,
+  };
+
+  Kind kind_;
+  union {
+    float decimal;
+    long integer;
+    unsigned long count;
+    const char *text;
+    MessageId message;
+  } value_;
+};
+
+// Message texts live in flash (MessagesTr.h) and are written straight to the
+// output: "{n}" is replaced by args[n], a slot without an argument stays empty,
+// and any other '{' is copied as is. Returns the bytes written.
+size_t render(Print &out, MessageId id, const Arg *args, size_t count);
+// snprintf-like: always terminates, returns the full length even when cut short.
+size_t render(char *buffer, size_t size, MessageId id, const Arg *args, size_t count);
+// Upper bound of the rendered length, exact but for a byte per decimal
+// argument; numbers are not formatted, so it is cheap to call before a render.
+size_t measure(MessageId id, const Arg *args, size_t count);
+// Grows the string once to the measured length, then renders into it.
+void append(String &out, MessageId id, const Arg *args, size_t count);
+
+void append(String &out, MessageId id, Arg a0 = Arg(), Arg a1 = Arg(), Arg a2 = Arg(), Arg a3 = Arg());
+String format(MessageId id, Arg a0 = Arg(), Arg a1 = Arg(), Arg a2 = Arg(), Arg a3 = Arg());
+
+}  // namespace text
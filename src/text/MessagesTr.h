@@ -0,0 +1,189 @@
+#pragma once
+
+// Turkish message texts, one X(id, text) entry per message. The ids become
+// text::MessageId in this order; another language is a second list with the
+// same ids in the same order. {0}..{9} are argument slots (see MessageCatalog.h).
+#define TEXT_MESSAGES_TR(X) \
+  X(Start, "Cihaz baslatildi.") \
+  X(Usage, \
+    "Komutlar:\n" \
+    "config\n" \
+    "stats\n" \
+    "heap\n" \
+    "history [30m|2h|2d]\n" \
+    "export <30m|6h|3d> [csv|bin]\n" \
+    "stream [on|off]\n" \
+    "trace [on|off|clear|export]\n" \
+    "fleet\n" \
+    "@<dugum> <komut>\n" \
+    "set min <deger_C>\n" \
+    "set max <deger_C>\n" \
+    "set hysteresis <deger_C>\n" \
+    "set minsamples <tam_sayi>\n" \
+    "set renotify <saniye>\n" \
+    "set deadband <deger_C>\n" \
+    "set silence <saniye>") \
+  X(NoData, "Son periyotta olcum verisi bulunamadi.") \
+  X(SensorReadFailed, "Sensor hatasi: MLX90614 olcumu alinamiyor.") \
+  X(SensorRecovered, "Sensor olcumleri yeniden aliniyor.") \
+  X(SensorInitFailed, "Sensor hatasi: MLX90614 baslatilamadi.") \
+  /* Measurement report: header, object stats, ambient header, ambient stats, footer */ \
+  X(ReportHeader, "Olcum Raporu\nOrnek sayisi: {0}\nNesne (C)\n") \
+  X(ReportStats, "  Ortalama: {0}\n  Min: {1}\n  Maks: {2}\n  Son: {3}\n") \
+  X(ReportAmbient, "Ortam (C)\n") \
+  X(ReportFooter, "Koruma: {0}\nSinirlar: {1} - {2} C, histerezis: {3} C") \
+  X(ReportSuppressed, "\nBastirilan rapor: {0} (toplam {1})") \
+  X(ProtectionDisabled, "Devre disi") \
+  X(ProtectionHeating, "Isitma aktif") \
+  X(ProtectionCooling, "Sogutma aktif") \
+  X(ProtectionNormal, "Normal") \
+  /* Protection alerts: {0} last, {1} limit, {2} average, {3} ReadingBelow or ReadingAbove */ \
+  X(ReadingBelow, "Son: {0} C (< {1} C). Ortalama: {2} C.") \
+  X(ReadingAbove, "Son: {0} C (> {1} C). Ortalama: {2} C.") \
+  X(HeatingStarted, "UYARI: Nesne sicakligi alt sinirin altinda. {3} Isitma baslatiliyor.") \
+  X(CoolingStarted, "UYARI: Nesne sicakligi ust sinirin ustunde. {3} Sogutma baslatiliyor.") \
+  X(HeatingContinues, "Bilgi: Isitma koruma modu suruyor. {3}") \
+  X(CoolingContinues, "Bilgi: Sogutma koruma modu suruyor. {3}") \
+  X(BackInRange, "Bilgi: Nesne sicakligi guvenli araliga dondu. Son: {0} C, ortalama: {2} C. Koruma devre disi.") \
+  /* Settings: config lines and set replies share the labels and units */ \
+  X(ConfigHeader, "Koruma Ayarlari\n") \
+  X(ConfigLine, "- {0}: {1}{2}\n") \
+  X(ConfigFooter, \
+    "\n{0}\n\nNot: min < max olmali, histerezis pozitif ve aralik icinde olmalidir. " \
+    "Tum degisiklikler EEPROM'a kaydedilir.") \
+  X(LabelMin, "min") \
+  X(LabelMax, "max") \
+  X(LabelHysteresis, "histerezis") \
+  X(LabelMinSamples, "min ornek sayisi") \
+  X(LabelRenotify, "renotify") \
+  X(LabelDeadband, "rapor deadband") \
+  X(LabelSilence, "rapor sessizlik") \
+  X(UnitNone, "") \
+  X(UnitCelsius, " C") \
+  X(UnitSeconds, " sn") \
+  X(MinNotBelowMax, "Min degeri maksimumdan kucuk olmali.") \
+  X(MaxNotAboveMin, "Max degeri minimumdan buyuk olmali.") \
+  X(HysteresisOutOfRange, "Histerezis pozitif olmali ve araligin tamamindan kucuk olmali.") \
+  X(DeadbandOutOfRange, "deadband 0 ile 10 C arasinda olmali (0 = kapali).") \
+  X(OutOfRange, "{0} {1} ile {2}{3} arasinda olmali.") \
+  X(SetMissingParameter, "Eksik parametre. Ornek: set min 22.5") \
+  X(SetMissingValue, "Deger bulunamadi. Ornek: set max 28.0") \
+  X(SetUnknownKey, "Bilinmeyen ayar anahtari. 'config' yazarak yardim alabilirsiniz.") \
+  X(InvalidDecimal, "Gecersiz sayi. Ondalik icin nokta kullanin.") \
+  X(InvalidInteger, "Gecersiz tam sayi.") \
+  X(SettingsIncompatible, "Ayar guncellenemedi: yeni degerler uyumsuz.") \
+  X(SettingUpdated, "Ayar guncellendi: {0} = {1}{2}{3}") \
+  X(SettingSaved, " (kaydedildi)") \
+  X(SettingNotSaved, " (EEPROM kaydedilemedi, eski ayarlar korunuyor)") \
+  /* Command replies */ \
+  X(UnknownCommand, "Bilinmeyen komut.\n\n{0}") \
+  X(UsageHint, "Kullanim: {0}") \
+  X(SyntaxStream, "stream [on|off]") \
+  X(SyntaxTrace, "trace [on|off|clear|export]") \
+  X(SyntaxRoute, "@<dugum> <komut>") \
+  X(InvalidHistoryRange, "Gecersiz aralik. Ornek: history 30m, history 2h, history 2d") \
+  X(InvalidExportRange, "Gecersiz aralik. Ornek: export 30m, export 6h csv, export 3d bin") \
+  X(InvalidExportFormat, "Gecersiz bicim. 'csv' veya 'bin' kullanin.") \
+  X(TelegramOnly, "{0} yalnizca Telegram uzerinden kullanilabilir.") \
+  X(RemoteCommands, "Uzak dugum komutlari") \
+  X(DisabledInBuild, "{0} bu derlemede kapali.") \
+  X(FeatureStream, "Ikili akis") \
+  X(FeatureTrace, "Karar kaydi") \
+  X(SeriesLogDisabled, "Zaman serisi kaydi kapali.") \
+  X(UploadBusy, "Devam eden bir disari aktarma var; bitince tekrar deneyin.") \
+  X(ClockNotSynced, "Saat henuz senkronize degil; biraz sonra tekrar deneyin.") \
+  X(DocumentFailed, "Belge gonderilemedi; daha sonra tekrar deneyin.") \
+  X(FleetDisabled, "Filo modu kapali (FLEET_NODE_NAME bos).") \
+  X(FleetNoKey, "Uzak komutlar kapali: FLEET_KEY tanimli degil.") \
+  X(FleetCommandRepeated, "Komut zaten calistirildi; ilk yanit kayboldu.") \
+  /* Routed command replies: {0} node, {1} reply text or FleetReplyEmpty */ \
+  X(FleetReply, "{0}:\n{1}") \
+  X(FleetReplyPartLost, "{0}:\n{1}\n(yanitin bir kismi kayboldu)") \
+  X(FleetReplyEndLost, "{0}:\n{1}\n(yanitin sonu gelmedi)") \
+  X(FleetReplyEmpty, "(bos yanit)") \
+  X(FleetNoReply, "{0}: yanit alinamadi.") \
+  X(FleetNotGateway, "Bu dugum filo gecidi degil.") \
+  X(FleetUnknownNode, "Bilinmeyen veya erisilemeyen dugum: {0}") \
+  X(FleetCommandsFull, "Bekleyen uzak komut sayisi dolu, biraz sonra tekrar deneyin.") \
+  /* Watchdog: {0} stalled ms, {1} stage */ \
+  X(StallAlert, "UYARI: Ana dongu {0} ms takildi (asama: {1}). Roleler guvenli duruma alindi.") \
+  /* History table: {0}/{1} are SpanMinutes or SpanHours */ \
+  X(HistoryDisabled, "Gecmis kaydi devre disi.") \
+  X(HistoryEmpty, "Gecmis henuz bos; ilk kova kapanmadi.") \
+  X(HistoryHeader, "Gecmis son {0} ({1} adim)\nyas nesne min/ort/maks | ortam ort | role") \
+  X(HistoryAgeMinutes, "-{0}dk") \
+  X(HistoryAgeHours, "-{0}sa") \
+  X(HistoryNoData, "veri yok") \
+  X(HistoryHeating, "I") \
+  X(HistoryCooling, "S") \
+  X(SpanMinutes, "{0} dk") \
+  X(SpanHours, "{0} sa") \
+  /* Diagnostics ("stats", "heap", "fleet"); stage, sink and role ids stay untranslated */ \
+  X(StateOn, "acik") \
+  X(StateOff, "kapali") \
+  X(ValueYes, "var") \
+  X(ValueNone, "yok") \
+  X(ProfilerDisabled, "Profil olcumu devre disi.") \
+  X(ProfilerHeader, "Asama sureleri (us)\n") \
+  X(ProfilerStage, "{0}: n={1}") \
+  X(ProfilerPercentiles, " p50={0} p99={1} max={2}") \
+  X(ProfilerOverhead, "Olcum maliyeti: {0} cevrim/kayit") \
+  X(StallWatchDisabled, "Takilma bekcisi devre disi.") \
+  X(StallStats, "Takilma: {0} kez, butce {1} ms") \
+  X(StallStatsLast, ", son: {0} {1} ms") \
+  X(TelegramStats, \
+    "Telegram: gonderilen {0}, ertelenen {1}, dusurulen {2}, 429 {3}, baglanti hatasi {4}, kuyruk {5}\n" \
+    "TLS: el sikisma {6}") \
+  X(TlsStats, ", son {0} ms, ort {1} ms, maks {2} ms, heap son {3} B, maks {4} B") \
+  X(TlsMfln, ", MFLN {0}") \
+  X(UploadStats, "\nBelge: gonderilen {0}, hata {1} (uyari icin kesilen {2}), son {3} B / {4} ms") \
+  X(UploadRate, " ({0} B/sn)") \
+  X(UploadMinHeap, ", min heap {0} B") \
+  X(HistoryMemory, "Gecmis bellegi: {0} B ({1} x {2}, {3} x {4})") \
+  X(SeriesLogOff, "TS log: kapali") \
+  X(SeriesLogStats, "TS log: blok {0}/{1}, nokta {2}") \
+  X(SeriesLogPointSize, ", {0} B/nokta (ham {1})") \
+  X(SeriesLogWrites, ", yazma {0}") \
+  X(SeriesLogWriteErrors, ", hata {0}") \
+  X(MqttOff, "MQTT: kapali") \
+  X(MqttConnected, "bagli") \
+  X(MqttDisconnected, "bagli degil") \
+  X(MqttStats, "MQTT: {0}, yayin {1} ({2}/sn), hata {3}") \
+  X(MqttWriteTimes, ", yazma ort {0} us, maks {1} us") \
+  X(MqttAcks, "\nMQTT QoS1: onay {0}") \
+  X(MqttAckTimes, ", son {0} ms, ort {1} ms, maks {2} ms") \
+  X(MqttQueue, ", tekrar {0}, kuyruk {1}, dusurulen {2}, komut {3}, baglanti {4} (hata {5})") \
+  X(NotifyStats, "Bildirim: kuyruk {0}/{1}, olay {2}, dusurulen {3}") \
+  X(NotifyUnrouted, ", hedefsiz {0}") \
+  X(NotifySink, "\n- {0}: {1}, iletilen {2} ({3} toplu), ort {4} ms, maks {5} ms, hata {6}") \
+  X(NotifySinkReady, "hazir") \
+  X(NotifySinkWaiting, "bekliyor") \
+  X(LogStats, \
+    "Log: satir {0}, dusurulen {1} ({2} B), tekrar {3}, kesilen {4}, tampon tepe {5}/{6} B") \
+  X(StreamStats, "Ikili akis: {0}, cerceve {1}, dusen {2}, bayt {3}") \
+  X(StreamRate, ", {0} cerceve/sn") \
+  X(TraceStats, "Karar kaydi: {0}, kayit {1}, bayt {2}, bekleyen {3} B, kayip {4}, dosya degisimi {5}") \
+  X(HeapMonitorDisabled, "Heap izleme devre disi.") \
+  X(HeapLine, "Heap: bos {0} B, blok {1} B, parca %{2} (min bos {3} B)") \
+  X(HeapReport, \
+    "Heap Durumu\n- bos: {0} B (min {1}, maks {2})\n- en buyuk blok: {3} B (min {4}, maks {5})\n" \
+    "- parcalanma: %{6} (min %{7}, maks %{8})") \
+  X(HeapHistoryHeader, "\nSon {0} pencere (min bos/min blok/maks parca):") \
+  X(HeapSitesHeader, "\nTahsis noktalari (asama adres cagri bayt):") \
+  X(HeapSitesUntracked, "\n  tabloda yer yok: {0}") \
+  X(FleetRoleElecting, "secim") \
+  X(FleetRoleMember, "uye") \
+  X(FleetRoleGateway, "gecit") \
+  X(FleetRoleStandalone, "tekil") \
+  X(FleetNodes, "Filo: {0} ({1}), gecit: {2}") \
+  X(FleetPeer, "\n- {0}{1}{2}") \
+  X(FleetPeerGateway, " [gecit]") \
+  X(FleetPeerSilent, " [yanitsiz]") \
+  X(FleetPeerSample, ": nesne {0} C, ortam {1} C{2}{3}") \
+  X(FleetPeerHeating, ", isitma") \
+  X(FleetPeerCooling, ", sogutma") \
+  X(FleetPeerSeen, ", {0} sn once, oncelik {1}, calisma {2} sn") \
+  X(FleetStats, \
+    "Filo: rol {0}, es {1}, gonderilen {2} (hata {3}), alinan {4} (bozuk {5}, imzasiz {6}), iletilen olay {7}") \
+  X(FleetStatsLoss, ", NACK {0}, yeniden gonderim {1}, kayip olay {2}, kayip ornek {3}") \
+  X(FleetStatsCommands, ", uzak komut {0} (zaman asimi {1}, reddedilen {2}, tekrar {3}), rol degisimi {4}")
@@ -0,0 +1,163 @@
+#include "timeseries/SeriesCodec.h"
+
+#include <string.h>
+
+namespace timeseries {
+namespace {
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+size_t putVarint(uint8_t *out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(value);
+  return n;
+}
+
+bool getVarint(const uint8_t *buffer, size_t end, size_t &position, uint64_t &value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64 && position < end; shift += 7) {
+    const uint8_t byte = buffer[position++];
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void putLe(uint8_t *out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint64_t getLe(const uint8_t *in, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+bool readBlockHeader(const uint8_t *buffer, size_t length, SeriesBlockHeader &header) {
+  if (length < SERIES_BLOCK_HEADER_BYTES || getLe(buffer, 2) != SERIES_BLOCK_MAGIC ||
+      buffer[2] != SERIES_BLOCK_VERSION) {
+    return false;
+  }
+  header.sequence = static_cast<uint32_t>(getLe(buffer + 4, 4));
+  header.count = static_cast<uint16_t>(getLe(buffer + 8, 2));
+  header.usedBytes = static_cast<uint16_t>(getLe(buffer + 10, 2));
+  header.firstTimestampMs = getLe(buffer + 12, 8);
+  header.lastTimestampMs = getLe(buffer + 20, 8);
+  return header.usedBytes >= SERIES_BLOCK_HEADER_BYTES && header.usedBytes <= length;
+}
+
+BlockEncoder::BlockEncoder(uint8_t *buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+void BlockEncoder::begin(uint32_t sequence) {
+  header_ = SeriesBlockHeader();
+  header_.sequence = sequence;
+  previous_ = SeriesPoint();
+  previousDelta_ = 0;
+  used_ = SERIES_BLOCK_HEADER_BYTES;
+  memset(buffer_, 0xFF, capacity_);
+  writeHeader();
+}
+
+bool BlockEncoder::append(const SeriesPoint &point) {
+  if (header_.count == 0) {
+    header_.firstTimestampMs = point.timestampMs;
+    previous_.timestampMs = point.timestampMs;
+  }
+  const int64_t delta = static_cast<int64_t>(point.timestampMs - previous_.timestampMs);
+  const bool flagsChanged = header_.count == 0 || point.flags != previous_.flags;
+
+  uint8_t record[SERIES_MAX_RECORD_BYTES];
+  size_t n = putVarint(record, (zigzag(delta - previousDelta_) << 1) | (flagsChanged ? 1 : 0));
+  n += putVarint(record + n, zigzag(static_cast<int64_t>(point.objectCenti) - previous_.objectCenti));
+  n += putVarint(record + n, zigzag(static_cast<int64_t>(point.ambientCenti) - previous_.ambientCenti));
+  if (flagsChanged) {
+    record[n++] = point.flags;
+  }
+  if (used_ + n > capacity_ || header_.count == UINT16_MAX) {
+    if (header_.count == 0) {
+      header_.firstTimestampMs = 0;
+    }
+    return false;
+  }
+
+  memcpy(buffer_ + used_, record, n);
+  used_ += n;
+  ++header_.count;
+  header_.lastTimestampMs = point.timestampMs;
+  previousDelta_ = delta;
+  previous_ = point;
+  writeHeader();
+  return true;
+}
+
+void BlockEncoder::writeHeader() {
+  header_.usedBytes = static_cast<uint16_t>(used_);
+  putLe(buffer_, SERIES_BLOCK_MAGIC, 2);
+  buffer_[2] = SERIES_BLOCK_VERSION;
+  buffer_[3] = 0;
+  putLe(buffer_ + 4, header_.sequence, 4);
+  putLe(buffer_ + 8, header_.count, 2);
+  putLe(buffer_ + 10, header_.usedBytes, 2);
+  putLe(buffer_ + 12, header_.firstTimestampMs, 8);
+  putLe(buffer_ + 20, header_.lastTimestampMs, 8);
+}
+
+BlockDecoder::BlockDecoder(const uint8_t *buffer, size_t length) : buffer_(buffer) {
+  valid_ = readBlockHeader(buffer, length, header_);
+  if (valid_) {
+    end_ = header_.usedBytes;
+    position_ = SERIES_BLOCK_HEADER_BYTES;
+    previous_.timestampMs = header_.firstTimestampMs;
+  }
+}
+
+bool BlockDecoder::next(SeriesPoint &point) {
+  if (!valid_ || decoded_ >= header_.count) {
+    return false;
+  }
+  uint64_t control = 0;
+  uint64_t objectDelta = 0;
+  uint64_t ambientDelta = 0;
+  if (!getVarint(buffer_, end_, position_, control) || !getVarint(buffer_, end_, position_, objectDelta) ||
+      !getVarint(buffer_, end_, position_, ambientDelta)) {
+    valid_ = false;
+    return false;
+  }
+  uint8_t flags = previous_.flags;
+  if (control & 1) {
+    if (position_ >= end_) {
+      valid_ = false;
+      return false;
+    }
+    flags = buffer_[position_++];
+  }
+
+  previousDelta_ += unzigzag(control >> 1);
+  point.timestampMs = previous_.timestampMs + static_cast<uint64_t>(previousDelta_);
+  point.objectCenti = static_cast<int32_t>(previous_.objectCenti + unzigzag(objectDelta));
+  point.ambientCenti = static_cast<int32_t>(previous_.ambientCenti + unzigzag(ambientDelta));
+  point.flags = flags;
+  previous_ = point;
+  ++decoded_;
+  return true;
+}
+
+}  // namespace timeseries
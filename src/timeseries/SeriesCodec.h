@@ -0,0 +1,83 @@
+#pragma once
+
+// Block codec for the flash time-series log. Deliberately free of Arduino
+// dependencies so the same code decodes exported blocks on a host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace timeseries {
+
+constexpr uint16_t SERIES_BLOCK_MAGIC = 0x5354;  // "TS" little endian
+constexpr uint8_t SERIES_BLOCK_VERSION = 1;
+constexpr size_t SERIES_BLOCK_HEADER_BYTES = 28;
+constexpr size_t SERIES_MAX_RECORD_BYTES = 21;  // 10 (timestamp) + 5 + 5 + 1 (flags)
+
+struct SeriesPoint {
+  uint64_t timestampMs = 0;  // Unix epoch milliseconds
+  int32_t objectCenti = 0;   // 0.01 C
+  int32_t ambientCenti = 0;
+  uint8_t flags = 0;         // history::HistoryFlags bits
+};
+
+struct SeriesBlockHeader {
+  uint32_t sequence = 0;
+  uint16_t count = 0;
+  uint16_t usedBytes = 0;
+  uint64_t firstTimestampMs = 0;
+  uint64_t lastTimestampMs = 0;
+};
+
+// Header layout (little endian):
+//   u16 magic, u8 version, u8 reserved, u32 sequence, u16 count, u16 usedBytes,
+//   u64 firstTimestampMs, u64 lastTimestampMs
+// Each record then stores zigzag varints of
+//   (delta-of-delta timestamp << 1 | flagsChanged), delta object, delta ambient
+// followed by the flags byte when flagsChanged is set. The first record is
+// encoded against the header timestamp with a zero previous delta and zero
+// previous values, so every block decodes on its own.
+class BlockEncoder {
+public:
+  BlockEncoder(uint8_t *buffer, size_t capacity);
+
+  void begin(uint32_t sequence);
+  // Returns false when the record does not fit; the block is left unchanged.
+  bool append(const SeriesPoint &point);
+
+  const SeriesBlockHeader &header() const { return header_; }
+  size_t size() const { return used_; }
+  bool empty() const { return header_.count == 0; }
+
+private:
+  void writeHeader();
+
+  uint8_t *buffer_;
+  size_t capacity_;
+  size_t used_{0};
+  SeriesBlockHeader header_;
+  SeriesPoint previous_;
+  int64_t previousDelta_{0};
+};
+
+class BlockDecoder {
+public:
+  BlockDecoder(const uint8_t *buffer, size_t length);
+
+  bool valid() const { return valid_; }
+  const SeriesBlockHeader &header() const { return header_; }
+  bool next(SeriesPoint &point);
+
+private:
+  const uint8_t *buffer_;
+  size_t end_{0};
+  size_t position_{0};
+  uint16_t decoded_{0};
+  bool valid_{false};
+  SeriesBlockHeader header_;
+  SeriesPoint previous_;
+  int64_t previousDelta_{0};
+};
+
+bool readBlockHeader(const uint8_t *buffer, size_t length, SeriesBlockHeader &header);
+
+}  // namespace timeseries
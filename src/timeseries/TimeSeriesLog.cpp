@@ -0,0 +1,351 @@
+#include "timeseries/TimeSeriesLog.h"
+
+#include <LittleFS.h>
+#include <string.h>
+
+#include "logging/Log.h"
+#include "text/MessageCatalog.h"
+
+
+namespace timeseries {
+
+static_assert(config::TIMESERIES_BLOCK_BYTES > SERIES_BLOCK_HEADER_BYTES + SERIES_MAX_RECORD_BYTES,
+              "Time-series block too small for one record");
+static_assert(config::TIMESERIES_BLOCK_BYTES <= UINT16_MAX, "Block size must fit the header's usedBytes field");
+
+static_assert(config::TIMESERIES_BLOCKS % config::TIMESERIES_SEGMENT_BLOCKS == 0,
+              "The ring must hold whole segments");
+static_assert(SERIES_LOG_SEGMENTS >= 2, "One segment is reused while the others keep the history");
+static_assert(config::TIMESERIES_SEGMENT_BLOCKS <= UINT8_MAX, "Block count per segment must fit a byte");
+
+namespace {
+constexpr char LEGACY_LOG_PATH[] = "/tslog.bin";  // Single-file ring of earlier builds
+constexpr char OPEN_BLOCK_PATH[] = "/tslog_open.bin";
+constexpr size_t SEGMENT_PATH_BYTES = 20;
+constexpr uint32_t SEGMENT_BLOCKS = config::TIMESERIES_SEGMENT_BLOCKS;
+constexpr size_t RAW_POINT_BYTES = 8 + 4 + 4 + 1;  // Uncompressed SeriesPoint payload
+constexpr size_t EXPORT_SKIPS_PER_CALL = 32;  // Bounds header reads per exportNext() call
+constexpr uint8_t EXPORT_MAGIC[4] = {'T', 'S', 'X', 1};
+constexpr size_t EXPORT_HEADER_BYTES = 24;
+constexpr char CSV_HEADER[] = "zaman_utc_s,nesne_C,ortam_C,durum\n";
+
+// Block n of the log is block n % SEGMENT_BLOCKS of segment (n / SEGMENT_BLOCKS) % SEGMENTS.
+size_t segmentOf(uint32_t sequence) { return (sequence / SEGMENT_BLOCKS) % SERIES_LOG_SEGMENTS; }
+uint32_t segmentStart(uint32_t sequence) { return sequence - sequence % SEGMENT_BLOCKS; }
+
+void segmentPath(char *out, size_t size, size_t segment) {
+  snprintf(out, size, "/tslog_%03u.seg", static_cast<unsigned>(segment));
+}
+
+bool readBlock(File &file, size_t index, uint8_t *buffer, size_t length) {
+  return file.seek(static_cast<uint32_t>(index * config::TIMESERIES_BLOCK_BYTES)) &&
+         static_cast<size_t>(file.read(buffer, length)) == length;
+}
+
+// Renders 0.01 C fixed point without going through float formatting.
+size_t formatCenti(char *out, size_t size, int32_t value) {
+  const uint32_t magnitude = static_cast<uint32_t>(value < 0 ? -static_cast<int64_t>(value) : value);
+  return static_cast<size_t>(snprintf(out, size, "%s%lu.%02lu", value < 0 ? "-" : "",
+                                      static_cast<unsigned long>(magnitude / 100),
+                                      static_cast<unsigned long>(magnitude % 100)));
+}
+
+void putLe(uint8_t *out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+}  // namespace
+
+TimeSeriesLog::TimeSeriesLog() : encoder_(writeBuffer_, sizeof(writeBuffer_)) {}
+
+bool TimeSeriesLog::begin() {
+  if (!config::ENABLE_TIMESERIES_LOG) {
+    return false;
+  }
+  if (!LittleFS.begin()) {
+    LOG_ERROR("LittleFS baglanamadi; zaman serisi kaydi kapali.");
+    return false;
+  }
+  if (LittleFS.exists(LEGACY_LOG_PATH)) {
+    LittleFS.remove(LEGACY_LOG_PATH);  // Its 640 KB are needed by the segments
+  }
+
+  // Writing resumes after the newest complete block. Every segment starts on a
+  // multiple of SEGMENT_BLOCKS, so its first header dates the whole file.
+  uint32_t resumeSequence = 0;
+  for (size_t segment = 0; segment < SERIES_LOG_SEGMENTS; ++segment) {
+    char path[SEGMENT_PATH_BYTES];
+    segmentPath(path, sizeof(path), segment);
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+      continue;
+    }
+    const size_t bytes = file.size();
+    size_t blocks = bytes / config::TIMESERIES_BLOCK_BYTES;
+    if (blocks > SEGMENT_BLOCKS) {
+      blocks = SEGMENT_BLOCKS;
+    }
+    SeriesBlockHeader header;
+    const bool valid = blocks > 0 && readBlock(file, 0, readBuffer_, SERIES_BLOCK_HEADER_BYTES) &&
+                       readBlockHeader(readBuffer_, config::TIMESERIES_BLOCK_BYTES, header) &&
+                       header.sequence % SEGMENT_BLOCKS == 0 && segmentOf(header.sequence) == segment;
+    file.close();
+    if (!valid) {
+      continue;
+    }
+    segmentBlocks_[segment] = static_cast<uint8_t>(blocks);
+    // A torn append leaves part of a block at the end: the next block goes to a new segment.
+    const bool appendable = blocks < SEGMENT_BLOCKS && bytes % config::TIMESERIES_BLOCK_BYTES == 0;
+    const uint32_t next = header.sequence + (appendable ? blocks : SEGMENT_BLOCKS);
+    if (next > resumeSequence) {
+      resumeSequence = next;
+    }
+  }
+
+  nextSequence_ = resumeSequence;
+  recoverOpenBlock();
+  startBlock();
+  ready_ = true;
+  return true;
+}
+
+void TimeSeriesLog::append(const SeriesPoint &point) {
+  if (!ready_) {
+    return;
+  }
+  size_t before = encoder_.size();
+  if (!encoder_.append(point)) {
+    writeBlock(currentSequence());
+    startBlock();
+    before = encoder_.size();
+    if (!encoder_.append(point)) {
+      return;
+    }
+  }
+  encodedBytes_ += encoder_.size() - before;
+  ++pointsAppended_;
+  dirty_ = true;
+}
+
+void TimeSeriesLog::update(unsigned long now) {
+  if (!ready_ || !dirty_ || now - lastFlush_ < config::TIMESERIES_FLUSH_INTERVAL_MS) {
+    return;
+  }
+  flush();
+}
+
+bool TimeSeriesLog::flush() {
+  if (!ready_ || !dirty_) {
+    return true;
+  }
+  return saveOpenBlock();
+}
+
+void TimeSeriesLog::beginExport(ExportCursor &cursor, uint64_t fromMs, uint64_t toMs, ExportFormat format) const {
+  cursor = ExportCursor();
+  cursor.fromMs = fromMs;
+  cursor.toMs = toMs;
+  cursor.format = format;
+  // Until the open block closes, its segment file still holds the oldest segment of the ring.
+  const uint32_t current = currentSequence();
+  const uint32_t kept = static_cast<uint32_t>(
+      (current % SEGMENT_BLOCKS == 0 ? SERIES_LOG_SEGMENTS : SERIES_LOG_SEGMENTS - 1) * SEGMENT_BLOCKS);
+  cursor.nextSequence = segmentStart(current) >= kept ? segmentStart(current) - kept : 0;
+  cursor.finished = !ready_;
+}
+
+bool TimeSeriesLog::exportNext(ExportCursor &cursor, Print &out) {
+  if (cursor.finished) {
+    return false;
+  }
+  if (!cursor.headerWritten) {
+    cursor.headerWritten = true;
+    if (cursor.format == ExportFormat::Csv) {
+      out.write(reinterpret_cast<const uint8_t *>(CSV_HEADER), sizeof(CSV_HEADER) - 1);
+    } else {
+      uint8_t header[EXPORT_HEADER_BYTES];
+      memcpy(header, EXPORT_MAGIC, sizeof(EXPORT_MAGIC));
+      putLe(header + 4, config::TIMESERIES_BLOCK_BYTES, 2);
+      putLe(header + 6, 0, 2);
+      putLe(header + 8, cursor.fromMs, 8);
+      putLe(header + 16, cursor.toMs, 8);
+      out.write(header, sizeof(header));
+    }
+    return true;
+  }
+
+  File file;
+  size_t fileSegment = SERIES_LOG_SEGMENTS;
+  for (size_t skipped = 0; skipped < EXPORT_SKIPS_PER_CALL; ++skipped) {
+    const uint32_t current = currentSequence();
+    if (cursor.nextSequence > current) {
+      cursor.finished = true;
+      return false;
+    }
+    const uint32_t sequence = cursor.nextSequence++;
+
+    // The header check catches blocks of a segment that was reused since.
+    const uint8_t *block = writeBuffer_;
+    SeriesBlockHeader header = encoder_.header();
+    const size_t index = sequence % SEGMENT_BLOCKS;
+    if (sequence != current) {
+      const size_t segment = segmentOf(sequence);
+      if (segment != fileSegment) {
+        file.close();
+        fileSegment = segment;
+        if (index < segmentBlocks_[segment]) {
+          char path[SEGMENT_PATH_BYTES];
+          segmentPath(path, sizeof(path), segment);
+          file = LittleFS.open(path, "r");
+        }
+      }
+      if (!file || index >= segmentBlocks_[segment]) {
+        // Nothing more in this segment: go on with the next one, or the open block.
+        const uint32_t nextSegment = segmentStart(sequence) + SEGMENT_BLOCKS;
+        cursor.nextSequence = nextSegment < current ? nextSegment : current;
+        continue;
+      }
+      if (!readBlock(file, index, readBuffer_, SERIES_BLOCK_HEADER_BYTES) ||
+          !readBlockHeader(readBuffer_, config::TIMESERIES_BLOCK_BYTES, header) || header.sequence != sequence) {
+        continue;
+      }
+      block = readBuffer_;
+    }
+
+    if (header.count == 0 || header.lastTimestampMs < cursor.fromMs) {
+      continue;
+    }
+    if (header.firstTimestampMs > cursor.toMs) {
+      cursor.finished = true;
+      return false;
+    }
+    if (block == readBuffer_ && !readBlock(file, index, readBuffer_, header.usedBytes)) {
+      continue;
+    }
+
+    if (cursor.format == ExportFormat::Csv) {
+      cursor.points += writeCsvRows(block, header.usedBytes, cursor, out);
+    } else {
+      out.write(block, header.usedBytes);
+      cursor.points += header.count;
+    }
+    return true;
+  }
+  return true;
+}
+
+uint32_t TimeSeriesLog::writeCsvRows(const uint8_t *buffer, size_t length, const ExportCursor &cursor, Print &out) {
+  uint32_t rows = 0;
+  BlockDecoder decoder(buffer, length);
+  SeriesPoint point;
+  char row[64];
+  while (decoder.next(point)) {
+    if (point.timestampMs < cursor.fromMs || point.timestampMs > cursor.toMs) {
+      continue;
+    }
+    size_t n = static_cast<size_t>(snprintf(row, sizeof(row), "%lu.%03u,",
+                                            static_cast<unsigned long>(point.timestampMs / 1000ULL),
+                                            static_cast<unsigned>(point.timestampMs % 1000ULL)));
+    n += formatCenti(row + n, sizeof(row) - n, point.objectCenti);
+    row[n++] = ',';
+    n += formatCenti(row + n, sizeof(row) - n, point.ambientCenti);
+    n += static_cast<size_t>(snprintf(row + n, sizeof(row) - n, ",%u\n", static_cast<unsigned>(point.flags)));
+    out.write(reinterpret_cast<const uint8_t *>(row), n);
+    ++rows;
+  }
+  return rows;
+}
+
+String TimeSeriesLog::formatStats() const {
+  if (!ready_) {
+    return text::format(text::MessageId::SeriesLogOff);
+  }
+  String line = text::format(text::MessageId::SeriesLogStats, static_cast<unsigned long>(storedBlocks()),
+                             static_cast<unsigned long>(config::TIMESERIES_BLOCKS), pointsAppended_);
+  if (pointsAppended_ > 0) {
+    text::append(line, text::MessageId::SeriesLogPointSize,
+                 static_cast<float>(encodedBytes_) / static_cast<float>(pointsAppended_),
+                 static_cast<unsigned long>(RAW_POINT_BYTES));
+  }
+  text::append(line, text::MessageId::SeriesLogWrites, blockWrites_);
+  if (failedWrites_ > 0) {
+    text::append(line, text::MessageId::SeriesLogWriteErrors, failedWrites_);
+  }
+  return line;
+}
+
+// Appends the block to its segment; the first block of a segment truncates the
+// file, which drops the oldest segment of the ring.
+bool TimeSeriesLog::writeBlock(uint32_t sequence) {
+  lastFlush_ = millis();
+  dirty_ = false;
+  const size_t segment = segmentOf(sequence);
+  const size_t index = sequence % SEGMENT_BLOCKS;
+  char path[SEGMENT_PATH_BYTES];
+  segmentPath(path, sizeof(path), segment);
+  File file = LittleFS.open(path, index == 0 ? "w" : "a");
+  const bool ok = file && file.write(writeBuffer_, sizeof(writeBuffer_)) == sizeof(writeBuffer_);
+  if (file) {
+    file.close();
+  }
+  segmentBlocks_[segment] = static_cast<uint8_t>(ok ? index + 1 : index);
+  if (!ok) {
+    // Block offsets follow from the sequence, so the segment cannot take a
+    // later block after this one went missing: continue in the next segment.
+    nextSequence_ = segmentStart(sequence) + SEGMENT_BLOCKS;
+    ++failedWrites_;
+    return false;
+  }
+  ++blockWrites_;
+  return true;
+}
+
+// The partial block is rewritten whole in a one-block file of its own.
+bool TimeSeriesLog::saveOpenBlock() {
+  lastFlush_ = millis();
+  dirty_ = false;
+  File file = LittleFS.open(OPEN_BLOCK_PATH, "w");
+  const bool ok = file && file.write(writeBuffer_, sizeof(writeBuffer_)) == sizeof(writeBuffer_);
+  if (file) {
+    file.close();
+  }
+  if (!ok) {
+    ++failedWrites_;
+    return false;
+  }
+  ++blockWrites_;
+  return true;
+}
+
+// A partial block saved before the reset is closed as a short block, so its
+// points stay in the log. One already appended to its segment is stale.
+void TimeSeriesLog::recoverOpenBlock() {
+  File file = LittleFS.open(OPEN_BLOCK_PATH, "r");
+  if (!file) {
+    return;
+  }
+  SeriesBlockHeader header;
+  const bool pending = file.size() >= sizeof(writeBuffer_) && readBlock(file, 0, writeBuffer_, sizeof(writeBuffer_)) &&
+                       readBlockHeader(writeBuffer_, sizeof(writeBuffer_), header) && header.count > 0 &&
+                       header.sequence == nextSequence_;
+  file.close();
+  LittleFS.remove(OPEN_BLOCK_PATH);
+  if (pending && writeBlock(header.sequence)) {
+    nextSequence_ = header.sequence + 1;
+  }
+}
+
+size_t TimeSeriesLog::storedBlocks() const {
+  size_t blocks = 0;
+  for (uint8_t count : segmentBlocks_) {
+    blocks += count;
+  }
+  return blocks;
+}
+
+void TimeSeriesLog::startBlock() {
+  encoder_.begin(nextSequence_++);
+}
+
+}  // namespace timeseries
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "timeseries/SeriesCodec.h"
+
+namespace timeseries {
+
+constexpr size_t SERIES_LOG_SEGMENTS = config::TIMESERIES_BLOCKS / config::TIMESERIES_SEGMENT_BLOCKS;
+
+enum class ExportFormat : uint8_t {
+  Csv,
+  Binary,  // Export header followed by the raw codec blocks; see tools/tslog_decode.py
+};
+
+// Position of an export that is produced one block at a time. Blocks are
+// addressed by sequence number, so appends during the export do not shift it.
+struct ExportCursor {
+  uint64_t fromMs = 0;
+  uint64_t toMs = 0;
+  ExportFormat format = ExportFormat::Csv;
+  bool headerWritten = false;
+  bool finished = false;
+  uint32_t nextSequence = 0;
+  uint32_t points = 0;
+};
+
+// Append-only ring of fixed-size codec blocks, kept as SERIES_LOG_SEGMENTS small
+// LittleFS segment files of TIMESERIES_SEGMENT_BLOCKS blocks each. The open
+// block lives in RAM and is appended to its segment when it fills up; while
+// partially filled it is saved whole to a one-block file every
+// TIMESERIES_FLUSH_INTERVAL_MS. A file is only ever appended to or truncated
+// and rewritten from its start, never patched in the middle: LittleFS copies
+// everything after a patched offset. When the ring is full the oldest segment
+// is truncated and reused.
+class TimeSeriesLog {
+public:
+  TimeSeriesLog();
+
+  bool begin();
+  bool ready() const { return ready_; }
+
+  void append(const SeriesPoint &point);
+  void update(unsigned long now);
+  bool flush();
+
+  void beginExport(ExportCursor &cursor, uint64_t fromMs, uint64_t toMs, ExportFormat format) const;
+  // Writes the export header or the next block overlapping the range, reading
+  // flash one block at a time. Returns false once the export is complete.
+  bool exportNext(ExportCursor &cursor, Print &out);
+
+  String formatStats() const;
+
+private:
+  bool writeBlock(uint32_t sequence);
+  bool saveOpenBlock();
+  void recoverOpenBlock();
+  void startBlock();
+  uint32_t currentSequence() const { return encoder_.header().sequence; }
+  size_t storedBlocks() const;
+  static uint32_t writeCsvRows(const uint8_t *buffer, size_t length, const ExportCursor &cursor, Print &out);
+
+  uint8_t writeBuffer_[config::TIMESERIES_BLOCK_BYTES];
+  uint8_t readBuffer_[config::TIMESERIES_BLOCK_BYTES];
+  BlockEncoder encoder_;
+  bool ready_{false};
+  bool dirty_{false};
+  uint8_t segmentBlocks_[SERIES_LOG_SEGMENTS] = {};  // Complete blocks in each segment file
+  uint32_t nextSequence_{0};
+  unsigned long lastFlush_{0};
+  uint32_t pointsAppended_{0};
+  uint32_t blockWrites_{0};
+  uint32_t failedWrites_{0};
+  uint32_t encodedBytes_{0};
+};
+
+}  // namespace timeseries
@@ -0,0 +1,35 @@
+#include "timeseries/WallClock.h"
+
+#include <sys/time.h>
+#include <time.h>
+
+#include "config.h"
+
+namespace timeseries {
+namespace {
+constexpr time_t MIN_VALID_EPOCH_S = 1600000000;  // Anything earlier means SNTP has not answered yet
+bool started = false;
+}  // namespace
+
+void beginWallClock() {
+  if (started) {
+    return;
+  }
+  started = true;
+  configTime(0, 0, config::TIME_NTP_SERVER);
+}
+
+bool wallClockValid() {
+  return time(nullptr) >= MIN_VALID_EPOCH_S;
+}
+
+bool wallClockNowMs(uint64_t &epochMs) {
+  timeval tv;
+  if (gettimeofday(&tv, nullptr) != 0 || tv.tv_sec < MIN_VALID_EPOCH_S) {
+    return false;
+  }
+  epochMs = static_cast<uint64_t>(tv.tv_sec) * 1000ULL + static_cast<uint64_t>(tv.tv_usec / 1000);
+  return true;
+}
+
+}  // namespace timeseries
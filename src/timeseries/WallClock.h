@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace timeseries {
+
+// SNTP backed UTC clock; the flash log only records samples once it is set.
+void beginWallClock();
+bool wallClockValid();
+// Unix epoch milliseconds; returns false until the first SNTP sync.
+bool wallClockNowMs(uint64_t &epochMs);
+
+}  // namespace timeseries
@@ -0,0 +1,183 @@
+#include "trace/TraceFormat.h"
+
+#include <string.h>
+
+#include "stream/SampleFrame.h"
+
+namespace trace {
+namespace {
+constexpr size_t HEADER_BYTES = 5;  // type + uptime
+constexpr size_t SETTINGS_BYTES = 26;
+
+void putLe(uint8_t *out, uint32_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t getLe(const uint8_t *in, size_t bytes) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+void putFloat(uint8_t *out, float value) {
+  uint32_t bits = 0;
+  memcpy(&bits, &value, sizeof(bits));
+  putLe(out, bits, 4);
+}
+
+float getFloat(const uint8_t *in) {
+  const uint32_t bits = getLe(in, 4);
+  float value = 0.0f;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+size_t putSettings(uint8_t *out, const protection::ProtectionSettings &settings) {
+  putFloat(out, settings.minC);
+  putFloat(out + 4, settings.maxC);
+  putFloat(out + 8, settings.hysteresisC);
+  putLe(out + 12, settings.minSamples > 0xFFFF ? 0xFFFF : static_cast<uint32_t>(settings.minSamples), 2);
+  putLe(out + 14, static_cast<uint32_t>(settings.renotifyIntervalMs), 4);
+  putFloat(out + 18, settings.reportDeltaC);
+  putLe(out + 22, static_cast<uint32_t>(settings.reportMaxSilenceMs), 4);
+  return SETTINGS_BYTES;
+}
+
+void getSettings(const uint8_t *in, protection::ProtectionSettings &settings) {
+  settings.minC = getFloat(in);
+  settings.maxC = getFloat(in + 4);
+  settings.hysteresisC = getFloat(in + 8);
+  settings.minSamples = getLe(in + 12, 2);
+  settings.renotifyIntervalMs = getLe(in + 14, 4);
+  settings.reportDeltaC = getFloat(in + 18);
+  settings.reportMaxSilenceMs = getLe(in + 22, 4);
+}
+
+// Payload bytes after the common header, or 0 for an unknown type.
+size_t bodyLength(RecordType type, size_t textLength) {
+  switch (type) {
+    case RecordType::Boot:
+    case RecordType::Checkpoint:
+      return 2 + SETTINGS_BYTES;
+    case RecordType::Reading:
+      return 11;
+    case RecordType::Relays:
+      return 1;
+    case RecordType::Command:
+      return 2 + textLength;
+    case RecordType::Settings:
+      return SETTINGS_BYTES;
+    case RecordType::WindowReset:
+    case RecordType::SafeState:
+      return 0;
+  }
+  return 0;
+}
+
+bool knownType(uint8_t type) {
+  return type >= static_cast<uint8_t>(RecordType::Boot) && type <= static_cast<uint8_t>(RecordType::SafeState);
+}
+}  // namespace
+
+size_t encodeRecord(const TraceRecord &record, uint8_t *out) {
+  uint8_t payload[TRACE_PAYLOAD_MAX];
+  payload[0] = static_cast<uint8_t>(record.type);
+  putLe(payload + 1, record.uptimeMs, 4);
+  uint8_t *body = payload + HEADER_BYTES;
+  const size_t textLength = record.textLength > TRACE_COMMAND_MAX ? TRACE_COMMAND_MAX : record.textLength;
+
+  switch (record.type) {
+    case RecordType::Boot:
+    case RecordType::Checkpoint:
+      body[0] = TRACE_FORMAT_VERSION;
+      body[1] = record.flags;
+      putSettings(body + 2, record.settings);
+      break;
+    case RecordType::Reading:
+      putLe(body, record.intervalMs, 2);
+      putFloat(body + 2, record.ambientC);
+      putFloat(body + 6, record.objectC);
+      body[10] = record.flags;
+      break;
+    case RecordType::Relays:
+      body[0] = record.flags;
+      break;
+    case RecordType::Command:
+      body[0] = record.flags;
+      body[1] = static_cast<uint8_t>(textLength);
+      memcpy(body + 2, record.text, textLength);
+      break;
+    case RecordType::Settings:
+      putSettings(body, record.settings);
+      break;
+    case RecordType::WindowReset:
+    case RecordType::SafeState:
+      break;
+  }
+
+  const size_t dataLength = HEADER_BYTES + bodyLength(record.type, textLength);
+  putLe(payload + dataLength, stream::crc16Ccitt(payload, dataLength), 2);
+  const size_t length = stream::cobsEncode(payload, dataLength + 2, out);
+  out[length] = 0;
+  return length + 1;
+}
+
+bool decodeRecord(const uint8_t *frame, size_t length, TraceRecord &record) {
+  uint8_t payload[TRACE_PAYLOAD_MAX];
+  const size_t decoded = stream::cobsDecode(frame, length, payload, sizeof(payload));
+  if (decoded < HEADER_BYTES + 2 || !knownType(payload[0])) {
+    return false;
+  }
+  const size_t dataLength = decoded - 2;
+  if (getLe(payload + dataLength, 2) != stream::crc16Ccitt(payload, dataLength)) {
+    return false;
+  }
+  const RecordType type = static_cast<RecordType>(payload[0]);
+  const uint8_t *body = payload + HEADER_BYTES;
+  const size_t textLength = type == RecordType::Command && dataLength > HEADER_BYTES + 1 ? body[1] : 0;
+  if (textLength > TRACE_COMMAND_MAX || dataLength != HEADER_BYTES + bodyLength(type, textLength)) {
+    return false;
+  }
+
+  record = TraceRecord();
+  record.type = type;
+  record.uptimeMs = getLe(payload + 1, 4);
+  switch (type) {
+    case RecordType::Boot:
+    case RecordType::Checkpoint:
+      if (body[0] != TRACE_FORMAT_VERSION) {
+        return false;
+      }
+      record.flags = body[1];
+      getSettings(body + 2, record.settings);
+      break;
+    case RecordType::Reading:
+      record.intervalMs = static_cast<uint16_t>(getLe(body, 2));
+      record.ambientC = getFloat(body + 2);
+      record.objectC = getFloat(body + 6);
+      record.flags = body[10];
+      break;
+    case RecordType::Relays:
+      record.flags = body[0];
+      break;
+    case RecordType::Command:
+      record.flags = body[0];
+      record.textLength = static_cast<uint8_t>(textLength);
+      memcpy(record.text, body + 2, textLength);
+      record.text[textLength] = '\0';
+      break;
+    case RecordType::Settings:
+      getSettings(body, record.settings);
+      break;
+    case RecordType::WindowReset:
+    case RecordType::SafeState:
+      break;
+  }
+  return true;
+}
+
+}  // namespace trace
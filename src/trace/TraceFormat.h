@@ -0,0 +1,67 @@
+#pragma once
+
+// Decision trace records: what went into the protection logic (sensor reads,
+// report window resets, commands, watchdog resets) and what came out of it
+// (relay states, settings), so src/replay can rerun a field session on the
+// host. Framed like the serial sample stream: COBS, 0x00 delimiter, CRC-16.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protection/ProtectionSettings.h"
+
+namespace trace {
+
+constexpr uint8_t TRACE_FORMAT_VERSION = 1;
+constexpr size_t TRACE_COMMAND_MAX = 64;  // Longer command texts are cut and flagged
+constexpr size_t TRACE_PAYLOAD_MAX = 7 + TRACE_COMMAND_MAX + 2;
+constexpr size_t TRACE_FRAME_MAX_BYTES = TRACE_PAYLOAD_MAX + TRACE_PAYLOAD_MAX / 254 + 2;
+
+enum class RecordType : uint8_t {
+  Boot = 0x20,         // First record after a reset: settings, relays off
+  Checkpoint = 0x21,   // After a gap (rotation, trace off, failed write): settings and relay state
+  Reading = 0x22,      // One sensor read of the measurement path
+  WindowReset = 0x23,  // Report window closed, aggregators cleared
+  Relays = 0x24,       // Relay state changed
+  Command = 0x25,      // Command text as the processor got it
+  Settings = 0x26,     // Settings after a successful "set"
+  SafeState = 0x27,    // Loop watchdog forced the relays off
+};
+
+enum TraceFlags : uint8_t {
+  TRACE_HEATING = 0x01,
+  TRACE_COOLING = 0x02,
+  TRACE_READ_ERROR = 0x04,
+  TRACE_TRUNCATED = 0x08,  // Command text was cut at TRACE_COMMAND_MAX
+  TRACE_GAP = 0x10,        // Checkpoint: records before it were lost (trace off, clear, failed write)
+};
+
+struct TraceRecord {
+  RecordType type = RecordType::Reading;
+  uint32_t uptimeMs = 0;
+  uint8_t flags = 0;         // TraceFlags
+  uint16_t intervalMs = 0;   // Reading: sample weight
+  float ambientC = 0.0f;     // Reading: exact values handed to the aggregators
+  float objectC = 0.0f;
+  protection::ProtectionSettings settings{};  // Boot, Checkpoint, Settings
+  uint8_t textLength = 0;    // Command
+  char text[TRACE_COMMAND_MAX + 1] = {};
+};
+
+// Payload layout (little endian, floats as IEEE 754 bits), COBS encoded and
+// terminated by 0x00; every payload starts with u8 type, u32 uptimeMs and ends
+// with u16 CRC-16/CCITT-FALSE over the preceding bytes:
+//   Boot, Checkpoint  u8 version, u8 flags, settings
+//   Reading           u16 intervalMs, f32 ambient, f32 object, u8 flags
+//   Relays            u8 flags
+//   Command           u8 flags, u8 length, text
+//   Settings          settings
+//   WindowReset, SafeState  -
+// settings = f32 min, f32 max, f32 hysteresis, u16 minSamples, u32 renotifyMs,
+//            f32 reportDelta, u32 reportMaxSilenceMs
+// Returns the frame length including the delimiter; out needs TRACE_FRAME_MAX_BYTES.
+size_t encodeRecord(const TraceRecord &record, uint8_t *out);
+// Takes one frame without its delimiter; false on COBS, length, type, version or CRC errors.
+bool decodeRecord(const uint8_t *frame, size_t length, TraceRecord &record);
+
+}  // namespace trace
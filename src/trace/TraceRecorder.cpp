@@ -0,0 +1,263 @@
+#include "trace/TraceRecorder.h"
+
+#include <LittleFS.h>
+#include <string.h>
+
+#include "config.h"
+#include "logging/Log.h"
+#include "text/MessageCatalog.h"
+
+namespace trace {
+namespace {
+constexpr char TRACE_PATH[] = "/trace.bin";
+constexpr char TRACE_ROTATED_PATH[] = "/trace.1.bin";
+constexpr size_t EXPORT_PIECE_BYTES = 256;
+
+bool mounted = false;
+bool recording = false;
+TraceStats counters;
+
+uint8_t buffer[config::TRACE_BUFFER_BYTES];
+size_t buffered = 0;
+uint32_t bufferedRecords = 0;
+unsigned long lastFlushMs = 0;
+
+protection::ProtectionSettings currentSettings{};
+uint8_t relayFlags = 0;
+
+// A Checkpoint goes in front of the buffer on the next flush when the file has
+// a gap before it; it carries the state as of the first buffered record.
+bool resync = false;
+bool gap = false;  // Records were lost since the last successful write, not just a new file
+bool bufferStartsSession = false;
+unsigned long checkpointMs = 0;
+uint8_t checkpointFlags = 0;
+protection::ProtectionSettings checkpointSettings{};
+
+void append(const TraceRecord &record) {
+  if (!recording) {
+    return;
+  }
+  uint8_t frame[TRACE_FRAME_MAX_BYTES];
+  const size_t length = encodeRecord(record, frame);
+  if (buffered + length > sizeof(buffer)) {
+    flush();
+  }
+  if (buffered == 0) {
+    bufferStartsSession = record.type == RecordType::Boot;
+    checkpointMs = record.uptimeMs;
+    checkpointFlags = relayFlags;
+    checkpointSettings = currentSettings;
+  }
+  memcpy(buffer + buffered, frame, length);
+  buffered += length;
+  ++bufferedRecords;
+}
+
+bool writeCheckpoint(File &file) {
+  TraceRecord checkpoint;
+  checkpoint.type = RecordType::Checkpoint;
+  checkpoint.uptimeMs = static_cast<uint32_t>(checkpointMs);
+  checkpoint.flags = checkpointFlags | (gap ? TRACE_GAP : 0);
+  checkpoint.settings = checkpointSettings;
+  // Leading delimiter: ends a frame a failed write may have cut short.
+  uint8_t frame[TRACE_FRAME_MAX_BYTES + 1];
+  frame[0] = 0;
+  const size_t length = encodeRecord(checkpoint, frame + 1) + 1;
+  if (file.write(frame, length) != length) {
+    return false;
+  }
+  ++counters.records;
+  counters.bytes += length;
+  return true;
+}
+}  // namespace
+
+bool begin(unsigned long now, const protection::ProtectionSettings &settings) {
+  if (!config::ENABLE_TRACE_RECORDER) {
+    return false;
+  }
+  if (!LittleFS.begin()) {
+    LOG_ERROR("LittleFS baglanamadi; karar kaydi kapali.");
+    return false;
+  }
+  mounted = true;
+  recording = true;
+  currentSettings = settings;
+  relayFlags = 0;
+
+  TraceRecord boot;
+  boot.type = RecordType::Boot;
+  boot.uptimeMs = static_cast<uint32_t>(now);
+  boot.settings = settings;
+  append(boot);
+  return flush();
+}
+
+void setActive(bool value) {
+  if (!mounted || value == recording) {
+    return;
+  }
+  if (value) {
+    recording = true;
+    resync = true;
+    gap = true;
+    return;
+  }
+  flush();
+  recording = false;
+}
+
+bool active() { return recording; }
+
+void update(unsigned long now) {
+  if (buffered > 0 && now - lastFlushMs >= config::TRACE_FLUSH_INTERVAL_MS) {
+    flush();
+  }
+}
+
+bool flush() {
+  if (!mounted || buffered == 0) {
+    return true;
+  }
+  File file = LittleFS.open(TRACE_PATH, "a");
+  if (file && file.size() >= config::TRACE_FILE_MAX_BYTES) {
+    file.close();
+    LittleFS.remove(TRACE_ROTATED_PATH);
+    LittleFS.rename(TRACE_PATH, TRACE_ROTATED_PATH);
+    file = LittleFS.open(TRACE_PATH, "a");
+    ++counters.rotations;
+    resync = true;
+  }
+  bool written = static_cast<bool>(file);
+  if (written && resync && !bufferStartsSession) {
+    written = writeCheckpoint(file);
+  }
+  if (written) {
+    written = file.write(buffer, buffered) == buffered;
+  }
+  if (file) {
+    file.close();
+  }
+
+  if (written) {
+    counters.records += bufferedRecords;
+    counters.bytes += buffered;
+    resync = false;
+    gap = false;
+  } else {
+    counters.dropped += bufferedRecords;
+    resync = true;
+    gap = true;
+  }
+  ++counters.flushes;
+  buffered = 0;
+  bufferedRecords = 0;
+  lastFlushMs = millis();
+  return written;
+}
+
+void clear() {
+  buffered = 0;
+  bufferedRecords = 0;
+  if (mounted) {
+    LittleFS.remove(TRACE_PATH);
+    LittleFS.remove(TRACE_ROTATED_PATH);
+  }
+  counters = TraceStats();
+  resync = true;
+  gap = true;
+}
+
+void recordReading(unsigned long now, unsigned long weightMs, bool readOk, float ambientC, float objectC) {
+  TraceRecord record;
+  record.type = RecordType::Reading;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  record.intervalMs = static_cast<uint16_t>(weightMs > 0xFFFF ? 0xFFFF : weightMs);
+  record.ambientC = readOk ? ambientC : 0.0f;
+  record.objectC = readOk ? objectC : 0.0f;
+  record.flags = readOk ? 0 : TRACE_READ_ERROR;
+  append(record);
+}
+
+void recordWindowReset(unsigned long now) {
+  TraceRecord record;
+  record.type = RecordType::WindowReset;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  append(record);
+}
+
+void recordRelays(unsigned long now, bool heating, bool cooling) {
+  const uint8_t flags = (heating ? TRACE_HEATING : 0) | (cooling ? TRACE_COOLING : 0);
+  if (flags == relayFlags) {
+    return;
+  }
+  TraceRecord record;
+  record.type = RecordType::Relays;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  record.flags = flags;
+  append(record);
+  relayFlags = flags;
+  flush();
+}
+
+void recordCommand(unsigned long now, const String &text) {
+  TraceRecord record;
+  record.type = RecordType::Command;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  const size_t length = text.length() > TRACE_COMMAND_MAX ? TRACE_COMMAND_MAX : text.length();
+  record.flags = length < text.length() ? TRACE_TRUNCATED : 0;
+  record.textLength = static_cast<uint8_t>(length);
+  memcpy(record.text, text.c_str(), length);
+  append(record);
+  flush();
+}
+
+void recordSettings(unsigned long now, const protection::ProtectionSettings &settings) {
+  TraceRecord record;
+  record.type = RecordType::Settings;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  record.settings = settings;
+  append(record);
+  currentSettings = settings;
+  flush();
+}
+
+void recordSafeState(unsigned long now) {
+  TraceRecord record;
+  record.type = RecordType::SafeState;
+  record.uptimeMs = static_cast<uint32_t>(now);
+  append(record);
+  flush();
+}
+
+bool exportNext(ExportCursor &cursor, Print &out) {
+  while (cursor.file < 2) {
+    const char *path = cursor.file == 0 ? TRACE_ROTATED_PATH : TRACE_PATH;
+    if (mounted && LittleFS.exists(path)) {
+      File file = LittleFS.open(path, "r");
+      uint8_t piece[EXPORT_PIECE_BYTES];
+      const int length = file && file.seek(cursor.offset) ? file.read(piece, sizeof(piece)) : 0;
+      if (length > 0) {
+        out.write(piece, static_cast<size_t>(length));
+        cursor.offset += static_cast<uint32_t>(length);
+        return true;
+      }
+    }
+    ++cursor.file;
+    cursor.offset = 0;
+  }
+  return false;
+}
+
+const TraceStats &stats() { return counters; }
+
+String formatStats() {
+  const text::Arg args[] = {recording ? text::MessageId::StateOn : text::MessageId::StateOff,
+                            counters.records, counters.bytes, buffered, counters.dropped, counters.rotations};
+  String message;
+  text::append(message, text::MessageId::TraceStats, args, sizeof(args) / sizeof(args[0]));
+  return message;
+}
+
+}  // namespace trace
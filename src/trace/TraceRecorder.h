@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "protection/ProtectionSettings.h"
+#include "trace/TraceFormat.h"
+
+namespace trace {
+
+struct TraceStats {
+  uint32_t records = 0;    // Records written to flash
+  uint32_t bytes = 0;
+  uint32_t dropped = 0;    // Lost to a failed flash write
+  uint32_t rotations = 0;
+  uint32_t flushes = 0;
+};
+
+// Walks /trace.1.bin, then /trace.bin.
+struct ExportCursor {
+  uint8_t file = 0;
+  uint32_t offset = 0;
+};
+
+// Decision trace on LittleFS (/trace.bin, rotated to /trace.1.bin; format in
+// TraceFormat.h). Records collect in a RAM buffer; relay changes, commands,
+// settings and watchdog resets are written at once, readings when the buffer
+// fills or TRACE_FLUSH_INTERVAL_MS passed. After any gap in the file a
+// Checkpoint record lets the replay pick the session up again.
+bool begin(unsigned long now, const protection::ProtectionSettings &settings);
+void setActive(bool active);
+bool active();
+void update(unsigned long now);
+bool flush();
+void clear();
+
+void recordReading(unsigned long now, unsigned long weightMs, bool readOk, float ambientC, float objectC);
+void recordWindowReset(unsigned long now);
+// Writes a record only when the state differs from the last one recorded.
+void recordRelays(unsigned long now, bool heating, bool cooling);
+void recordCommand(unsigned long now, const String &text);
+void recordSettings(unsigned long now, const protection::ProtectionSettings &settings);
+void recordSafeState(unsigned long now);
+
+// Streams both files, oldest first, in pieces; returns false once done.
+bool exportNext(ExportCursor &cursor, Print &out);
+
+const TraceStats &stats();
+String formatStats();
+
+}  // namespace trace
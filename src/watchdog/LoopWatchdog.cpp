@@ -0,0 +1,108 @@
+#include "watchdog/LoopWatchdog.h"
+
+#include "config.h"
+#include "text/MessageCatalog.h"
+
+namespace watchdog {
+namespace {
+constexpr uint32_t TIMER1_TICKS_PER_MS = 80000000UL / 256UL / 1000UL;  // APB clock with TIM_DIV256
+static_assert(config::LOOP_STALL_BUDGET_MS > config::MEASUREMENT_INTERVAL_MAX_MS,
+              "a healthy loop feeds once per measurement; the budget must cover the longest interval");
+
+protection::ProtectionController *protectionTarget = nullptr;
+volatile uint32_t lastProgressMs = 0;
+volatile uint8_t currentStage = static_cast<uint8_t>(profiling::Stage::Loop);
+volatile uint8_t trippedStage = static_cast<uint8_t>(profiling::Stage::Loop);
+volatile bool tripped = false;
+volatile bool armed = false;
+
+bool eventPending = false;
+StallEvent pendingEvent;
+StallEvent lastEvent;
+uint32_t stalls = 0;
+
+void IRAM_ATTR onTimer() {
+  if (!armed || tripped) {
+    return;
+  }
+  if (millis() - lastProgressMs < config::LOOP_STALL_BUDGET_MS) {
+    return;
+  }
+  // With both relays off there is nothing to take to a safe state; a slow
+  // loop only counts once it leaves a relay unsupervised.
+  if (!protectionTarget || (!protectionTarget->heatingActive() && !protectionTarget->coolingActive())) {
+    return;
+  }
+  tripped = true;
+  trippedStage = currentStage;
+  protectionTarget->forceSafeState();
+}
+}  // namespace
+
+void begin(protection::ProtectionController &protection) {
+  if (!config::ENABLE_LOOP_WATCHDOG) {
+    return;
+  }
+  protectionTarget = &protection;
+  lastProgressMs = millis();
+  timer1_isr_init();
+  timer1_attachInterrupt(onTimer);
+  timer1_enable(TIM_DIV256, TIM_EDGE, TIM_LOOP);
+  timer1_write(config::LOOP_WATCHDOG_TICK_MS * TIMER1_TICKS_PER_MS);
+  armed = true;
+}
+
+void feed() {
+  if (!config::ENABLE_LOOP_WATCHDOG) {
+    return;
+  }
+  const uint32_t now = millis();
+  if (tripped) {
+    pendingEvent.stage = static_cast<profiling::Stage>(trippedStage);
+    pendingEvent.stalledMs = now - lastProgressMs;
+    eventPending = true;
+    ++stalls;
+    lastEvent = pendingEvent;
+    tripped = false;
+  }
+  lastProgressMs = now;
+}
+
+bool takePendingEvent(StallEvent &event) {
+  if (!eventPending) {
+    return false;
+  }
+  event = pendingEvent;
+  eventPending = false;
+  return true;
+}
+
+uint32_t stallCount() {
+  return stalls;
+}
+
+String formatEvent(const StallEvent &event) {
+  return text::format(text::MessageId::StallAlert, event.stalledMs, profiling::stageName(event.stage));
+}
+
+String formatReport() {
+  if (!config::ENABLE_LOOP_WATCHDOG) {
+    return text::format(text::MessageId::StallWatchDisabled);
+  }
+  String message = text::format(text::MessageId::StallStats, stalls, config::LOOP_STALL_BUDGET_MS);
+  if (stalls > 0) {
+    text::append(message, text::MessageId::StallStatsLast, profiling::stageName(lastEvent.stage),
+                 lastEvent.stalledMs);
+  }
+  return message;
+}
+
+StageGuard::StageGuard(profiling::Stage stage) : previous_(static_cast<profiling::Stage>(currentStage)) {
+  currentStage = static_cast<uint8_t>(stage);
+}
+
+StageGuard::~StageGuard() {
+  currentStage = static_cast<uint8_t>(previous_);
+}
+
+}  // namespace watchdog
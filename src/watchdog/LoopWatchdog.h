@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "profiling/StageProfiler.h"
+#include "protection/ProtectionController.h"
+
+namespace watchdog {
+
+struct StallEvent {
+  profiling::Stage stage = profiling::Stage::Loop;
+  unsigned long stalledMs = 0;
+};
+
+// Arms a timer1 interrupt that forces both relays off when loop() stops making
+// progress for longer than config::LOOP_STALL_BUDGET_MS.
+void begin(protection::ProtectionController &protection);
+// Progress means protection evaluated a fresh sample: call it right after
+// handleProtection(), never just for passing through loop().
+void feed();
+bool takePendingEvent(StallEvent &event);
+uint32_t stallCount();
+String formatEvent(const StallEvent &event);
+String formatReport();
+
+// Names the stage a stall is reported against; it does not count as progress.
+class StageGuard {
+public:
+  explicit StageGuard(profiling::Stage stage);
+  ~StageGuard();
+
+  StageGuard(const StageGuard &) = delete;
+  StageGuard &operator=(const StageGuard &) = delete;
+
+private:
+  profiling::Stage previous_;
+};
+
+}  // namespace watchdog
@@ -0,0 +1,332 @@
+// Every command and every "set" key through TelegramCommandProcessor, table by
+// table: accepted input, rejected input and the EEPROM save/rollback path.
+//   pio test -e native_test -f test_commands
+
+#include <Arduino.h>
+#include <NativeHost.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "config.h"
+#include "fleet/FleetNode.h"
+#include "history/HistoryStore.h"
+#include "mqtt/MqttService.h"
+#include "notify/NotificationBus.h"
+#include "profiling/HeapMonitor.h"
+#include "profiling/StageProfiler.h"
+#include "protection/ProtectionController.h"
+#include "protection/ProtectionStorage.h"
+#include "stream/SampleStream.h"
+#include "telegram/TelegramCommandProcessor.h"
+#include "telegram/TelegramService.h"
+#include "text/MessageCatalog.h"
+#include "timeseries/TimeSeriesLog.h"
+#include "trace/TraceRecorder.h"
+
+using text::MessageId;
+
+namespace {
+constexpr unsigned long NOW_MS = 120000;
+constexpr size_t MAX_REPLIES = 4;
+
+const protection::ProtectionSettings DEFAULT_SETTINGS{
+    config::OBJECT_TEMP_MIN_C,
+    config::OBJECT_TEMP_MAX_C,
+    config::OBJECT_TEMP_HYSTERESIS_C,
+    config::PROTECTION_MIN_SAMPLES,
+    config::PROTECTION_RENOTIFY_INTERVAL_MS,
+    config::TELEGRAM_REPORT_DEADBAND_C,
+    config::TELEGRAM_REPORT_MAX_SILENCE_MS,
+};
+
+// Same object graph as main.cpp, without the network, sensor and storage begin() calls.
+protection::ProtectionController protectionController(DEFAULT_SETTINGS);
+protection::ProtectionSettingsStorage protectionStorage;
+profiling::HeapMonitor heapMonitor;
+history::HistoryStore historyStore;
+timeseries::TimeSeriesLog timeSeriesLog;
+telegram::TelegramService telegramService;
+mqtt::MqttService mqttService;
+notify::NotificationBus notificationBus;
+fleet::FleetNode fleetNode(notificationBus, telegramService);
+telegram::TelegramCommandProcessor commandProcessor(protectionController, protectionStorage, telegramService,
+                                                    heapMonitor, historyStore, timeSeriesLog, mqttService,
+                                                    notificationBus, fleetNode);
+sensor::MeasurementStats objectStats;
+char stateDirectory[64];
+
+struct Replies {
+  String text[MAX_REPLIES];
+  size_t count = 0;
+};
+
+void collectReply(const String &text, void *context) {
+  Replies &replies = *static_cast<Replies *>(context);
+  if (replies.count < MAX_REPLIES) {
+    replies.text[replies.count] = text;
+  }
+  ++replies.count;
+}
+
+Replies run(const char *command) {
+  Replies replies;
+  commandProcessor.processCommand(String(command), NOW_MS, objectStats, collectReply, &replies);
+  return replies;
+}
+
+String expected(MessageId id, text::Arg a0 = text::Arg(), text::Arg a1 = text::Arg(), text::Arg a2 = text::Arg(),
+                text::Arg a3 = text::Arg()) {
+  return text::format(id, a0, a1, a2, a3);
+}
+
+void assertSingleReply(const char *command, const Replies &replies, const String &want) {
+  TEST_ASSERT_EQUAL_MESSAGE(1, replies.count, command);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE(want.c_str(), replies.text[0].c_str(), command);
+}
+
+bool sameSettings(const protection::ProtectionSettings &a, const protection::ProtectionSettings &b) {
+  return a.minC == b.minC && a.maxC == b.maxC && a.hysteresisC == b.hysteresisC && a.minSamples == b.minSamples &&
+         a.renotifyIntervalMs == b.renotifyIntervalMs && a.reportDeltaC == b.reportDeltaC &&
+         a.reportMaxSilenceMs == b.reportMaxSilenceMs;
+}
+
+// --- Commands ---------------------------------------------------------------------
+
+// Commands answered with a report: the reply must start with the report's own text.
+struct ReportCase {
+  const char *command;
+  String (*report)();
+};
+
+const ReportCase REPORT_CASES[] = {
+    {"config", [] { return protectionController.formatProtectionConfig(); }},
+    {"CONFIG", [] { return protectionController.formatProtectionConfig(); }},
+    {"  config  ", [] { return protectionController.formatProtectionConfig(); }},
+    {"heap", [] { return heapMonitor.formatReport(); }},
+    {"stats", [] { return profiling::formatReport(); }},
+    {"history", [] { return historyStore.formatTable(config::HISTORY_DEFAULT_RANGE_MS, NOW_MS); }},
+    {"history 30m", [] { return historyStore.formatTable(30UL * 60000UL, NOW_MS); }},
+    {"history 2h", [] { return historyStore.formatTable(2UL * 3600000UL, NOW_MS); }},
+    {"history 2d", [] { return historyStore.formatTable(2UL * 86400000UL, NOW_MS); }},
+    {"stream", [] { return stream::formatStats(); }},
+    {"stream off", [] { return stream::formatStats(); }},
+    {"trace", [] { return trace::formatStats(); }},
+    {"trace off", [] { return trace::formatStats(); }},
+};
+
+// Commands answered with one catalog message.
+struct MessageCase {
+  const char *command;
+  MessageId reply;
+  text::Arg arg;
+};
+
+const MessageCase MESSAGE_CASES[] = {
+    {"durum", MessageId::UnknownCommand, MessageId::Usage},
+    {"config now", MessageId::UnknownCommand, MessageId::Usage},  // Takes no arguments
+    {"heap 1", MessageId::UnknownCommand, MessageId::Usage},
+    {"configs", MessageId::UnknownCommand, MessageId::Usage},
+    {"history 5x", MessageId::InvalidHistoryRange, text::Arg()},
+    {"history 0", MessageId::InvalidHistoryRange, text::Arg()},
+    {"export", MessageId::InvalidExportRange, text::Arg()},
+    {"export soon", MessageId::InvalidExportRange, text::Arg()},
+    {"export 6h pdf", MessageId::InvalidExportFormat, text::Arg()},
+    {"export 6h csv more", MessageId::InvalidExportFormat, text::Arg()},
+    {"export 30m", MessageId::TelegramOnly, "export"},  // Documents need the Telegram channel
+    {"export 6h csv", MessageId::TelegramOnly, "export"},
+    {"export 3d bin", MessageId::TelegramOnly, "export"},
+    {"stream maybe", MessageId::UsageHint, MessageId::SyntaxStream},
+    {"stream on now", MessageId::UsageHint, MessageId::SyntaxStream},
+    {"trace maybe", MessageId::UsageHint, MessageId::SyntaxTrace},
+    {"trace on now", MessageId::UsageHint, MessageId::SyntaxTrace},
+    {"trace export", MessageId::TelegramOnly, "trace export"},
+    {"fleet", MessageId::FleetDisabled, text::Arg()},
+    {"@", MessageId::UsageHint, MessageId::SyntaxRoute},
+    {"@node", MessageId::UsageHint, MessageId::SyntaxRoute},
+    {"@node config", MessageId::TelegramOnly, MessageId::RemoteCommands},
+    {"set", MessageId::SetMissingParameter, text::Arg()},
+    {"set min", MessageId::SetMissingParameter, text::Arg()},
+    {"set color 3", MessageId::SetUnknownKey, text::Arg()},
+    {"set min 29.5", MessageId::SettingsIncompatible, text::Arg()},  // Band narrower than the hysteresis
+};
+
+void test_report_commands() {
+  for (const ReportCase &row : REPORT_CASES) {
+    const Replies replies = run(row.command);
+    const String want = row.report();
+    TEST_ASSERT_EQUAL_MESSAGE(1, replies.count, row.command);
+    TEST_ASSERT_TRUE_MESSAGE(want.length() > 0, row.command);
+    TEST_ASSERT_TRUE_MESSAGE(replies.text[0].startsWith(want.substring(0, want.indexOf('\n'))), row.command);
+  }
+}
+
+void test_message_commands() {
+  for (const MessageCase &row : MESSAGE_CASES) {
+    assertSingleReply(row.command, run(row.command), expected(row.reply, row.arg));
+  }
+}
+
+// Toggles reply with the new state and leave it switched.
+void test_toggle_commands() {
+  run("stream on");
+  TEST_ASSERT_TRUE_MESSAGE(stream::active(), "stream on");
+  run("stream off");
+  TEST_ASSERT_FALSE_MESSAGE(stream::active(), "stream off");
+  run("trace off");
+  TEST_ASSERT_FALSE_MESSAGE(trace::active(), "trace off");
+}
+
+void test_empty_command_is_ignored() {
+  TEST_ASSERT_EQUAL_MESSAGE(0, run("").count, "empty");
+  TEST_ASSERT_EQUAL_MESSAGE(0, run("   ").count, "blank");
+}
+
+void test_command_changes_no_settings() {
+  for (const MessageCase &row : MESSAGE_CASES) {
+    run(row.command);
+    TEST_ASSERT_TRUE_MESSAGE(sameSettings(DEFAULT_SETTINGS, protectionController.settings()), row.command);
+  }
+}
+
+// --- Settings ---------------------------------------------------------------------
+
+struct SettingCase {
+  const char *key;
+  MessageId label;
+  MessageId unit;
+  const char *accepted;  // Applied and saved
+  text::Arg shown;       // As the reply prints it back
+  float stored;          // Settings field afterwards, in its own unit
+  const char *malformed;
+  MessageId malformedReply;
+  const char *refused;   // Well formed, out of the setting's range
+  MessageId refusedReply;
+  text::Arg refusedArgs[4];
+  float (*field)(const protection::ProtectionSettings &settings);
+};
+
+const SettingCase SETTING_CASES[] = {
+    {"min", MessageId::LabelMin, MessageId::UnitCelsius, "22.5", 22.5f, 22.5f,
+     "22,5", MessageId::InvalidDecimal, "30", MessageId::MinNotBelowMax, {},
+     [](const protection::ProtectionSettings &s) { return s.minC; }},
+    {"max", MessageId::LabelMax, MessageId::UnitCelsius, "28", 28.0f, 28.0f,
+     "28C", MessageId::InvalidDecimal, "20", MessageId::MaxNotAboveMin, {},
+     [](const protection::ProtectionSettings &s) { return s.maxC; }},
+    {"hysteresis", MessageId::LabelHysteresis, MessageId::UnitCelsius, "1.5", 1.5f, 1.5f,
+     "1.5.0", MessageId::InvalidDecimal, "0", MessageId::HysteresisOutOfRange, {},
+     [](const protection::ProtectionSettings &s) { return s.hysteresisC; }},
+    {"minsamples", MessageId::LabelMinSamples, MessageId::UnitNone, "8", 8L, 8.0f,
+     "8.5", MessageId::InvalidInteger, "0", MessageId::OutOfRange, {"minsamples", 1, 3600, MessageId::UnitNone},
+     [](const protection::ProtectionSettings &s) { return static_cast<float>(s.minSamples); }},
+    {"renotify", MessageId::LabelRenotify, MessageId::UnitSeconds, "300", 300L, 300000.0f,
+     "-300", MessageId::InvalidInteger, "5", MessageId::OutOfRange, {"renotify", 10, 86400, MessageId::UnitSeconds},
+     [](const protection::ProtectionSettings &s) { return static_cast<float>(s.renotifyIntervalMs); }},
+    {"deadband", MessageId::LabelDeadband, MessageId::UnitCelsius, "0.25", 0.25f, 0.25f,
+     ".", MessageId::InvalidDecimal, "10.5", MessageId::DeadbandOutOfRange, {},
+     [](const protection::ProtectionSettings &s) { return s.reportDeltaC; }},
+    {"silence", MessageId::LabelSilence, MessageId::UnitSeconds, "900", 900L, 900000.0f,
+     "15m", MessageId::InvalidInteger, "10", MessageId::OutOfRange,
+     {"silence", config::TELEGRAM_REPORT_INTERVAL_MS / 1000UL, 86400, MessageId::UnitSeconds},
+     [](const protection::ProtectionSettings &s) { return static_cast<float>(s.reportMaxSilenceMs); }},
+};
+
+String setCommand(const SettingCase &row, const char *value) {
+  String command(F("set "));
+  command += row.key;
+  command += ' ';
+  command += value;
+  return command;
+}
+
+void test_set_accepts_and_saves() {
+  for (const SettingCase &row : SETTING_CASES) {
+    protectionController.applySettings(DEFAULT_SETTINGS);
+    const String command = setCommand(row, row.accepted);
+    const Replies replies = run(command.c_str());
+    const String updated = expected(MessageId::SettingUpdated, row.label, row.shown, row.unit, MessageId::SettingSaved);
+    const String listing = protectionController.formatProtectionConfig();
+    TEST_ASSERT_EQUAL_MESSAGE(2, replies.count, command.c_str());
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(updated.c_str(), replies.text[0].c_str(), command.c_str());
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(listing.c_str(), replies.text[1].c_str(), command.c_str());
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(row.stored, row.field(protectionController.settings()), command.c_str());
+
+    // What a reboot would load
+    protection::ProtectionSettings loaded = DEFAULT_SETTINGS;
+    TEST_ASSERT_TRUE_MESSAGE(protectionStorage.load(loaded), command.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(sameSettings(protectionController.settings(), loaded), command.c_str());
+  }
+}
+
+void test_set_key_is_case_insensitive() {
+  const Replies replies = run("SET Min 22.5");
+  TEST_ASSERT_EQUAL_MESSAGE(2, replies.count, "SET Min 22.5");
+  TEST_ASSERT_EQUAL_FLOAT(22.5f, protectionController.settings().minC);
+}
+
+void test_set_rejects_malformed_values() {
+  for (const SettingCase &row : SETTING_CASES) {
+    const String command = setCommand(row, row.malformed);
+    assertSingleReply(command.c_str(), run(command.c_str()), expected(row.malformedReply));
+    TEST_ASSERT_TRUE_MESSAGE(sameSettings(DEFAULT_SETTINGS, protectionController.settings()), command.c_str());
+  }
+}
+
+void test_set_rejects_out_of_range_values() {
+  for (const SettingCase &row : SETTING_CASES) {
+    const String command = setCommand(row, row.refused);
+    assertSingleReply(command.c_str(), run(command.c_str()),
+                      expected(row.refusedReply, row.refusedArgs[0], row.refusedArgs[1], row.refusedArgs[2],
+                               row.refusedArgs[3]));
+    TEST_ASSERT_TRUE_MESSAGE(sameSettings(DEFAULT_SETTINGS, protectionController.settings()), command.c_str());
+  }
+}
+
+// A failed EEPROM commit keeps the old settings in RAM and says so.
+void test_set_rolls_back_when_save_fails() {
+  char unwritable[96];
+  snprintf(unwritable, sizeof(unwritable), "%s/missing/state", stateDirectory);
+  for (const SettingCase &row : SETTING_CASES) {
+    protectionController.applySettings(DEFAULT_SETTINGS);
+    native::setStateDirectory(unwritable);
+    const String command = setCommand(row, row.accepted);
+    const Replies replies = run(command.c_str());
+    native::setStateDirectory(stateDirectory);
+    const String updated =
+        expected(MessageId::SettingUpdated, row.label, row.shown, row.unit, MessageId::SettingNotSaved);
+    TEST_ASSERT_EQUAL_MESSAGE(2, replies.count, command.c_str());
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(updated.c_str(), replies.text[0].c_str(), command.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(sameSettings(DEFAULT_SETTINGS, protectionController.settings()), command.c_str());
+  }
+}
+}  // namespace
+
+void setUp() {
+  snprintf(stateDirectory, sizeof(stateDirectory), "/tmp/tastan09-test-XXXXXX");
+  TEST_ASSERT_NOT_NULL_MESSAGE(mkdtemp(stateDirectory), "state directory");
+  native::setStateDirectory(stateDirectory);
+  protectionController.applySettings(DEFAULT_SETTINGS);
+}
+
+void tearDown() {
+  char command[96];
+  snprintf(command, sizeof(command), "rm -rf %s", stateDirectory);
+  system(command);
+}
+
+int main(int, char **) {
+  native::useVirtualClock(true);
+  native::setMillis(NOW_MS);
+  protectionController.initializeHardware();
+  UNITY_BEGIN();
+  RUN_TEST(test_report_commands);
+  RUN_TEST(test_message_commands);
+  RUN_TEST(test_toggle_commands);
+  RUN_TEST(test_empty_command_is_ignored);
+  RUN_TEST(test_command_changes_no_settings);
+  RUN_TEST(test_set_accepts_and_saves);
+  RUN_TEST(test_set_key_is_case_insensitive);
+  RUN_TEST(test_set_rejects_malformed_values);
+  RUN_TEST(test_set_rejects_out_of_range_values);
+  RUN_TEST(test_set_rolls_back_when_save_fails);
+  return UNITY_END();
+}
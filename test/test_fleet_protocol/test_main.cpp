@@ -0,0 +1,100 @@
+// Fleet datagram signing on the host: the SipHash reference vector, and tags
+// that reject a changed byte, another key and a cut datagram.
+//   pio test -e native_test -f test_fleet_protocol
+
+#include <string.h>
+#include <unity.h>
+
+#include "fleet/FleetProtocol.h"
+
+namespace {
+const fleet::FleetKey KEY = fleet::keyFor("depo-anahtari");
+
+size_t sealedCommand(const fleet::FleetKey &key, uint8_t *out, size_t capacity) {
+  fleet::Header header;
+  header.type = fleet::MessageType::Command;
+  header.nodeId = fleet::nodeIdFor("gecit");
+  header.session = 0x1234;
+  fleet::Command body;
+  body.targetId = fleet::nodeIdFor("depo2");
+  body.commandId = 7;
+  body.text = "set max 28";
+  body.length = static_cast<uint16_t>(strlen(body.text));
+  const size_t length = fleet::encode(header, body, out, capacity - fleet::FLEET_TAG_BYTES);
+  return fleet::seal(key, out, length, capacity);
+}
+
+// SipHash-2-4 paper, appendix A: key 00..0f, message 00..0e.
+void test_siphash_reference_vector() {
+  fleet::FleetKey key;
+  key.k0 = 0x0706050403020100ULL;
+  key.k1 = 0x0F0E0D0C0B0A0908ULL;
+  uint8_t message[15];
+  for (uint8_t i = 0; i < sizeof(message); ++i) {
+    message[i] = i;
+  }
+  TEST_ASSERT_TRUE(fleet::sipHash(key, message, sizeof(message)) == 0xA129CA6149BE45E5ULL);
+}
+
+void test_sealed_datagram_round_trips() {
+  uint8_t datagram[fleet::FLEET_DATAGRAM_MAX];
+  const size_t length = sealedCommand(KEY, datagram, sizeof(datagram));
+  TEST_ASSERT_TRUE(length > fleet::FLEET_TAG_BYTES);
+  const size_t body = fleet::unseal(KEY, datagram, length);
+  TEST_ASSERT_EQUAL(length - fleet::FLEET_TAG_BYTES, body);
+
+  fleet::Header header;
+  fleet::Command command;
+  TEST_ASSERT_TRUE(fleet::parseHeader(datagram, body, header));
+  TEST_ASSERT_TRUE(fleet::parse(datagram, body, command));
+  TEST_ASSERT_EQUAL(7, command.commandId);
+  TEST_ASSERT_EQUAL(10, command.length);
+}
+
+void test_every_changed_byte_is_rejected() {
+  uint8_t datagram[fleet::FLEET_DATAGRAM_MAX];
+  const size_t length = sealedCommand(KEY, datagram, sizeof(datagram));
+  for (size_t i = 0; i < length; ++i) {
+    datagram[i] ^= 0x01;
+    TEST_ASSERT_EQUAL(0, fleet::unseal(KEY, datagram, length));
+    datagram[i] ^= 0x01;
+  }
+}
+
+void test_other_key_is_rejected() {
+  uint8_t datagram[fleet::FLEET_DATAGRAM_MAX];
+  const size_t length = sealedCommand(fleet::keyFor("baska-anahtar"), datagram, sizeof(datagram));
+  TEST_ASSERT_EQUAL(0, fleet::unseal(KEY, datagram, length));
+  TEST_ASSERT_EQUAL(0, fleet::unseal(fleet::keyFor(""), datagram, length));
+}
+
+void test_cut_datagram_is_rejected() {
+  uint8_t datagram[fleet::FLEET_DATAGRAM_MAX];
+  const size_t length = sealedCommand(KEY, datagram, sizeof(datagram));
+  for (size_t cut = 0; cut <= fleet::FLEET_TAG_BYTES + 1; ++cut) {
+    TEST_ASSERT_EQUAL(0, fleet::unseal(KEY, datagram, length - 1 - cut));
+  }
+}
+
+void test_seal_needs_room_for_the_tag() {
+  uint8_t datagram[32] = {};
+  TEST_ASSERT_EQUAL(0, fleet::seal(KEY, datagram, 25, sizeof(datagram)));
+  TEST_ASSERT_EQUAL(32, fleet::seal(KEY, datagram, 24, sizeof(datagram)));
+  TEST_ASSERT_EQUAL(0, fleet::seal(KEY, datagram, 0, sizeof(datagram)));
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_siphash_reference_vector);
+  RUN_TEST(test_sealed_datagram_round_trips);
+  RUN_TEST(test_every_changed_byte_is_rejected);
+  RUN_TEST(test_other_key_is_rejected);
+  RUN_TEST(test_cut_datagram_is_rejected);
+  RUN_TEST(test_seal_needs_room_for_the_tag);
+  return UNITY_END();
+}
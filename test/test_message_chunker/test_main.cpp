@@ -0,0 +1,143 @@
+// MessageChunker on the host: UTF-16 unit counting, line-boundary splits and
+// sequences that must not be cut.
+//   pio test -e native_test -f test_message_chunker
+
+#include <Arduino.h>
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+
+#include "config.h"
+#include "telegram/MessageChunker.h"
+
+namespace {
+constexpr size_t MAX_SPANS = 8;
+
+// UTF-8 spelled out so the source stays ASCII.
+#define C_CEDILLA "\xC3\xA7"        // U+00E7, 2 bytes, 1 unit
+#define EURO "\xE2\x82\xAC"         // U+20AC, 3 bytes, 1 unit
+#define GRINNING "\xF0\x9F\x98\x80"  // U+1F600, 4 bytes, a surrogate pair: 2 units
+
+struct ChunkCase {
+  const char *name;
+  const char *text;
+  size_t maxUnits;
+  bool single;
+  const char *spans[MAX_SPANS];  // Expected spans, nullptr terminated
+};
+
+const ChunkCase CHUNK_CASES[] = {
+    {"fits", "Olcum Raporu\nSon: 25.00", 64, true, {"Olcum Raporu\nSon: 25.00"}},
+    {"fits exactly", "0123456789", 10, true, {"0123456789"}},
+    {"split at the last line break", "satir bir\nsatir iki\nsatir uc", 20, false,
+     {"satir bir\nsatir iki", "satir uc"}},
+    {"single line longer than the limit", "abcdefghijklmnopqrstuvwxy", 10, false, {"abcdefghij", "klmnopqrst", "uvwxy"}},
+    {"long line after a short one", "kisa\nabcdefghijklmnopqrstuvwxy", 10, false,
+     {"kisa", "abcdefghij", "klmnopqrst", "uvwxy"}},
+    {"blank line at a boundary", "abcde\n\nfghijklmn", 6, false, {"abcde", "fghijk", "lmn"}},
+    {"two-byte sequences count one unit", C_CEDILLA C_CEDILLA C_CEDILLA C_CEDILLA, 4, true,
+     {C_CEDILLA C_CEDILLA C_CEDILLA C_CEDILLA}},
+    {"two-byte sequences are not cut", C_CEDILLA C_CEDILLA C_CEDILLA C_CEDILLA C_CEDILLA, 2, false,
+     {C_CEDILLA C_CEDILLA, C_CEDILLA C_CEDILLA, C_CEDILLA}},
+    {"three-byte sequences are not cut", EURO EURO EURO, 2, false, {EURO EURO, EURO}},
+    {"four-byte sequence counts two units", GRINNING GRINNING, 4, true, {GRINNING GRINNING}},
+    {"four-byte sequences over the limit", GRINNING GRINNING GRINNING, 5, false, {GRINNING GRINNING, GRINNING}},
+    {"surrogate pair does not fit the last unit", "a" GRINNING, 2, false, {"a", GRINNING}},
+    {"sequence wider than the limit", GRINNING "a", 1, false, {GRINNING, "a"}},
+    {"mixed widths with line breaks", "T: 25" EURO "\n" GRINNING " s" C_CEDILLA "cak\nson", 10, false,
+     {"T: 25" EURO, GRINNING " s" C_CEDILLA "cak", "son"}},
+};
+
+size_t sequenceBytes(uint8_t lead) {
+  return lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+}
+
+bool continuationByte(uint8_t byte) { return (byte & 0xC0) == 0x80; }
+
+// Telegram's count: one UTF-16 unit per code point, two above U+FFFF.
+size_t utf16Units(const char *text, size_t length) {
+  size_t units = 0;
+  for (size_t i = 0; i < length; i += sequenceBytes(static_cast<uint8_t>(text[i]))) {
+    units += sequenceBytes(static_cast<uint8_t>(text[i])) == 4 ? 2 : 1;
+  }
+  return units;
+}
+
+void test_chunk_table() {
+  for (const ChunkCase &row : CHUNK_CASES) {
+    telegram::MessageChunker chunker(row.text, strlen(row.text), row.maxUnits);
+    TEST_ASSERT_EQUAL_MESSAGE(row.single, chunker.single(), row.name);
+    telegram::TextSpan span;
+    size_t count = 0;
+    while (chunker.next(span)) {
+      TEST_ASSERT_TRUE_MESSAGE(count < MAX_SPANS && row.spans[count] != nullptr, row.name);
+      const std::string got(row.text + span.offset, span.length);
+      TEST_ASSERT_EQUAL_STRING_MESSAGE(row.spans[count], got.c_str(), row.name);
+      ++count;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(count == MAX_SPANS || row.spans[count] == nullptr, row.name);
+  }
+}
+
+void test_empty_text_has_no_spans() {
+  telegram::MessageChunker chunker("", 0, 10);
+  telegram::TextSpan span;
+  TEST_ASSERT_TRUE(chunker.single());
+  TEST_ASSERT_FALSE(chunker.next(span));
+}
+
+// A long report of mixed widths at several limits: spans are in order, within
+// the limit, start and end on sequence boundaries, and only line breaks are dropped.
+void test_spans_cover_the_text() {
+  std::string text;
+  for (int line = 0; line < 120; ++line) {
+    text += "Satir ";
+    text += std::to_string(line);
+    text += line % 3 == 0 ? " s" C_CEDILLA "cak " EURO : " ";
+    for (int i = 0; i < line % 7; ++i) {
+      text += GRINNING;
+    }
+    text += line % 11 == 0 ? "\n\n" : "\n";
+  }
+  text.append(300, 'x');  // No break to split at
+
+  const size_t limits[] = {1, 2, 7, 50, 333, config::TELEGRAM_MAX_MESSAGE_UNITS};
+  for (size_t maxUnits : limits) {
+    char name[32];
+    snprintf(name, sizeof(name), "limit %u", static_cast<unsigned>(maxUnits));
+    telegram::MessageChunker chunker(text.data(), text.size(), maxUnits);
+    TEST_ASSERT_EQUAL_MESSAGE(utf16Units(text.data(), text.size()) <= maxUnits, chunker.single(), name);
+
+    telegram::TextSpan span;
+    size_t position = 0;
+    while (chunker.next(span)) {
+      TEST_ASSERT_TRUE_MESSAGE(span.length > 0, name);
+      TEST_ASSERT_TRUE_MESSAGE(span.offset >= position, name);
+      for (size_t i = position; i < span.offset; ++i) {
+        TEST_ASSERT_EQUAL_MESSAGE('\n', text[i], name);
+      }
+      const char *start = text.data() + span.offset;
+      const size_t units = utf16Units(start, span.length);
+      TEST_ASSERT_TRUE_MESSAGE(units <= maxUnits || (maxUnits == 1 && units == 2), name);
+      TEST_ASSERT_FALSE_MESSAGE(continuationByte(static_cast<uint8_t>(start[0])), name);
+      const size_t end = span.offset + span.length;
+      TEST_ASSERT_TRUE_MESSAGE(end == text.size() || !continuationByte(static_cast<uint8_t>(text[end])), name);
+      position = end;
+    }
+    TEST_ASSERT_EQUAL_MESSAGE(text.size(), position, name);
+  }
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_chunk_table);
+  RUN_TEST(test_empty_text_has_no_spans);
+  RUN_TEST(test_spans_cover_the_text);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Collect and compare micro-benchmark results (src/bench).
+
+Both bench environments print one Google Benchmark JSON document: native_bench
+on stdout, nodemcu_bench on the serial port at boot. This tool extracts that
+document from a capture (boot noise around it is skipped), stamps it with the
+git revision and compares it against a baseline.
+
+    pio run -e native_bench && .pio/build/native_bench/program > host.txt
+    python3 tools/bench_report.py --input host.txt --output bench/host-$(git describe --always).json
+    python3 tools/bench_report.py --port /dev/ttyUSB0 --output device.json   # then reset the board
+    python3 tools/bench_report.py --input device.json --baseline old-device.json --threshold 10
+
+With --baseline the exit status is 1 when any benchmark got slower by more than
+--threshold percent (ns/op) or allocates more per call, so it can gate CI. The
+JSON is also readable by Google Benchmark's tools/compare.py.
+"""
+
+import argparse
+import json
+import os
+import select
+import subprocess
+import sys
+import termios
+import time
+
+
+def extract_document(text):
+    decoder = json.JSONDecoder()
+    start = text.find('{\n  "context"')
+    while start >= 0:
+        try:
+            document, _ = decoder.raw_decode(text, start)
+            if "benchmarks" in document:
+                return document
+        except json.JSONDecodeError:
+            pass
+        start = text.find('{\n  "context"', start + 1)
+    return None
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, "B%d" % baud)
+    attrs[0] = 0
+    attrs[1] = 0
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0
+    attrs[4] = speed
+    attrs[5] = speed
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def capture_port(path, baud, timeout):
+    fd = open_port(path, baud)
+    deadline = time.monotonic() + timeout
+    received = bytearray()
+    try:
+        while time.monotonic() < deadline:
+            ready, _, _ = select.select([fd], [], [], 0.2)
+            if not ready:
+                continue
+            received += os.read(fd, 4096)
+            if b"\n  ]\n}" in received.replace(b"\r\n", b"\n"):
+                break
+    finally:
+        os.close(fd)
+    return received.decode("utf-8", errors="replace").replace("\r\n", "\n")
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "describe", "--always", "--dirty"], stderr=subprocess.DEVNULL,
+                                       text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return ""
+
+
+def print_table(document, out):
+    context = document["context"]
+    out.write("%s (%s, %s MHz, cycles: %s)\n" % (context.get("executable"), context.get("platform"),
+                                                 context.get("mhz_per_cpu"), context.get("cycle_counter")))
+    out.write("%-56s %12s %12s %9s %9s\n" % ("benchmark", "ns/op", "cycles/op", "alloc/op", "B/op"))
+    for bench in document["benchmarks"]:
+        out.write("%-56s %12.1f %12.1f %9.2f %9.1f\n" % (
+            bench["name"], bench["real_time"], bench["cycles_per_iteration"], bench["allocs_per_iteration"],
+            bench["bytes_per_iteration"]))
+
+
+def compare(baseline, current, threshold, out):
+    old = {bench["name"]: bench for bench in baseline["benchmarks"]}
+    regressions = 0
+    out.write("%-56s %12s %12s %8s %13s\n" % ("benchmark", "old ns/op", "new ns/op", "delta", "alloc/op"))
+    for bench in current["benchmarks"]:
+        before = old.get(bench["name"])
+        if before is None:
+            out.write("%-56s %12s %12.1f %8s\n" % (bench["name"], "-", bench["real_time"], "yeni"))
+            continue
+        delta = 100.0 * (bench["real_time"] - before["real_time"]) / before["real_time"] if before["real_time"] else 0.0
+        slower = delta > threshold
+        more_allocs = bench["allocs_per_iteration"] > before["allocs_per_iteration"] + 0.005
+        flag = " <-- GERILEME" if slower or more_allocs else ""
+        regressions += 1 if flag else 0
+        out.write("%-56s %12.1f %12.1f %+7.1f%% %6.2f->%-6.2f%s\n" % (
+            bench["name"], before["real_time"], bench["real_time"], delta, before["allocs_per_iteration"],
+            bench["allocs_per_iteration"], flag))
+    if baseline["context"].get("platform") != current["context"].get("platform"):
+        out.write("uyari: farkli platformlar karsilastiriliyor\n")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--input", help="JSON, serial capture or program output ('-' for stdin)")
+    source.add_argument("--port", help="serial port of a board running nodemcu_bench")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=120.0, help="seconds to wait for the serial document")
+    parser.add_argument("--output", help="write the cleaned JSON document here")
+    parser.add_argument("--baseline", help="earlier JSON document to compare against")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed ns/op increase in percent")
+    args = parser.parse_args()
+
+    if args.port:
+        text = capture_port(args.port, args.baud, args.timeout)
+    elif args.input == "-":
+        text = sys.stdin.read()
+    else:
+        with open(args.input, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+    document = extract_document(text)
+    if document is None:
+        sys.stderr.write("benchmark JSON bulunamadi\n")
+        return 2
+    if "git_revision" not in document["context"]:
+        document["context"]["git_revision"] = git_revision()
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            json.dump(document, f, indent=2)
+            f.write("\n")
+
+    if args.baseline:
+        with open(args.baseline, encoding="utf-8") as f:
+            baseline = extract_document(f.read())
+        if baseline is None:
+            sys.stderr.write("baseline icinde benchmark JSON yok\n")
+            return 2
+        return 1 if compare(baseline, document, args.threshold, sys.stdout) else 0
+    print_table(document, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
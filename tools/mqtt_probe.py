@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Measure the device's MQTT channel from a broker subscriber.
+
+Subscribes to <prefix>/#, counts messages per topic and reports messages/second.
+Telemetry carrying a "ts" field also yields device-to-probe latency (needs both
+clocks on NTP). With --command the probe publishes to <prefix>/cmd at QoS 1 and
+times the first reply on <prefix>/cmd/reply; the device only subscribes to the
+command topic when built with MQTT_ACCEPT_COMMANDS = true.
+
+    python3 tools/mqtt_probe.py --host 192.168.1.10 --duration 60
+    python3 tools/mqtt_probe.py --host localhost --command stats --repeat 20
+
+Only the standard library is used, so it runs wherever mosquitto does.
+"""
+
+import argparse
+import json
+import select
+import socket
+import struct
+import sys
+import time
+
+
+def encode_length(length):
+    out = bytearray()
+    while True:
+        digit = length % 128
+        length //= 128
+        out.append(digit | (0x80 if length else 0))
+        if not length:
+            return bytes(out)
+
+
+def encode_string(text):
+    data = text.encode()
+    return struct.pack(">H", len(data)) + data
+
+
+def packet(header, body):
+    return bytes([header]) + encode_length(len(body)) + body
+
+
+class Connection:
+    def __init__(self, host, port, client_id, keepalive=60):
+        self.sock = socket.create_connection((host, port), timeout=5)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer = bytearray()
+        self.packet_id = 0
+        body = encode_string("MQTT") + bytes([4, 0x02]) + struct.pack(">H", keepalive) + encode_string(client_id)
+        self.sock.sendall(packet(0x10, body))
+        received = self.read_packet(5)
+        if not received:
+            raise RuntimeError("no CONNACK from broker")
+        header, payload = received
+        if header & 0xF0 != 0x20 or len(payload) < 2 or payload[1] != 0:
+            raise RuntimeError("broker refused connection")
+
+    def next_id(self):
+        self.packet_id = self.packet_id % 0xFFFF + 1
+        return self.packet_id
+
+    def subscribe(self, topic):
+        self.sock.sendall(packet(0x82, struct.pack(">H", self.next_id()) + encode_string(topic) + b"\x00"))
+
+    def publish(self, topic, payload, qos=0):
+        body = encode_string(topic)
+        if qos:
+            body += struct.pack(">H", self.next_id())
+        self.sock.sendall(packet(0x30 | (qos << 1), body + payload))
+
+    def ping(self):
+        self.sock.sendall(b"\xc0\x00")
+
+    def read_packet(self, timeout):
+        """Returns (header, body) or None when nothing complete arrived in time."""
+        deadline = time.monotonic() + timeout
+        while True:
+            parsed = self._parse()
+            if parsed:
+                return parsed
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return None
+            ready, _, _ = select.select([self.sock], [], [], remaining)
+            if ready:
+                chunk = self.sock.recv(4096)
+                if not chunk:
+                    raise RuntimeError("broker closed the connection")
+                self.buffer += chunk
+
+    def _parse(self):
+        if len(self.buffer) < 2:
+            return None
+        length = 0
+        shift = 0
+        pos = 1
+        while True:
+            if pos >= len(self.buffer):
+                return None
+            byte = self.buffer[pos]
+            pos += 1
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        if len(self.buffer) < pos + length:
+            return None
+        header = self.buffer[0]
+        body = bytes(self.buffer[pos:pos + length])
+        del self.buffer[:pos + length]
+        return header, body
+
+
+def split_publish(header, body):
+    topic_length = struct.unpack(">H", body[:2])[0]
+    topic = body[2:2 + topic_length].decode(errors="replace")
+    pos = 2 + topic_length
+    if (header >> 1) & 0x03:
+        pos += 2
+    return topic, body[pos:], bool(header & 0x01)
+
+
+def summarize(values):
+    if not values:
+        return "-"
+    values = sorted(values)
+    p95 = values[min(len(values) - 1, int(len(values) * 0.95))]
+    return "min %.1f / ort %.1f / p95 %.1f / maks %.1f ms (n=%d)" % (
+        values[0], sum(values) / len(values), p95, values[-1], len(values))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--prefix", default="tastan09")
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds to listen")
+    parser.add_argument("--command", help="command text published to <prefix>/cmd, e.g. stats")
+    parser.add_argument("--repeat", type=int, default=1, help="how many times to send --command")
+    args = parser.parse_args()
+
+    conn = Connection(args.host, args.port, "tastan-probe-%d" % (time.time() * 1000 % 100000))
+    conn.subscribe(args.prefix + "/#")
+
+    counts = {}
+    telemetry_latency = []
+    command_latency = []
+    commands_left = args.repeat if args.command else 0
+    command_sent_at = None
+    next_command_at = 0.0
+    started = time.monotonic()
+    first_live = None
+    live = 0
+    last_ping = started
+
+    while time.monotonic() - started < args.duration or command_sent_at is not None:
+        now = time.monotonic()
+        if command_sent_at is None and commands_left > 0 and now >= next_command_at:
+            command_sent_at = now
+            commands_left -= 1
+            conn.publish(args.prefix + "/cmd", args.command.encode(), qos=1)
+        if now - last_ping > 20:
+            conn.ping()
+            last_ping = now
+        if command_sent_at is not None and now - command_sent_at > 10:
+            print("komut yanitsiz kaldi", file=sys.stderr)
+            command_sent_at = None
+        received = conn.read_packet(0.5)
+        if not received:
+            continue
+        header, body = received
+        if header & 0xF0 != 0x30:
+            continue
+        topic, payload, retained = split_publish(header, body)
+        counts[topic] = counts.get(topic, 0) + 1
+        if retained:
+            continue  # Stored copy from before the probe connected
+        if first_live is None:
+            first_live = now
+        live += 1
+        if topic.endswith("/cmd/reply") and command_sent_at is not None:
+            command_latency.append((time.monotonic() - command_sent_at) * 1000.0)
+            command_sent_at = None
+            next_command_at = time.monotonic() + 1.0  # Let multi-part replies finish first
+        elif topic.endswith("/telemetry"):
+            try:
+                ts = json.loads(payload).get("ts")
+            except ValueError:
+                ts = None
+            if ts:
+                telemetry_latency.append(time.time() * 1000.0 - ts)
+
+    elapsed = time.monotonic() - (first_live or started)
+    print("Konu basina mesaj:")
+    for topic in sorted(counts):
+        print("  %-32s %d" % (topic, counts[topic]))
+    print("Canli mesaj hizi: %.2f mesaj/sn (%d mesaj, %.1f sn)" % (live / elapsed if elapsed > 0 else 0.0, live,
+                                                                 elapsed))
+    print("Telemetri gecikmesi (cihaz ts -> probe): " + summarize(telemetry_latency))
+    if args.command:
+        print("Komut tur gecikmesi (%s): %s" % (args.command, summarize(command_latency)))
+
+
+if __name__ == "__main__":
+    main()
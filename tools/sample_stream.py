@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Decode the binary sample stream (src/stream) into CSV and report lost frames.
+
+Reads a serial port directly (Linux, raw termios) or a capture file. With a
+port, the tool sends "stream on" at start and "stream off" on exit, so the
+device goes back to text logging afterwards.
+
+    python3 tools/sample_stream.py --port /dev/ttyUSB0 --duration 60 > olcum.csv
+    python3 tools/sample_stream.py --port /dev/ttyUSB0 --raw capture.bin --duration 60
+    python3 tools/sample_stream.py --input capture.bin --parquet olcum.parquet
+
+Frames are COBS encoded and 0x00 terminated; each carries a 16-bit sequence
+number, so gaps count frames the device dropped (UART FIFO full) or the wire
+corrupted. --parquet needs pyarrow; CSV output needs only the standard library.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+FRAME_TYPE = 0x01
+PAYLOAD = struct.Struct("<BHIhhB")  # type, sequence, uptime ms, ambient, object, flags (+ u16 CRC)
+INVALID_CENTI = -32768
+FLAG_HEATING = 0x01
+FLAG_COOLING = 0x02
+FLAG_READ_ERROR = 0x04
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        pos += 1
+        if code == 0 or pos + code - 1 > len(data):
+            return None
+        out += data[pos:pos + code - 1]
+        pos += code - 1
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(frame):
+    payload = cobs_decode(frame)
+    if payload is None or len(payload) != PAYLOAD.size + 2 or payload[0] != FRAME_TYPE:
+        return None
+    if struct.unpack_from("<H", payload, PAYLOAD.size)[0] != crc16_ccitt(payload[:PAYLOAD.size]):
+        return None
+    return PAYLOAD.unpack_from(payload)[1:]
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.corrupt = 0
+        self.lost = 0
+        self.read_errors = 0
+        self.last_sequence = None
+        self.first_uptime = None
+        self.last_uptime = None
+        self.intervals = []
+
+    def add(self, sequence, uptime, flags):
+        if self.last_sequence is not None:
+            gap = (sequence - self.last_sequence - 1) & 0xFFFF
+            self.lost += gap
+        if self.last_uptime is not None:
+            self.intervals.append((uptime - self.last_uptime) & 0xFFFFFFFF)
+        if self.first_uptime is None:
+            self.first_uptime = uptime
+        self.last_sequence = sequence
+        self.last_uptime = uptime
+        self.frames += 1
+        if flags & FLAG_READ_ERROR:
+            self.read_errors += 1
+
+    def report(self, out):
+        expected = self.frames + self.lost
+        span = ((self.last_uptime - self.first_uptime) & 0xFFFFFFFF) / 1000.0 if self.frames > 1 else 0.0
+        out.write("cerceve %d, kayip %d (%.3f%%), bozuk %d, okuma hatasi %d\n" % (
+            self.frames, self.lost, 100.0 * self.lost / expected if expected else 0.0, self.corrupt,
+            self.read_errors))
+        if span > 0:
+            out.write("cihaz suresi %.1f sn, %.1f ornek/sn\n" % (span, (self.frames - 1) / span))
+        if self.intervals:
+            values = sorted(self.intervals)
+            out.write("ornek araligi ms: min %d / medyan %d / p99 %d / maks %d\n" % (
+                values[0], values[len(values) // 2], values[min(len(values) - 1, int(len(values) * 0.99))],
+                values[-1]))
+
+
+def centi(value):
+    if value == INVALID_CENTI:
+        return ""
+    sign = "-" if value < 0 else ""
+    value = abs(value)
+    return "%s%d.%02d" % (sign, value // 100, value % 100)
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, "B%d" % baud)
+    attrs[0] = 0                                              # iflag: no translation
+    attrs[1] = 0                                              # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL   # cflag
+    attrs[3] = 0                                              # lflag: raw
+    attrs[4] = speed
+    attrs[5] = speed
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def read_chunks(fd, deadline):
+    while deadline is None or time.monotonic() < deadline:
+        ready, _, _ = select.select([fd], [], [], 0.2)
+        if ready:
+            chunk = os.read(fd, 4096)
+            if not chunk:
+                return
+            yield chunk
+
+
+class Sink:
+    def __init__(self, csv_out, parquet_path):
+        self.csv_out = csv_out
+        self.parquet_path = parquet_path
+        self.columns = {"sira": [], "sure_ms": [], "ortam_C": [], "nesne_C": [], "isitma": [], "sogutma": [],
+                        "hata": []}
+        if csv_out:
+            csv_out.write("sira,sure_ms,ortam_C,nesne_C,isitma,sogutma,hata\n")
+
+    def add(self, sequence, uptime, ambient, obj, flags):
+        heating = 1 if flags & FLAG_HEATING else 0
+        cooling = 1 if flags & FLAG_COOLING else 0
+        error = 1 if flags & FLAG_READ_ERROR else 0
+        if self.csv_out:
+            self.csv_out.write("%d,%d,%s,%s,%d,%d,%d\n" % (sequence, uptime, centi(ambient), centi(obj), heating,
+                                                           cooling, error))
+        if self.parquet_path:
+            for key, value in (("sira", sequence), ("sure_ms", uptime),
+                               ("ortam_C", None if ambient == INVALID_CENTI else ambient / 100.0),
+                               ("nesne_C", None if obj == INVALID_CENTI else obj / 100.0),
+                               ("isitma", heating), ("sogutma", cooling), ("hata", error)):
+                self.columns[key].append(value)
+
+    def close(self):
+        if self.parquet_path:
+            import pyarrow
+            import pyarrow.parquet
+            pyarrow.parquet.write_table(pyarrow.table(self.columns), self.parquet_path)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial device, e.g. /dev/ttyUSB0")
+    source.add_argument("--input", help="capture file written with --raw")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--duration", type=float, help="seconds to record from --port (default: until Ctrl-C)")
+    parser.add_argument("--raw", help="also save the undecoded byte stream here")
+    parser.add_argument("--parquet", help="write a Parquet file instead of CSV on stdout (needs pyarrow)")
+    args = parser.parse_args()
+
+    sink = Sink(None if args.parquet else sys.stdout, args.parquet)
+    stats = Stats()
+    raw = open(args.raw, "wb") if args.raw else None
+    fd = None
+    if args.port:
+        fd = open_port(args.port, args.baud)
+        os.write(fd, b"\nstream on\n")
+        deadline = time.monotonic() + args.duration if args.duration else None
+        chunks = read_chunks(fd, deadline)
+    else:
+        with open(args.input, "rb") as handle:
+            chunks = iter([handle.read()])
+
+    buffer = bytearray()
+    synced = False  # Bytes before the first delimiter are the tail of text output
+    try:
+        for chunk in chunks:
+            if raw:
+                raw.write(chunk)
+            buffer += chunk
+            while True:
+                end = buffer.find(b"\x00")
+                if end < 0:
+                    break
+                frame = bytes(buffer[:end])
+                del buffer[:end + 1]
+                if not synced:
+                    synced = True
+                    continue
+                if not frame:
+                    continue
+                decoded = decode_frame(frame)
+                if decoded is None:
+                    stats.corrupt += 1
+                    continue
+                sequence, uptime, ambient, obj, flags = decoded
+                stats.add(sequence, uptime, flags)
+                sink.add(sequence, uptime, ambient, obj, flags)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if fd is not None:
+            os.write(fd, b"\nstream off\n")
+            os.close(fd)
+        if raw:
+            raw.close()
+    sink.close()
+    stats.report(sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
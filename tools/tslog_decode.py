@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Decode time-series data written by src/timeseries into CSV.
+
+Accepts binary exports received from the `export <range> bin` command (.tsx)
+or raw segment files (/tslog_NNN.seg, /tslog_open.bin) copied off the LittleFS
+partition. Blocks of all inputs are merged in sequence order.
+
+    python3 tools/tslog_decode.py olcum_1700000000.tsx > olcum.csv
+    python3 tools/tslog_decode.py --block-size 512 littlefs/tslog_*.seg littlefs/tslog_open.bin > olcum.csv
+"""
+
+import argparse
+import itertools
+import struct
+import sys
+
+BLOCK_MAGIC = 0x5354
+BLOCK_VERSION = 1
+BLOCK_HEADER = struct.Struct("<HBBIHHQQ")  # magic, version, reserved, sequence, count, used, first, last
+EXPORT_MAGIC = b"TSX\x01"
+EXPORT_HEADER = struct.Struct("<4sHHQQ")  # magic, block size, reserved, from ms, to ms
+
+
+def read_varint(data, pos, end):
+    value = 0
+    shift = 0
+    while pos < end and shift < 64:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+    raise ValueError("truncated varint")
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode_block(data):
+    """Yields (timestamp_ms, object_centi, ambient_centi, flags) and returns the header."""
+    if len(data) < BLOCK_HEADER.size:
+        return None, []
+    magic, version, _, sequence, count, used, first, last = BLOCK_HEADER.unpack_from(data)
+    if magic != BLOCK_MAGIC or version != BLOCK_VERSION or used < BLOCK_HEADER.size or used > len(data):
+        return None, []
+    points = []
+    pos = BLOCK_HEADER.size
+    timestamp, delta, obj, amb, flags = first, 0, 0, 0, 0
+    for _ in range(count):
+        control, pos = read_varint(data, pos, used)
+        obj_delta, pos = read_varint(data, pos, used)
+        amb_delta, pos = read_varint(data, pos, used)
+        if control & 1:
+            flags = data[pos]
+            pos += 1
+        delta += unzigzag(control >> 1)
+        timestamp += delta
+        obj += unzigzag(obj_delta)
+        amb += unzigzag(amb_delta)
+        points.append((timestamp, obj, amb, flags))
+    header = {"sequence": sequence, "count": count, "used": used, "first": first, "last": last}
+    return header, points
+
+
+def iter_export(data):
+    magic, _, _, from_ms, to_ms = EXPORT_HEADER.unpack_from(data)
+    if magic != EXPORT_MAGIC:
+        raise ValueError("not a TSX export")
+    pos = EXPORT_HEADER.size
+    while pos + BLOCK_HEADER.size <= len(data):
+        used = BLOCK_HEADER.unpack_from(data, pos)[5]
+        header, points = decode_block(data[pos:pos + used])
+        if header is None:
+            raise ValueError("corrupt block at offset %d" % pos)
+        pos += used
+        for point in points:
+            if from_ms <= point[0] <= to_ms:
+                yield point
+
+
+def image_blocks(data, block_size):
+    for offset in range(0, len(data) - block_size + 1, block_size):
+        header, points = decode_block(data[offset:offset + block_size])
+        if header is not None:
+            yield header["sequence"], points
+
+
+def iter_images(images, block_size):
+    # The open block file may repeat a block already closed in its segment; the
+    # segment copy is at least as long.
+    blocks = {}
+    for data in images:
+        for sequence, points in image_blocks(data, block_size):
+            if len(points) > len(blocks.get(sequence, [])):
+                blocks[sequence] = points
+    for sequence in sorted(blocks):
+        yield from blocks[sequence]
+
+
+def centi(value):
+    sign = "-" if value < 0 else ""
+    value = abs(value)
+    return "%s%d.%02d" % (sign, value // 100, value % 100)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="+", help=".tsx exports or raw segment files")
+    parser.add_argument("--block-size", type=int, default=512, help="block size of a raw image (TIMESERIES_BLOCK_BYTES)")
+    args = parser.parse_args()
+
+    exports = []
+    images = []
+    for path in args.input:
+        with open(path, "rb") as handle:
+            data = handle.read()
+        (exports if data.startswith(EXPORT_MAGIC) else images).append(data)
+    points = itertools.chain(itertools.chain.from_iterable(iter_export(data) for data in exports),
+                             iter_images(images, args.block_size))
+
+    out = sys.stdout
+    out.write("zaman_utc_s,nesne_C,ortam_C,durum\n")
+    for timestamp, obj, amb, flags in points:
+        out.write("%d.%03d,%s,%s,%d\n" % (timestamp // 1000, timestamp % 1000, centi(obj), centi(amb), flags))
+
+
+if __name__ == "__main__":
+    main()